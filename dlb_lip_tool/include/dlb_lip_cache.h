@@ -0,0 +1,115 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_cache.h
+ *  @brief      Persistent storage of dlb_lip cache blobs
+ *
+ *  By default blobs are stored in cache_<uuid>.dat files. Stores are queued and written by a background
+ *  thread: the file is written to a temporary file, synced and renamed over the previous one,
+ *  so a crash never leaves a partially written cache file. Repeated stores of the same UUID
+ *  that are still queued are coalesced.
+ *
+ *  Cache files are loaded by a warm start thread started when the cache is opened, so it runs in parallel
+ *  with XML parsing and CEC adapter open. Only records passing validation are kept in memory, afterwards
+ *  reads are served from memory and stores update it. Reads and stores wait until the warm start is done.
+ *
+ *  Alternatively all blobs are kept in one store file mapped into memory. The store is an array
+ *  of fixed size slots indexed by UUID, stores overwrite the slot of the UUID in place and reads
+ *  copy from the mapped memory. Slots grow when a bigger blob is stored, free slots are
+ *  reclaimed by a compaction pass when the store is opened. The warm start thread validates all
+ *  slots of the store, invalid slots are freed.
+ *
+ *  Processes on the same host can share the cache in a POSIX shared memory segment. Readers are lock-free:
+ *  a slot is copied and the copy is used only if the sequence number of the slot didn't change meanwhile.
+ *  Writers of the same UUID are serialized by the lock of its slot, a blob stored by one process is
+ *  immediately readable by the others.
+ *
+ *  Total size and number of cached UUIDs can be limited. Every store and every read hit marks
+ *  the UUID as most recently used, least recently used UUIDs are evicted when a limit is exceeded.
+ *  For the store file the size limit applies to the file size.
+ *
+ *  Every blob is kept with a record header holding magic, dlb_lip version, blob size and CRC32C
+ *  of the blob. Reads return 0 for records which are truncated, written by another library
+ *  version or corrupted, so dlb_lip never gets a blob it can't trust.
+ *
+ *  Blobs of all UUIDs can be exported to one archive and imported on another host, regardless of the backend.
+ *  Archive layout, all numbers are little endian uint32:
+ *      header: "LICA", archive version(1), dlb_lip version, number of entries
+ *      entry:  UUID, blob size, CRC32C of the blob, blob
+ *  Archives are accepted only by the same dlb_lip version, entries with bad checksum are skipped.
+ */
+
+#ifndef DLB_LIP_CACHE_H
+#define DLB_LIP_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct dlb_lip_cache_config_s
+{
+    const char *directory;       /**< Directory of cache files and relative store path, NULL or empty for current directory */
+    const char *store_path;      /**< Path of the store file, NULL or empty for cache files */
+    const char *shm_name;        /**< Name of the shared memory segment, NULL or empty for store or cache files */
+    uint64_t    max_size;        /**< Maximum size of cached blobs in bytes, 0 for no limit */
+    uint32_t    max_entries;     /**< Maximum number of cached UUIDs, 0 for no limit */
+    uint32_t    library_version; /**< Version of dlb_lip, records written by other versions are rejected */
+} dlb_lip_cache_config_t;
+
+/**
+ * @brief Opens the shared memory segment, the store file or starts the background writer of cache files
+ * @return 0 on success, 1 on error(falls back to store or cache files, written synchronously if the writer can't be started)
+ */
+int dlb_lip_cache_open(const dlb_lip_cache_config_t *config);
+
+/**
+ * @brief Waits until the warm start is done
+ * @return number of valid cache records(loaded files or valid store slots), -1 if there is no warm start
+ */
+int dlb_lip_cache_wait_warm_start(void);
+
+/**
+ * @brief Imports cache_<uuid>.dat files of the cache directory into the store file
+ * @param legacy Also imports files without record header written before records had one, their blobs are trusted
+ *               although their dlb_lip version and integrity can't be checked. Otherwise such files are rejected.
+ * @return number of imported files, -1 on error
+ */
+int dlb_lip_cache_import_files(bool legacy);
+
+/**
+ * @brief Writes blobs of all UUIDs of the cache to the archive
+ * @return number of exported UUIDs, -1 on error
+ */
+int dlb_lip_cache_export(const char *path);
+
+/**
+ * @brief Stores all valid blobs of the archive in the cache, cached blobs of the same UUIDs are replaced
+ * @return number of imported UUIDs, -1 if the archive can't be used
+ */
+int dlb_lip_cache_import(const char *path);
+
+/**
+ * @brief Writes all queued stores and stops the background writer, or syncs and closes the store file
+ */
+void dlb_lip_cache_close(void);
+
+/**
+ * @brief Queues copy of the cache blob for writing, never blocks on file I/O
+ */
+void dlb_lip_cache_store(uint32_t uuid, const void *const cache_data, unsigned int size);
+
+/**
+ * @brief Reads cache blob of the UUID
+ * @return number of bytes read, 0 if there is no valid cache record for the UUID
+ */
+unsigned int dlb_lip_cache_read(uint32_t uuid, void *const cache_data, unsigned int size);
+
+#endif
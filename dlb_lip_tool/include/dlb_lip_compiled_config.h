@@ -0,0 +1,55 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_compiled_config.h
+ *  @brief      Device config compiled from the XML file into a binary file loaded at startup
+ *
+ *  The compiled file holds fully expanded dlb_lip_config_params_t, latency tables, physical address and device type,
+ *  so startup doesn't parse the XML file and doesn't expand its wildcard latencies. The file is mapped and its fixed
+ *  part is copied as a whole. Layout:
+ *      header:  "LIPC", file version, dlb_lip version, payload size, FNV-1a hash of the payload
+ *      payload: dlb_lip_config_params_t, physical address(uint16_t), device type(uint32_t), dependency count(uint32_t),
+ *               dependencies of the parser(the XML file, its base and included files), then rule count(uint32_t) and
+ *               rules(first and last indexes, latency) of the video and of the audio latency table
+ *  Tables take as much space as their rules. The fixed part is in memory layout of the tool, so the file is accepted
+ *  only by a tool built with the same dlb_lip version. The file is used only if none of its dependencies changed since
+ *  it was compiled(modification time and size).
+ */
+
+#ifndef DLB_LIP_COMPILED_CONFIG_H
+#define DLB_LIP_COMPILED_CONFIG_H
+
+#include <stdint.h>
+
+#include "dlb_lip_xml_parser.h"
+
+#define DLB_LIP_COMPILED_CONFIG_SUFFIX ".lipc" // Compiled file of <config>.xml is <config>.xml.lipc
+
+/**
+ * @brief Writes config of the parsed XML file to the compiled file
+ * @param library_version Version of dlb_lip, files written by other versions are rejected
+ * @return 0 on success, 1 on error
+ */
+int dlb_lip_compiled_config_write(const char *path, const dlb_lip_xml_parser_t *p_parser, uint32_t library_version);
+
+/**
+ * @brief Loads config from the compiled file
+ * @param xml_path XML file the file was compiled from, the compiled file is stale if it or its base or included files
+ *                 changed
+ * @param p_parser Parser which holds no latency tables
+ * @return 0 if config_params, latency tables, physical_address, device_type and dependencies of the parser are loaded,
+ *         1 if the file is missing, stale or invalid(parser holds no latency tables, XML file has to be parsed)
+ */
+int dlb_lip_compiled_config_load(
+    const char *path, const char *xml_path, dlb_lip_xml_parser_t *p_parser, uint32_t library_version);
+
+#endif
@@ -0,0 +1,81 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_config_fingerprint.h
+ *  @brief      Incremental fingerprint of a LIP config
+ *
+ *  Hash of a latency table is the sum of hashes of its (cell index, latency) pairs, so a changed cell updates it
+ *  in O(1). The fingerprint of the config passed to dlb_lip last tells which tables changed since, without
+ *  comparing the tables: tables with equal 64-bit hashes are taken as equal.
+ */
+
+#ifndef DLB_LIP_CONFIG_FINGERPRINT_H
+#define DLB_LIP_CONFIG_FINGERPRINT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dlb_lip.h"
+
+typedef enum dlb_lip_config_changes_e
+{
+    DLB_LIP_CONFIG_PARAMS_CHANGED = 1, /**< UUID, downstream device, transcoding or render mode */
+    DLB_LIP_CONFIG_AUDIO_CHANGED  = 2,
+    DLB_LIP_CONFIG_VIDEO_CHANGED  = 4
+} dlb_lip_config_changes_t;
+
+typedef struct dlb_lip_config_fingerprint_s
+{
+    uint32_t uuid;
+    uint64_t params; /**< Hash of the downstream device, transcoding and render mode params */
+    uint64_t audio;  /**< Hash of audio_latencies */
+    uint64_t video;  /**< Hash of video_latencies */
+} dlb_lip_config_fingerprint_t;
+
+/**
+ * @brief Computes fingerprint of the whole config
+ */
+void dlb_lip_config_fingerprint_init(dlb_lip_config_fingerprint_t *p_fingerprint, const dlb_lip_config_params_t *p_config);
+
+/**
+ * @brief Updates UUID and params hash after they were changed in the config
+ */
+void dlb_lip_config_fingerprint_update_params(
+    dlb_lip_config_fingerprint_t *p_fingerprint, const dlb_lip_config_params_t *p_config);
+
+/**
+ * @brief Sets audio latency of the format in the config and updates the audio hash
+ */
+void dlb_lip_config_fingerprint_set_audio_latency(
+    dlb_lip_config_fingerprint_t *p_fingerprint,
+    dlb_lip_config_params_t *     p_config,
+    const dlb_lip_audio_format_t *p_format,
+    uint8_t                       latency);
+
+/**
+ * @brief Sets video latency of the format in the config and updates the video hash
+ * @param hdr_mode Index of the hdr mode of the format, see dlb_lip_get_hdr_mode_from_video_format
+ */
+void dlb_lip_config_fingerprint_set_video_latency(
+    dlb_lip_config_fingerprint_t *p_fingerprint,
+    dlb_lip_config_params_t *     p_config,
+    const dlb_lip_video_format_t *p_format,
+    uint8_t                       hdr_mode,
+    uint8_t                       latency);
+
+/**
+ * @brief Compares configs by their fingerprints
+ * @return dlb_lip_config_changes_t flags of the parts with different hashes, 0 if the configs are equal
+ */
+unsigned int dlb_lip_config_fingerprint_compare(const dlb_lip_config_fingerprint_t *p_a, const dlb_lip_config_fingerprint_t *p_b);
+
+#endif
@@ -0,0 +1,54 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_config_watch.h
+ *  @brief      Watches XML config files for changes(inotify)
+ *
+ *  Directories of the files are watched, so files replaced by rename(as most editors save) are seen as well as files
+ *  written in place. A file is reported once no write to it was seen for DLB_LIP_CONFIG_WATCH_SETTLE_MS,
+ *  so a save made by several writes is reported once. Base and included files of a config are added to the watch
+ *  with the index of the config, so their changes are reported as changes of the config.
+ */
+
+#ifndef DLB_LIP_CONFIG_WATCH_H
+#define DLB_LIP_CONFIG_WATCH_H
+
+#define DLB_LIP_CONFIG_WATCH_MAX_FILES 64
+#define DLB_LIP_CONFIG_WATCH_SETTLE_MS 100
+
+/**
+ * @brief Called from the watch thread when a file changed
+ * @param index Index of the changed config in the paths passed to dlb_lip_config_watch_open
+ */
+typedef void (*dlb_lip_config_watch_callback_t)(void *arg, unsigned int index);
+
+/**
+ * @brief Starts watching the files
+ * @return 0 on success, 1 on error
+ */
+int dlb_lip_config_watch_open(const char *const *paths, unsigned int count, dlb_lip_config_watch_callback_t callback, void *arg);
+
+/**
+ * @brief Adds a file the config of the index depends on, files already watched for the index are ignored
+ *
+ * May be called from the callback.
+ *
+ * @return 0 on success, 1 on error
+ */
+int dlb_lip_config_watch_add(const char *path, unsigned int index);
+
+/**
+ * @brief Stops watching, waits for the running callback
+ */
+void dlb_lip_config_watch_close(void);
+
+#endif
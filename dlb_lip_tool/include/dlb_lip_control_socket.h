@@ -0,0 +1,61 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_control_socket.h
+ *  @brief      Unix-domain socket control interface
+ *
+ *  Each client sends one request per line: "<request_id> <command>".
+ *  Every request is answered with one JSON line:
+ *      {"id":"<request_id>","status":"ok|error|unknown|quit","output":"<command output>"}
+ *  Requests of one client are executed in order, requests of different clients are served concurrently
+ *  and serialized by the execute callback.
+ */
+
+#ifndef DLB_LIP_CONTROL_SOCKET_H
+#define DLB_LIP_CONTROL_SOCKET_H
+
+#include <stddef.h>
+
+#define DLB_LIP_CONTROL_MAX_CLIENTS 16
+#define DLB_LIP_CONTROL_MAX_REQUEST 512
+#define DLB_LIP_CONTROL_MAX_OUTPUT 4096
+
+typedef enum dlb_lip_control_status_e
+{
+    DLB_LIP_CONTROL_OK,
+    DLB_LIP_CONTROL_ERROR,
+    DLB_LIP_CONTROL_UNKNOWN,
+    DLB_LIP_CONTROL_QUIT /**< Client connection is closed after the response */
+} dlb_lip_control_status_t;
+
+/**
+ * @brief Executes single command, called from client threads.
+ * @param arg Argument passed to dlb_lip_control_socket_open.
+ * @param command Null terminated command.
+ * @param output Buffer for the command output.
+ * @param output_size Size of the output buffer.
+ */
+typedef dlb_lip_control_status_t (
+    *dlb_lip_control_execute_callback_t)(void *arg, const char *command, char *output, size_t output_size);
+
+/**
+ * @brief Starts listening for clients on a Unix-domain socket, existing socket file is replaced.
+ * @return 0 on success, 1 on error
+ */
+int dlb_lip_control_socket_open(const char *socket_path, dlb_lip_control_execute_callback_t execute, void *arg);
+
+/**
+ * @brief Disconnects all clients and removes the socket file
+ */
+void dlb_lip_control_socket_close(void);
+
+#endif
@@ -0,0 +1,134 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_latency_table.h
+ *  @brief      Sparse latency table of the device config
+ *
+ *  A latency table is an ordered list of rules, every rule gives latency of a block of cells: an index range in each
+ *  of the three dimensions(VIC, color format, hdr mode for video; codec, subtype, extension for audio). A wildcard is
+ *  the full range, so "VIC 96" is a default for all color formats and hdr modes of VIC 96 and "codec DDP" a default
+ *  for all its subtypes and extensions. Later rules override earlier ones, the same way later XML elements overwrite
+ *  latencies of earlier ones. A rule covering all cells of an earlier rule replaces it, so repeated updates of
+ *  the same cell keep one rule.
+ *
+ *  Configs populate a few dozen rules, the dense arrays of dlb_lip_config_params_t are written only when the table
+ *  is expanded for dlb_lip, by one block fill per rule. Rules are allocated as they are set, so a table takes memory
+ *  of its rules only and copies of the table are cheap. A table which doesn't fit in DLB_LIP_LATENCY_TABLE_MAX_RULES
+ *  rules falls back to an allocated dense array of its cells, so no valid input is rejected.
+ */
+
+#ifndef DLB_LIP_LATENCY_TABLE_H
+#define DLB_LIP_LATENCY_TABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dlb_lip_types.h"
+
+#define DLB_LIP_LATENCY_TABLE_MAX_RULES 1024
+#define DLB_LIP_LATENCY_TABLE_DIMENSIONS 3
+
+#define DLB_LIP_LATENCY_TABLE_VIDEO_CELLS (MAX_VICS * LIP_COLOR_FORMAT_COUNT * HDR_MODES_COUNT)
+#define DLB_LIP_LATENCY_TABLE_AUDIO_CELLS (IEC61937_AUDIO_CODECS * IEC61937_SUBTYPES * MAX_AUDIO_FORMAT_EXTENSIONS)
+#define DLB_LIP_LATENCY_TABLE_MAX_CELLS                                                                       \
+    (DLB_LIP_LATENCY_TABLE_VIDEO_CELLS > DLB_LIP_LATENCY_TABLE_AUDIO_CELLS ? DLB_LIP_LATENCY_TABLE_VIDEO_CELLS \
+                                                                             : DLB_LIP_LATENCY_TABLE_AUDIO_CELLS)
+
+typedef struct dlb_lip_latency_rule_s
+{
+    uint8_t first[DLB_LIP_LATENCY_TABLE_DIMENSIONS]; /**< First index of the block in each dimension */
+    uint8_t last[DLB_LIP_LATENCY_TABLE_DIMENSIONS];  /**< Last index of the block in each dimension */
+    uint8_t latency;
+} dlb_lip_latency_rule_t;
+
+typedef struct dlb_lip_latency_table_s
+{
+    uint8_t                 size[DLB_LIP_LATENCY_TABLE_DIMENSIONS]; /**< Dimensions of the dense array */
+    bool                    dense;                                  /**< Rules didn't fit, latencies are kept in cells */
+    unsigned int            rule_count;                             /**< Number of rules, 0 if dense */
+    unsigned int            rule_capacity;                          /**< Number of allocated rules */
+    dlb_lip_latency_rule_t *rules;                                  /**< NULL until the first rule is set */
+    uint8_t *               cells;                                  /**< Dense array[size0][size1][size2], NULL if not dense */
+} dlb_lip_latency_table_t;
+
+/**
+ * @brief Callback called for rules of the table
+ * @return 0 to continue, any other value stops the iteration and is returned by dlb_lip_latency_table_for_each_rule
+ */
+typedef int (*dlb_lip_latency_rule_callback_t)(void *arg, const dlb_lip_latency_rule_t *p_rule);
+
+/**
+ * @brief Initializes empty table of the dense array[size0][size1][size2]
+ *
+ * The dense array must not have more than DLB_LIP_LATENCY_TABLE_MAX_CELLS cells. Memory allocated by the table is freed
+ * by dlb_lip_latency_table_destroy.
+ */
+void dlb_lip_latency_table_init(dlb_lip_latency_table_t *p_table, uint8_t size0, uint8_t size1, uint8_t size2);
+
+/**
+ * @brief Frees rules and cells of the table, the table is left empty
+ */
+void dlb_lip_latency_table_destroy(dlb_lip_latency_table_t *p_table);
+
+/**
+ * @brief Replaces content of the initialized destination table by a copy of the table
+ * @return 0 on success, 1 if memory couldn't be allocated(destination is left empty)
+ */
+int dlb_lip_latency_table_copy(dlb_lip_latency_table_t *p_dst, const dlb_lip_latency_table_t *p_src);
+
+/**
+ * @brief Sets latency of the block of cells, overriding all earlier rules
+ * @return 0 on success, 1 if the range is invalid or memory couldn't be allocated
+ */
+int dlb_lip_latency_table_set(
+    dlb_lip_latency_table_t *p_table,
+    const uint8_t            first[DLB_LIP_LATENCY_TABLE_DIMENSIONS],
+    const uint8_t            last[DLB_LIP_LATENCY_TABLE_DIMENSIONS],
+    uint8_t                  latency);
+
+/**
+ * @brief Sets latency of one cell, overriding all earlier rules
+ * @return 0 on success, 1 if the cell is invalid or memory couldn't be allocated
+ */
+int dlb_lip_latency_table_set_cell(
+    dlb_lip_latency_table_t *p_table, uint8_t index0, uint8_t index1, uint8_t index2, uint8_t latency);
+
+/**
+ * @brief Returns latency of one cell, LIP_INVALID_LATENCY if no rule covers it
+ */
+uint8_t dlb_lip_latency_table_get(const dlb_lip_latency_table_t *p_table, uint8_t index0, uint8_t index1, uint8_t index2);
+
+/**
+ * @brief Checks if any cell of the block has latency
+ */
+bool dlb_lip_latency_table_intersects(
+    const dlb_lip_latency_table_t *p_table,
+    const uint8_t                  first[DLB_LIP_LATENCY_TABLE_DIMENSIONS],
+    const uint8_t                  last[DLB_LIP_LATENCY_TABLE_DIMENSIONS]);
+
+/**
+ * @brief Calls the callback for rules of the table in order, setting them to an empty table gives the same latencies
+ *
+ * Rules of a dense table are runs of cells with the same latency along the last dimension.
+ *
+ * @return 0 if all rules were passed, otherwise the value returned by the callback
+ */
+int dlb_lip_latency_table_for_each_rule(
+    const dlb_lip_latency_table_t *p_table, dlb_lip_latency_rule_callback_t callback, void *arg);
+
+/**
+ * @brief Writes all cells of the dense array, cells without rule are LIP_INVALID_LATENCY
+ * @param dense Array[size0][size1][size2], e.g. video_latencies of dlb_lip_config_params_t
+ */
+void dlb_lip_latency_table_expand(const dlb_lip_latency_table_t *p_table, uint8_t *dense);
+
+#endif
@@ -31,7 +31,16 @@ typedef enum dlb_lip_device_type_e
 } dlb_lip_device_type_t;
 
 /**
- * @brief Initialize CEC bus transport
+ * @brief CEC frame counters of the bus, frames handled internally(e.g. simulated ARC) included
+ */
+typedef struct dlb_cec_bus_stats_s
+{
+    unsigned long tx_frames;
+    unsigned long rx_frames;
+} dlb_cec_bus_stats_t;
+
+/**
+ * @brief Initialize CEC bus transport, every call creates separate libCEC connection
  * @return CEC bus interface or NULL
  */
 dlb_cec_bus_t *dlb_cec_bus_init(
@@ -45,6 +54,11 @@ dlb_cec_bus_t *dlb_cec_bus_init(
 /**
  * @brief Destroy cec bus transport
  */
-void dlb_cec_bus_destroy(void);
+void dlb_cec_bus_destroy(dlb_cec_bus_t *cec_bus);
 
-int dlb_cec_poll_device(cec_logical_address downstream_device);
+int dlb_cec_poll_device(dlb_cec_bus_t *cec_bus, cec_logical_address downstream_device);
+
+/**
+ * @brief Get number of CEC frames transmitted and received since dlb_cec_bus_init
+ */
+void dlb_cec_bus_get_stats(const dlb_cec_bus_t *cec_bus, dlb_cec_bus_stats_t *const stats);
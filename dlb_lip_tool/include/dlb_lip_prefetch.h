@@ -0,0 +1,107 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_prefetch.h
+ *  @brief      Speculative latency queries issued when a downstream device connects
+ *
+ *  Every emulated device has its own prefetch thread. When triggered(downstream device connected or its UUID changed)
+ *  the thread issues queries of the configured formats followed by the most often requested formats of the history,
+ *  one query at a time and only while no CEC frames are seen on the bus. A new trigger restarts the list.
+ *
+ *  Formats are packed queries, opaque for this module. The history counts formats requested by the user, it is shared
+ *  by all devices and can be kept in a file between runs.
+ */
+
+#ifndef DLB_LIP_PREFETCH_H
+#define DLB_LIP_PREFETCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dlb_lip_tool_osa.h"
+
+#define DLB_LIP_PREFETCH_MAX_FORMATS 64
+#define DLB_LIP_PREFETCH_HISTORY_SIZE 256
+#define DLB_LIP_PREFETCH_DEFAULT_LEARNED 8
+#define DLB_LIP_PREFETCH_IDLE_MS 100 // Bus is idle when no frame was sent or received for this time
+
+typedef struct dlb_lip_prefetch_callbacks_s
+{
+    void *arg;
+    /** @brief Returns number of CEC frames sent and received by the device so far */
+    unsigned long (*bus_frames_callback)(void *arg);
+    /** @brief Issues query of the format, returns 0 on success */
+    int (*query_callback)(void *arg, uint64_t format);
+    /** @brief Called when all formats of the list were queried */
+    void (*done_callback)(void *arg, unsigned int succeeded, unsigned int count);
+} dlb_lip_prefetch_callbacks_t;
+
+typedef struct dlb_lip_prefetch_s
+{
+    dlb_lip_tool_mutex_t         mutex;
+    dlb_lip_tool_cond_t          cond;
+    dlb_lip_tool_thread_t        thread;
+    bool                         started;
+    bool                         running;
+    bool                         triggered;
+    const uint64_t *             formats;
+    unsigned int                 format_count;
+    unsigned int                 learned_count;
+    dlb_lip_prefetch_callbacks_t callbacks;
+} dlb_lip_prefetch_t;
+
+/**
+ * @brief Opens the history shared by all devices
+ * @param path History file loaded now and written by dlb_lip_prefetch_history_close, NULL or empty to keep it in memory only
+ * @return number of loaded formats, -1 if the file couldn't be read(history starts empty)
+ */
+int dlb_lip_prefetch_history_open(const char *path);
+
+/**
+ * @brief Writes the history file
+ */
+void dlb_lip_prefetch_history_close(void);
+
+/**
+ * @brief Counts one request of the format by the user
+ */
+void dlb_lip_prefetch_learn(uint64_t format);
+
+/**
+ * @brief Initializes the engine, can be triggered before it is started
+ * @param formats Formats always prefetched first, must stay valid until the engine is stopped
+ * @param learned_count Number of most often requested formats of the history prefetched after them
+ */
+void dlb_lip_prefetch_init(
+    dlb_lip_prefetch_t *                p_prefetch,
+    const uint64_t *                    formats,
+    unsigned int                        format_count,
+    unsigned int                        learned_count,
+    const dlb_lip_prefetch_callbacks_t *p_callbacks);
+
+/**
+ * @brief Starts the prefetch thread, nothing is started if there is nothing to prefetch
+ * @return 0 on success, 1 on error
+ */
+int dlb_lip_prefetch_start(dlb_lip_prefetch_t *p_prefetch);
+
+/**
+ * @brief Requests prefetch of all formats, called when downstream device connects or its UUID changes
+ */
+void dlb_lip_prefetch_trigger(dlb_lip_prefetch_t *p_prefetch);
+
+/**
+ * @brief Stops the prefetch thread, waits for the running query
+ */
+void dlb_lip_prefetch_stop(dlb_lip_prefetch_t *p_prefetch);
+
+#endif
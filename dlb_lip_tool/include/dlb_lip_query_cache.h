@@ -0,0 +1,82 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_query_cache.h
+ *  @brief      Latency query results cached by the tool in front of dlb_lip
+ *
+ *  Results are memoized per downstream device, i.e. keyed by downstream UUID and packed query: all entries are dropped
+ *  when the downstream UUID changes or the downstream device disconnects. A latency change of the downstream device
+ *  always changes its UUID, so latencies never expire. Negative results(LIP_INVALID_LATENCY) expire after
+ *  the configured TTL, so a format the downstream device doesn't support is asked on the bus at most once per TTL.
+ *  Each key can be stored in one of DLB_LIP_QUERY_CACHE_PROBES slots, lookups and inserts never scan
+ *  more than that.
+ */
+
+#ifndef DLB_LIP_QUERY_CACHE_H
+#define DLB_LIP_QUERY_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dlb_lip_tool_osa.h"
+
+#define DLB_LIP_QUERY_CACHE_SIZE 4096 // Power of 2, holds a full sweep of audio or video formats
+#define DLB_LIP_QUERY_CACHE_PROBES 8
+#define DLB_LIP_QUERY_CACHE_DEFAULT_NEGATIVE_TTL_MS 10000
+
+typedef struct dlb_lip_query_cache_entry_s
+{
+    uint64_t           key;        /**< Packed query, 0 for free slot */
+    uint32_t           generation; /**< Generation of the downstream device the result belongs to */
+    uint8_t            audio_latency;
+    uint8_t            video_latency;
+    unsigned long long expire_us; /**< Expiry time of negative result, 0 if the result doesn't expire */
+} dlb_lip_query_cache_entry_t;
+
+typedef struct dlb_lip_query_cache_s
+{
+    dlb_lip_tool_mutex_t        mutex;
+    unsigned int                negative_ttl_ms; /**< 0 disables caching of negative results */
+    bool                        uuid_valid;
+    uint32_t                    uuid;
+    uint32_t                    generation; /**< Bumped on every downstream UUID change */
+    dlb_lip_query_cache_entry_t entries[DLB_LIP_QUERY_CACHE_SIZE];
+} dlb_lip_query_cache_t;
+
+/**
+ * @brief Initializes empty cache
+ */
+void dlb_lip_query_cache_init(dlb_lip_query_cache_t *p_cache, unsigned int negative_ttl_ms);
+
+void dlb_lip_query_cache_destroy(dlb_lip_query_cache_t *p_cache);
+
+/**
+ * @brief Updates the downstream device, all cached results are dropped if the UUID changed or the device disconnected
+ */
+void dlb_lip_query_cache_set_downstream(dlb_lip_query_cache_t *p_cache, bool uuid_valid, uint32_t uuid);
+
+/**
+ * @brief Looks up cached result of the query
+ * @param p_generation Generation to pass to dlb_lip_query_cache_insert when the query is sent to dlb_lip
+ * @return true on hit, latencies are set
+ */
+bool dlb_lip_query_cache_lookup(
+    dlb_lip_query_cache_t *p_cache, uint64_t key, uint32_t *p_generation, uint8_t *p_audio_latency, uint8_t *p_video_latency);
+
+/**
+ * @brief Stores result of the query, ignored if the downstream device changed since the lookup
+ * @param negative Latency of the query is LIP_INVALID_LATENCY, result expires after negative TTL
+ */
+void dlb_lip_query_cache_insert(
+    dlb_lip_query_cache_t *p_cache, uint32_t generation, uint64_t key, uint8_t audio_latency, uint8_t video_latency, bool negative);
+
+#endif
@@ -0,0 +1,107 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_script.h
+ *  @brief      Command script preprocessor - loops, variables and arithmetic
+ *
+ *  Expands command lines read from a command source:
+ *      set <var> = <expr>                          - assign variable
+ *      repeat <count> [<var>] {                    - repeat block <count> times, <var> counts from 0
+ *      for <var> in <first>..<last> [step <n>] {   - iterate <var> over range
+ *      }                                           - close block
+ *      ${<expr>}                                   - substituted with value of arithmetic expression
+ *      # comment                                   - ignored
+ *  Blocks are buffered and executed in place, commands are expanded one at a time.
+ */
+
+#ifndef DLB_LIP_SCRIPT_H
+#define DLB_LIP_SCRIPT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define DLB_LIP_SCRIPT_MAX_LINE 256
+#define DLB_LIP_SCRIPT_MAX_VARIABLES 32
+#define DLB_LIP_SCRIPT_MAX_VARIABLE_NAME 32
+#define DLB_LIP_SCRIPT_MAX_DEPTH 16
+
+/**
+ * @brief Reads next line from command source, fgets like.
+ * @return line or NULL when no more lines are available
+ */
+typedef char *(*dlb_lip_script_line_callback_t)(void *p_context, char *line, int size);
+
+typedef struct dlb_lip_script_variable_s
+{
+    char      name[DLB_LIP_SCRIPT_MAX_VARIABLE_NAME];
+    long long value;
+} dlb_lip_script_variable_t;
+
+typedef struct dlb_lip_script_frame_s
+{
+    char **      lines;      /**< Block lines, shared with nested frames */
+    unsigned int line_count; /**< Number of lines, valid if owns_lines is set */
+    bool         owns_lines; /**< Lines are freed when frame finishes */
+    unsigned int begin;      /**< First line of the block body */
+    unsigned int end;        /**< One past last line of the block body */
+    unsigned int pc;         /**< Next line to execute */
+    int          variable;   /**< Loop variable index or -1 */
+    long long    value;      /**< Current loop value */
+    long long    last;       /**< Last loop value */
+    long long    step;       /**< Loop step */
+} dlb_lip_script_frame_t;
+
+typedef struct dlb_lip_script_s
+{
+    dlb_lip_script_variable_t variables[DLB_LIP_SCRIPT_MAX_VARIABLES];
+    unsigned int              variable_count;
+
+    dlb_lip_script_frame_t frames[DLB_LIP_SCRIPT_MAX_DEPTH];
+    unsigned int           depth;
+
+    /* Block being read from the command source */
+    char **      collect_lines;
+    unsigned int collect_count;
+    unsigned int collect_capacity;
+    unsigned int collect_depth;
+
+    char source_line[DLB_LIP_SCRIPT_MAX_LINE];
+} dlb_lip_script_t;
+
+/**
+ * @brief Initializes script preprocessor state
+ */
+void dlb_lip_script_init(dlb_lip_script_t *p_script);
+
+/**
+ * @brief Releases buffered blocks
+ */
+void dlb_lip_script_destroy(dlb_lip_script_t *p_script);
+
+/**
+ * @brief Produces next expanded command.
+ * @param p_script Script state.
+ * @param command Output buffer for the command, new line characters stripped.
+ * @param size Size of the output buffer.
+ * @param line_callback Reads next line from the command source.
+ * @param p_context Passed to line_callback.
+ * @return 1 if command was produced, 0 if command source has no more lines, -1 on script error(also when the command
+ *         source ends inside a block).
+ */
+int dlb_lip_script_next_command(
+    dlb_lip_script_t *             p_script,
+    char *                         command,
+    size_t                         size,
+    dlb_lip_script_line_callback_t line_callback,
+    void *                         p_context);
+
+#endif
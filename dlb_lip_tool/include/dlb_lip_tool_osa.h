@@ -0,0 +1,85 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_tool_osa.h
+ *  @brief      Threads and synchronization primitives used by the LIP tool
+ */
+
+#ifndef DLB_LIP_TOOL_OSA_H
+#define DLB_LIP_TOOL_OSA_H
+
+#include <stdbool.h>
+
+#if defined(_MSC_VER)
+#include <Windows.h>
+
+typedef HANDLE             dlb_lip_tool_thread_t;
+typedef CRITICAL_SECTION   dlb_lip_tool_mutex_t;
+typedef CONDITION_VARIABLE dlb_lip_tool_cond_t;
+typedef INIT_ONCE          dlb_lip_tool_once_t;
+
+#define DLB_LIP_TOOL_ONCE_INIT INIT_ONCE_STATIC_INIT
+#define DLB_LIP_TOOL_THREAD_LOCAL __declspec(thread)
+#else
+#include <pthread.h>
+
+typedef pthread_t       dlb_lip_tool_thread_t;
+typedef pthread_mutex_t dlb_lip_tool_mutex_t;
+typedef pthread_cond_t  dlb_lip_tool_cond_t;
+typedef pthread_once_t  dlb_lip_tool_once_t;
+
+#define DLB_LIP_TOOL_ONCE_INIT PTHREAD_ONCE_INIT
+#define DLB_LIP_TOOL_THREAD_LOCAL __thread
+#endif
+
+typedef void (*dlb_lip_tool_thread_func_t)(void *arg);
+
+/**
+ * @brief Starts new thread executing func(arg)
+ * @return 0 on success, 1 on error
+ */
+int dlb_lip_tool_thread_create(dlb_lip_tool_thread_t *p_thread, dlb_lip_tool_thread_func_t func, void *arg);
+
+/**
+ * @brief Waits for the thread to finish
+ */
+void dlb_lip_tool_thread_join(dlb_lip_tool_thread_t *p_thread);
+
+void dlb_lip_tool_mutex_init(dlb_lip_tool_mutex_t *p_mutex);
+void dlb_lip_tool_mutex_lock(dlb_lip_tool_mutex_t *p_mutex);
+void dlb_lip_tool_mutex_unlock(dlb_lip_tool_mutex_t *p_mutex);
+void dlb_lip_tool_mutex_destroy(dlb_lip_tool_mutex_t *p_mutex);
+
+void dlb_lip_tool_cond_init(dlb_lip_tool_cond_t *p_cond);
+void dlb_lip_tool_cond_wait(dlb_lip_tool_cond_t *p_cond, dlb_lip_tool_mutex_t *p_mutex);
+
+/**
+ * @brief Waits for the condition at most timeout_ms
+ * @return true if signaled, false on timeout
+ */
+bool dlb_lip_tool_cond_timedwait(dlb_lip_tool_cond_t *p_cond, dlb_lip_tool_mutex_t *p_mutex, unsigned int timeout_ms);
+void dlb_lip_tool_cond_signal(dlb_lip_tool_cond_t *p_cond);
+void dlb_lip_tool_cond_broadcast(dlb_lip_tool_cond_t *p_cond);
+void dlb_lip_tool_cond_destroy(dlb_lip_tool_cond_t *p_cond);
+
+/**
+ * @brief Calls func once for the once object initialized to DLB_LIP_TOOL_ONCE_INIT, other callers wait until it returned
+ */
+void dlb_lip_tool_once(dlb_lip_tool_once_t *p_once, void (*func)(void));
+
+/**
+ * @brief Reads monotonic clock
+ * @return time in microseconds
+ */
+unsigned long long dlb_lip_tool_time_us(void);
+
+#endif
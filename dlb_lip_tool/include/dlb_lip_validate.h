@@ -0,0 +1,65 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_validate.h
+ *  @brief      Validation of XML config files on a thread pool
+ *
+ *  Files are parsed like by the tool at startup(topology files like by --topology), but no CEC adapter or LIP
+ *  instance is opened. Every thread parses one file at a time and keeps its own base and included files.
+ */
+
+#ifndef DLB_LIP_VALIDATE_H
+#define DLB_LIP_VALIDATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dlb_lip_xml_parser.h"
+
+#define DLB_LIP_VALIDATE_MAX_THREADS 64
+
+/**
+ *  Result of one validated file
+ */
+typedef struct dlb_lip_validate_result_s
+{
+    char *       path;
+    bool         valid;
+    unsigned int devices;            /**< Number of devices of a topology file, 1 for a config file */
+    unsigned int overwrite_elements; /**< Elements which overwrote different earlier latencies */
+    unsigned int overwritten_cells;
+    char         first_overwrite[256];
+    uint64_t     fingerprint; /**< FNV-1a of the expanded configs, equal for files describing the same devices */
+} dlb_lip_validate_result_t;
+
+/**
+ * @brief Validates XML files, directories are searched recursively for *.xml files
+ * @param threads Number of parsing threads, 0 for number of processors
+ * @param fail_on_overwrite Overwrites are errors, see dlb_lip_xml_diagnostics_t
+ * @param pp_results Results sorted by path, freed by dlb_lip_validate_free
+ * @param p_result_count Number of results
+ * @return 0 on success(results may be invalid files), 1 if a path can't be read or on allocation error
+ */
+int dlb_lip_validate_configs(
+    const char *const *         paths,
+    unsigned int                path_count,
+    unsigned int                threads,
+    bool                        fail_on_overwrite,
+    dlb_lip_validate_result_t **pp_results,
+    unsigned int *              p_result_count);
+
+/**
+ * @brief Frees results of dlb_lip_validate_configs
+ */
+void dlb_lip_validate_free(dlb_lip_validate_result_t *p_results, unsigned int result_count);
+
+#endif
@@ -0,0 +1,69 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_vocabulary.h
+ *  @brief      Names of LIP formats and device params used by XML configs and commands
+ *
+ *  Every name is listed once in dlb_lip_vocabulary.c, name arrays and the hash table of all names are generated
+ *  from the lists. Names are case sensitive and matched exactly.
+ */
+
+#ifndef DLB_LIP_VOCABULARY_H
+#define DLB_LIP_VOCABULARY_H
+
+#include "dlb_lip.h"
+#include "dlb_lip_libcec_bus.h" // for dlb_lip_device_type_t
+
+typedef enum dlb_lip_vocabulary_kind_e
+{
+    DLB_LIP_VOCABULARY_CODEC,        /**< dlb_lip_audio_codec_t */
+    DLB_LIP_VOCABULARY_COLOR_FORMAT, /**< dlb_lip_color_format_type_t */
+    DLB_LIP_VOCABULARY_HDR_STATIC,   /**< dlb_lip_hdr_static_t */
+    DLB_LIP_VOCABULARY_HDR_DYNAMIC,  /**< dlb_lip_hdr_dynamic_t */
+    DLB_LIP_VOCABULARY_DOLBY_VISION, /**< dlb_lip_dolby_vision_t */
+    DLB_LIP_VOCABULARY_DEVICE_TYPE,  /**< dlb_lip_device_type_t */
+    DLB_LIP_VOCABULARY_RENDERER,     /**< LIP_AUDIO_RENDERER and LIP_VIDEO_RENDERER flags */
+    DLB_LIP_VOCABULARY_KINDS
+} dlb_lip_vocabulary_kind_t;
+
+/**
+ * @brief Builds the hash table of names
+ *
+ * Optional, otherwise the table is built by the first lookup. Safe to call from several threads.
+ */
+void dlb_lip_vocabulary_init(void);
+
+/**
+ * @brief Finds value of the name
+ * @return value, -1 if the name is NULL or not a name of the kind
+ */
+int dlb_lip_vocabulary_lookup(dlb_lip_vocabulary_kind_t kind, const char *name);
+
+/**
+ * @brief Returns name of the value
+ * @return null terminated name, NULL if the value has no name
+ */
+const char *dlb_lip_vocabulary_name(dlb_lip_vocabulary_kind_t kind, int value);
+
+/**
+ * @brief Returns names of all values of the kind, indexed by value(entries of values without name are NULL)
+ * @param p_count Set to number of entries
+ */
+const char *const *dlb_lip_vocabulary_names(dlb_lip_vocabulary_kind_t kind, unsigned int *p_count);
+
+/**
+ * @brief Returns kind of hdr mode names of the color format
+ * @return kind, DLB_LIP_VOCABULARY_KINDS for invalid color format
+ */
+dlb_lip_vocabulary_kind_t dlb_lip_vocabulary_hdr_kind(dlb_lip_color_format_type_t color_format);
+
+#endif
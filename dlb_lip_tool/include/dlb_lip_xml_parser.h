@@ -21,36 +21,199 @@
 
 #include <stdbool.h>
 #include "dlb_lip.h"            // for dlb_lip_config_params_t
+#include "dlb_lip_latency_table.h"
 #include "dlb_lip_libcec_bus.h" // for dlb_lip_device_type_t
 
 #define MAX_XML_LINE 4096
+#define MAX_XML_INDEX_RANGES 64
+#define MAX_XML_OVERWRITES 8
+#define MAX_XML_TOPOLOGY_DEVICES 8
+#define MAX_XML_NAME 32
+#define MAX_XML_PATH 1024
+#define MAX_XML_INCLUDE_DEPTH 8
+#define MAX_XML_FRAGMENTS 64
+#define MAX_XML_DEPENDENCIES 32
+
+/**
+ *  Index ranges of a VIC, subtype or ext attribute, e.g. VIC="1-64,96-107"
+ */
+typedef struct dlb_lip_xml_index_ranges_s
+{
+    unsigned int count; /**< 0 if the attribute is not given, all indexes are selected */
+    uint8_t      first[MAX_XML_INDEX_RANGES];
+    uint8_t      last[MAX_XML_INDEX_RANGES];
+} dlb_lip_xml_index_ranges_t;
 
 typedef struct dlb_lip_xml_cache_s
 {
-    bool                   vid_latency_opened;
-    bool                   aud_latency_opened;
-    dlb_lip_video_format_t video_format;
-    dlb_lip_audio_format_t audio_format;
+    bool                       vid_latency_opened;
+    bool                       aud_latency_opened;
+    dlb_lip_video_format_t     video_format; // vic is not used, see vic_ranges
+    dlb_lip_audio_format_t     audio_format; // subtype and ext are not used, see subtype_ranges and ext_ranges
+    dlb_lip_xml_index_ranges_t vic_ranges;
+    dlb_lip_xml_index_ranges_t subtype_ranges;
+    dlb_lip_xml_index_ranges_t ext_ranges;
 } dlb_lip_xml_cache_t;
 
+/**
+ *  Cells of earlier latency rules with one value overwritten by the current latency element
+ */
+typedef struct dlb_lip_xml_overwrite_s
+{
+    uint8_t      latency; /**< Overwritten value */
+    uint8_t      first[DLB_LIP_LATENCY_TABLE_DIMENSIONS]; /**< Bounds of the overwritten cells */
+    uint8_t      last[DLB_LIP_LATENCY_TABLE_DIMENSIONS];
+    unsigned int cells;
+} dlb_lip_xml_overwrite_t;
+
+/**
+ *  Latency overwrites of the parsed file. Overwrites of one element are collected per overwritten value
+ *  and reported in one line when the element is closed.
+ */
+typedef struct dlb_lip_xml_diagnostics_s
+{
+    bool                    fail_on_overwrite;  /**< Overwriting a different earlier latency is a parsing error */
+    bool                    quiet;              /**< Overwrites are not printed, only counted and kept in first_overwrite */
+    unsigned int            line;               /**< Line of the XML file being parsed */
+    unsigned int            overwrite_elements; /**< Latency elements which overwrote earlier latencies */
+    unsigned int            overwritten_cells;
+    dlb_lip_xml_overwrite_t overwrites[MAX_XML_OVERWRITES]; /**< Of the current element */
+    unsigned int            overwrite_count;
+    unsigned int            other_cells; /**< Cells of the current element with values not fitting in overwrites */
+    char                    first_overwrite[256]; /**< Report of the first element which overwrote latencies */
+} dlb_lip_xml_diagnostics_t;
+
+/**
+ *  File read by the parser, with its modification time and size when it was read
+ */
+typedef struct dlb_lip_xml_dependency_s
+{
+    char    path[MAX_XML_PATH];
+    int64_t mtime; /**< Nanoseconds since the epoch */
+    int64_t size;
+} dlb_lip_xml_dependency_t;
+
 typedef struct dlb_lip_xml_parser_s
 {
-    FILE *config_file;
-    char  xml_line[MAX_XML_LINE];
+    FILE *       config_file;
+    char         xml_line[MAX_XML_LINE];
+    char         file_name[MAX_XML_PATH]; /**< Included files and base files are relative to its directory */
+    unsigned int include_depth;
 
     dlb_lip_xml_cache_t     xml_cache;
-    dlb_lip_config_params_t config_params;
+    dlb_lip_config_params_t config_params;   /**< Latency arrays are written by dlb_lip_xml_parser_expand_latencies */
+    dlb_lip_latency_table_t video_latencies; /**< [VIC][color format][hdr mode] */
+    dlb_lip_latency_table_t audio_latencies; /**< [codec][subtype][ext] */
     uint16_t                physical_address;
     dlb_lip_device_type_t   device_type;
+
+    dlb_lip_xml_diagnostics_t diagnostics;
+
+    dlb_lip_xml_dependency_t dependencies[MAX_XML_DEPENDENCIES]; /**< Parsed file, its base and included files */
+    unsigned int             dependency_count;
 } dlb_lip_xml_parser_t;
 
+/**
+ *  Device of a topology file, with the command line options of the device given by its attributes
+ */
+typedef struct dlb_lip_xml_topology_device_s
+{
+    char                 name[MAX_XML_NAME];
+    char                 port_name[MAX_XML_PATH];
+    char                 commands_file_name[MAX_XML_PATH];
+    char                 state_file_name[MAX_XML_PATH];
+    bool                 sim_arc;
+    dlb_lip_xml_parser_t parser; /**< Config of the device, latencies are expanded */
+} dlb_lip_xml_topology_device_t;
+
+/**
+ *  HDMI link of a topology file, device named "to" is the downstream device of device named "from"
+ */
+typedef struct dlb_lip_xml_topology_link_s
+{
+    char from[MAX_XML_NAME];
+    char to[MAX_XML_NAME];
+} dlb_lip_xml_topology_link_t;
+
+/**
+ *  Topology file describing all devices of the HDMI cluster and links between them
+ */
+typedef struct dlb_lip_xml_topology_s
+{
+    FILE *       config_file;
+    char         xml_line[MAX_XML_LINE];
+    char         file_name[MAX_XML_PATH];
+    unsigned int line;
+    bool         fail_on_overwrite; /**< Set by the caller, see dlb_lip_xml_diagnostics_t */
+    bool         quiet;             /**< Set by the caller, see dlb_lip_xml_diagnostics_t */
+
+    dlb_lip_xml_topology_device_t devices[MAX_XML_TOPOLOGY_DEVICES];
+    unsigned int                  device_count;
+    bool                          device_opened; /**< Elements belong to the last device */
+    dlb_lip_xml_topology_link_t   links[MAX_XML_TOPOLOGY_DEVICES];
+    unsigned int                  link_count;
+} dlb_lip_xml_topology_t;
+
+/**
+ * @brief Sets default device params, empty latency tables, clears diagnostics(fail_on_overwrite is false) and dependencies
+ *
+ * The parser must not hold latency tables, tables of a used parser are freed by dlb_lip_xml_parser_destroy first.
+ */
+void dlb_lip_xml_parser_init(dlb_lip_xml_parser_t *p_parser);
+
+/**
+ * @brief Frees latency tables of the parser
+ */
+void dlb_lip_xml_parser_destroy(dlb_lip_xml_parser_t *p_parser);
+
+/**
+ * @brief Copies the parsed config to the destination parser, which must not hold latency tables
+ * @return 0 on success, 1 if memory couldn't be allocated(destination holds no latency tables)
+ */
+int dlb_lip_xml_parser_copy(dlb_lip_xml_parser_t *p_dst, const dlb_lip_xml_parser_t *p_src);
+
+/**
+ * @brief Writes latency tables of the parser to the dense latency arrays of config_params
+ */
+void dlb_lip_xml_parser_expand_latencies(dlb_lip_xml_parser_t *p_parser);
+
 /**
  * @brief Parses input XML file with LIP device config parameters.
+ * Latencies are stored in the latency tables, config_params arrays are not changed.
+ * base="file" attribute of the root element starts the config from DeviceParams and latencies of the base file,
+ * <Include file="file"/> adds latencies of the included file at its position(DeviceParams of the file are ignored).
+ * Base and included files are parsed once per thread and kept until they or their own base and included files change
+ * on disk, see dlb_lip_xml_fragments_clear. The parsed file, its base and included files at any depth are recorded
+ * in dependencies. Parsers used by different threads are independent.
  * @return 0 if parsed correctly, 1 if error occured.
  */
 
 int parse_xml_config_file(dlb_lip_xml_parser_t *p_parser, const char *p_config_file_name);
 
+/**
+ * @brief Sets path, modification time and size of the file
+ * @return 0 on success, 1 if the file doesn't exist
+ */
+int dlb_lip_xml_dependency_stat(dlb_lip_xml_dependency_t *p_dependency, const char *path);
+
+/**
+ * @brief Frees base and included files kept by parse_xml_config_file on the calling thread
+ */
+void dlb_lip_xml_fragments_clear(void);
+
+/**
+ * @brief Parses topology file with configs of all devices of the cluster and links between them.
+ * Every Device element holds the elements of a device config file, latencies of all devices are expanded.
+ * LogicalAddressMap of a device linked to a downstream device is the logical address of the downstream device type.
+ * @return 0 if parsed correctly, 1 if error occured.
+ */
+int parse_xml_topology_file(dlb_lip_xml_topology_t *p_topology, const char *p_topology_file_name);
+
+/**
+ * @brief Frees latency tables of all devices of the parsed topology, also after a parsing error
+ */
+void dlb_lip_xml_topology_destroy(dlb_lip_xml_topology_t *p_topology);
+
 /**
  * @brief Translates codec name to dlb_lip_audio_codec_t
  * @param codec_str Null terminated codec name string.
@@ -58,4 +221,21 @@ int parse_xml_config_file(dlb_lip_xml_parser_t *p_parser, const char *p_config_f
  */
 dlb_lip_audio_codec_t get_codec_type_from_str(const char *const codec_str);
 
+/**
+ * @brief Translates dlb_lip_audio_codec_t to codec name
+ * @param codec one of dlb_lip_audio_codec_t value.
+ * @return Null terminated codec name string or NULL for unknown codec.
+ */
+const char *get_codec_str_from_type(const dlb_lip_audio_codec_t codec);
+
+/**
+ * @brief Parses list of indexes and index ranges, e.g. "1-64,96,98-107" or "*" for all indexes
+ * @param list_str Null terminated list string.
+ * @param min Lowest valid index.
+ * @param max Number of entries in mask, indexes must be lower than max.
+ * @param mask Set to true for every listed index, false otherwise.
+ * @return 0 if parsed correctly, 1 if error occured.
+ */
+int parse_index_list(const char *const list_str, const unsigned int min, const unsigned int max, bool *const mask);
+
 #endif
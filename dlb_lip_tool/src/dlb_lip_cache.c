@@ -0,0 +1,2580 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_cache.c
+ *  @brief      Persistent storage of dlb_lip cache blobs
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dlb_lip_cache.h"
+#include "dlb_lip_tool_osa.h"
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+
+#if defined(_MSC_VER)
+#include <direct.h>
+#include <io.h>
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define CACHE_PATH_SIZE 1024
+#define CACHE_FILE_NAME_SIZE (CACHE_PATH_SIZE + 32)
+
+#define CACHE_RECORD_MAGIC 0x5243494CU // "LICR"
+#define CRC32C_POLYNOMIAL 0x82F63B78U  // Reflected Castagnoli polynomial
+
+#define STORE_MAGIC 0x5350494CU // "LIPS"
+#define STORE_VERSION 2U
+#define STORE_HEADER_SIZE 64U
+#define STORE_MIN_SLOTS 16U
+#define STORE_SLOT_ALIGN 64U
+#define STORE_EMPTY_INDEX 0xFFFFFFFFU
+
+#define SHM_MAGIC 0x4D48534CU // "LSHM"
+#define SHM_VERSION 1U
+#define SHM_HEADER_SIZE 64U
+#define SHM_DEFAULT_SLOTS 64U
+#define SHM_DEFAULT_SLOT_SIZE 16384U
+#define SHM_READ_RETRIES 1000U
+#define SHM_OPEN_TIMEOUT_MS 1000U
+
+#define ARCHIVE_MAGIC "LICA"
+#define ARCHIVE_VERSION 1U
+#define ARCHIVE_HEADER_SIZE 16U
+#define ARCHIVE_ENTRY_HEADER_SIZE 12U
+#define ARCHIVE_MAX_BLOB_SIZE (16U << 20) // Sanity limit, blobs of dlb_lip are a few KiB
+
+typedef struct cache_entry_s
+{
+    uint32_t              uuid;
+    unsigned int          size;
+    unsigned char *       data;
+    struct cache_entry_s *next;
+} cache_entry_t;
+
+/**
+ *  Every cache file, queued store and store slot holds a record: cache_record_header_t followed by the blob.
+ */
+typedef struct cache_record_header_s
+{
+    uint32_t magic;
+    uint32_t library_version;
+    uint32_t size; // Blob size
+    uint32_t crc;  // CRC32C of the blob
+} cache_record_header_t;
+
+typedef struct cache_settings_s
+{
+    char     directory[CACHE_PATH_SIZE]; // Empty or ends with path separator
+    uint64_t max_size;                   // 0 - no limit
+    uint32_t max_entries;                // 0 - no limit
+    uint32_t library_version;
+} cache_settings_t;
+
+static cache_settings_t settings = { { 0 }, 0, 0, 0 };
+
+static uint32_t crc32c_table[256];
+
+typedef struct cache_lru_entry_s
+{
+    uint32_t uuid;
+    uint32_t size;
+    uint64_t last_use;
+} cache_lru_entry_t;
+
+/**
+ *  Usage order of cache files, tracked only if there is a size or entry limit.
+ */
+typedef struct cache_lru_s
+{
+    bool               enabled;
+    cache_lru_entry_t *entries;
+    uint32_t           count;
+    uint32_t           capacity;
+    uint64_t           total_size;
+    uint64_t           clock;
+} cache_lru_t;
+
+/**
+ *  Validated blobs of all cache files, hash table of UUIDs with open addressing. Filled by the warm start
+ *  and kept up to date by stores and evictions, reads of cache files are served from it.
+ */
+typedef struct cache_ram_entry_s
+{
+    uint32_t       uuid;
+    uint32_t       size;
+    unsigned char *blob; // NULL for empty position
+} cache_ram_entry_t;
+
+typedef struct cache_ram_s
+{
+    cache_ram_entry_t *entries;
+    uint32_t           capacity; // Power of two
+    uint32_t           count;
+} cache_ram_t;
+
+/**
+ *  Entries with NULL data are queued removals of evicted cache files.
+ */
+typedef struct cache_persister_s
+{
+    bool                  open;
+    bool                  running;
+    dlb_lip_tool_mutex_t  mutex; // Protects the queue, lru and ram
+    dlb_lip_tool_cond_t   cond;
+    dlb_lip_tool_thread_t thread;
+    cache_entry_t *       head;
+    cache_entry_t *       tail;
+    cache_entry_t *       writing; // Entry being written by the background thread, still valid for reads
+    cache_lru_t           lru;
+    cache_ram_t           ram;
+} cache_persister_t;
+
+static cache_persister_t persister = { 0 };
+
+/**
+ *  Warm start runs on its own thread while the tool parses XML files and opens CEC adapters.
+ *  Cache files are loaded into ram, store slots are validated. Reads and stores wait until it is done.
+ */
+typedef struct cache_warm_s
+{
+    bool                  started;
+    bool                  ready;
+    bool                  threaded;
+    int                   loaded;
+    dlb_lip_tool_mutex_t  mutex;
+    dlb_lip_tool_cond_t   cond;
+    dlb_lip_tool_thread_t thread;
+} cache_warm_t;
+
+static cache_warm_t warm = { 0 };
+
+/**
+ *  Store file layout: store_header_t padded to STORE_HEADER_SIZE followed by slot_count slots,
+ *  every slot is store_slot_header_t followed by slot_size bytes of the blob.
+ */
+typedef struct store_header_s
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_size;
+    uint32_t slot_count;
+    uint32_t use_clock; // Incremented on every read hit and write, stamped to last_use of the slot
+} store_header_t;
+
+typedef enum store_slot_state_e
+{
+    STORE_SLOT_FREE    = 0,
+    STORE_SLOT_WRITING = 1, // Interrupted write if found at startup
+    STORE_SLOT_VALID   = 2
+} store_slot_state_t;
+
+typedef struct store_slot_header_s
+{
+    uint32_t uuid;
+    uint32_t size;
+    uint32_t state;
+    uint32_t last_use;
+} store_slot_header_t;
+
+typedef struct cache_store_s
+{
+    bool                 open;
+    char                 path[CACHE_PATH_SIZE];
+    int                  fd;
+    unsigned char *      p_map;
+    size_t               map_size;
+    uint32_t *           index; // UUID hash table of slot numbers, open addressing
+    uint32_t             index_size;
+    uint32_t             valid_count;
+    dlb_lip_tool_mutex_t mutex;
+} cache_store_t;
+
+static cache_store_t store = { 0 };
+
+/**
+ *  Shared memory layout: shm_header_t padded to SHM_HEADER_SIZE followed by slot_count slots,
+ *  every slot is shm_slot_header_t followed by slot_size bytes of the record.
+ *  Readers never lock, writers of one slot are serialized by the slot lock.
+ */
+typedef struct shm_header_s
+{
+    uint32_t magic; // Written last by the creator of the segment
+    uint32_t version;
+    uint32_t slot_size;
+    uint32_t slot_count;
+    uint32_t use_clock;
+} shm_header_t;
+
+typedef struct shm_slot_header_s
+{
+    uint32_t sequence; // Odd while the slot is written
+    uint32_t lock;     // pid of the writer, 0 if unlocked
+    uint64_t key;      // 1 << 32 | uuid, 0 for empty slot
+    uint32_t size;     // Record size
+    uint32_t last_use;
+    uint32_t reserved[2];
+} shm_slot_header_t;
+
+typedef struct cache_shm_s
+{
+    bool           open;
+    unsigned char *p_map;
+    size_t         map_size;
+    shm_header_t * p_header;
+} cache_shm_t;
+
+static cache_shm_t shm = { 0 };
+
+/**
+ *  Called for every valid blob of the cache by export
+ */
+typedef void (*cache_blob_callback_t)(void *arg, uint32_t uuid, const void *blob, unsigned int size);
+
+static void get_cache_file_name(char *file_name, size_t size, uint32_t uuid, bool temporary)
+{
+    snprintf(file_name, size, temporary ? "%scache_%x.dat.tmp" : "%scache_%x.dat", settings.directory, uuid);
+}
+
+/*!
+Checks if the directory entry is a cache file, temporary and other files are skipped.
+
+@return true if name is exactly cache_<uuid>.dat
+*/
+static bool parse_cache_file_name(const char *name, uint32_t *uuid)
+{
+    char         expected[CACHE_FILE_NAME_SIZE];
+    unsigned int value = 0;
+
+    if (sscanf(name, "cache_%x.dat", &value) != 1)
+    {
+        return false;
+    }
+    snprintf(expected, sizeof(expected), "cache_%x.dat", value);
+    *uuid = value;
+
+    return strcmp(expected, name) == 0;
+}
+
+typedef void (*cache_file_callback_t)(void *arg, uint32_t uuid, const char *file_name);
+
+/*!
+Calls the callback for every cache file in the cache directory.
+
+@return 0 on success, 1 if the directory can't be listed
+*/
+static int list_cache_files(cache_file_callback_t callback, void *arg)
+{
+    char file_name[CACHE_FILE_NAME_SIZE];
+#if defined(_MSC_VER)
+    WIN32_FIND_DATAA find_data;
+    HANDLE           find = INVALID_HANDLE_VALUE;
+
+    snprintf(file_name, sizeof(file_name), "%scache_*.dat", settings.directory);
+    find = FindFirstFileA(file_name, &find_data);
+    if (find == INVALID_HANDLE_VALUE)
+    {
+        return GetLastError() == ERROR_FILE_NOT_FOUND ? 0 : 1;
+    }
+    do
+    {
+        uint32_t uuid = 0;
+        if (parse_cache_file_name(find_data.cFileName, &uuid))
+        {
+            get_cache_file_name(file_name, sizeof(file_name), uuid, false);
+            callback(arg, uuid, file_name);
+        }
+    } while (FindNextFileA(find, &find_data));
+    FindClose(find);
+#else
+    DIR *          dir      = opendir(settings.directory[0] != '\0' ? settings.directory : ".");
+    struct dirent *p_dirent = NULL;
+
+    if (dir == NULL)
+    {
+        return 1;
+    }
+    while ((p_dirent = readdir(dir)) != NULL)
+    {
+        uint32_t uuid = 0;
+        if (parse_cache_file_name(p_dirent->d_name, &uuid))
+        {
+            get_cache_file_name(file_name, sizeof(file_name), uuid, false);
+            callback(arg, uuid, file_name);
+        }
+    }
+    closedir(dir);
+#endif
+
+    return 0;
+}
+
+static void crc32c_init(void)
+{
+    for (uint32_t i = 0; i < 256U; ++i)
+    {
+        uint32_t crc = i;
+        for (unsigned int bit = 0; bit < 8U; ++bit)
+        {
+            crc = (crc >> 1) ^ ((crc & 1U) ? CRC32C_POLYNOMIAL : 0U);
+        }
+        crc32c_table[i] = crc;
+    }
+}
+
+static uint32_t crc32c(const void *data, unsigned int size)
+{
+    const unsigned char *p_data = (const unsigned char *)data;
+    uint32_t             crc    = 0xFFFFFFFFU;
+
+    while (size--)
+    {
+        crc = crc32c_table[(crc ^ *p_data++) & 0xFFU] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
+
+/*!
+Builds cache record of the blob.
+
+@return allocated record of sizeof(cache_record_header_t) + size bytes, NULL on error
+*/
+static unsigned char *make_record(const void *const cache_data, unsigned int size)
+{
+    unsigned char *       p_record = (unsigned char *)malloc(sizeof(cache_record_header_t) + size);
+    cache_record_header_t header;
+
+    if (p_record == NULL)
+    {
+        fprintf(stderr, "ERROR: Couldn't allocate cache entry\n");
+        return NULL;
+    }
+
+    header.magic           = CACHE_RECORD_MAGIC;
+    header.library_version = settings.library_version;
+    header.size            = size;
+    header.crc             = crc32c(cache_data, size);
+    memcpy(p_record, &header, sizeof(header));
+    memcpy(p_record + sizeof(header), cache_data, size);
+
+    return p_record;
+}
+
+/*!
+Checks everything but the checksum, so stale records are rejected before the blob is read.
+
+@param buffer_size - size of the blob buffer of dlb_lip
+
+@return NULL if the header is valid, otherwise reason of the rejection
+*/
+static const char *check_record_header(const cache_record_header_t *p_header, unsigned int buffer_size)
+{
+    if (p_header->magic != CACHE_RECORD_MAGIC)
+    {
+        return "bad magic";
+    }
+    if (p_header->library_version != settings.library_version)
+    {
+        return "library version mismatch";
+    }
+    if (p_header->size > buffer_size)
+    {
+        return "size mismatch";
+    }
+    return NULL;
+}
+
+static unsigned int reject_record(uint32_t uuid, const char *reason)
+{
+    fprintf(stderr, "WARNING: Cache record of UUID %x rejected(%s)\n", uuid, reason);
+    return 0;
+}
+
+/*!
+Validates the record header and the checksum of its blob.
+
+@param record_size - size of the whole record
+@param size        - size of the blob buffer of dlb_lip
+
+@return blob size, 0 if the record is rejected
+*/
+static unsigned int check_record(
+    uint32_t uuid, const cache_record_header_t *p_header, unsigned int record_size, const void *blob, unsigned int size)
+{
+    const char *reason = check_record_header(p_header, size);
+
+    if (reason == NULL && record_size - sizeof(cache_record_header_t) != p_header->size)
+    {
+        reason = "truncated";
+    }
+    if (reason == NULL && crc32c(blob, p_header->size) != p_header->crc)
+    {
+        reason = "checksum mismatch";
+    }
+
+    return reason ? reject_record(uuid, reason) : p_header->size;
+}
+
+/*!
+Validates the record in memory and copies its blob.
+
+@return blob size, 0 if the record is rejected
+*/
+static unsigned int read_record(
+    uint32_t uuid, const unsigned char *p_record, unsigned int record_size, void *const cache_data, unsigned int size)
+{
+    cache_record_header_t header;
+    unsigned int          data_read = 0;
+
+    if (record_size < sizeof(header))
+    {
+        return reject_record(uuid, "truncated");
+    }
+    memcpy(&header, p_record, sizeof(header));
+
+    data_read = check_record(uuid, &header, record_size, p_record + sizeof(header), size);
+    if (data_read > 0)
+    {
+        memcpy(cache_data, p_record + sizeof(header), data_read);
+    }
+
+    return data_read;
+}
+
+/*!
+Reads the record from the cache file, the blob is read directly to the buffer of dlb_lip.
+
+@param record_size - set to the record size on success
+
+@return blob size, 0 if there is no valid record
+*/
+static unsigned int read_record_file(
+    uint32_t uuid, const char *file_name, void *const cache_data, unsigned int size, unsigned int *record_size)
+{
+    cache_record_header_t header;
+    const char *          reason = NULL;
+    FILE *                file   = fopen(file_name, "rb");
+
+    if (file == NULL)
+    {
+        return 0;
+    }
+
+    if (fread(&header, 1, sizeof(header), file) != sizeof(header))
+    {
+        reason = "truncated";
+    }
+    if (reason == NULL)
+    {
+        reason = check_record_header(&header, size);
+    }
+    if (reason == NULL && fread(cache_data, 1, header.size, file) != header.size)
+    {
+        reason = "truncated";
+    }
+    if (reason == NULL && crc32c(cache_data, header.size) != header.crc)
+    {
+        reason = "checksum mismatch";
+    }
+    fclose(file);
+
+    if (reason)
+    {
+        return reject_record(uuid, reason);
+    }
+
+    *record_size = (unsigned int)sizeof(header) + header.size;
+    return header.size;
+}
+
+static bool cache_limit_exceeded(uint32_t count, uint64_t total_size)
+{
+    return (settings.max_entries && count > settings.max_entries) || (settings.max_size && total_size > settings.max_size);
+}
+
+/*!
+Writes the blob to a temporary file, flushes it to the storage and renames it over the cache file.
+
+@return 0 on success, 1 on error
+*/
+static int write_cache_file(uint32_t uuid, const void *const cache_data, unsigned int size)
+{
+    char  file_name[CACHE_FILE_NAME_SIZE];
+    char  tmp_file_name[CACHE_FILE_NAME_SIZE];
+    FILE *file = NULL;
+    int   ret  = 0;
+
+    get_cache_file_name(file_name, sizeof(file_name), uuid, false);
+    get_cache_file_name(tmp_file_name, sizeof(tmp_file_name), uuid, true);
+
+    file = fopen(tmp_file_name, "wb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "ERROR: Couldn't open cache file(%s)\n", tmp_file_name);
+        return 1;
+    }
+
+    if (fwrite(cache_data, 1, size, file) != size || fflush(file) != 0)
+    {
+        ret = 1;
+    }
+#if defined(_MSC_VER)
+    else if (_commit(_fileno(file)) != 0)
+#else
+    else if (fsync(fileno(file)) != 0)
+#endif
+    {
+        ret = 1;
+    }
+    fclose(file);
+
+    if (ret == 0)
+    {
+#if defined(_MSC_VER)
+        ret = MoveFileExA(tmp_file_name, file_name, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) ? 0 : 1;
+#else
+        ret = rename(tmp_file_name, file_name) == 0 ? 0 : 1;
+#endif
+    }
+
+    if (ret)
+    {
+        fprintf(stderr, "ERROR: Couldn't write cache file(%s)\n", file_name);
+        remove(tmp_file_name);
+    }
+
+    return ret;
+}
+
+static void remove_cache_file(uint32_t uuid)
+{
+    char file_name[CACHE_FILE_NAME_SIZE];
+
+    get_cache_file_name(file_name, sizeof(file_name), uuid, false);
+    remove(file_name);
+}
+
+static void free_entry(cache_entry_t *p_entry)
+{
+    free(p_entry->data);
+    free(p_entry);
+}
+
+/*!
+Appends the entry to the write queue or replaces data of the queued entry of the same UUID.
+Called with persister mutex locked.
+
+@param data - blob owned by the queue afterwards, NULL to remove the cache file
+
+@return 0 on success, 1 on error
+*/
+static int persister_enqueue(uint32_t uuid, unsigned char *data, unsigned int size)
+{
+    cache_entry_t *p_entry = NULL;
+
+    for (p_entry = persister.head; p_entry != NULL; p_entry = p_entry->next)
+    {
+        if (p_entry->uuid == uuid)
+        {
+            // Not written yet, only the latest blob is needed
+            free(p_entry->data);
+            p_entry->data = data;
+            p_entry->size = size;
+            return 0;
+        }
+    }
+
+    p_entry = (cache_entry_t *)malloc(sizeof(cache_entry_t));
+    if (p_entry == NULL)
+    {
+        fprintf(stderr, "ERROR: Couldn't allocate cache entry\n");
+        free(data);
+        return 1;
+    }
+    p_entry->uuid = uuid;
+    p_entry->size = size;
+    p_entry->data = data;
+    p_entry->next = NULL;
+    if (persister.tail)
+    {
+        persister.tail->next = p_entry;
+    }
+    else
+    {
+        persister.head = p_entry;
+    }
+    persister.tail = p_entry;
+    dlb_lip_tool_cond_signal(&persister.cond);
+
+    return 0;
+}
+
+static uint32_t ram_position(uint32_t uuid)
+{
+    uint32_t pos = (uuid * 2654435761U) & (persister.ram.capacity - 1U);
+
+    while (persister.ram.entries[pos].blob != NULL && persister.ram.entries[pos].uuid != uuid)
+    {
+        pos = (pos + 1U) & (persister.ram.capacity - 1U);
+    }
+    return pos;
+}
+
+static const cache_ram_entry_t *ram_find(uint32_t uuid)
+{
+    const cache_ram_entry_t *p_entry = NULL;
+
+    if (persister.ram.capacity > 0)
+    {
+        p_entry = &persister.ram.entries[ram_position(uuid)];
+    }
+    return p_entry && p_entry->blob ? p_entry : NULL;
+}
+
+static int ram_resize(uint32_t capacity)
+{
+    cache_ram_entry_t *p_old        = persister.ram.entries;
+    const uint32_t     old_capacity = persister.ram.capacity;
+
+    persister.ram.entries = (cache_ram_entry_t *)calloc(capacity, sizeof(cache_ram_entry_t));
+    if (persister.ram.entries == NULL)
+    {
+        fprintf(stderr, "ERROR: Couldn't allocate cache ram\n");
+        persister.ram.entries = p_old;
+        return 1;
+    }
+    persister.ram.capacity = capacity;
+
+    for (uint32_t i = 0; i < old_capacity; ++i)
+    {
+        if (p_old[i].blob)
+        {
+            persister.ram.entries[ram_position(p_old[i].uuid)] = p_old[i];
+        }
+    }
+    free(p_old);
+
+    return 0;
+}
+
+/*!
+Puts the blob to ram, the table takes ownership of it.
+
+@param replace - false keeps existing blob of the UUID
+
+@return true if the blob was put to ram, otherwise it is freed
+*/
+static bool ram_put(uint32_t uuid, unsigned char *blob, uint32_t size, bool replace)
+{
+    cache_ram_entry_t *p_entry = NULL;
+
+    if ((persister.ram.count + 1U) * 2U > persister.ram.capacity
+        && ram_resize(persister.ram.capacity ? persister.ram.capacity * 2U : 64U))
+    {
+        free(blob);
+        return false;
+    }
+
+    p_entry = &persister.ram.entries[ram_position(uuid)];
+    if (p_entry->blob && !replace)
+    {
+        free(blob);
+        return false;
+    }
+    if (p_entry->blob == NULL)
+    {
+        persister.ram.count += 1;
+    }
+    free(p_entry->blob);
+    p_entry->uuid = uuid;
+    p_entry->size = size;
+    p_entry->blob = blob;
+
+    return true;
+}
+
+/*!
+Removes the UUID, following entries of the probe sequence are moved back to keep it unbroken.
+*/
+static void ram_remove(uint32_t uuid)
+{
+    const uint32_t mask = persister.ram.capacity - 1U;
+    uint32_t       pos  = 0;
+
+    if (persister.ram.capacity == 0 || persister.ram.entries[pos = ram_position(uuid)].blob == NULL)
+    {
+        return;
+    }
+
+    free(persister.ram.entries[pos].blob);
+    persister.ram.entries[pos].blob = NULL;
+    persister.ram.count -= 1;
+
+    for (pos = (pos + 1U) & mask; persister.ram.entries[pos].blob != NULL; pos = (pos + 1U) & mask)
+    {
+        const cache_ram_entry_t entry = persister.ram.entries[pos];
+
+        persister.ram.entries[pos].blob                 = NULL;
+        persister.ram.entries[ram_position(entry.uuid)] = entry;
+    }
+}
+
+static void ram_free(void)
+{
+    for (uint32_t i = 0; i < persister.ram.capacity; ++i)
+    {
+        free(persister.ram.entries[i].blob);
+    }
+    free(persister.ram.entries);
+    memset(&persister.ram, 0, sizeof(persister.ram));
+}
+
+/*!
+Calls the callback for every blob in ram, must be called with persister mutex locked.
+*/
+static void ram_for_each(cache_blob_callback_t callback, void *arg)
+{
+    for (uint32_t i = 0; i < persister.ram.capacity; ++i)
+    {
+        if (persister.ram.entries[i].blob)
+        {
+            callback(arg, persister.ram.entries[i].uuid, persister.ram.entries[i].blob, persister.ram.entries[i].size);
+        }
+    }
+}
+
+static cache_lru_entry_t *lru_find(uint32_t uuid)
+{
+    for (uint32_t i = 0; i < persister.lru.count; ++i)
+    {
+        if (persister.lru.entries[i].uuid == uuid)
+        {
+            return &persister.lru.entries[i];
+        }
+    }
+    return NULL;
+}
+
+static cache_lru_entry_t *lru_add(uint32_t uuid, uint32_t size)
+{
+    cache_lru_t *const p_lru = &persister.lru;
+
+    if (p_lru->count == p_lru->capacity)
+    {
+        const uint32_t     capacity  = p_lru->capacity ? p_lru->capacity * 2U : 64U;
+        cache_lru_entry_t *p_entries = (cache_lru_entry_t *)realloc(p_lru->entries, capacity * sizeof(cache_lru_entry_t));
+        if (p_entries == NULL)
+        {
+            fprintf(stderr, "ERROR: Couldn't allocate cache usage list\n");
+            return NULL;
+        }
+        p_lru->entries  = p_entries;
+        p_lru->capacity = capacity;
+    }
+
+    p_lru->entries[p_lru->count].uuid     = uuid;
+    p_lru->entries[p_lru->count].size     = size;
+    p_lru->entries[p_lru->count].last_use = 0;
+    p_lru->total_size += size;
+
+    return &p_lru->entries[p_lru->count++];
+}
+
+/*!
+Removes least recently used cache files until the limits are met, the most recently used entry is always kept.
+Called with persister mutex locked.
+*/
+static void lru_evict(void)
+{
+    cache_lru_t *const p_lru = &persister.lru;
+
+    while (p_lru->count > 1 && cache_limit_exceeded(p_lru->count, p_lru->total_size))
+    {
+        uint32_t oldest = 0;
+        uint32_t uuid   = 0;
+
+        for (uint32_t i = 1; i < p_lru->count; ++i)
+        {
+            if (p_lru->entries[i].last_use < p_lru->entries[oldest].last_use)
+            {
+                oldest = i;
+            }
+        }
+
+        uuid = p_lru->entries[oldest].uuid;
+        p_lru->total_size -= p_lru->entries[oldest].size;
+        p_lru->entries[oldest] = p_lru->entries[--p_lru->count];
+        ram_remove(uuid);
+
+        if (!persister.running || persister_enqueue(uuid, NULL, 0))
+        {
+            remove_cache_file(uuid);
+        }
+    }
+}
+
+/*!
+Marks the UUID as most recently used and evicts entries over the limits. Called with persister mutex locked.
+
+@param size         - blob size of the UUID
+@param update_size  - true for stores, reads only add untracked UUIDs with the size read
+*/
+static void lru_use(uint32_t uuid, unsigned int size, bool update_size)
+{
+    cache_lru_entry_t *p_entry = NULL;
+
+    if (!persister.lru.enabled)
+    {
+        return;
+    }
+
+    p_entry = lru_find(uuid);
+    if (p_entry == NULL)
+    {
+        p_entry = lru_add(uuid, size);
+    }
+    else if (update_size)
+    {
+        persister.lru.total_size = persister.lru.total_size - p_entry->size + size;
+        p_entry->size            = size;
+    }
+
+    if (p_entry)
+    {
+        p_entry->last_use = ++persister.lru.clock;
+        lru_evict();
+    }
+}
+
+typedef struct lru_scan_entry_s
+{
+    uint32_t uuid;
+    uint32_t size;
+    time_t   mtime;
+} lru_scan_entry_t;
+
+typedef struct lru_scan_s
+{
+    lru_scan_entry_t *entries;
+    uint32_t          count;
+    uint32_t          capacity;
+} lru_scan_t;
+
+static void lru_scan_file(void *arg, uint32_t uuid, const char *file_name)
+{
+    lru_scan_t *const p_scan = (lru_scan_t *)arg;
+    struct stat       st;
+
+    if (stat(file_name, &st) != 0)
+    {
+        return;
+    }
+    if (p_scan->count == p_scan->capacity)
+    {
+        const uint32_t    capacity  = p_scan->capacity ? p_scan->capacity * 2U : 64U;
+        lru_scan_entry_t *p_entries = (lru_scan_entry_t *)realloc(p_scan->entries, capacity * sizeof(lru_scan_entry_t));
+        if (p_entries == NULL)
+        {
+            return;
+        }
+        p_scan->entries  = p_entries;
+        p_scan->capacity = capacity;
+    }
+    p_scan->entries[p_scan->count].uuid  = uuid;
+    p_scan->entries[p_scan->count].size  = (uint32_t)st.st_size;
+    p_scan->entries[p_scan->count].mtime = st.st_mtime;
+    p_scan->count += 1;
+}
+
+static int compare_mtime(const void *a, const void *b)
+{
+    const time_t mtime_a = ((const lru_scan_entry_t *)a)->mtime;
+    const time_t mtime_b = ((const lru_scan_entry_t *)b)->mtime;
+    return mtime_a < mtime_b ? -1 : mtime_a > mtime_b;
+}
+
+/*!
+Builds usage order of existing cache files from their modification time and applies the limits.
+*/
+static void lru_load(void)
+{
+    lru_scan_t scan = { NULL, 0, 0 };
+
+    persister.lru.enabled = true;
+    if (list_cache_files(lru_scan_file, &scan))
+    {
+        // Directory doesn't exist yet or isn't readable, writes will report errors
+        return;
+    }
+
+    if (scan.count > 1)
+    {
+        qsort(scan.entries, scan.count, sizeof(lru_scan_entry_t), compare_mtime);
+    }
+    dlb_lip_tool_mutex_lock(&persister.mutex);
+    for (uint32_t i = 0; i < scan.count; ++i)
+    {
+        cache_lru_entry_t *p_entry = lru_add(scan.entries[i].uuid, scan.entries[i].size);
+        if (p_entry)
+        {
+            p_entry->last_use = ++persister.lru.clock;
+        }
+    }
+    lru_evict();
+    dlb_lip_tool_mutex_unlock(&persister.mutex);
+    free(scan.entries);
+}
+
+/*!
+Loads the cache file to ram if it holds a valid record, UUIDs evicted by the limits are skipped.
+*/
+static void warm_load_file(void *arg, uint32_t uuid, const char *file_name)
+{
+    int *const     p_loaded    = (int *)arg;
+    unsigned char *blob        = NULL;
+    unsigned int   size        = 0;
+    unsigned int   record_size = 0;
+    struct stat    st;
+
+    if (stat(file_name, &st) != 0 || (uint64_t)st.st_size <= sizeof(cache_record_header_t)
+        || (uint64_t)st.st_size > UINT32_MAX)
+    {
+        return;
+    }
+    size = (unsigned int)st.st_size - (unsigned int)sizeof(cache_record_header_t);
+    blob = (unsigned char *)malloc(size);
+    if (blob == NULL)
+    {
+        return;
+    }
+
+    size = read_record_file(uuid, file_name, blob, size, &record_size);
+
+    dlb_lip_tool_mutex_lock(&persister.mutex);
+    if (size == 0 || (persister.lru.enabled && lru_find(uuid) == NULL))
+    {
+        free(blob);
+    }
+    else if (ram_put(uuid, blob, size, false))
+    {
+        *p_loaded += 1;
+    }
+    dlb_lip_tool_mutex_unlock(&persister.mutex);
+}
+
+static void persister_thread(void *arg)
+{
+    (void)arg;
+
+    dlb_lip_tool_mutex_lock(&persister.mutex);
+    while (true)
+    {
+        cache_entry_t *p_entry = NULL;
+
+        while (persister.running && persister.head == NULL)
+        {
+            dlb_lip_tool_cond_wait(&persister.cond, &persister.mutex);
+        }
+        if (persister.head == NULL)
+        {
+            // Stopped and everything is written
+            break;
+        }
+
+        p_entry        = persister.head;
+        persister.head = p_entry->next;
+        if (persister.head == NULL)
+        {
+            persister.tail = NULL;
+        }
+        persister.writing = p_entry;
+        dlb_lip_tool_mutex_unlock(&persister.mutex);
+
+        if (p_entry->data)
+        {
+            write_cache_file(p_entry->uuid, p_entry->data, p_entry->size);
+        }
+        else
+        {
+            remove_cache_file(p_entry->uuid);
+        }
+
+        dlb_lip_tool_mutex_lock(&persister.mutex);
+        persister.writing = NULL;
+        free_entry(p_entry);
+    }
+    dlb_lip_tool_mutex_unlock(&persister.mutex);
+}
+
+#if defined(_MSC_VER)
+
+static int store_open(const char *path)
+{
+    (void)path;
+    fprintf(stderr, "ERROR: Cache store file is not supported on this platform!\n");
+    return 1;
+}
+
+static void store_close(void) {}
+
+static int store_write(uint32_t uuid, const void *const cache_data, unsigned int size)
+{
+    (void)uuid;
+    (void)cache_data;
+    (void)size;
+    return 1;
+}
+
+static unsigned int store_read(uint32_t uuid, void *const cache_data, unsigned int size)
+{
+    (void)uuid;
+    (void)cache_data;
+    (void)size;
+    return 0;
+}
+
+static int store_validate(void)
+{
+    return 0;
+}
+
+static void store_for_each(cache_blob_callback_t callback, void *arg)
+{
+    (void)callback;
+    (void)arg;
+}
+
+int dlb_lip_cache_import_files(bool legacy)
+{
+    (void)legacy;
+    return -1;
+}
+
+#else
+
+static store_header_t *store_header(void)
+{
+    return (store_header_t *)store.p_map;
+}
+
+static size_t store_slot_stride(uint32_t slot_size)
+{
+    return sizeof(store_slot_header_t) + slot_size;
+}
+
+static store_slot_header_t *store_slot(uint32_t slot)
+{
+    return (store_slot_header_t *)(store.p_map + STORE_HEADER_SIZE
+                                   + (size_t)slot * store_slot_stride(store_header()->slot_size));
+}
+
+static uint32_t store_hash(uint32_t uuid)
+{
+    return (uuid * 2654435761U) & (store.index_size - 1U);
+}
+
+static uint32_t store_find(uint32_t uuid)
+{
+    for (uint32_t pos = store_hash(uuid);; pos = (pos + 1U) & (store.index_size - 1U))
+    {
+        const uint32_t slot = store.index[pos];
+        if (slot == STORE_EMPTY_INDEX || store_slot(slot)->uuid == uuid)
+        {
+            return slot;
+        }
+    }
+}
+
+static void store_index_insert(uint32_t uuid, uint32_t slot)
+{
+    uint32_t pos = store_hash(uuid);
+    while (store.index[pos] != STORE_EMPTY_INDEX)
+    {
+        pos = (pos + 1U) & (store.index_size - 1U);
+    }
+    store.index[pos] = slot;
+}
+
+/*!
+Removes the UUID from the index, following entries of the probe sequence are reinserted to keep it unbroken.
+*/
+static void store_index_remove(uint32_t uuid)
+{
+    uint32_t pos = store_hash(uuid);
+
+    while (store.index[pos] != STORE_EMPTY_INDEX && store_slot(store.index[pos])->uuid != uuid)
+    {
+        pos = (pos + 1U) & (store.index_size - 1U);
+    }
+    if (store.index[pos] == STORE_EMPTY_INDEX)
+    {
+        return;
+    }
+
+    store.index[pos] = STORE_EMPTY_INDEX;
+    for (pos = (pos + 1U) & (store.index_size - 1U); store.index[pos] != STORE_EMPTY_INDEX;
+         pos = (pos + 1U) & (store.index_size - 1U))
+    {
+        const uint32_t slot = store.index[pos];
+        store.index[pos]    = STORE_EMPTY_INDEX;
+        store_index_insert(store_slot(slot)->uuid, slot);
+    }
+}
+
+/*!
+Maximum number of slots allowed by the limits, at least one.
+*/
+static uint32_t store_capacity(uint32_t slot_size)
+{
+    uint64_t capacity = UINT32_MAX;
+
+    if (settings.max_entries && settings.max_entries < capacity)
+    {
+        capacity = settings.max_entries;
+    }
+    if (settings.max_size)
+    {
+        const uint64_t by_size =
+            settings.max_size > STORE_HEADER_SIZE ? (settings.max_size - STORE_HEADER_SIZE) / store_slot_stride(slot_size) : 0;
+        capacity = by_size < capacity ? by_size : capacity;
+    }
+
+    return capacity ? (uint32_t)capacity : 1U;
+}
+
+/*!
+Frees the valid slot with the oldest last use.
+*/
+static void store_evict_lru(void)
+{
+    const uint32_t slot_count = store_header()->slot_count;
+    uint32_t       oldest     = STORE_EMPTY_INDEX;
+
+    for (uint32_t slot = 0; slot < slot_count; ++slot)
+    {
+        const store_slot_header_t *p_slot = store_slot(slot);
+
+        if (p_slot->state == STORE_SLOT_VALID
+            && (oldest == STORE_EMPTY_INDEX || p_slot->last_use - store_slot(oldest)->last_use > UINT32_MAX / 2U))
+        {
+            oldest = slot;
+        }
+    }
+
+    if (oldest != STORE_EMPTY_INDEX)
+    {
+        store_index_remove(store_slot(oldest)->uuid);
+        store_slot(oldest)->state = STORE_SLOT_FREE;
+        store.valid_count -= 1;
+    }
+}
+
+static void store_evict_to(uint32_t count)
+{
+    while (store.valid_count > count)
+    {
+        store_evict_lru();
+    }
+}
+
+/*!
+Rebuilds UUID index of valid slots, index has at least twice as many positions as slots.
+Interrupted writes, duplicate UUIDs and slots with a record size not fitting the slot(corrupt store) are freed,
+so readers of indexed slots can trust the size.
+
+@return 0 on success, 1 on error
+*/
+static int store_build_index(void)
+{
+    const uint32_t slot_count = store_header()->slot_count;
+    const uint32_t slot_size  = store_header()->slot_size;
+    uint32_t       size       = 32U;
+
+    while (size < slot_count * 2U)
+    {
+        size *= 2U;
+    }
+
+    free(store.index);
+    store.index = (uint32_t *)malloc(size * sizeof(uint32_t));
+    if (store.index == NULL)
+    {
+        fprintf(stderr, "ERROR: Couldn't allocate cache store index\n");
+        return 1;
+    }
+    store.index_size  = size;
+    store.valid_count = 0;
+    memset(store.index, 0xFF, size * sizeof(uint32_t));
+
+    for (uint32_t slot = 0; slot < slot_count; ++slot)
+    {
+        store_slot_header_t *p_slot = store_slot(slot);
+
+        if (p_slot->state == STORE_SLOT_VALID && sizeof(cache_record_header_t) <= p_slot->size && p_slot->size <= slot_size
+            && store_find(p_slot->uuid) == STORE_EMPTY_INDEX)
+        {
+            store_index_insert(p_slot->uuid, slot);
+            store.valid_count += 1;
+        }
+        else
+        {
+            p_slot->state = STORE_SLOT_FREE;
+        }
+    }
+
+    return 0;
+}
+
+static int store_map(size_t size)
+{
+    if (store.p_map)
+    {
+        munmap(store.p_map, store.map_size);
+        store.p_map = NULL;
+    }
+
+    if (ftruncate(store.fd, (off_t)size) != 0)
+    {
+        fprintf(stderr, "ERROR: Couldn't resize cache store(%s)\n", store.path);
+        return 1;
+    }
+
+    store.p_map = (unsigned char *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, store.fd, 0);
+    if (store.p_map == MAP_FAILED)
+    {
+        store.p_map = NULL;
+        fprintf(stderr, "ERROR: Couldn't map cache store(%s)\n", store.path);
+        return 1;
+    }
+    store.map_size = size;
+
+    return 0;
+}
+
+/*!
+Doubles number of slots up to the capacity, new slots are zero filled by ftruncate which makes them free.
+
+@return 0 on success, 1 on error
+*/
+static int store_grow(void)
+{
+    const uint32_t slot_size  = store_header()->slot_size;
+    const uint32_t slot_count = store_header()->slot_count;
+    const uint32_t capacity   = store_capacity(slot_size);
+    uint32_t       new_count  = slot_count < STORE_MIN_SLOTS ? STORE_MIN_SLOTS : slot_count * 2U;
+
+    new_count = new_count < capacity ? new_count : capacity;
+    if (new_count <= slot_count || store_map(STORE_HEADER_SIZE + (size_t)new_count * store_slot_stride(slot_size)))
+    {
+        return 1;
+    }
+    store_header()->slot_count = new_count;
+
+    return store_build_index();
+}
+
+/*!
+Compaction pass - rewrites the store with valid slots only, optionally with bigger slot size.
+New store is written to a temporary file, synced and renamed over the old one.
+Number of valid slots must not exceed the capacity for the new slot size.
+
+@param slot_size - slot size of the new store
+
+@return 0 on success, 1 on error
+*/
+static int store_compact(uint32_t slot_size)
+{
+    char            tmp_path[CACHE_PATH_SIZE + 8];
+    const uint32_t  slot_count = store_header()->slot_count;
+    const uint32_t  capacity   = store_capacity(slot_size);
+    uint32_t        new_count  = store.valid_count;
+    uint32_t        new_slot   = 0;
+    size_t          new_size   = 0;
+    unsigned char * p_buffer   = NULL;
+    store_header_t *p_header   = NULL;
+    int             fd         = -1;
+    int             ret        = 0;
+
+    new_count = new_count < STORE_MIN_SLOTS ? STORE_MIN_SLOTS : new_count + new_count / 2U;
+    new_count = new_count < capacity ? new_count : capacity;
+    new_size  = STORE_HEADER_SIZE + (size_t)new_count * store_slot_stride(slot_size);
+
+    p_buffer = (unsigned char *)calloc(1, new_size);
+    if (p_buffer == NULL)
+    {
+        fprintf(stderr, "ERROR: Couldn't allocate compacted cache store\n");
+        return 1;
+    }
+
+    p_header             = (store_header_t *)p_buffer;
+    p_header->magic      = STORE_MAGIC;
+    p_header->version    = STORE_VERSION;
+    p_header->slot_size  = slot_size;
+    p_header->slot_count = new_count;
+    p_header->use_clock  = store_header()->use_clock;
+    for (uint32_t slot = 0; slot < slot_count; ++slot)
+    {
+        const store_slot_header_t *p_slot = store_slot(slot);
+
+        if (p_slot->state == STORE_SLOT_VALID)
+        {
+            unsigned char *p_dst = p_buffer + STORE_HEADER_SIZE + (size_t)new_slot * store_slot_stride(slot_size);
+            memcpy(p_dst, p_slot, sizeof(store_slot_header_t) + p_slot->size);
+            new_slot += 1;
+        }
+    }
+
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", store.path);
+    fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || write(fd, p_buffer, new_size) != (ssize_t)new_size || fsync(fd) != 0 || rename(tmp_path, store.path) != 0)
+    {
+        fprintf(stderr, "ERROR: Couldn't write compacted cache store(%s)\n", tmp_path);
+        if (fd >= 0)
+        {
+            close(fd);
+            unlink(tmp_path);
+        }
+        ret = 1;
+    }
+    free(p_buffer);
+
+    if (ret == 0)
+    {
+        munmap(store.p_map, store.map_size);
+        store.p_map = NULL;
+        close(store.fd);
+        store.fd = fd;
+        ret      = store_map(new_size);
+        if (ret == 0)
+        {
+            ret = store_build_index();
+        }
+    }
+
+    return ret;
+}
+
+static int store_open(const char *path)
+{
+    struct stat st;
+
+    memset(&store, 0, sizeof(store));
+    snprintf(store.path, sizeof(store.path), "%s", path);
+
+    store.fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (store.fd < 0 || fstat(store.fd, &st) != 0)
+    {
+        fprintf(stderr, "ERROR: Couldn't open cache store(%s)\n", path);
+        if (store.fd >= 0)
+        {
+            close(store.fd);
+        }
+        return 1;
+    }
+
+    if (st.st_size == 0 || store_map((size_t)st.st_size))
+    {
+        st.st_size = 0;
+    }
+    else if (
+        store_header()->magic != STORE_MAGIC || store_header()->version != STORE_VERSION
+        || (size_t)st.st_size
+               != STORE_HEADER_SIZE + (size_t)store_header()->slot_count * store_slot_stride(store_header()->slot_size))
+    {
+        fprintf(stderr, "WARNING: Cache store(%s) is not valid, starting with empty cache\n", path);
+        st.st_size = 0;
+    }
+
+    if (st.st_size == 0)
+    {
+        if (store_map(STORE_HEADER_SIZE))
+        {
+            close(store.fd);
+            return 1;
+        }
+        memset(store.p_map, 0, STORE_HEADER_SIZE);
+        store_header()->magic   = STORE_MAGIC;
+        store_header()->version = STORE_VERSION;
+    }
+
+    if (store_build_index())
+    {
+        munmap(store.p_map, store.map_size);
+        close(store.fd);
+        return 1;
+    }
+
+    // Apply limits which may have changed since the store was written, reclaim space of freed slots
+    store_evict_to(store_capacity(store_header()->slot_size));
+    if (store_header()->slot_count > store_capacity(store_header()->slot_size)
+        || (store_header()->slot_count > STORE_MIN_SLOTS && store.valid_count < store_header()->slot_count / 2U))
+    {
+        store_compact(store_header()->slot_size);
+    }
+
+    dlb_lip_tool_mutex_init(&store.mutex);
+    store.open = true;
+
+    return 0;
+}
+
+static void store_close(void)
+{
+    if (store.open)
+    {
+        store.open = false;
+        msync(store.p_map, store.map_size, MS_SYNC);
+        munmap(store.p_map, store.map_size);
+        close(store.fd);
+        free(store.index);
+        store.index = NULL;
+        dlb_lip_tool_mutex_destroy(&store.mutex);
+    }
+}
+
+/*!
+Writes the blob in place to the slot of the UUID. If there is no free slot the store grows,
+the least recently used slot is reused once the store reached its capacity.
+
+@return 0 on success, 1 on error
+*/
+static int store_write(uint32_t uuid, const void *const cache_data, unsigned int size)
+{
+    store_slot_header_t *p_slot = NULL;
+    uint32_t             slot   = STORE_EMPTY_INDEX;
+    int                  ret    = 0;
+
+    dlb_lip_tool_mutex_lock(&store.mutex);
+    if (size > store_header()->slot_size)
+    {
+        // Slots can't hold the blob, rewrite the store with bigger slots
+        const uint32_t slot_size = (size + STORE_SLOT_ALIGN - 1U) / STORE_SLOT_ALIGN * STORE_SLOT_ALIGN;
+
+        // Bigger slots fit less blobs into the size limit
+        store_evict_to(store_capacity(slot_size));
+        ret = store_compact(slot_size);
+    }
+
+    if (ret == 0)
+    {
+        slot = store_find(uuid);
+    }
+    if (ret == 0 && slot == STORE_EMPTY_INDEX)
+    {
+        store_evict_to(store_capacity(store_header()->slot_size) - 1U);
+        for (uint32_t i = 0; i < store_header()->slot_count; ++i)
+        {
+            if (store_slot(i)->state == STORE_SLOT_FREE)
+            {
+                slot = i;
+                break;
+            }
+        }
+        if (slot == STORE_EMPTY_INDEX)
+        {
+            slot = store_header()->slot_count;
+            ret  = store_grow();
+        }
+        if (ret == 0)
+        {
+            store_index_insert(uuid, slot);
+            store.valid_count += 1;
+        }
+    }
+
+    if (ret == 0)
+    {
+        p_slot           = store_slot(slot);
+        p_slot->state    = STORE_SLOT_WRITING;
+        p_slot->uuid     = uuid;
+        p_slot->size     = size;
+        p_slot->last_use = ++store_header()->use_clock;
+        memcpy(p_slot + 1, cache_data, size);
+        p_slot->state = STORE_SLOT_VALID;
+    }
+    dlb_lip_tool_mutex_unlock(&store.mutex);
+
+    return ret;
+}
+
+static unsigned int store_read(uint32_t uuid, void *const cache_data, unsigned int size)
+{
+    unsigned int data_read = 0;
+    uint32_t     slot      = STORE_EMPTY_INDEX;
+
+    dlb_lip_tool_mutex_lock(&store.mutex);
+    slot = store_find(uuid);
+    if (slot != STORE_EMPTY_INDEX)
+    {
+        store_slot_header_t *p_slot = store_slot(slot);
+
+        data_read = read_record(uuid, (const unsigned char *)(p_slot + 1), p_slot->size, cache_data, size);
+        if (data_read > 0)
+        {
+            p_slot->last_use = ++store_header()->use_clock;
+        }
+        else
+        {
+            // Free the slot, the next store of the UUID replaces it
+            store_index_remove(uuid);
+            p_slot->state = STORE_SLOT_FREE;
+            store.valid_count -= 1;
+        }
+    }
+    dlb_lip_tool_mutex_unlock(&store.mutex);
+
+    return data_read;
+}
+
+/*!
+Validates records of all slots, invalid slots are freed. Pages of the store are faulted in on the way.
+
+@return number of valid records
+*/
+static int store_validate(void)
+{
+    int valid = 0;
+
+    dlb_lip_tool_mutex_lock(&store.mutex);
+    for (uint32_t slot = 0; slot < store_header()->slot_count; ++slot)
+    {
+        store_slot_header_t *const p_slot   = store_slot(slot);
+        const unsigned char *const p_record = (const unsigned char *)(p_slot + 1);
+        cache_record_header_t      header;
+
+        if (p_slot->state != STORE_SLOT_VALID)
+        {
+            continue;
+        }
+        if (p_slot->size >= sizeof(header))
+        {
+            memcpy(&header, p_record, sizeof(header));
+        }
+        if (p_slot->size >= sizeof(header)
+            && check_record(p_slot->uuid, &header, p_slot->size, p_record + sizeof(header), UINT32_MAX) > 0)
+        {
+            valid += 1;
+        }
+        else
+        {
+            store_index_remove(p_slot->uuid);
+            p_slot->state = STORE_SLOT_FREE;
+            store.valid_count -= 1;
+        }
+    }
+    dlb_lip_tool_mutex_unlock(&store.mutex);
+
+    return valid;
+}
+
+/*!
+Calls the callback for every valid record of the store, usage order of the slots is not changed.
+*/
+static void store_for_each(cache_blob_callback_t callback, void *arg)
+{
+    dlb_lip_tool_mutex_lock(&store.mutex);
+    for (uint32_t slot = 0; slot < store_header()->slot_count; ++slot)
+    {
+        const store_slot_header_t *const p_slot   = store_slot(slot);
+        const unsigned char *const       p_record = (const unsigned char *)(p_slot + 1);
+        cache_record_header_t            header;
+
+        if (p_slot->state != STORE_SLOT_VALID || p_slot->size < sizeof(header))
+        {
+            continue;
+        }
+        memcpy(&header, p_record, sizeof(header));
+        if (check_record(p_slot->uuid, &header, p_slot->size, p_record + sizeof(header), UINT32_MAX) > 0)
+        {
+            callback(arg, p_slot->uuid, p_record + sizeof(header), header.size);
+        }
+    }
+    dlb_lip_tool_mutex_unlock(&store.mutex);
+}
+
+typedef struct cache_file_import_s
+{
+    int  imported;
+    bool legacy;
+} cache_file_import_t;
+
+/*!
+Copies the record of the cache file to the store, records rejected by reads are not imported.
+Legacy cache files written before records had a header hold the bare blob, with legacy import the blob is wrapped
+in a new record of the current library version.
+*/
+static void import_cache_file(void *arg, uint32_t uuid, const char *file_name)
+{
+    cache_file_import_t *const p_import = (cache_file_import_t *)arg;
+    FILE *         file        = fopen(file_name, "rb");
+    long           file_size   = 0;
+    unsigned char *p_data      = NULL;
+    unsigned char *p_blob      = NULL;
+    unsigned char *p_record    = NULL;
+    unsigned int   record_size = 0;
+    uint32_t       magic       = 0;
+
+    if (file == NULL)
+    {
+        return;
+    }
+    if (fseek(file, 0, SEEK_END) == 0 && (file_size = ftell(file)) > 0 && (uint64_t)file_size <= UINT32_MAX / 2U
+        && fseek(file, 0, SEEK_SET) == 0)
+    {
+        p_data = (unsigned char *)malloc((size_t)file_size);
+        p_blob = (unsigned char *)malloc((size_t)file_size);
+    }
+    if (p_data && p_blob && fread(p_data, 1, (size_t)file_size, file) == (size_t)file_size)
+    {
+        record_size = (unsigned int)file_size;
+    }
+
+    if (record_size >= sizeof(magic))
+    {
+        memcpy(&magic, p_data, sizeof(magic));
+    }
+    if (record_size > 0 && magic != CACHE_RECORD_MAGIC && !p_import->legacy)
+    {
+        reject_record(uuid, "no record header");
+    }
+    else if (record_size > 0 && magic != CACHE_RECORD_MAGIC)
+    {
+        fprintf(stderr, "WARNING: Cache file %s has no record header, imported as legacy blob\n", file_name);
+        p_record    = make_record(p_data, record_size);
+        record_size = (unsigned int)sizeof(cache_record_header_t) + record_size;
+    }
+    else if (record_size > 0 && read_record(uuid, p_data, record_size, p_blob, record_size) > 0)
+    {
+        p_record = p_data;
+        p_data   = NULL;
+    }
+
+    if (p_record && store_write(uuid, p_record, record_size) == 0)
+    {
+        p_import->imported += 1;
+    }
+    else if (file_size > 0)
+    {
+        fprintf(stderr, "WARNING: Cache file %s not imported\n", file_name);
+    }
+    free(p_record);
+    free(p_blob);
+    free(p_data);
+    fclose(file);
+}
+
+int dlb_lip_cache_import_files(bool legacy)
+{
+    cache_file_import_t import = { 0, legacy };
+
+    if (!store.open)
+    {
+        fprintf(stderr, "ERROR: Cache files can be imported only to cache store\n");
+        return -1;
+    }
+
+    if (list_cache_files(import_cache_file, &import))
+    {
+        fprintf(stderr, "ERROR: Couldn't list cache files\n");
+        return -1;
+    }
+
+    return import.imported;
+}
+
+#endif
+
+#if defined(_MSC_VER)
+
+static int shm_open_segment(const char *name)
+{
+    (void)name;
+    fprintf(stderr, "ERROR: Shared memory cache is not supported on this platform!\n");
+    return 1;
+}
+
+static void shm_close_segment(void) {}
+
+static void shm_write(uint32_t uuid, const void *const record, unsigned int record_size)
+{
+    (void)uuid;
+    (void)record;
+    (void)record_size;
+}
+
+static unsigned int shm_read(uint32_t uuid, void *const cache_data, unsigned int size, bool touch)
+{
+    (void)uuid;
+    (void)cache_data;
+    (void)size;
+    (void)touch;
+    return 0;
+}
+
+static void shm_for_each(cache_blob_callback_t callback, void *arg)
+{
+    (void)callback;
+    (void)arg;
+}
+
+#else
+
+static shm_slot_header_t *shm_slot(uint32_t slot)
+{
+    return (shm_slot_header_t *)(shm.p_map + SHM_HEADER_SIZE
+                                 + (size_t)slot * (sizeof(shm_slot_header_t) + shm.p_header->slot_size));
+}
+
+static uint64_t shm_key(uint32_t uuid)
+{
+    return (1ULL << 32) | uuid;
+}
+
+static uint32_t shm_first_slot(uint32_t uuid)
+{
+    return (uuid * 2654435761U) % shm.p_header->slot_count;
+}
+
+/*!
+Writer lock of the slot, holds pid of the writer. Lock of a process which died while writing is taken over.
+*/
+static void shm_lock_slot(shm_slot_header_t *p_slot)
+{
+    const uint32_t pid = (uint32_t)getpid();
+
+    while (true)
+    {
+        uint32_t holder = 0;
+
+        if (__atomic_compare_exchange_n(&p_slot->lock, &holder, pid, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            return;
+        }
+        if (kill((pid_t)holder, 0) != 0 && errno == ESRCH
+            && __atomic_compare_exchange_n(&p_slot->lock, &holder, pid, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            return;
+        }
+        sched_yield();
+    }
+}
+
+static void shm_unlock_slot(shm_slot_header_t *p_slot)
+{
+    __atomic_store_n(&p_slot->lock, 0U, __ATOMIC_RELEASE);
+}
+
+static void shm_touch(shm_slot_header_t *p_slot)
+{
+    __atomic_store_n(&p_slot->last_use, __atomic_add_fetch(&shm.p_header->use_clock, 1U, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+}
+
+/*!
+Finds the slot of the UUID or claims an empty slot on its probe sequence. Claimed slots never become empty again,
+so probe sequences are never broken. If all slots are used the least recently used slot is returned.
+
+@param p_key - set to the key currently in the returned slot
+*/
+static uint32_t shm_find_write_slot(uint32_t uuid, uint64_t *p_key)
+{
+    const uint32_t slot_count = shm.p_header->slot_count;
+    const uint64_t key        = shm_key(uuid);
+    uint32_t       oldest     = 0;
+    uint32_t       oldest_use = 0;
+
+    for (uint32_t i = 0, slot = shm_first_slot(uuid); i < slot_count; ++i, slot = (slot + 1U) % slot_count)
+    {
+        shm_slot_header_t *p_slot  = shm_slot(slot);
+        uint64_t           current = __atomic_load_n(&p_slot->key, __ATOMIC_ACQUIRE);
+        uint32_t           last_use;
+
+        // Failed claim leaves the key of the writer which claimed the slot meanwhile in current
+        if ((current == 0
+             && __atomic_compare_exchange_n(&p_slot->key, &current, key, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            || current == key)
+        {
+            *p_key = key;
+            return slot;
+        }
+
+        last_use = __atomic_load_n(&p_slot->last_use, __ATOMIC_RELAXED);
+        if (i == 0 || last_use - oldest_use > UINT32_MAX / 2U)
+        {
+            oldest     = slot;
+            oldest_use = last_use;
+        }
+    }
+
+    *p_key = __atomic_load_n(&shm_slot(oldest)->key, __ATOMIC_ACQUIRE);
+    return oldest;
+}
+
+/*!
+Writes the record to the slot of the UUID under the writer lock of the slot. Readers see odd sequence
+while the slot is written and retry.
+*/
+static void shm_write(uint32_t uuid, const void *const record, unsigned int record_size)
+{
+    const uint64_t key = shm_key(uuid);
+
+    if (record_size > shm.p_header->slot_size)
+    {
+        fprintf(stderr,
+                "WARNING: Cache record of UUID %x doesn't fit shared memory slot(%u bytes)\n",
+                uuid,
+                shm.p_header->slot_size);
+        return;
+    }
+
+    while (true)
+    {
+        uint64_t           found    = 0;
+        const uint32_t     slot     = shm_find_write_slot(uuid, &found);
+        shm_slot_header_t *p_slot   = shm_slot(slot);
+        uint32_t           sequence = 0;
+
+        shm_lock_slot(p_slot);
+        if (__atomic_load_n(&p_slot->key, __ATOMIC_RELAXED) != found)
+        {
+            // Least recently used slot was replaced by another writer, look again
+            shm_unlock_slot(p_slot);
+            continue;
+        }
+
+        // Sequence may be left odd by a writer which died, it becomes even again below
+        sequence = __atomic_load_n(&p_slot->sequence, __ATOMIC_RELAXED) | 1U;
+        __atomic_store_n(&p_slot->sequence, sequence, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+
+        __atomic_store_n(&p_slot->key, key, __ATOMIC_RELAXED);
+        p_slot->size = record_size;
+        memcpy(p_slot + 1, record, record_size);
+        shm_touch(p_slot);
+
+        __atomic_store_n(&p_slot->sequence, sequence + 1U, __ATOMIC_RELEASE);
+        shm_unlock_slot(p_slot);
+        return;
+    }
+}
+
+/*!
+Lock-free read: the record is copied and the copy is used only if the slot sequence didn't change meanwhile.
+
+@param touch - mark the UUID as recently used
+
+@return blob size, 0 if there is no valid record of the UUID
+*/
+static unsigned int shm_read(uint32_t uuid, void *const cache_data, unsigned int size, bool touch)
+{
+    const uint32_t        slot_count  = shm.p_header->slot_count;
+    const uint64_t        key         = shm_key(uuid);
+    shm_slot_header_t *   p_slot      = NULL;
+    unsigned int          record_size = 0;
+    cache_record_header_t header;
+
+    for (uint32_t i = 0, slot = shm_first_slot(uuid); i < slot_count; ++i, slot = (slot + 1U) % slot_count)
+    {
+        const uint64_t current = __atomic_load_n(&shm_slot(slot)->key, __ATOMIC_ACQUIRE);
+
+        if (current == 0)
+        {
+            return 0;
+        }
+        if (current == key)
+        {
+            p_slot = shm_slot(slot);
+            break;
+        }
+    }
+    if (p_slot == NULL)
+    {
+        return 0;
+    }
+
+    for (unsigned int retry = 0; retry < SHM_READ_RETRIES; ++retry)
+    {
+        const uint32_t       sequence = __atomic_load_n(&p_slot->sequence, __ATOMIC_ACQUIRE);
+        const unsigned char *p_record = (const unsigned char *)(p_slot + 1);
+        bool                 matches  = false;
+
+        if (sequence & 1U)
+        {
+            sched_yield();
+            continue;
+        }
+
+        matches     = __atomic_load_n(&p_slot->key, __ATOMIC_RELAXED) == key;
+        record_size = p_slot->size;
+        if (matches && record_size >= sizeof(header) && record_size <= shm.p_header->slot_size)
+        {
+            memcpy(&header, p_record, sizeof(header));
+            if (header.size <= size && header.size <= record_size - sizeof(header))
+            {
+                memcpy(cache_data, p_record + sizeof(header), header.size);
+            }
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&p_slot->sequence, __ATOMIC_RELAXED) != sequence)
+        {
+            continue;
+        }
+
+        // Claimed but not written yet or replaced by another UUID
+        if (!matches || record_size == 0)
+        {
+            return 0;
+        }
+        if (record_size < sizeof(header))
+        {
+            return reject_record(uuid, "truncated");
+        }
+        if (check_record(uuid, &header, record_size, cache_data, size) == 0)
+        {
+            return 0;
+        }
+        if (touch)
+        {
+            shm_touch(p_slot);
+        }
+        return header.size;
+    }
+
+    return 0;
+}
+
+/*!
+Creates the shared memory segment or maps the segment created by another process. Geometry of a new
+segment follows the limits, an existing segment is used with its own geometry.
+
+@return 0 on success, 1 on error
+*/
+static int shm_open_segment(const char *name)
+{
+    const uint32_t slot_count = settings.max_entries ? settings.max_entries : SHM_DEFAULT_SLOTS;
+    uint64_t       slot_size  = SHM_DEFAULT_SLOT_SIZE;
+    struct stat    st;
+    int            fd      = -1;
+    bool           created = false;
+
+    if (settings.max_size)
+    {
+        const uint64_t stride = settings.max_size > SHM_HEADER_SIZE ? (settings.max_size - SHM_HEADER_SIZE) / slot_count : 0;
+        slot_size             = stride > sizeof(shm_slot_header_t) ? (stride - sizeof(shm_slot_header_t)) / 64U * 64U : 0;
+        if (slot_size == 0 || slot_size > UINT32_MAX)
+        {
+            fprintf(stderr, "ERROR: Cache size limit doesn't fit %u shared memory slots\n", slot_count);
+            return 1;
+        }
+    }
+
+    memset(&shm, 0, sizeof(shm));
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0)
+    {
+        created    = true;
+        st.st_size = (off_t)(SHM_HEADER_SIZE + (uint64_t)slot_count * (sizeof(shm_slot_header_t) + slot_size));
+        if (ftruncate(fd, st.st_size) != 0)
+        {
+            fprintf(stderr, "ERROR: Couldn't resize shared memory cache(%s)\n", name);
+            close(fd);
+            shm_unlink(name);
+            return 1;
+        }
+    }
+    else if (errno == EEXIST && (fd = shm_open(name, O_RDWR, 0)) >= 0)
+    {
+        // Creator may still be resizing the segment
+        for (unsigned int wait_ms = 0; fstat(fd, &st) == 0 && st.st_size == 0 && wait_ms < SHM_OPEN_TIMEOUT_MS; wait_ms += 10U)
+        {
+            usleep(10 * 1000);
+        }
+    }
+    if (fd < 0 || (!created && (fstat(fd, &st) != 0 || (size_t)st.st_size < SHM_HEADER_SIZE)))
+    {
+        fprintf(stderr, "ERROR: Couldn't open shared memory cache(%s)\n", name);
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return 1;
+    }
+
+    shm.p_map = (unsigned char *)mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shm.p_map == MAP_FAILED)
+    {
+        fprintf(stderr, "ERROR: Couldn't map shared memory cache(%s)\n", name);
+        return 1;
+    }
+    shm.map_size = (size_t)st.st_size;
+    shm.p_header = (shm_header_t *)shm.p_map;
+
+    if (created)
+    {
+        // New segment is zero filled, all slots are empty. Magic is published last.
+        shm.p_header->version    = SHM_VERSION;
+        shm.p_header->slot_size  = (uint32_t)slot_size;
+        shm.p_header->slot_count = slot_count;
+        __atomic_store_n(&shm.p_header->magic, SHM_MAGIC, __ATOMIC_RELEASE);
+    }
+    else
+    {
+        for (unsigned int wait_ms = 0; __atomic_load_n(&shm.p_header->magic, __ATOMIC_ACQUIRE) != SHM_MAGIC
+                                       && wait_ms < SHM_OPEN_TIMEOUT_MS;
+             wait_ms += 10U)
+        {
+            usleep(10 * 1000);
+        }
+        if (shm.p_header->magic != SHM_MAGIC || shm.p_header->version != SHM_VERSION || shm.p_header->slot_count == 0
+            || shm.map_size
+                   != SHM_HEADER_SIZE
+                          + (size_t)shm.p_header->slot_count * (sizeof(shm_slot_header_t) + shm.p_header->slot_size))
+        {
+            fprintf(stderr, "ERROR: Shared memory cache(%s) is not valid\n", name);
+            munmap(shm.p_map, shm.map_size);
+            return 1;
+        }
+    }
+
+    shm.open = true;
+    return 0;
+}
+
+/*!
+Calls the callback for a consistent copy of every record of the segment, usage order of the slots is not changed.
+*/
+static void shm_for_each(cache_blob_callback_t callback, void *arg)
+{
+    unsigned char *blob = (unsigned char *)malloc(shm.p_header->slot_size);
+
+    if (blob == NULL)
+    {
+        fprintf(stderr, "ERROR: Couldn't allocate cache entry\n");
+        return;
+    }
+
+    for (uint32_t slot = 0; slot < shm.p_header->slot_count; ++slot)
+    {
+        const uint64_t key  = __atomic_load_n(&shm_slot(slot)->key, __ATOMIC_ACQUIRE);
+        unsigned int   size = 0;
+
+        if (key != 0 && (size = shm_read((uint32_t)key, blob, shm.p_header->slot_size, false)) > 0)
+        {
+            callback(arg, (uint32_t)key, blob, size);
+        }
+    }
+    free(blob);
+}
+
+/*!
+Unmaps the segment, it is kept for other processes and the next run until it is removed or the system restarts.
+*/
+static void shm_close_segment(void)
+{
+    if (shm.open)
+    {
+        shm.open = false;
+        munmap(shm.p_map, shm.map_size);
+    }
+}
+
+#endif
+
+static void warm_start_thread(void *arg)
+{
+    int loaded = 0;
+
+    (void)arg;
+    if (store.open)
+    {
+        loaded = store_validate();
+    }
+    else
+    {
+        if (settings.max_size || settings.max_entries)
+        {
+            lru_load();
+        }
+        list_cache_files(warm_load_file, &loaded);
+    }
+
+    dlb_lip_tool_mutex_lock(&warm.mutex);
+    warm.loaded = loaded;
+    warm.ready  = true;
+    dlb_lip_tool_cond_broadcast(&warm.cond);
+    dlb_lip_tool_mutex_unlock(&warm.mutex);
+}
+
+static void warm_start(void)
+{
+    memset(&warm, 0, sizeof(warm));
+    dlb_lip_tool_mutex_init(&warm.mutex);
+    dlb_lip_tool_cond_init(&warm.cond);
+    warm.started  = true;
+    warm.threaded = dlb_lip_tool_thread_create(&warm.thread, warm_start_thread, NULL) == 0;
+    if (!warm.threaded)
+    {
+        warm_start_thread(NULL);
+    }
+}
+
+static void warm_wait(void)
+{
+    if (warm.started)
+    {
+        dlb_lip_tool_mutex_lock(&warm.mutex);
+        while (!warm.ready)
+        {
+            dlb_lip_tool_cond_wait(&warm.cond, &warm.mutex);
+        }
+        dlb_lip_tool_mutex_unlock(&warm.mutex);
+    }
+}
+
+static void warm_stop(void)
+{
+    if (warm.started)
+    {
+        if (warm.threaded)
+        {
+            dlb_lip_tool_thread_join(&warm.thread);
+        }
+        dlb_lip_tool_cond_destroy(&warm.cond);
+        dlb_lip_tool_mutex_destroy(&warm.mutex);
+        warm.started = false;
+    }
+}
+
+/*!
+Sets the cache directory, relative store path is resolved against it.
+
+@return 0 on success, 1 if the paths are too long
+*/
+static int set_cache_paths(const char *directory, const char *store_path, char *resolved_store_path, size_t size)
+{
+    const size_t length   = directory ? strlen(directory) : 0;
+    bool         absolute = false;
+
+    memset(settings.directory, 0, sizeof(settings.directory));
+    if (length > 0)
+    {
+        const char last = directory[length - 1];
+
+        if (length + 2 > sizeof(settings.directory))
+        {
+            fprintf(stderr, "ERROR: Cache directory path is too long\n");
+            return 1;
+        }
+#if defined(_MSC_VER)
+        _mkdir(directory);
+#else
+        mkdir(directory, 0755);
+#endif
+        snprintf(settings.directory, sizeof(settings.directory), "%s%s", directory, last == '/' || last == '\\' ? "" : "/");
+    }
+
+    if (store_path && store_path[0] != '\0')
+    {
+        absolute = store_path[0] == '/' || store_path[0] == '\\' || store_path[1] == ':';
+        if ((size_t)snprintf(resolved_store_path, size, "%s%s", absolute ? "" : settings.directory, store_path) >= size)
+        {
+            fprintf(stderr, "ERROR: Cache store path is too long\n");
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int dlb_lip_cache_open(const dlb_lip_cache_config_t *config)
+{
+    char store_path[CACHE_PATH_SIZE] = { 0 };
+    int  ret                         = 0;
+
+    settings.max_size        = config->max_size;
+    settings.max_entries     = config->max_entries;
+    settings.library_version = config->library_version;
+    crc32c_init();
+    if (set_cache_paths(config->directory, config->store_path, store_path, sizeof(store_path)))
+    {
+        return 1;
+    }
+
+    if (config->shm_name && config->shm_name[0] != '\0')
+    {
+        if (shm_open_segment(config->shm_name) == 0)
+        {
+            return 0;
+        }
+        fprintf(stderr,
+                "WARNING: Using %s instead of shared memory cache\n",
+                store_path[0] != '\0' ? "cache store" : "cache files");
+        ret = 1;
+    }
+
+    if (store_path[0] != '\0')
+    {
+        // Store writes are memcpy to mapped memory, no writer thread is needed
+        if (store_open(store_path) == 0)
+        {
+            warm_start();
+            return 0;
+        }
+        fprintf(stderr, "WARNING: Using cache files instead of cache store\n");
+        ret = 1;
+    }
+
+    memset(&persister, 0, sizeof(persister));
+    dlb_lip_tool_mutex_init(&persister.mutex);
+    dlb_lip_tool_cond_init(&persister.cond);
+    persister.open = true;
+
+    persister.running = true;
+    if (dlb_lip_tool_thread_create(&persister.thread, persister_thread, NULL))
+    {
+        fprintf(stderr, "ERROR: Couldn't start cache writer thread, cache is written synchronously\n");
+        persister.running = false;
+        ret               = 1;
+    }
+
+    warm_start();
+
+    return ret;
+}
+
+int dlb_lip_cache_wait_warm_start(void)
+{
+    if (!warm.started)
+    {
+        return -1;
+    }
+    warm_wait();
+    return warm.loaded;
+}
+
+void dlb_lip_cache_close(void)
+{
+    warm_stop();
+    shm_close_segment();
+    store_close();
+    if (persister.open)
+    {
+        persister.open = false;
+        if (persister.running)
+        {
+            dlb_lip_tool_mutex_lock(&persister.mutex);
+            persister.running = false;
+            dlb_lip_tool_cond_signal(&persister.cond);
+            dlb_lip_tool_mutex_unlock(&persister.mutex);
+
+            dlb_lip_tool_thread_join(&persister.thread);
+        }
+        dlb_lip_tool_cond_destroy(&persister.cond);
+        dlb_lip_tool_mutex_destroy(&persister.mutex);
+        free(persister.lru.entries);
+        persister.lru.entries = NULL;
+        ram_free();
+    }
+}
+
+void dlb_lip_cache_store(uint32_t uuid, const void *const cache_data, unsigned int size)
+{
+    // Build the record outside of the lock to keep it short
+    unsigned char *const p_record    = make_record(cache_data, size);
+    const unsigned int   record_size = (unsigned int)sizeof(cache_record_header_t) + size;
+    unsigned char *      blob        = NULL;
+
+    if (p_record == NULL)
+    {
+        return;
+    }
+
+    if (shm.open)
+    {
+        shm_write(uuid, p_record, record_size);
+        free(p_record);
+        return;
+    }
+    if (store.open)
+    {
+        store_write(uuid, p_record, record_size);
+        free(p_record);
+        return;
+    }
+
+    // Reads are served from ram, keep it up to date
+    warm_wait();
+    blob = (unsigned char *)malloc(size ? size : 1);
+    if (blob)
+    {
+        memcpy(blob, cache_data, size);
+    }
+
+    dlb_lip_tool_mutex_lock(&persister.mutex);
+    if (blob)
+    {
+        ram_put(uuid, blob, size, true);
+    }
+    if (!persister.running)
+    {
+        write_cache_file(uuid, p_record, record_size);
+        free(p_record);
+        lru_use(uuid, record_size, true);
+    }
+    else if (persister_enqueue(uuid, p_record, record_size) == 0)
+    {
+        lru_use(uuid, record_size, true);
+    }
+    dlb_lip_tool_mutex_unlock(&persister.mutex);
+}
+
+unsigned int dlb_lip_cache_read(uint32_t uuid, void *const cache_data, unsigned int size)
+{
+    const cache_ram_entry_t *p_entry   = NULL;
+    unsigned int             data_read = 0;
+
+    if (shm.open)
+    {
+        return shm_read(uuid, cache_data, size, true);
+    }
+    if (store.open)
+    {
+        return store_read(uuid, cache_data, size);
+    }
+
+    // Ram holds all valid cache files after the warm start, no file I/O is needed
+    warm_wait();
+    dlb_lip_tool_mutex_lock(&persister.mutex);
+    p_entry = ram_find(uuid);
+    if (p_entry && p_entry->size > size)
+    {
+        reject_record(uuid, "size mismatch");
+    }
+    else if (p_entry)
+    {
+        memcpy(cache_data, p_entry->blob, p_entry->size);
+        data_read = p_entry->size;
+        lru_use(uuid, (unsigned int)sizeof(cache_record_header_t) + data_read, false);
+    }
+    dlb_lip_tool_mutex_unlock(&persister.mutex);
+
+    return data_read;
+}
+
+static void put_le32(unsigned char *p, uint32_t value)
+{
+    p[0] = (unsigned char)value;
+    p[1] = (unsigned char)(value >> 8);
+    p[2] = (unsigned char)(value >> 16);
+    p[3] = (unsigned char)(value >> 24);
+}
+
+static uint32_t get_le32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+typedef struct archive_writer_s
+{
+    FILE *   file;
+    uint32_t count;
+    bool     failed;
+} archive_writer_t;
+
+static void archive_write_entry(void *arg, uint32_t uuid, const void *blob, unsigned int size)
+{
+    archive_writer_t *p_writer = (archive_writer_t *)arg;
+    unsigned char     header[ARCHIVE_ENTRY_HEADER_SIZE];
+
+    put_le32(header, uuid);
+    put_le32(header + 4, size);
+    put_le32(header + 8, crc32c(blob, size));
+    if (fwrite(header, 1, sizeof(header), p_writer->file) != sizeof(header) || fwrite(blob, 1, size, p_writer->file) != size)
+    {
+        p_writer->failed = true;
+    }
+    else
+    {
+        p_writer->count += 1;
+    }
+}
+
+int dlb_lip_cache_export(const char *path)
+{
+    archive_writer_t writer                      = { NULL, 0, false };
+    unsigned char    header[ARCHIVE_HEADER_SIZE] = { 0 };
+
+    if (!shm.open && !store.open && !persister.open)
+    {
+        fprintf(stderr, "ERROR: Cache is not open\n");
+        return -1;
+    }
+
+    writer.file = fopen(path, "wb");
+    if (writer.file == NULL)
+    {
+        fprintf(stderr, "ERROR: Couldn't create cache archive %s\n", path);
+        return -1;
+    }
+
+    // Number of entries is filled in when all entries are written
+    memcpy(header, ARCHIVE_MAGIC, 4);
+    put_le32(header + 4, ARCHIVE_VERSION);
+    put_le32(header + 8, settings.library_version);
+    writer.failed = fwrite(header, 1, sizeof(header), writer.file) != sizeof(header);
+
+    if (shm.open)
+    {
+        shm_for_each(archive_write_entry, &writer);
+    }
+    else if (store.open)
+    {
+        store_for_each(archive_write_entry, &writer);
+    }
+    else
+    {
+        // Ram holds all valid cache files including stores not written yet
+        warm_wait();
+        dlb_lip_tool_mutex_lock(&persister.mutex);
+        ram_for_each(archive_write_entry, &writer);
+        dlb_lip_tool_mutex_unlock(&persister.mutex);
+    }
+
+    put_le32(header + 12, writer.count);
+    if (!writer.failed
+        && (fseek(writer.file, 0, SEEK_SET) != 0 || fwrite(header, 1, sizeof(header), writer.file) != sizeof(header)))
+    {
+        writer.failed = true;
+    }
+    writer.failed |= fclose(writer.file) != 0;
+
+    if (writer.failed)
+    {
+        fprintf(stderr, "ERROR: Couldn't write cache archive %s\n", path);
+        remove(path);
+        return -1;
+    }
+
+    return (int)writer.count;
+}
+
+int dlb_lip_cache_import(const char *path)
+{
+    unsigned char  header[ARCHIVE_HEADER_SIZE];
+    unsigned char *blob     = NULL;
+    uint32_t       capacity = 0;
+    uint32_t       count    = 0;
+    int            imported = 0;
+    FILE *         file     = NULL;
+
+    if (!shm.open && !store.open && !persister.open)
+    {
+        fprintf(stderr, "ERROR: Cache is not open\n");
+        return -1;
+    }
+
+    file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "ERROR: Couldn't open cache archive %s\n", path);
+        return -1;
+    }
+
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) || memcmp(header, ARCHIVE_MAGIC, 4) != 0)
+    {
+        fprintf(stderr, "ERROR: %s is not a cache archive\n", path);
+        fclose(file);
+        return -1;
+    }
+    if (get_le32(header + 4) != ARCHIVE_VERSION)
+    {
+        fprintf(stderr, "ERROR: Cache archive %s has unsupported version %u\n", path, get_le32(header + 4));
+        fclose(file);
+        return -1;
+    }
+    if (get_le32(header + 8) != settings.library_version)
+    {
+        // Blobs are opaque to the tool, only the library which wrote them can use them
+        fprintf(stderr,
+                "ERROR: Cache archive %s was written by dlb_lip version %x, expected %x\n",
+                path,
+                get_le32(header + 8),
+                settings.library_version);
+        fclose(file);
+        return -1;
+    }
+
+    count = get_le32(header + 12);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        unsigned char entry[ARCHIVE_ENTRY_HEADER_SIZE];
+        uint32_t      uuid = 0;
+        uint32_t      size = 0;
+
+        if (fread(entry, 1, sizeof(entry), file) != sizeof(entry))
+        {
+            fprintf(stderr, "WARNING: Cache archive %s is truncated, %u of %u entries read\n", path, i, count);
+            break;
+        }
+        uuid = get_le32(entry);
+        size = get_le32(entry + 4);
+        if (size > ARCHIVE_MAX_BLOB_SIZE)
+        {
+            fprintf(stderr, "WARNING: Cache archive %s is corrupted, %u of %u entries read\n", path, i, count);
+            break;
+        }
+        if (size > capacity)
+        {
+            unsigned char *const p_new = (unsigned char *)realloc(blob, size);
+            if (p_new == NULL)
+            {
+                fprintf(stderr, "ERROR: Couldn't allocate cache entry\n");
+                break;
+            }
+            blob     = p_new;
+            capacity = size;
+        }
+        if (fread(blob, 1, size, file) != size)
+        {
+            fprintf(stderr, "WARNING: Cache archive %s is truncated, %u of %u entries read\n", path, i, count);
+            break;
+        }
+
+        if (crc32c(blob, size) != get_le32(entry + 8))
+        {
+            reject_record(uuid, "checksum mismatch");
+            continue;
+        }
+        dlb_lip_cache_store(uuid, blob, size);
+        imported += 1;
+    }
+
+    free(blob);
+    fclose(file);
+
+    return imported;
+}
@@ -0,0 +1,402 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_compiled_config.c
+ *  @brief      Device config compiled from the XML file into a binary file loaded at startup
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dlb_lip_compiled_config.h"
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#if !defined(_MSC_VER)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define COMPILED_CONFIG_MAGIC 0x4350494CU // "LIPC"
+#define COMPILED_CONFIG_VERSION 5U
+
+// Fixed part of the payload, followed by the rules of the video and audio latency tables
+#define COMPILED_CONFIG_DEPENDENCIES_OFFSET (sizeof(dlb_lip_config_params_t) + sizeof(uint16_t) + sizeof(uint32_t))
+#define COMPILED_CONFIG_TABLES_OFFSET \
+    (COMPILED_CONFIG_DEPENDENCIES_OFFSET + sizeof(uint32_t) + MAX_XML_DEPENDENCIES * sizeof(dlb_lip_xml_dependency_t))
+#define COMPILED_CONFIG_RULE_SIZE (2 * DLB_LIP_LATENCY_TABLE_DIMENSIONS + 1) // First and last indexes, latency
+// Rules of a dense table are runs of its cells, so a table has at most as many rules as cells
+#define COMPILED_CONFIG_MAX_PAYLOAD_SIZE \
+    (COMPILED_CONFIG_TABLES_OFFSET + 2 * (sizeof(uint32_t) + DLB_LIP_LATENCY_TABLE_MAX_CELLS * COMPILED_CONFIG_RULE_SIZE))
+
+typedef struct compiled_config_header_s
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t library_version;
+    uint32_t payload_size;
+    uint32_t hash; // FNV-1a of the payload
+} compiled_config_header_t;
+
+static uint32_t compiled_config_hash(const unsigned char *data, size_t size)
+{
+    uint32_t hash = 2166136261U;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash = (hash ^ data[i]) * 16777619U;
+    }
+
+    return hash;
+}
+
+static int count_compiled_rule(void *arg, const dlb_lip_latency_rule_t *p_rule)
+{
+    (void)p_rule;
+    *(uint32_t *)arg += 1;
+    return 0;
+}
+
+static int write_compiled_rule(void *arg, const dlb_lip_latency_rule_t *p_rule)
+{
+    unsigned char **const pp = (unsigned char **)arg;
+
+    memcpy(*pp, p_rule->first, DLB_LIP_LATENCY_TABLE_DIMENSIONS);
+    memcpy(*pp + DLB_LIP_LATENCY_TABLE_DIMENSIONS, p_rule->last, DLB_LIP_LATENCY_TABLE_DIMENSIONS);
+    (*pp)[2 * DLB_LIP_LATENCY_TABLE_DIMENSIONS] = p_rule->latency;
+    *pp += COMPILED_CONFIG_RULE_SIZE;
+    return 0;
+}
+
+static uint32_t compiled_rule_count(const dlb_lip_latency_table_t *p_table)
+{
+    uint32_t count = 0;
+
+    dlb_lip_latency_table_for_each_rule(p_table, count_compiled_rule, &count);
+    return count;
+}
+
+/*!
+Writes rule count and rules of the table.
+
+@return pointer after the rules
+*/
+static unsigned char *write_compiled_table(unsigned char *p, const dlb_lip_latency_table_t *p_table)
+{
+    const uint32_t count = compiled_rule_count(p_table);
+
+    memcpy(p, &count, sizeof(count));
+    p += sizeof(count);
+    dlb_lip_latency_table_for_each_rule(p_table, write_compiled_rule, &p);
+
+    return p;
+}
+
+/*!
+Sets rules of the compiled table to the table.
+
+@return pointer after the rules, NULL if the rules don't fit in the payload or are invalid
+*/
+static const unsigned char *read_compiled_table(const unsigned char *p, const unsigned char *end, dlb_lip_latency_table_t *p_table)
+{
+    uint32_t count = 0;
+
+    if ((size_t)(end - p) < sizeof(count))
+    {
+        return NULL;
+    }
+    memcpy(&count, p, sizeof(count));
+    p += sizeof(count);
+    if (count > (size_t)(end - p) / COMPILED_CONFIG_RULE_SIZE)
+    {
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < count; ++i, p += COMPILED_CONFIG_RULE_SIZE)
+    {
+        if (dlb_lip_latency_table_set(p_table, p, p + DLB_LIP_LATENCY_TABLE_DIMENSIONS, p[2 * DLB_LIP_LATENCY_TABLE_DIMENSIONS]))
+        {
+            return NULL;
+        }
+    }
+
+    return p;
+}
+
+int dlb_lip_compiled_config_write(const char *path, const dlb_lip_xml_parser_t *p_parser, uint32_t library_version)
+{
+    compiled_config_header_t header;
+    const uint32_t           device_type      = (uint32_t)p_parser->device_type;
+    const uint32_t           dependency_count = p_parser->dependency_count;
+    const size_t             payload_size     = COMPILED_CONFIG_TABLES_OFFSET + 2 * sizeof(uint32_t)
+                                   + (compiled_rule_count(&p_parser->video_latencies)
+                                      + compiled_rule_count(&p_parser->audio_latencies))
+                                         * COMPILED_CONFIG_RULE_SIZE;
+    unsigned char *const payload = (unsigned char *)malloc(payload_size);
+    char                 tmp_path[FILENAME_MAX];
+    FILE *               file = NULL;
+    unsigned char *      p    = payload;
+    int                  ret  = 0;
+
+    if (payload == NULL)
+    {
+        fprintf(stderr, "ERROR: Out of memory for compiled config %s.\n", path);
+        return 1;
+    }
+
+    memcpy(p, &p_parser->config_params, sizeof(p_parser->config_params));
+    p += sizeof(p_parser->config_params);
+    memcpy(p, &p_parser->physical_address, sizeof(p_parser->physical_address));
+    p += sizeof(p_parser->physical_address);
+    memcpy(p, &device_type, sizeof(device_type));
+    p += sizeof(device_type);
+    memcpy(p, &dependency_count, sizeof(dependency_count));
+    p += sizeof(dependency_count);
+    memcpy(p, p_parser->dependencies, sizeof(p_parser->dependencies));
+    p += sizeof(p_parser->dependencies);
+    p = write_compiled_table(p, &p_parser->video_latencies);
+    write_compiled_table(p, &p_parser->audio_latencies);
+
+    header.magic           = COMPILED_CONFIG_MAGIC;
+    header.version         = COMPILED_CONFIG_VERSION;
+    header.library_version = library_version;
+    header.payload_size    = (uint32_t)payload_size;
+    header.hash            = compiled_config_hash(payload, payload_size);
+
+    // Written to a temporary file and renamed, a tool starting meanwhile never maps a partially written file
+    if ((size_t)snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= sizeof(tmp_path))
+    {
+        fprintf(stderr, "ERROR: Path of the compiled config %s is too long.\n", path);
+        free(payload);
+        return 1;
+    }
+
+    file = fopen(tmp_path, "wb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "ERROR: Couldn't create compiled config %s.\n", tmp_path);
+        free(payload);
+        return 1;
+    }
+    if (fwrite(&header, sizeof(header), 1, file) != 1 || fwrite(payload, payload_size, 1, file) != 1)
+    {
+        ret = 1;
+    }
+    if (fclose(file) != 0)
+    {
+        ret = 1;
+    }
+    free(payload);
+
+#if defined(_MSC_VER)
+    remove(path);
+#endif
+    if (ret == 0 && rename(tmp_path, path) != 0)
+    {
+        ret = 1;
+    }
+    if (ret != 0)
+    {
+        fprintf(stderr, "ERROR: Couldn't write compiled config %s.\n", path);
+        remove(tmp_path);
+    }
+
+    return ret;
+}
+
+/*!
+Checks if the XML file or any of its base and included files changed since the config was compiled.
+The XML file is looked for at the path it is loaded from, base and included files at the paths they were parsed from.
+
+@return true if the compiled file is stale
+*/
+static bool compiled_config_stale(const char *path, const char *xml_path, const unsigned char *dependencies, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        dlb_lip_xml_dependency_t dependency;
+        dlb_lip_xml_dependency_t current;
+
+        memcpy(&dependency, dependencies + i * sizeof(dependency), sizeof(dependency));
+        if (i == 0)
+        {
+            snprintf(dependency.path, sizeof(dependency.path), "%s", xml_path);
+        }
+        // Missing file doesn't make the compiled file stale, only compiled files may be deployed
+        if (dlb_lip_xml_dependency_stat(&current, dependency.path) == 0
+            && (current.mtime != dependency.mtime || current.size != dependency.size))
+        {
+            fprintf(stderr, "WARNING: Compiled config %s is older than %s, XML file is parsed.\n", path, dependency.path);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*!
+Validates content of the compiled file and copies the payload to the parser.
+
+@return 0 on success, 1 if the content is invalid or stale
+*/
+static int compiled_config_parse(
+    const char *          path,
+    const char *          xml_path,
+    const unsigned char * data,
+    size_t                size,
+    dlb_lip_xml_parser_t *p_parser,
+    uint32_t              library_version)
+{
+    compiled_config_header_t header;
+    const char *             reason = NULL;
+    const unsigned char *    p_rules;
+    uint32_t                 device_type;
+    uint32_t                 dependency_count = 0;
+
+    if (size < sizeof(header))
+    {
+        reason = "size";
+    }
+    else
+    {
+        memcpy(&header, data, sizeof(header));
+        data += sizeof(header);
+        if (header.magic != COMPILED_CONFIG_MAGIC || header.version != COMPILED_CONFIG_VERSION)
+        {
+            reason = "format";
+        }
+        else if (header.library_version != library_version)
+        {
+            reason = "dlb_lip version";
+        }
+        else if (header.payload_size != size - sizeof(header) || header.payload_size < COMPILED_CONFIG_TABLES_OFFSET
+                 || header.payload_size > COMPILED_CONFIG_MAX_PAYLOAD_SIZE)
+        {
+            reason = "size";
+        }
+        else if (compiled_config_hash(data, header.payload_size) != header.hash)
+        {
+            reason = "checksum";
+        }
+        else
+        {
+            memcpy(&dependency_count, data + COMPILED_CONFIG_DEPENDENCIES_OFFSET, sizeof(dependency_count));
+            if (dependency_count > MAX_XML_DEPENDENCIES)
+            {
+                reason = "format";
+            }
+        }
+    }
+
+    if (reason)
+    {
+        fprintf(stderr, "WARNING: Compiled config %s rejected(%s), XML file is parsed.\n", path, reason);
+        return 1;
+    }
+    if (compiled_config_stale(
+            path, xml_path, data + COMPILED_CONFIG_DEPENDENCIES_OFFSET + sizeof(dependency_count), dependency_count))
+    {
+        return 1;
+    }
+
+    dlb_lip_latency_table_init(&p_parser->video_latencies, MAX_VICS, LIP_COLOR_FORMAT_COUNT, HDR_MODES_COUNT);
+    dlb_lip_latency_table_init(
+        &p_parser->audio_latencies, IEC61937_AUDIO_CODECS, IEC61937_SUBTYPES, MAX_AUDIO_FORMAT_EXTENSIONS);
+    p_rules = read_compiled_table(data + COMPILED_CONFIG_TABLES_OFFSET, data + header.payload_size, &p_parser->video_latencies);
+    if (p_rules == NULL || read_compiled_table(p_rules, data + header.payload_size, &p_parser->audio_latencies) == NULL)
+    {
+        fprintf(stderr, "WARNING: Compiled config %s rejected(latency rules), XML file is parsed.\n", path);
+        dlb_lip_xml_parser_destroy(p_parser);
+        return 1;
+    }
+
+    memcpy(&p_parser->config_params, data, sizeof(p_parser->config_params));
+    data += sizeof(p_parser->config_params);
+    memcpy(&p_parser->physical_address, data, sizeof(p_parser->physical_address));
+    data += sizeof(p_parser->physical_address);
+    memcpy(&device_type, data, sizeof(device_type));
+    data += sizeof(device_type) + sizeof(dependency_count);
+    p_parser->device_type = (dlb_lip_device_type_t)device_type;
+    memcpy(p_parser->dependencies, data, sizeof(p_parser->dependencies));
+    p_parser->dependency_count = dependency_count;
+
+    return 0;
+}
+
+int dlb_lip_compiled_config_load(
+    const char *path, const char *xml_path, dlb_lip_xml_parser_t *p_parser, uint32_t library_version)
+{
+    struct stat compiled_st;
+    int         ret = 1;
+
+    if (stat(path, &compiled_st) != 0)
+    {
+        return 1;
+    }
+
+#if defined(_MSC_VER)
+    {
+        const size_t         max_size = sizeof(compiled_config_header_t) + COMPILED_CONFIG_MAX_PAYLOAD_SIZE;
+        unsigned char *const data     = (unsigned char *)malloc(max_size);
+        FILE *               file     = fopen(path, "rb");
+        size_t               size     = 0;
+
+        if (file == NULL || data == NULL)
+        {
+            if (file)
+            {
+                fclose(file);
+            }
+            free(data);
+            return 1;
+        }
+        size = fread(data, 1, max_size, file);
+        if (size == max_size && fgetc(file) != EOF)
+        {
+            size += 1;
+        }
+        fclose(file);
+        // Longer file is rejected by its size
+        ret = compiled_config_parse(path, xml_path, data, size, p_parser, library_version);
+        free(data);
+    }
+#else
+    {
+        const int   fd = open(path, O_RDONLY);
+        struct stat st;
+        void *      p_map = MAP_FAILED;
+
+        if (fd < 0)
+        {
+            return 1;
+        }
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            p_map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+        if (p_map == MAP_FAILED)
+        {
+            fprintf(stderr, "WARNING: Couldn't map compiled config %s, XML file is parsed.\n", path);
+            return 1;
+        }
+        ret = compiled_config_parse(
+            path, xml_path, (const unsigned char *)p_map, (size_t)st.st_size, p_parser, library_version);
+        munmap(p_map, (size_t)st.st_size);
+    }
+#endif
+
+    return ret;
+}
@@ -0,0 +1,131 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_config_fingerprint.c
+ *  @brief      Incremental fingerprint of a LIP config
+ */
+
+#include <stddef.h>
+
+#include "dlb_lip_config_fingerprint.h"
+
+/*!
+Hash of one latency cell(splitmix64 finalizer), cells are hashed independently so they can be added and removed.
+
+@return hash
+*/
+static uint64_t hash_cell(size_t index, uint8_t latency)
+{
+    uint64_t x = (((uint64_t)index << 8) | latency) + 0x9E3779B97F4A7C15ULL;
+
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+static uint64_t hash_table(const uint8_t *p_cells, size_t size)
+{
+    uint64_t hash = 0;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash += hash_cell(i, p_cells[i]);
+    }
+
+    return hash;
+}
+
+/*!
+Replaces the cell hash in the table hash and sets the cell.
+*/
+static void set_cell(uint64_t *p_hash, const uint8_t *p_first, uint8_t *p_cell, uint8_t latency)
+{
+    const size_t index = (size_t)(p_cell - p_first);
+
+    *p_hash = *p_hash - hash_cell(index, *p_cell) + hash_cell(index, latency);
+    *p_cell = latency;
+}
+
+void dlb_lip_config_fingerprint_init(dlb_lip_config_fingerprint_t *p_fingerprint, const dlb_lip_config_params_t *p_config)
+{
+    dlb_lip_config_fingerprint_update_params(p_fingerprint, p_config);
+    p_fingerprint->audio = hash_table(&p_config->audio_latencies[0][0][0], sizeof(p_config->audio_latencies));
+    p_fingerprint->video = hash_table(&p_config->video_latencies[0][0][0], sizeof(p_config->video_latencies));
+}
+
+void dlb_lip_config_fingerprint_update_params(
+    dlb_lip_config_fingerprint_t *p_fingerprint, const dlb_lip_config_params_t *p_config)
+{
+    // FNV-1a of the fields, padding of the structures is not hashed
+    const uint32_t fields[] = { (uint32_t)p_config->downstream_device_addr,
+                                p_config->audio_transcoding ? 1U : 0U,
+                                (uint32_t)p_config->audio_transcoding_format.codec,
+                                p_config->audio_transcoding_format.subtype,
+                                p_config->audio_transcoding_format.ext,
+                                p_config->render_mode };
+    uint64_t       hash     = 14695981039346656037ULL;
+
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); ++i)
+    {
+        hash = (hash ^ fields[i]) * 1099511628211ULL;
+    }
+
+    p_fingerprint->uuid   = p_config->uuid;
+    p_fingerprint->params = hash;
+}
+
+void dlb_lip_config_fingerprint_set_audio_latency(
+    dlb_lip_config_fingerprint_t *p_fingerprint,
+    dlb_lip_config_params_t *     p_config,
+    const dlb_lip_audio_format_t *p_format,
+    uint8_t                       latency)
+{
+    set_cell(
+        &p_fingerprint->audio,
+        &p_config->audio_latencies[0][0][0],
+        &p_config->audio_latencies[p_format->codec][p_format->subtype][p_format->ext],
+        latency);
+}
+
+void dlb_lip_config_fingerprint_set_video_latency(
+    dlb_lip_config_fingerprint_t *p_fingerprint,
+    dlb_lip_config_params_t *     p_config,
+    const dlb_lip_video_format_t *p_format,
+    uint8_t                       hdr_mode,
+    uint8_t                       latency)
+{
+    set_cell(
+        &p_fingerprint->video,
+        &p_config->video_latencies[0][0][0],
+        &p_config->video_latencies[p_format->vic][p_format->color_format][hdr_mode],
+        latency);
+}
+
+unsigned int dlb_lip_config_fingerprint_compare(const dlb_lip_config_fingerprint_t *p_a, const dlb_lip_config_fingerprint_t *p_b)
+{
+    unsigned int changes = 0;
+
+    if (p_a->uuid != p_b->uuid || p_a->params != p_b->params)
+    {
+        changes |= DLB_LIP_CONFIG_PARAMS_CHANGED;
+    }
+    if (p_a->audio != p_b->audio)
+    {
+        changes |= DLB_LIP_CONFIG_AUDIO_CHANGED;
+    }
+    if (p_a->video != p_b->video)
+    {
+        changes |= DLB_LIP_CONFIG_VIDEO_CHANGED;
+    }
+
+    return changes;
+}
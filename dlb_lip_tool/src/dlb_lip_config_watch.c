@@ -0,0 +1,284 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_config_watch.c
+ *  @brief      Watches XML config files for changes(inotify)
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dlb_lip_config_watch.h"
+#include "dlb_lip_tool_osa.h"
+
+#if defined(_MSC_VER)
+
+int dlb_lip_config_watch_open(const char *const *paths, unsigned int count, dlb_lip_config_watch_callback_t callback, void *arg)
+{
+    (void)paths;
+    (void)count;
+    (void)callback;
+    (void)arg;
+    fprintf(stderr, "ERROR: Config watch is not supported on this platform!\n");
+    return 1;
+}
+
+int dlb_lip_config_watch_add(const char *path, unsigned int index)
+{
+    (void)path;
+    (void)index;
+    return 1;
+}
+
+void dlb_lip_config_watch_close(void) {}
+
+#else
+
+#include <limits.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#define POLL_TIMEOUT_MS 50
+
+typedef struct watched_file_s
+{
+    int                wd;
+    char               name[NAME_MAX + 1];
+    unsigned int       index; // Index of the config reported when the file changes
+    bool               pending;
+    unsigned long long changed_us; // Time of the last write seen
+} watched_file_t;
+
+typedef struct config_watch_s
+{
+    int                             fd;
+    bool                            running;
+    dlb_lip_tool_thread_t           thread;
+    dlb_lip_tool_mutex_t            mutex; // Protects running and files added while the thread runs
+    watched_file_t                  files[DLB_LIP_CONFIG_WATCH_MAX_FILES];
+    unsigned int                    count;
+    unsigned int                    config_count;
+    dlb_lip_config_watch_callback_t callback;
+    void *                          arg;
+} config_watch_t;
+
+static config_watch_t config_watch = { .fd = -1 };
+
+/*!
+Marks files named by the inotify events as changed.
+*/
+static void read_watch_events(void)
+{
+    char    buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t size = 0;
+
+    while ((size = read(config_watch.fd, buffer, sizeof(buffer))) > 0)
+    {
+        const unsigned long long now_us = dlb_lip_tool_time_us();
+
+        dlb_lip_tool_mutex_lock(&config_watch.mutex);
+        for (char *p = buffer; p < buffer + size;)
+        {
+            const struct inotify_event *const p_event = (const struct inotify_event *)p;
+
+            for (unsigned int i = 0; p_event->len > 0 && i < config_watch.count; ++i)
+            {
+                watched_file_t *const p_file = &config_watch.files[i];
+
+                if (p_file->wd == p_event->wd && strcmp(p_file->name, p_event->name) == 0)
+                {
+                    p_file->pending    = true;
+                    p_file->changed_us = now_us;
+                }
+            }
+            p += sizeof(struct inotify_event) + p_event->len;
+        }
+        dlb_lip_tool_mutex_unlock(&config_watch.mutex);
+    }
+}
+
+static bool config_watch_running(void)
+{
+    bool running = false;
+
+    dlb_lip_tool_mutex_lock(&config_watch.mutex);
+    running = config_watch.running;
+    dlb_lip_tool_mutex_unlock(&config_watch.mutex);
+
+    return running;
+}
+
+static void watch_thread(void *arg)
+{
+    (void)arg;
+
+    while (config_watch_running())
+    {
+        struct pollfd      pfd                                     = { config_watch.fd, POLLIN, 0 };
+        bool               changed[DLB_LIP_CONFIG_WATCH_MAX_FILES] = { false };
+        unsigned long long now_us;
+
+        if (poll(&pfd, 1, POLL_TIMEOUT_MS) > 0)
+        {
+            read_watch_events();
+        }
+
+        // Config is reported once when several of its files settled, the callback may add files
+        now_us = dlb_lip_tool_time_us();
+        dlb_lip_tool_mutex_lock(&config_watch.mutex);
+        for (unsigned int i = 0; i < config_watch.count; ++i)
+        {
+            watched_file_t *const p_file = &config_watch.files[i];
+
+            if (p_file->pending && now_us - p_file->changed_us >= DLB_LIP_CONFIG_WATCH_SETTLE_MS * 1000ULL)
+            {
+                p_file->pending        = false;
+                changed[p_file->index] = true;
+            }
+        }
+        dlb_lip_tool_mutex_unlock(&config_watch.mutex);
+
+        for (unsigned int i = 0; i < config_watch.config_count && config_watch_running(); ++i)
+        {
+            if (changed[i])
+            {
+                config_watch.callback(config_watch.arg, i);
+            }
+        }
+    }
+}
+
+/*!
+Watches the directory of the file for writes of the file, files of the same directory share the watch descriptor.
+Called with the mutex locked.
+
+@return 0 on success, 1 on error
+*/
+static int watch_file(const char *path, unsigned int index)
+{
+    const char *const separator = strrchr(path, '/');
+    watched_file_t    file      = { 0 };
+    char              directory[PATH_MAX];
+
+    if (separator == NULL)
+    {
+        snprintf(directory, sizeof(directory), ".");
+    }
+    else
+    {
+        snprintf(directory, sizeof(directory), "%.*s", separator == path ? 1 : (int)(separator - path), path);
+    }
+    snprintf(file.name, sizeof(file.name), "%s", separator ? separator + 1 : path);
+    file.index = index;
+
+    file.wd = inotify_add_watch(config_watch.fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (file.wd < 0)
+    {
+        fprintf(stderr, "ERROR: Couldn't watch directory %s of config file %s.\n", directory, path);
+        return 1;
+    }
+    for (unsigned int i = 0; i < config_watch.count; ++i)
+    {
+        const watched_file_t *const p_file = &config_watch.files[i];
+
+        if (p_file->index == index && p_file->wd == file.wd && strcmp(p_file->name, file.name) == 0)
+        {
+            return 0;
+        }
+    }
+    if (config_watch.count == DLB_LIP_CONFIG_WATCH_MAX_FILES)
+    {
+        fprintf(stderr, "ERROR: Too many config files to watch.\n");
+        return 1;
+    }
+    config_watch.files[config_watch.count++] = file;
+
+    return 0;
+}
+
+int dlb_lip_config_watch_open(const char *const *paths, unsigned int count, dlb_lip_config_watch_callback_t callback, void *arg)
+{
+    if (count > DLB_LIP_CONFIG_WATCH_MAX_FILES)
+    {
+        fprintf(stderr, "ERROR: Too many config files to watch.\n");
+        return 1;
+    }
+
+    memset(&config_watch, 0, sizeof(config_watch));
+    config_watch.callback     = callback;
+    config_watch.arg          = arg;
+    config_watch.config_count = count;
+
+    config_watch.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (config_watch.fd < 0)
+    {
+        fprintf(stderr, "ERROR: Couldn't initialize inotify.\n");
+        return 1;
+    }
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (watch_file(paths[i], i))
+        {
+            close(config_watch.fd);
+            config_watch.fd = -1;
+            return 1;
+        }
+    }
+
+    dlb_lip_tool_mutex_init(&config_watch.mutex);
+    config_watch.running = true;
+    if (dlb_lip_tool_thread_create(&config_watch.thread, watch_thread, NULL))
+    {
+        config_watch.running = false;
+        dlb_lip_tool_mutex_destroy(&config_watch.mutex);
+        close(config_watch.fd);
+        config_watch.fd = -1;
+        return 1;
+    }
+
+    return 0;
+}
+
+int dlb_lip_config_watch_add(const char *path, unsigned int index)
+{
+    int ret = 1;
+
+    if (config_watch.fd < 0 || index >= config_watch.config_count)
+    {
+        return 1;
+    }
+
+    dlb_lip_tool_mutex_lock(&config_watch.mutex);
+    ret = watch_file(path, index);
+    dlb_lip_tool_mutex_unlock(&config_watch.mutex);
+
+    return ret;
+}
+
+void dlb_lip_config_watch_close(void)
+{
+    if (config_watch.fd >= 0)
+    {
+        dlb_lip_tool_mutex_lock(&config_watch.mutex);
+        config_watch.running = false;
+        dlb_lip_tool_mutex_unlock(&config_watch.mutex);
+        dlb_lip_tool_thread_join(&config_watch.thread);
+        dlb_lip_tool_mutex_destroy(&config_watch.mutex);
+        close(config_watch.fd);
+        config_watch.fd = -1;
+    }
+}
+
+#endif
@@ -0,0 +1,420 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_control_socket.c
+ *  @brief      Unix-domain socket control interface
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dlb_lip_control_socket.h"
+#include "dlb_lip_tool_osa.h"
+
+#if defined(_MSC_VER)
+
+int dlb_lip_control_socket_open(const char *socket_path, dlb_lip_control_execute_callback_t execute, void *arg)
+{
+    (void)socket_path;
+    (void)execute;
+    (void)arg;
+    fprintf(stderr, "ERROR: Control socket is not supported on this platform!\n");
+    return 1;
+}
+
+void dlb_lip_control_socket_close(void) {}
+
+#else
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define POLL_TIMEOUT_MS 200
+
+#if !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL 0
+#endif
+
+typedef struct control_client_s
+{
+    int                   fd;
+    bool                  active;
+    bool                  finished; /**< Set by the client thread, guarded by mutex of the socket */
+    dlb_lip_tool_thread_t thread;
+} control_client_t;
+
+typedef struct control_socket_s
+{
+    int                                listen_fd;
+    char                               path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+    dlb_lip_tool_mutex_t               mutex; /**< Guards running and finished flags of the clients */
+    bool                               running;
+    dlb_lip_tool_thread_t              accept_thread;
+    control_client_t                   clients[DLB_LIP_CONTROL_MAX_CLIENTS];
+    dlb_lip_control_execute_callback_t execute;
+    void *                             arg;
+} control_socket_t;
+
+static control_socket_t control_socket = { .listen_fd = -1 };
+
+static const char *control_status_description(dlb_lip_control_status_t status)
+{
+    const char *str = NULL;
+    switch (status)
+    {
+    case DLB_LIP_CONTROL_OK:
+        str = "ok";
+        break;
+    case DLB_LIP_CONTROL_ERROR:
+        str = "error";
+        break;
+    case DLB_LIP_CONTROL_UNKNOWN:
+        str = "unknown";
+        break;
+    case DLB_LIP_CONTROL_QUIT:
+        str = "quit";
+        break;
+    default:
+        str = "error";
+        break;
+    }
+    return str;
+}
+
+/*!
+Appends JSON escaped string, output is truncated if it doesn't fit.
+
+@return pointer to the end of the written string
+*/
+static char *append_json_string(char *dst, char *end, const char *src)
+{
+    while (*src && dst < end)
+    {
+        const unsigned char ch = (unsigned char)*src++;
+        char                escaped[8];
+        int                 len = 0;
+
+        if (ch == '"' || ch == '\\')
+        {
+            len = snprintf(escaped, sizeof(escaped), "\\%c", ch);
+        }
+        else if (ch == '\n')
+        {
+            len = snprintf(escaped, sizeof(escaped), "\\n");
+        }
+        else if (ch == '\r')
+        {
+            len = snprintf(escaped, sizeof(escaped), "\\r");
+        }
+        else if (ch == '\t')
+        {
+            len = snprintf(escaped, sizeof(escaped), "\\t");
+        }
+        else if (ch < 0x20)
+        {
+            len = snprintf(escaped, sizeof(escaped), "\\u%04x", ch);
+        }
+        else
+        {
+            escaped[0] = (char)ch;
+            len        = 1;
+        }
+
+        if (end - dst < len)
+        {
+            break;
+        }
+        memcpy(dst, escaped, (size_t)len);
+        dst += len;
+    }
+
+    return dst;
+}
+
+static int send_all(int fd, const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        const ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent <= 0)
+        {
+            return 1;
+        }
+        data += sent;
+        size -= (size_t)sent;
+    }
+    return 0;
+}
+
+static int send_response(int fd, const char *id, dlb_lip_control_status_t status, const char *output)
+{
+    char        response[DLB_LIP_CONTROL_MAX_OUTPUT * 2 + DLB_LIP_CONTROL_MAX_REQUEST];
+    char *const end = response + sizeof(response) - 4;
+    char *      ptr = response;
+
+    // request id is shorter than DLB_LIP_CONTROL_MAX_REQUEST, only output may be truncated
+    ptr += snprintf(ptr, (size_t)(end - ptr), "{\"id\":\"");
+    ptr = append_json_string(ptr, end, id);
+    ptr += snprintf(ptr, (size_t)(end - ptr), "\",\"status\":\"%s\",\"output\":\"", control_status_description(status));
+    ptr = append_json_string(ptr, end, output);
+    memcpy(ptr, "\"}\n", 3);
+    ptr += 3;
+
+    return send_all(fd, response, (size_t)(ptr - response));
+}
+
+static bool control_socket_running(void)
+{
+    bool running = false;
+
+    dlb_lip_tool_mutex_lock(&control_socket.mutex);
+    running = control_socket.running;
+    dlb_lip_tool_mutex_unlock(&control_socket.mutex);
+
+    return running;
+}
+
+/*!
+Handles single "<request_id> <command>" line.
+
+@return true if connection should be closed
+*/
+static bool handle_request(int fd, char *line)
+{
+    char                     output[DLB_LIP_CONTROL_MAX_OUTPUT] = { 0 };
+    char *                   id                                 = line;
+    char *                   command                            = NULL;
+    dlb_lip_control_status_t status                             = DLB_LIP_CONTROL_ERROR;
+
+    line[strcspn(line, "\r")] = '\0';
+    while (*id == ' ' || *id == '\t')
+    {
+        id++;
+    }
+    if (*id == '\0')
+    {
+        return false;
+    }
+
+    command = id + strcspn(id, " \t");
+    if (*command)
+    {
+        *command++ = '\0';
+        while (*command == ' ' || *command == '\t')
+        {
+            command++;
+        }
+    }
+
+    if (*command == '\0')
+    {
+        snprintf(output, sizeof(output), "missing command");
+    }
+    else
+    {
+        status = control_socket.execute(control_socket.arg, command, output, sizeof(output));
+    }
+
+    if (send_response(fd, id, status, output))
+    {
+        return true;
+    }
+
+    return status == DLB_LIP_CONTROL_QUIT;
+}
+
+static void client_thread(void *arg)
+{
+    control_client_t *p_client                             = (control_client_t *)arg;
+    char              buffer[DLB_LIP_CONTROL_MAX_REQUEST]  = { 0 };
+    size_t            used                                 = 0;
+    bool              close_connection                     = false;
+
+    while (!close_connection && control_socket_running())
+    {
+        struct pollfd pfd = { p_client->fd, POLLIN, 0 };
+        ssize_t       received;
+        char *        newline;
+
+        if (poll(&pfd, 1, POLL_TIMEOUT_MS) <= 0)
+        {
+            continue;
+        }
+
+        received = recv(p_client->fd, buffer + used, sizeof(buffer) - used - 1, 0);
+        if (received <= 0)
+        {
+            break;
+        }
+        used += (size_t)received;
+        buffer[used] = '\0';
+
+        while (!close_connection && (newline = strchr(buffer, '\n')) != NULL)
+        {
+            *newline         = '\0';
+            close_connection = handle_request(p_client->fd, buffer);
+            used -= (size_t)(newline + 1 - buffer);
+            memmove(buffer, newline + 1, used + 1);
+        }
+
+        if (used == sizeof(buffer) - 1)
+        {
+            send_response(p_client->fd, "", DLB_LIP_CONTROL_ERROR, "request too long");
+            break;
+        }
+    }
+
+    close(p_client->fd);
+    dlb_lip_tool_mutex_lock(&control_socket.mutex);
+    p_client->finished = true;
+    dlb_lip_tool_mutex_unlock(&control_socket.mutex);
+}
+
+static void reap_clients(bool wait_all)
+{
+    for (unsigned int i = 0; i < DLB_LIP_CONTROL_MAX_CLIENTS; ++i)
+    {
+        control_client_t *p_client = &control_socket.clients[i];
+        bool              finished = false;
+
+        dlb_lip_tool_mutex_lock(&control_socket.mutex);
+        finished = p_client->finished;
+        dlb_lip_tool_mutex_unlock(&control_socket.mutex);
+        if (p_client->active && (wait_all || finished))
+        {
+            dlb_lip_tool_thread_join(&p_client->thread);
+            p_client->active = false;
+        }
+    }
+}
+
+static void accept_thread(void *arg)
+{
+    (void)arg;
+
+    while (control_socket_running())
+    {
+        struct pollfd     pfd      = { control_socket.listen_fd, POLLIN, 0 };
+        control_client_t *p_client = NULL;
+        int               fd;
+
+        reap_clients(false);
+        if (poll(&pfd, 1, POLL_TIMEOUT_MS) <= 0)
+        {
+            continue;
+        }
+
+        fd = accept(control_socket.listen_fd, NULL, NULL);
+        if (fd < 0)
+        {
+            continue;
+        }
+
+        for (unsigned int i = 0; i < DLB_LIP_CONTROL_MAX_CLIENTS; ++i)
+        {
+            if (!control_socket.clients[i].active)
+            {
+                p_client = &control_socket.clients[i];
+                break;
+            }
+        }
+
+        if (p_client == NULL)
+        {
+            send_response(fd, "", DLB_LIP_CONTROL_ERROR, "too many clients");
+            close(fd);
+            continue;
+        }
+
+        p_client->fd       = fd;
+        p_client->finished = false;
+        p_client->active   = true;
+        if (dlb_lip_tool_thread_create(&p_client->thread, client_thread, p_client))
+        {
+            p_client->active = false;
+            close(fd);
+        }
+    }
+
+    reap_clients(true);
+}
+
+int dlb_lip_control_socket_open(const char *socket_path, dlb_lip_control_execute_callback_t execute, void *arg)
+{
+    struct sockaddr_un addr;
+
+    if (strlen(socket_path) >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, "ERROR: Control socket path is too long.\n");
+        return 1;
+    }
+
+    memset(&control_socket, 0, sizeof(control_socket));
+    control_socket.execute = execute;
+    control_socket.arg     = arg;
+    snprintf(control_socket.path, sizeof(control_socket.path), "%s", socket_path);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", socket_path);
+
+    control_socket.listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (control_socket.listen_fd < 0)
+    {
+        fprintf(stderr, "ERROR: Couldn't create control socket.\n");
+        return 1;
+    }
+
+    unlink(socket_path);
+    if (bind(control_socket.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0
+        || listen(control_socket.listen_fd, DLB_LIP_CONTROL_MAX_CLIENTS) != 0)
+    {
+        fprintf(stderr, "ERROR: Couldn't listen on control socket(%s).\n", socket_path);
+        close(control_socket.listen_fd);
+        control_socket.listen_fd = -1;
+        return 1;
+    }
+
+    dlb_lip_tool_mutex_init(&control_socket.mutex);
+    control_socket.running = true;
+    if (dlb_lip_tool_thread_create(&control_socket.accept_thread, accept_thread, NULL))
+    {
+        control_socket.running = false;
+        dlb_lip_tool_mutex_destroy(&control_socket.mutex);
+        close(control_socket.listen_fd);
+        control_socket.listen_fd = -1;
+        unlink(socket_path);
+        return 1;
+    }
+
+    return 0;
+}
+
+void dlb_lip_control_socket_close(void)
+{
+    if (control_socket.listen_fd >= 0)
+    {
+        dlb_lip_tool_mutex_lock(&control_socket.mutex);
+        control_socket.running = false;
+        dlb_lip_tool_mutex_unlock(&control_socket.mutex);
+        dlb_lip_tool_thread_join(&control_socket.accept_thread);
+        dlb_lip_tool_mutex_destroy(&control_socket.mutex);
+        close(control_socket.listen_fd);
+        control_socket.listen_fd = -1;
+        unlink(control_socket.path);
+    }
+}
+
+#endif
@@ -0,0 +1,371 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_latency_table.c
+ *  @brief      Sparse latency table of the device config
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dlb_lip_latency_table.h"
+#include "dlb_lip_types.h"
+
+#define LATENCY_TABLE_MIN_CAPACITY 16U // Rules allocated by the first rule set to the table
+
+static bool latency_rule_covers(const dlb_lip_latency_rule_t *p_rule, const dlb_lip_latency_rule_t *p_other)
+{
+    for (unsigned int d = 0; d < DLB_LIP_LATENCY_TABLE_DIMENSIONS; ++d)
+    {
+        if (p_other->first[d] < p_rule->first[d] || p_other->last[d] > p_rule->last[d])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool latency_rule_intersects(
+    const dlb_lip_latency_rule_t *p_rule,
+    const uint8_t                 first[DLB_LIP_LATENCY_TABLE_DIMENSIONS],
+    const uint8_t                 last[DLB_LIP_LATENCY_TABLE_DIMENSIONS])
+{
+    for (unsigned int d = 0; d < DLB_LIP_LATENCY_TABLE_DIMENSIONS; ++d)
+    {
+        if (last[d] < p_rule->first[d] || first[d] > p_rule->last[d])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static size_t latency_table_cell_count(const dlb_lip_latency_table_t *p_table)
+{
+    return (size_t)p_table->size[0] * p_table->size[1] * p_table->size[2];
+}
+
+static size_t latency_table_offset(const dlb_lip_latency_table_t *p_table, size_t index0, size_t index1, size_t index2)
+{
+    return (index0 * p_table->size[1] + index1) * p_table->size[2] + index2;
+}
+
+/*!
+Writes latency of the rule to its block of the dense array, a block is one memset when it spans whole rows or planes.
+*/
+static void fill_latency_rule(const dlb_lip_latency_table_t *p_table, const dlb_lip_latency_rule_t *p_rule, uint8_t *dense)
+{
+    const size_t row       = p_table->size[2];
+    const size_t plane     = p_table->size[1] * row;
+    const bool   full_row  = p_rule->first[2] == 0 && p_rule->last[2] + 1U == p_table->size[2];
+    const bool   full_cols = p_rule->first[1] == 0 && p_rule->last[1] + 1U == p_table->size[1];
+
+    if (full_row && full_cols)
+    {
+        memset(dense + p_rule->first[0] * plane, p_rule->latency, (p_rule->last[0] - p_rule->first[0] + 1U) * plane);
+        return;
+    }
+    for (size_t i0 = p_rule->first[0]; i0 <= p_rule->last[0]; ++i0)
+    {
+        if (full_row)
+        {
+            memset(dense + i0 * plane + p_rule->first[1] * row, p_rule->latency, (p_rule->last[1] - p_rule->first[1] + 1U) * row);
+            continue;
+        }
+        for (size_t i1 = p_rule->first[1]; i1 <= p_rule->last[1]; ++i1)
+        {
+            memset(dense + i0 * plane + i1 * row + p_rule->first[2], p_rule->latency, p_rule->last[2] - p_rule->first[2] + 1U);
+        }
+    }
+}
+
+/*!
+Allocates room for the number of rules, capacity is doubled so rules set one by one are rarely reallocated.
+
+@return 0 on success, 1 if memory couldn't be allocated
+*/
+static int reserve_latency_rules(dlb_lip_latency_table_t *p_table, unsigned int count)
+{
+    unsigned int            capacity = p_table->rule_capacity ? p_table->rule_capacity : LATENCY_TABLE_MIN_CAPACITY;
+    dlb_lip_latency_rule_t *rules    = NULL;
+
+    if (count <= p_table->rule_capacity)
+    {
+        return 0;
+    }
+    while (capacity < count)
+    {
+        capacity *= 2U;
+    }
+    capacity = capacity < DLB_LIP_LATENCY_TABLE_MAX_RULES ? capacity : DLB_LIP_LATENCY_TABLE_MAX_RULES;
+
+    rules = (dlb_lip_latency_rule_t *)realloc(p_table->rules, capacity * sizeof(dlb_lip_latency_rule_t));
+    if (rules == NULL)
+    {
+        return 1;
+    }
+    p_table->rules         = rules;
+    p_table->rule_capacity = capacity;
+
+    return 0;
+}
+
+/*!
+Replaces the rules of the table by the dense array of its cells.
+
+@return 0 on success, 1 if memory couldn't be allocated(table is not changed)
+*/
+static int make_latency_table_dense(dlb_lip_latency_table_t *p_table)
+{
+    uint8_t *const cells = (uint8_t *)malloc(latency_table_cell_count(p_table));
+
+    if (cells == NULL)
+    {
+        return 1;
+    }
+    dlb_lip_latency_table_expand(p_table, cells);
+    free(p_table->rules);
+    p_table->rules         = NULL;
+    p_table->rule_capacity = 0;
+    p_table->rule_count    = 0;
+    p_table->cells         = cells;
+    p_table->dense         = true;
+
+    return 0;
+}
+
+void dlb_lip_latency_table_init(dlb_lip_latency_table_t *p_table, uint8_t size0, uint8_t size1, uint8_t size2)
+{
+    p_table->size[0]       = size0;
+    p_table->size[1]       = size1;
+    p_table->size[2]       = size2;
+    p_table->dense         = false;
+    p_table->rule_count    = 0;
+    p_table->rule_capacity = 0;
+    p_table->rules         = NULL;
+    p_table->cells         = NULL;
+}
+
+void dlb_lip_latency_table_destroy(dlb_lip_latency_table_t *p_table)
+{
+    free(p_table->rules);
+    free(p_table->cells);
+    dlb_lip_latency_table_init(p_table, p_table->size[0], p_table->size[1], p_table->size[2]);
+}
+
+int dlb_lip_latency_table_copy(dlb_lip_latency_table_t *p_dst, const dlb_lip_latency_table_t *p_src)
+{
+    if (p_dst == p_src)
+    {
+        return 0;
+    }
+
+    dlb_lip_latency_table_destroy(p_dst);
+    dlb_lip_latency_table_init(p_dst, p_src->size[0], p_src->size[1], p_src->size[2]);
+    if (p_src->dense)
+    {
+        p_dst->cells = (uint8_t *)malloc(latency_table_cell_count(p_src));
+        if (p_dst->cells == NULL)
+        {
+            return 1;
+        }
+        memcpy(p_dst->cells, p_src->cells, latency_table_cell_count(p_src));
+        p_dst->dense = true;
+    }
+    else if (p_src->rule_count > 0)
+    {
+        if (reserve_latency_rules(p_dst, p_src->rule_count))
+        {
+            return 1;
+        }
+        memcpy(p_dst->rules, p_src->rules, p_src->rule_count * sizeof(dlb_lip_latency_rule_t));
+        p_dst->rule_count = p_src->rule_count;
+    }
+
+    return 0;
+}
+
+int dlb_lip_latency_table_set(
+    dlb_lip_latency_table_t *p_table,
+    const uint8_t            first[DLB_LIP_LATENCY_TABLE_DIMENSIONS],
+    const uint8_t            last[DLB_LIP_LATENCY_TABLE_DIMENSIONS],
+    uint8_t                  latency)
+{
+    dlb_lip_latency_rule_t rule;
+    unsigned int           kept = 0;
+
+    for (unsigned int d = 0; d < DLB_LIP_LATENCY_TABLE_DIMENSIONS; ++d)
+    {
+        if (first[d] > last[d] || last[d] >= p_table->size[d])
+        {
+            return 1;
+        }
+        rule.first[d] = first[d];
+        rule.last[d]  = last[d];
+    }
+    rule.latency = latency;
+
+    if (!p_table->dense)
+    {
+        // Rules hidden completely by the new one are dropped, the table is changed only when the new rule fits
+        for (unsigned int i = 0; i < p_table->rule_count; ++i)
+        {
+            kept += latency_rule_covers(&rule, &p_table->rules[i]) ? 0U : 1U;
+        }
+
+        if (kept < DLB_LIP_LATENCY_TABLE_MAX_RULES)
+        {
+            if (reserve_latency_rules(p_table, kept + 1U))
+            {
+                return 1;
+            }
+            kept = 0;
+            for (unsigned int i = 0; i < p_table->rule_count; ++i)
+            {
+                if (!latency_rule_covers(&rule, &p_table->rules[i]))
+                {
+                    p_table->rules[kept++] = p_table->rules[i];
+                }
+            }
+            p_table->rules[kept] = rule;
+            p_table->rule_count  = kept + 1U;
+            return 0;
+        }
+        if (make_latency_table_dense(p_table))
+        {
+            return 1;
+        }
+    }
+    fill_latency_rule(p_table, &rule, p_table->cells);
+
+    return 0;
+}
+
+int dlb_lip_latency_table_set_cell(
+    dlb_lip_latency_table_t *p_table, uint8_t index0, uint8_t index1, uint8_t index2, uint8_t latency)
+{
+    const uint8_t index[DLB_LIP_LATENCY_TABLE_DIMENSIONS] = { index0, index1, index2 };
+
+    return dlb_lip_latency_table_set(p_table, index, index, latency);
+}
+
+uint8_t dlb_lip_latency_table_get(const dlb_lip_latency_table_t *p_table, uint8_t index0, uint8_t index1, uint8_t index2)
+{
+    if (p_table->dense)
+    {
+        return p_table->cells[latency_table_offset(p_table, index0, index1, index2)];
+    }
+
+    for (unsigned int i = p_table->rule_count; i > 0; --i)
+    {
+        const dlb_lip_latency_rule_t *const p_rule = &p_table->rules[i - 1];
+
+        if (index0 >= p_rule->first[0] && index0 <= p_rule->last[0] && index1 >= p_rule->first[1] && index1 <= p_rule->last[1]
+            && index2 >= p_rule->first[2] && index2 <= p_rule->last[2])
+        {
+            return p_rule->latency;
+        }
+    }
+
+    return LIP_INVALID_LATENCY;
+}
+
+bool dlb_lip_latency_table_intersects(
+    const dlb_lip_latency_table_t *p_table,
+    const uint8_t                  first[DLB_LIP_LATENCY_TABLE_DIMENSIONS],
+    const uint8_t                  last[DLB_LIP_LATENCY_TABLE_DIMENSIONS])
+{
+    if (!p_table->dense)
+    {
+        for (unsigned int i = 0; i < p_table->rule_count; ++i)
+        {
+            if (latency_rule_intersects(&p_table->rules[i], first, last))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    for (size_t i0 = first[0]; i0 <= last[0]; ++i0)
+    {
+        for (size_t i1 = first[1]; i1 <= last[1]; ++i1)
+        {
+            for (size_t i2 = first[2]; i2 <= last[2]; ++i2)
+            {
+                if (p_table->cells[latency_table_offset(p_table, i0, i1, i2)] != LIP_INVALID_LATENCY)
+                {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+int dlb_lip_latency_table_for_each_rule(
+    const dlb_lip_latency_table_t *p_table, dlb_lip_latency_rule_callback_t callback, void *arg)
+{
+    int ret = 0;
+
+    if (!p_table->dense)
+    {
+        for (unsigned int i = 0; i < p_table->rule_count && ret == 0; ++i)
+        {
+            ret = callback(arg, &p_table->rules[i]);
+        }
+        return ret;
+    }
+
+    for (unsigned int i0 = 0; i0 < p_table->size[0] && ret == 0; ++i0)
+    {
+        for (unsigned int i1 = 0; i1 < p_table->size[1] && ret == 0; ++i1)
+        {
+            const uint8_t *const   row  = &p_table->cells[latency_table_offset(p_table, i0, i1, 0)];
+            dlb_lip_latency_rule_t rule = { { (uint8_t)i0, (uint8_t)i1, 0 }, { (uint8_t)i0, (uint8_t)i1, 0 }, 0 };
+
+            for (unsigned int i2 = 0; i2 < p_table->size[2] && ret == 0; i2 = rule.last[2] + 1U)
+            {
+                rule.first[2] = (uint8_t)i2;
+                rule.last[2]  = (uint8_t)i2;
+                rule.latency  = row[i2];
+                while (rule.last[2] + 1U < p_table->size[2] && row[rule.last[2] + 1U] == rule.latency)
+                {
+                    rule.last[2] += 1;
+                }
+                if (rule.latency != LIP_INVALID_LATENCY)
+                {
+                    ret = callback(arg, &rule);
+                }
+            }
+        }
+    }
+
+    return ret;
+}
+
+void dlb_lip_latency_table_expand(const dlb_lip_latency_table_t *p_table, uint8_t *dense)
+{
+    if (p_table->dense)
+    {
+        memcpy(dense, p_table->cells, latency_table_cell_count(p_table));
+        return;
+    }
+
+    // Rules are applied in order, later rules overwrite cells of earlier ones
+    memset(dense, LIP_INVALID_LATENCY, latency_table_cell_count(p_table));
+    for (unsigned int i = 0; i < p_table->rule_count; ++i)
+    {
+        fill_latency_rule(p_table, &p_table->rules[i], dense);
+    }
+}
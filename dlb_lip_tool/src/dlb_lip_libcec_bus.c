@@ -21,6 +21,7 @@
 #include <assert.h>
 #include <ceccloader.h>
 #include <inttypes.h>
+#include <stdlib.h>
 
 struct dlb_cec_bus_handle_s
 {
@@ -33,10 +34,9 @@ struct dlb_cec_bus_handle_s
     void *                      callback_arg;
     bool                        sim_arc;
     bool                        arc_initiated;
+    dlb_cec_bus_stats_t         stats;
 };
 
-static dlb_cec_bus_handle_t cec_bus_handle;
-
 #define FATAL_ERROR(str)                                                         \
     do                                                                           \
     {                                                                            \
@@ -173,6 +173,8 @@ static void cb_cec_cmd_received(void *cb_param, const cec_command *const command
     dlb_cec_message_t     dlb_message     = { 0 };
     bool                  message_handled = false;
 
+    bus_handle->stats.rx_frames += 1;
+
     dlb_message.msg_length  = command->parameters.size;
     dlb_message.destination = (dlb_cec_logical_address_t)command->destination;
     dlb_message.initiator   = (dlb_cec_logical_address_t)command->initiator;
@@ -283,6 +285,7 @@ static int dlb_libcec_bus_transmit(dlb_cec_bus_handle_t *bus_handle, const dlb_c
         command.destination,
         command.parameters.size,
         command.opcode);
+    bus_handle->stats.tx_frames += 1;
     return bus_handle->libcec_interface.transmit(bus_handle->libcec_interface.connection, &command) == 1 ? 0 : 1;
 }
 
@@ -294,23 +297,29 @@ dlb_cec_bus_t *dlb_cec_bus_init(
     void *                arg,
     bool                  sim_arc)
 {
-    libcec_configuration libcec_config;
-    char                 buffer[100];
-    char                 strPort[50];
+    libcec_configuration  libcec_config;
+    char                  buffer[100];
+    char                  strPort[50];
+    dlb_cec_bus_handle_t *p_handle = (dlb_cec_bus_handle_t *)calloc(1, sizeof(dlb_cec_bus_handle_t));
+
+    if (p_handle == NULL)
+    {
+        return NULL;
+    }
 
-    cec_bus_handle.pritnf_func   = func;
-    cec_bus_handle.printf_arg    = arg;
-    cec_bus_handle.sim_arc       = sim_arc;
-    cec_bus_handle.arc_initiated = false;
+    p_handle->pritnf_func   = func;
+    p_handle->printf_arg    = arg;
+    p_handle->sim_arc       = sim_arc;
+    p_handle->arc_initiated = false;
 
     // loader API call #1
     libcecc_reset_configuration(&libcec_config);
 
     /* configure callbacks */
-    libcec_config.callbacks                  = &cec_bus_handle.libcec_callbacks;
+    libcec_config.callbacks                  = &p_handle->libcec_callbacks;
     libcec_config.callbacks->logMessage      = &cb_cec_log_message;
     libcec_config.callbacks->commandReceived = &cb_cec_cmd_received;
-    libcec_config.callbackParam              = &cec_bus_handle;
+    libcec_config.callbackParam              = p_handle;
 
     /* don't make this device as an active source on the startup */
     libcec_config.bActivateSource = 0;
@@ -349,78 +358,91 @@ dlb_cec_bus_t *dlb_cec_bus_init(
     libcec_config.iPhysicalAddress = physical_address;
 
     // loader API call #1
-    if (libcecc_initialise(&libcec_config, &cec_bus_handle.libcec_interface, NULL) != 1)
+    if (libcecc_initialise(&libcec_config, &p_handle->libcec_interface, NULL) != 1)
     {
-        lip_libcec_log_message(&cec_bus_handle, "can't initialise libCEC\n");
+        lip_libcec_log_message(p_handle, "can't initialise libCEC\n");
+        free(p_handle);
         return NULL;
     }
 
     // lib API call #2
-    cec_bus_handle.libcec_interface.version_to_string(libcec_config.serverVersion, buffer, sizeof(buffer));
-    lip_libcec_log_message(&cec_bus_handle, "CEC Parser created - libCEC version %s\n", buffer);
+    p_handle->libcec_interface.version_to_string(libcec_config.serverVersion, buffer, sizeof(buffer));
+    lip_libcec_log_message(p_handle, "CEC Parser created - libCEC version %s\n", buffer);
 
     if (port_name == NULL || port_name[0] == '\0')
     {
         /* discover devices on the serial COM ports #fixme - add commandline parameter to specify port wanted by the user */
         // lib API call #3
         cec_adapter devices[4];
-        int8_t      iDevicesFound = cec_bus_handle.libcec_interface.find_adapters(
-            cec_bus_handle.libcec_interface.connection, devices, sizeof(devices) / sizeof(devices[0]), NULL);
+        int8_t      iDevicesFound = p_handle->libcec_interface.find_adapters(
+            p_handle->libcec_interface.connection, devices, sizeof(devices) / sizeof(devices[0]), NULL);
         if (iDevicesFound <= 0)
         {
-            lip_libcec_log_message(&cec_bus_handle, "FAILED to find the adapters\n");
-            libcecc_destroy(&cec_bus_handle.libcec_interface);
+            lip_libcec_log_message(p_handle, "FAILED to find the adapters\n");
+            libcecc_destroy(&p_handle->libcec_interface);
+            free(p_handle);
             return NULL;
         }
         else
         {
-            lip_libcec_log_message(&cec_bus_handle, "\n path:     %s\n com port: %s\n\n", devices[0].path, devices[0].comm);
+            lip_libcec_log_message(p_handle, "\n path:     %s\n com port: %s\n\n", devices[0].path, devices[0].comm);
             strcpy(strPort, devices[0].comm);
         }
     }
     else
     {
-        lip_libcec_log_message(&cec_bus_handle, "\n com port: %s\n\n", port_name);
+        lip_libcec_log_message(p_handle, "\n com port: %s\n\n", port_name);
         strcpy(strPort, port_name);
     }
-    lip_libcec_log_message(&cec_bus_handle, "opening a connection to the CEC adapter...\n");
+    lip_libcec_log_message(p_handle, "opening a connection to the CEC adapter...\n");
 
     // lib API call #4
-    if (!cec_bus_handle.libcec_interface.open(cec_bus_handle.libcec_interface.connection, strPort, 5000))
+    if (!p_handle->libcec_interface.open(p_handle->libcec_interface.connection, strPort, 5000))
     {
-        lip_libcec_log_message(&cec_bus_handle, "unable to open the device on port %s\n", strPort);
-        libcecc_destroy(&cec_bus_handle.libcec_interface);
+        lip_libcec_log_message(p_handle, "unable to open the device on port %s\n", strPort);
+        libcecc_destroy(&p_handle->libcec_interface);
+        free(p_handle);
         return NULL;
     }
 
-    cec_bus_handle.cec_bus.handle            = &cec_bus_handle;
-    cec_bus_handle.cec_bus.transmit_callback = dlb_libcec_bus_transmit;
-    cec_bus_handle.cec_bus.register_callback = dlb_libcec_bus_register_callback;
+    p_handle->cec_bus.handle            = p_handle;
+    p_handle->cec_bus.transmit_callback = dlb_libcec_bus_transmit;
+    p_handle->cec_bus.register_callback = dlb_libcec_bus_register_callback;
     // lib API call #5
-    cec_bus_handle.cec_bus.logical_address = (dlb_cec_logical_address_t)cec_bus_handle.libcec_interface
-                                                 .get_logical_addresses(cec_bus_handle.libcec_interface.connection)
-                                                 .primary;
+    p_handle->cec_bus.logical_address = (dlb_cec_logical_address_t)p_handle->libcec_interface
+                                            .get_logical_addresses(p_handle->libcec_interface.connection)
+                                            .primary;
 
-    if (cec_bus_handle.sim_arc)
+    if (p_handle->sim_arc)
     {
-        if (cec_bus_handle.libcec_interface.poll_device(cec_bus_handle.libcec_interface.connection, CECDEVICE_TV))
+        if (p_handle->libcec_interface.poll_device(p_handle->libcec_interface.connection, CECDEVICE_TV))
         {
-            send_arc_initiate(&cec_bus_handle);
+            send_arc_initiate(p_handle);
         }
     }
-    return &cec_bus_handle.cec_bus;
+    return &p_handle->cec_bus;
 }
 
-void dlb_cec_bus_destroy(void)
+void dlb_cec_bus_destroy(dlb_cec_bus_t *cec_bus)
 {
-    if (cec_bus_handle.arc_initiated)
+    dlb_cec_bus_handle_t *p_handle = cec_bus->handle;
+
+    if (p_handle->arc_initiated)
     {
-        send_arc_terminate(&cec_bus_handle);
+        send_arc_terminate(p_handle);
     }
-    libcecc_destroy(&cec_bus_handle.libcec_interface);
+    libcecc_destroy(&p_handle->libcec_interface);
+    free(p_handle);
+}
+
+int dlb_cec_poll_device(dlb_cec_bus_t *cec_bus, cec_logical_address downstream_device)
+{
+    dlb_cec_bus_handle_t *p_handle = cec_bus->handle;
+
+    return p_handle->libcec_interface.poll_device(p_handle->libcec_interface.connection, downstream_device);
 }
 
-int dlb_cec_poll_device(cec_logical_address downstream_device)
+void dlb_cec_bus_get_stats(const dlb_cec_bus_t *cec_bus, dlb_cec_bus_stats_t *const stats)
 {
-    return cec_bus_handle.libcec_interface.poll_device(cec_bus_handle.libcec_interface.connection, downstream_device);
+    *stats = cec_bus->handle->stats;
 }
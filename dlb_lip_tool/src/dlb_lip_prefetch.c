@@ -0,0 +1,338 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_prefetch.c
+ *  @brief      Speculative latency queries issued when a downstream device connects
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dlb_lip_prefetch.h"
+
+#define HISTORY_FILE_HEADER "# dlb_lip_tool prefetch history 1"
+
+typedef struct history_entry_s
+{
+    uint64_t format;
+    uint32_t count;
+} history_entry_t;
+
+typedef struct history_s
+{
+    bool                 open;
+    const char *         path;
+    dlb_lip_tool_mutex_t mutex;
+    unsigned int         count;
+    history_entry_t      entries[DLB_LIP_PREFETCH_HISTORY_SIZE];
+} history_t;
+
+static history_t history = { 0 };
+
+/*!
+Adds count to the format, when the history is full the least requested format is replaced.
+Must be called with history mutex locked.
+*/
+static void history_add(uint64_t format, uint32_t count)
+{
+    history_entry_t *p_victim = NULL;
+
+    for (unsigned int i = 0; i < history.count; ++i)
+    {
+        history_entry_t *const p_entry = &history.entries[i];
+
+        if (p_entry->format == format)
+        {
+            p_entry->count = p_entry->count > UINT32_MAX - count ? UINT32_MAX : p_entry->count + count;
+            return;
+        }
+        if (p_victim == NULL || p_entry->count < p_victim->count)
+        {
+            p_victim = p_entry;
+        }
+    }
+
+    if (history.count < DLB_LIP_PREFETCH_HISTORY_SIZE)
+    {
+        p_victim = &history.entries[history.count++];
+    }
+    p_victim->format = format;
+    p_victim->count  = count;
+}
+
+int dlb_lip_prefetch_history_open(const char *path)
+{
+    FILE *file   = NULL;
+    char  line[128];
+    int   loaded = 0;
+
+    memset(&history, 0, sizeof(history));
+    dlb_lip_tool_mutex_init(&history.mutex);
+    history.open = true;
+    history.path = (path && path[0]) ? path : NULL;
+
+    if (history.path == NULL)
+    {
+        return 0;
+    }
+
+    file = fopen(history.path, "r");
+    if (file == NULL)
+    {
+        // First run, the file is created when the history is closed
+        return 0;
+    }
+
+    if (fgets(line, sizeof(line), file) == NULL || strncmp(line, HISTORY_FILE_HEADER, strlen(HISTORY_FILE_HEADER)) != 0)
+    {
+        fprintf(stderr, "WARNING: Prefetch history %s has unknown format, ignored.\n", history.path);
+        fclose(file);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), file))
+    {
+        uint64_t format = 0;
+        uint32_t count  = 0;
+
+        if (line[0] != '#' && sscanf(line, "%" SCNx64 " %" SCNu32, &format, &count) == 2 && format != 0 && count != 0)
+        {
+            history_add(format, count);
+            loaded += 1;
+        }
+    }
+    fclose(file);
+
+    return loaded;
+}
+
+void dlb_lip_prefetch_history_close(void)
+{
+    if (!history.open)
+    {
+        return;
+    }
+
+    if (history.path)
+    {
+        FILE *file = fopen(history.path, "w");
+
+        if (file)
+        {
+            fprintf(file, "%s\n", HISTORY_FILE_HEADER);
+            for (unsigned int i = 0; i < history.count; ++i)
+            {
+                fprintf(file, "0x%016" PRIx64 " %" PRIu32 "\n", history.entries[i].format, history.entries[i].count);
+            }
+            fclose(file);
+        }
+        else
+        {
+            fprintf(stderr, "ERROR: Couldn't write prefetch history %s.\n", history.path);
+        }
+    }
+
+    dlb_lip_tool_mutex_destroy(&history.mutex);
+    history.open = false;
+}
+
+void dlb_lip_prefetch_learn(uint64_t format)
+{
+    if (history.open)
+    {
+        dlb_lip_tool_mutex_lock(&history.mutex);
+        history_add(format, 1);
+        dlb_lip_tool_mutex_unlock(&history.mutex);
+    }
+}
+
+/*!
+Builds list of formats to prefetch: configured formats followed by the most requested formats of the history.
+
+@return number of formats in the list
+*/
+static unsigned int prefetch_build_list(const dlb_lip_prefetch_t *p_prefetch, uint64_t list[DLB_LIP_PREFETCH_MAX_FORMATS * 2])
+{
+    history_entry_t learned[DLB_LIP_PREFETCH_HISTORY_SIZE];
+    unsigned int    learned_total = 0;
+    unsigned int    count         = 0;
+
+    memcpy(list, p_prefetch->formats, p_prefetch->format_count * sizeof(*list));
+    count = p_prefetch->format_count;
+
+    if (history.open)
+    {
+        dlb_lip_tool_mutex_lock(&history.mutex);
+        learned_total = history.count;
+        memcpy(learned, history.entries, learned_total * sizeof(*learned));
+        dlb_lip_tool_mutex_unlock(&history.mutex);
+    }
+
+    // Partial selection sort, only the first learned_count entries are needed
+    for (unsigned int i = 0, added = 0; i < learned_total && added < p_prefetch->learned_count; ++i)
+    {
+        unsigned int best      = i;
+        bool         duplicate = false;
+
+        for (unsigned int j = i + 1; j < learned_total; ++j)
+        {
+            if (learned[j].count > learned[best].count)
+            {
+                best = j;
+            }
+        }
+        if (best != i)
+        {
+            const history_entry_t tmp = learned[i];
+            learned[i]                = learned[best];
+            learned[best]             = tmp;
+        }
+
+        for (unsigned int j = 0; j < p_prefetch->format_count; ++j)
+        {
+            duplicate |= list[j] == learned[i].format;
+        }
+        if (!duplicate)
+        {
+            list[count++] = learned[i].format;
+            added += 1;
+        }
+    }
+
+    return count;
+}
+
+/*!
+Waits until no frames were seen on the bus for DLB_LIP_PREFETCH_IDLE_MS.
+
+@return true if bus is idle, false if the engine was stopped or triggered again meanwhile
+*/
+static bool prefetch_wait_for_idle_bus(dlb_lip_prefetch_t *p_prefetch)
+{
+    bool idle = false;
+
+    while (!idle)
+    {
+        const unsigned long frames = p_prefetch->callbacks.bus_frames_callback(p_prefetch->callbacks.arg);
+        bool                abort  = false;
+
+        dlb_lip_tool_mutex_lock(&p_prefetch->mutex);
+        if (p_prefetch->running && !p_prefetch->triggered)
+        {
+            dlb_lip_tool_cond_timedwait(&p_prefetch->cond, &p_prefetch->mutex, DLB_LIP_PREFETCH_IDLE_MS);
+        }
+        abort = !p_prefetch->running || p_prefetch->triggered;
+        dlb_lip_tool_mutex_unlock(&p_prefetch->mutex);
+
+        if (abort)
+        {
+            return false;
+        }
+        idle = frames == p_prefetch->callbacks.bus_frames_callback(p_prefetch->callbacks.arg);
+    }
+
+    return true;
+}
+
+static void prefetch_thread(void *arg)
+{
+    dlb_lip_prefetch_t *p_prefetch = (dlb_lip_prefetch_t *)arg;
+
+    dlb_lip_tool_mutex_lock(&p_prefetch->mutex);
+    while (p_prefetch->running)
+    {
+        uint64_t     list[DLB_LIP_PREFETCH_MAX_FORMATS * 2];
+        unsigned int count     = 0;
+        unsigned int succeeded = 0;
+        unsigned int i         = 0;
+
+        if (!p_prefetch->triggered)
+        {
+            dlb_lip_tool_cond_wait(&p_prefetch->cond, &p_prefetch->mutex);
+            continue;
+        }
+        p_prefetch->triggered = false;
+        dlb_lip_tool_mutex_unlock(&p_prefetch->mutex);
+
+        count = prefetch_build_list(p_prefetch, list);
+        for (i = 0; i < count && prefetch_wait_for_idle_bus(p_prefetch); ++i)
+        {
+            succeeded += p_prefetch->callbacks.query_callback(p_prefetch->callbacks.arg, list[i]) == 0;
+        }
+        if (i == count && count > 0 && p_prefetch->callbacks.done_callback)
+        {
+            p_prefetch->callbacks.done_callback(p_prefetch->callbacks.arg, succeeded, count);
+        }
+
+        dlb_lip_tool_mutex_lock(&p_prefetch->mutex);
+    }
+    dlb_lip_tool_mutex_unlock(&p_prefetch->mutex);
+}
+
+void dlb_lip_prefetch_init(
+    dlb_lip_prefetch_t *                p_prefetch,
+    const uint64_t *                    formats,
+    unsigned int                        format_count,
+    unsigned int                        learned_count,
+    const dlb_lip_prefetch_callbacks_t *p_callbacks)
+{
+    memset(p_prefetch, 0, sizeof(*p_prefetch));
+    dlb_lip_tool_mutex_init(&p_prefetch->mutex);
+    dlb_lip_tool_cond_init(&p_prefetch->cond);
+    p_prefetch->formats       = formats;
+    p_prefetch->format_count  = format_count > DLB_LIP_PREFETCH_MAX_FORMATS ? DLB_LIP_PREFETCH_MAX_FORMATS : format_count;
+    p_prefetch->learned_count = learned_count > DLB_LIP_PREFETCH_MAX_FORMATS ? DLB_LIP_PREFETCH_MAX_FORMATS : learned_count;
+    p_prefetch->callbacks     = *p_callbacks;
+}
+
+int dlb_lip_prefetch_start(dlb_lip_prefetch_t *p_prefetch)
+{
+    if (p_prefetch->format_count == 0 && p_prefetch->learned_count == 0)
+    {
+        return 0;
+    }
+
+    p_prefetch->running = true;
+    if (dlb_lip_tool_thread_create(&p_prefetch->thread, prefetch_thread, p_prefetch))
+    {
+        fprintf(stderr, "ERROR: Couldn't start prefetch thread.\n");
+        p_prefetch->running = false;
+        return 1;
+    }
+    p_prefetch->started = true;
+
+    return 0;
+}
+
+void dlb_lip_prefetch_trigger(dlb_lip_prefetch_t *p_prefetch)
+{
+    dlb_lip_tool_mutex_lock(&p_prefetch->mutex);
+    p_prefetch->triggered = true;
+    dlb_lip_tool_cond_signal(&p_prefetch->cond);
+    dlb_lip_tool_mutex_unlock(&p_prefetch->mutex);
+}
+
+void dlb_lip_prefetch_stop(dlb_lip_prefetch_t *p_prefetch)
+{
+    if (p_prefetch->started)
+    {
+        dlb_lip_tool_mutex_lock(&p_prefetch->mutex);
+        p_prefetch->running = false;
+        dlb_lip_tool_cond_signal(&p_prefetch->cond);
+        dlb_lip_tool_mutex_unlock(&p_prefetch->mutex);
+        dlb_lip_tool_thread_join(&p_prefetch->thread);
+        p_prefetch->started = false;
+    }
+    dlb_lip_tool_cond_destroy(&p_prefetch->cond);
+    dlb_lip_tool_mutex_destroy(&p_prefetch->mutex);
+}
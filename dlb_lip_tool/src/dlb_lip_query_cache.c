@@ -0,0 +1,139 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_query_cache.c
+ *  @brief      Latency query results cached by the tool in front of dlb_lip
+ */
+
+#include <limits.h>
+#include <string.h>
+
+#include "dlb_lip_query_cache.h"
+
+/*!
+Mixes bits of the packed query so similar formats don't end up in neighbouring slots.
+
+@return index of the first slot the key can be stored in
+*/
+static unsigned int query_cache_position(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (unsigned int)key & (DLB_LIP_QUERY_CACHE_SIZE - 1U);
+}
+
+static bool query_cache_entry_valid(
+    const dlb_lip_query_cache_t *p_cache, const dlb_lip_query_cache_entry_t *p_entry, unsigned long long now_us)
+{
+    return p_entry->key != 0 && p_entry->generation == p_cache->generation
+           && (p_entry->expire_us == 0 || p_entry->expire_us > now_us);
+}
+
+void dlb_lip_query_cache_init(dlb_lip_query_cache_t *p_cache, unsigned int negative_ttl_ms)
+{
+    memset(p_cache, 0, sizeof(*p_cache));
+    dlb_lip_tool_mutex_init(&p_cache->mutex);
+    p_cache->negative_ttl_ms = negative_ttl_ms;
+}
+
+void dlb_lip_query_cache_destroy(dlb_lip_query_cache_t *p_cache)
+{
+    dlb_lip_tool_mutex_destroy(&p_cache->mutex);
+}
+
+void dlb_lip_query_cache_set_downstream(dlb_lip_query_cache_t *p_cache, bool uuid_valid, uint32_t uuid)
+{
+    dlb_lip_tool_mutex_lock(&p_cache->mutex);
+    if (p_cache->uuid_valid != uuid_valid || (uuid_valid && p_cache->uuid != uuid))
+    {
+        // Entries of older generations are treated as free slots
+        p_cache->generation += 1;
+    }
+    p_cache->uuid_valid = uuid_valid;
+    p_cache->uuid       = uuid;
+    dlb_lip_tool_mutex_unlock(&p_cache->mutex);
+}
+
+bool dlb_lip_query_cache_lookup(
+    dlb_lip_query_cache_t *p_cache, uint64_t key, uint32_t *p_generation, uint8_t *p_audio_latency, uint8_t *p_video_latency)
+{
+    const unsigned long long now_us   = dlb_lip_tool_time_us();
+    const unsigned int       position = query_cache_position(key);
+    bool                     hit      = false;
+
+    dlb_lip_tool_mutex_lock(&p_cache->mutex);
+    *p_generation = p_cache->generation;
+    for (unsigned int i = 0; p_cache->uuid_valid && i < DLB_LIP_QUERY_CACHE_PROBES; ++i)
+    {
+        const dlb_lip_query_cache_entry_t *p_entry = &p_cache->entries[(position + i) & (DLB_LIP_QUERY_CACHE_SIZE - 1U)];
+
+        if (p_entry->key == key && query_cache_entry_valid(p_cache, p_entry, now_us))
+        {
+            *p_audio_latency = p_entry->audio_latency;
+            *p_video_latency = p_entry->video_latency;
+            hit              = true;
+            break;
+        }
+    }
+    dlb_lip_tool_mutex_unlock(&p_cache->mutex);
+
+    return hit;
+}
+
+void dlb_lip_query_cache_insert(
+    dlb_lip_query_cache_t *p_cache, uint32_t generation, uint64_t key, uint8_t audio_latency, uint8_t video_latency, bool negative)
+{
+    const unsigned long long now_us   = dlb_lip_tool_time_us();
+    const unsigned int       position = query_cache_position(key);
+
+    if (key == 0 || (negative && p_cache->negative_ttl_ms == 0))
+    {
+        return;
+    }
+
+    dlb_lip_tool_mutex_lock(&p_cache->mutex);
+    if (p_cache->uuid_valid && p_cache->generation == generation)
+    {
+        dlb_lip_query_cache_entry_t *p_victim    = NULL;
+        unsigned long long           victim_rank = 0;
+
+        // Slot of the same key, otherwise free slot or the entry expiring first(results which never expire go last)
+        for (unsigned int i = 0; i < DLB_LIP_QUERY_CACHE_PROBES; ++i)
+        {
+            dlb_lip_query_cache_entry_t *p_entry = &p_cache->entries[(position + i) & (DLB_LIP_QUERY_CACHE_SIZE - 1U)];
+            unsigned long long           rank    = 0;
+
+            if (p_entry->key == key)
+            {
+                p_victim = p_entry;
+                break;
+            }
+            if (query_cache_entry_valid(p_cache, p_entry, now_us))
+            {
+                rank = p_entry->expire_us ? p_entry->expire_us : ULLONG_MAX;
+            }
+            if (p_victim == NULL || rank < victim_rank)
+            {
+                p_victim    = p_entry;
+                victim_rank = rank;
+            }
+        }
+
+        p_victim->key           = key;
+        p_victim->generation    = generation;
+        p_victim->audio_latency = audio_latency;
+        p_victim->video_latency = video_latency;
+        p_victim->expire_us     = negative ? now_us + (unsigned long long)p_cache->negative_ttl_ms * 1000ULL : 0;
+    }
+    dlb_lip_tool_mutex_unlock(&p_cache->mutex);
+}
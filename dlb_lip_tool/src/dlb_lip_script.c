@@ -0,0 +1,801 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_script.c
+ *  @brief      Command script preprocessor - loops, variables and arithmetic
+ */
+
+#include <ctype.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dlb_lip_script.h"
+
+typedef enum script_line_type_e
+{
+    SCRIPT_LINE_EMPTY,
+    SCRIPT_LINE_BLOCK_OPEN,
+    SCRIPT_LINE_BLOCK_CLOSE,
+    SCRIPT_LINE_SET,
+    SCRIPT_LINE_COMMAND
+} script_line_type_t;
+
+typedef struct script_expr_s
+{
+    dlb_lip_script_t *p_script;
+    const char *      ptr;
+    int               error;
+} script_expr_t;
+
+/**********************************************************************
+ *
+ *  Utils
+ *
+ **********************************************************************/
+
+static char *trim_line(char *line)
+{
+    size_t len = 0;
+
+    while (isspace((unsigned char)*line))
+    {
+        line++;
+    }
+    len = strlen(line);
+    while (len > 0 && isspace((unsigned char)line[len - 1]))
+    {
+        line[--len] = '\0';
+    }
+
+    return line;
+}
+
+static script_line_type_t get_line_type(const char *line)
+{
+    const size_t len = strlen(line);
+
+    if (len == 0 || line[0] == '#')
+    {
+        return SCRIPT_LINE_EMPTY;
+    }
+    if (strcmp(line, "}") == 0)
+    {
+        return SCRIPT_LINE_BLOCK_CLOSE;
+    }
+    if ((strncmp(line, "repeat ", strlen("repeat ")) == 0 || strncmp(line, "for ", strlen("for ")) == 0) && line[len - 1] == '{')
+    {
+        return SCRIPT_LINE_BLOCK_OPEN;
+    }
+    if (strncmp(line, "set ", strlen("set ")) == 0)
+    {
+        return SCRIPT_LINE_SET;
+    }
+
+    return SCRIPT_LINE_COMMAND;
+}
+
+static int get_variable(dlb_lip_script_t *p_script, const char *name, size_t name_len, bool create)
+{
+    for (unsigned int i = 0; i < p_script->variable_count; ++i)
+    {
+        if (strlen(p_script->variables[i].name) == name_len && strncmp(p_script->variables[i].name, name, name_len) == 0)
+        {
+            return (int)i;
+        }
+    }
+
+    if (create && name_len > 0 && name_len < DLB_LIP_SCRIPT_MAX_VARIABLE_NAME
+        && p_script->variable_count < DLB_LIP_SCRIPT_MAX_VARIABLES)
+    {
+        dlb_lip_script_variable_t *p_var = &p_script->variables[p_script->variable_count];
+
+        memcpy(p_var->name, name, name_len);
+        p_var->name[name_len] = '\0';
+        p_var->value          = 0;
+        return (int)p_script->variable_count++;
+    }
+
+    return -1;
+}
+
+static void free_lines(char **lines, unsigned int count)
+{
+    if (lines)
+    {
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            free(lines[i]);
+        }
+        free(lines);
+    }
+}
+
+/**********************************************************************
+ *
+ *  Arithmetic expressions: + - * / % ( ), integers and variables
+ *
+ **********************************************************************/
+
+static long long eval_sum(script_expr_t *p_expr);
+
+static void skip_spaces(script_expr_t *p_expr)
+{
+    while (isspace((unsigned char)*p_expr->ptr))
+    {
+        p_expr->ptr++;
+    }
+}
+
+static bool add_overflows(long long a, long long b)
+{
+    return b > 0 ? a > LLONG_MAX - b : a < LLONG_MIN - b;
+}
+
+static bool sub_overflows(long long a, long long b)
+{
+    return b > 0 ? a < LLONG_MIN + b : a > LLONG_MAX + b;
+}
+
+static bool mul_overflows(long long a, long long b)
+{
+    if (a == 0 || b == 0)
+    {
+        return false;
+    }
+    if (a > 0)
+    {
+        return b > 0 ? a > LLONG_MAX / b : b < LLONG_MIN / a;
+    }
+    return b > 0 ? a < LLONG_MIN / b : b < LLONG_MAX / a;
+}
+
+static void report_overflow(script_expr_t *p_expr)
+{
+    fprintf(stderr, "ERROR: Integer overflow in script expression!\n");
+    p_expr->error = 1;
+}
+
+static long long eval_primary(script_expr_t *p_expr)
+{
+    long long value = 0;
+
+    skip_spaces(p_expr);
+    if (*p_expr->ptr == '(')
+    {
+        p_expr->ptr++;
+        value = eval_sum(p_expr);
+        skip_spaces(p_expr);
+        if (*p_expr->ptr == ')')
+        {
+            p_expr->ptr++;
+        }
+        else
+        {
+            p_expr->error = 1;
+        }
+    }
+    else if (*p_expr->ptr == '-')
+    {
+        p_expr->ptr++;
+        value = eval_primary(p_expr);
+        if (value == LLONG_MIN)
+        {
+            report_overflow(p_expr);
+        }
+        else
+        {
+            value = -value;
+        }
+    }
+    else if (isdigit((unsigned char)*p_expr->ptr))
+    {
+        char *end   = NULL;
+        value       = strtoll(p_expr->ptr, &end, 0);
+        p_expr->ptr = end;
+    }
+    else if (isalpha((unsigned char)*p_expr->ptr) || *p_expr->ptr == '_')
+    {
+        const char *name = p_expr->ptr;
+        int         index;
+
+        while (isalnum((unsigned char)*p_expr->ptr) || *p_expr->ptr == '_')
+        {
+            p_expr->ptr++;
+        }
+        index = get_variable(p_expr->p_script, name, (size_t)(p_expr->ptr - name), false);
+        if (index < 0)
+        {
+            fprintf(stderr, "ERROR: Unknown script variable [%.*s]!\n", (int)(p_expr->ptr - name), name);
+            p_expr->error = 1;
+        }
+        else
+        {
+            value = p_expr->p_script->variables[index].value;
+        }
+    }
+    else
+    {
+        p_expr->error = 1;
+    }
+
+    return value;
+}
+
+static long long eval_product(script_expr_t *p_expr)
+{
+    long long value = eval_primary(p_expr);
+
+    for (;;)
+    {
+        char op;
+
+        skip_spaces(p_expr);
+        op = *p_expr->ptr;
+        if (op != '*' && op != '/' && op != '%')
+        {
+            break;
+        }
+        p_expr->ptr++;
+        {
+            const long long rhs = eval_primary(p_expr);
+
+            if (op == '*' && mul_overflows(value, rhs))
+            {
+                report_overflow(p_expr);
+                value = 0;
+            }
+            else if (op == '*')
+            {
+                value *= rhs;
+            }
+            else if (rhs == 0)
+            {
+                fprintf(stderr, "ERROR: Division by zero in script expression!\n");
+                p_expr->error = 1;
+            }
+            else if (value == LLONG_MIN && rhs == -1)
+            {
+                // Quotient doesn't fit, remainder is 0 but the C operation overflows as well
+                if (op == '/')
+                {
+                    report_overflow(p_expr);
+                }
+                value = 0;
+            }
+            else
+            {
+                value = op == '/' ? value / rhs : value % rhs;
+            }
+        }
+    }
+
+    return value;
+}
+
+static long long eval_sum(script_expr_t *p_expr)
+{
+    long long value = eval_product(p_expr);
+
+    for (;;)
+    {
+        char op;
+
+        skip_spaces(p_expr);
+        op = *p_expr->ptr;
+        if (op != '+' && op != '-')
+        {
+            break;
+        }
+        p_expr->ptr++;
+        {
+            const long long rhs = eval_product(p_expr);
+
+            if (op == '+' ? add_overflows(value, rhs) : sub_overflows(value, rhs))
+            {
+                report_overflow(p_expr);
+                value = 0;
+            }
+            else
+            {
+                value = op == '+' ? value + rhs : value - rhs;
+            }
+        }
+    }
+
+    return value;
+}
+
+static int eval_expression(dlb_lip_script_t *p_script, const char *str, long long *value)
+{
+    script_expr_t expr = { 0 };
+
+    expr.p_script = p_script;
+    expr.ptr      = str;
+    *value        = eval_sum(&expr);
+    skip_spaces(&expr);
+    if (*expr.ptr != '\0')
+    {
+        expr.error = 1;
+    }
+    if (expr.error)
+    {
+        fprintf(stderr, "ERROR: Invalid script expression [%s]!\n", str);
+    }
+
+    return expr.error;
+}
+
+/*!
+Substitutes every ${<expr>} in the line with the value of the expression.
+
+@return 0 on success, 1 on expression error or when output doesn't fit
+*/
+static int expand_line(dlb_lip_script_t *p_script, const char *line, char *out, size_t size)
+{
+    size_t out_len = 0;
+
+    while (*line)
+    {
+        if (line[0] == '$' && line[1] == '{')
+        {
+            char        expr[DLB_LIP_SCRIPT_MAX_LINE];
+            const char *close = strchr(line, '}');
+            long long   value = 0;
+            int         len   = 0;
+
+            if (close == NULL || (size_t)(close - line - 2) >= sizeof(expr))
+            {
+                fprintf(stderr, "ERROR: Unterminated ${ in script line [%s]!\n", line);
+                return 1;
+            }
+            memcpy(expr, line + 2, (size_t)(close - line - 2));
+            expr[close - line - 2] = '\0';
+            if (eval_expression(p_script, expr, &value))
+            {
+                return 1;
+            }
+            len = snprintf(out + out_len, size - out_len, "%lld", value);
+            if (len < 0 || (size_t)len >= size - out_len)
+            {
+                return 1;
+            }
+            out_len += (size_t)len;
+            line = close + 1;
+        }
+        else
+        {
+            if (out_len + 1 >= size)
+            {
+                fprintf(stderr, "ERROR: Expanded script line is too long!\n");
+                return 1;
+            }
+            out[out_len++] = *line++;
+        }
+    }
+    out[out_len] = '\0';
+
+    return 0;
+}
+
+static int process_set(dlb_lip_script_t *p_script, const char *line)
+{
+    char        expanded[DLB_LIP_SCRIPT_MAX_LINE];
+    const char *name = NULL;
+    const char *expr = NULL;
+    size_t      name_len;
+    int         index;
+    long long   value = 0;
+
+    if (expand_line(p_script, line + strlen("set "), expanded, sizeof(expanded)))
+    {
+        return 1;
+    }
+
+    name = expanded;
+    while (isspace((unsigned char)*name))
+    {
+        name++;
+    }
+    name_len = 0;
+    while (isalnum((unsigned char)name[name_len]) || name[name_len] == '_')
+    {
+        name_len++;
+    }
+    expr = name + name_len;
+    while (isspace((unsigned char)*expr))
+    {
+        expr++;
+    }
+    if (*expr == '=')
+    {
+        expr++;
+    }
+
+    index = get_variable(p_script, name, name_len, true);
+    if (index < 0 || eval_expression(p_script, expr, &value))
+    {
+        fprintf(stderr, "ERROR: Invalid script assignment [%s]!\n", line);
+        return 1;
+    }
+    p_script->variables[index].value = value;
+
+    return 0;
+}
+
+/**********************************************************************
+ *
+ *  Blocks
+ *
+ **********************************************************************/
+
+static unsigned int find_block_close(char **lines, unsigned int begin, unsigned int end)
+{
+    unsigned int depth = 1;
+
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        const script_line_type_t type = get_line_type(lines[i]);
+
+        if (type == SCRIPT_LINE_BLOCK_OPEN)
+        {
+            depth++;
+        }
+        else if (type == SCRIPT_LINE_BLOCK_CLOSE && --depth == 0)
+        {
+            return i;
+        }
+    }
+
+    return end;
+}
+
+static void set_loop_variable(dlb_lip_script_t *p_script, const dlb_lip_script_frame_t *p_frame)
+{
+    if (p_frame->variable >= 0)
+    {
+        p_script->variables[p_frame->variable].value = p_frame->value;
+    }
+}
+
+static bool loop_done(const dlb_lip_script_frame_t *p_frame)
+{
+    return p_frame->step > 0 ? p_frame->value > p_frame->last : p_frame->value < p_frame->last;
+}
+
+/*!
+Parses block header lines[header] and pushes frame executing lines (header, end).
+
+@return 0 on success, 1 on error
+*/
+static int push_block(
+    dlb_lip_script_t *p_script, char **lines, unsigned int header, unsigned int end, bool owns_lines, unsigned int line_count)
+{
+    char                    expanded[DLB_LIP_SCRIPT_MAX_LINE];
+    char                    name[DLB_LIP_SCRIPT_MAX_VARIABLE_NAME] = { 0 };
+    dlb_lip_script_frame_t *p_frame                               = NULL;
+    long long               first                                 = 0;
+    long long               last                                  = 0;
+    long long               step                                  = 0;
+    int                     variable                              = -1;
+
+    if (p_script->depth >= DLB_LIP_SCRIPT_MAX_DEPTH)
+    {
+        fprintf(stderr, "ERROR: Script blocks nested too deep!\n");
+        return 1;
+    }
+    if (expand_line(p_script, lines[header], expanded, sizeof(expanded)))
+    {
+        return 1;
+    }
+
+    if (strncmp(expanded, "repeat ", strlen("repeat ")) == 0)
+    {
+        long long count = 0;
+
+        if (sscanf(expanded, "repeat %lld %31s", &count, name) != 2 || count < 0)
+        {
+            fprintf(stderr, "ERROR: Invalid repeat [%s]!\n", expanded);
+            return 1;
+        }
+        if (strcmp(name, "{") == 0)
+        {
+            name[0] = '\0';
+        }
+        first = 0;
+        last  = count - 1;
+        step  = 1;
+    }
+    else
+    {
+        const char *step_str = strstr(expanded, " step ");
+
+        if (sscanf(expanded, "for %31s in %lld..%lld", name, &first, &last) != 3)
+        {
+            fprintf(stderr, "ERROR: Invalid for [%s]!\n", expanded);
+            return 1;
+        }
+        step = first <= last ? 1 : -1;
+        if (step_str && (sscanf(step_str, " step %lld", &step) != 1 || step == 0))
+        {
+            fprintf(stderr, "ERROR: Invalid for step [%s]!\n", expanded);
+            return 1;
+        }
+    }
+
+    if (name[0])
+    {
+        variable = get_variable(p_script, name, strlen(name), true);
+        if (variable < 0)
+        {
+            fprintf(stderr, "ERROR: Invalid script variable [%s]!\n", name);
+            return 1;
+        }
+    }
+
+    p_frame             = &p_script->frames[p_script->depth];
+    p_frame->lines      = lines;
+    p_frame->line_count = line_count;
+    p_frame->owns_lines = owns_lines;
+    p_frame->begin      = header + 1;
+    p_frame->end        = end;
+    p_frame->pc         = p_frame->begin;
+    p_frame->variable   = variable;
+    p_frame->value      = first;
+    p_frame->last       = last;
+    p_frame->step       = step;
+
+    if (loop_done(p_frame))
+    {
+        // Empty loop
+        if (owns_lines)
+        {
+            free_lines(lines, line_count);
+        }
+        return 0;
+    }
+
+    set_loop_variable(p_script, p_frame);
+    p_script->depth++;
+
+    return 0;
+}
+
+static int collect_line(dlb_lip_script_t *p_script, const char *line)
+{
+    const size_t len  = strlen(line);
+    char *       copy = NULL;
+
+    if (p_script->collect_count == p_script->collect_capacity)
+    {
+        const unsigned int capacity = p_script->collect_capacity ? p_script->collect_capacity * 2 : 16;
+        char **            lines    = (char **)realloc(p_script->collect_lines, capacity * sizeof(char *));
+
+        if (lines == NULL)
+        {
+            return 1;
+        }
+        p_script->collect_lines    = lines;
+        p_script->collect_capacity = capacity;
+    }
+
+    copy = (char *)malloc(len + 1);
+    if (copy == NULL)
+    {
+        return 1;
+    }
+    memcpy(copy, line, len + 1);
+    p_script->collect_lines[p_script->collect_count++] = copy;
+
+    return 0;
+}
+
+static void discard_collected_lines(dlb_lip_script_t *p_script)
+{
+    free_lines(p_script->collect_lines, p_script->collect_count);
+    p_script->collect_lines    = NULL;
+    p_script->collect_count    = 0;
+    p_script->collect_capacity = 0;
+    p_script->collect_depth    = 0;
+}
+
+/*!
+Executes single, non block line.
+
+@return 1 if command was produced, 0 if nothing to execute, -1 on error
+*/
+static int process_line(dlb_lip_script_t *p_script, const char *line, char *command, size_t size)
+{
+    int ret = 0;
+
+    switch (get_line_type(line))
+    {
+    case SCRIPT_LINE_EMPTY:
+        ret = 0;
+        break;
+    case SCRIPT_LINE_SET:
+        ret = process_set(p_script, line) ? -1 : 0;
+        break;
+    case SCRIPT_LINE_COMMAND:
+        ret = expand_line(p_script, line, command, size) ? -1 : 1;
+        break;
+    default:
+        fprintf(stderr, "ERROR: Unexpected script line [%s]!\n", line);
+        ret = -1;
+        break;
+    }
+
+    return ret;
+}
+
+/***********************************************************************
+ *
+ *  Public functions
+ *
+ ***********************************************************************/
+
+void dlb_lip_script_init(dlb_lip_script_t *p_script)
+{
+    memset(p_script, 0, sizeof(*p_script));
+}
+
+void dlb_lip_script_destroy(dlb_lip_script_t *p_script)
+{
+    while (p_script->depth > 0)
+    {
+        dlb_lip_script_frame_t *p_frame = &p_script->frames[--p_script->depth];
+        if (p_frame->owns_lines)
+        {
+            free_lines(p_frame->lines, p_frame->line_count);
+        }
+    }
+    free_lines(p_script->collect_lines, p_script->collect_count);
+    dlb_lip_script_init(p_script);
+}
+
+int dlb_lip_script_next_command(
+    dlb_lip_script_t *             p_script,
+    char *                         command,
+    size_t                         size,
+    dlb_lip_script_line_callback_t line_callback,
+    void *                         p_context)
+{
+    for (;;)
+    {
+        int ret = 0;
+
+        if (p_script->depth > 0)
+        {
+            dlb_lip_script_frame_t *p_frame = &p_script->frames[p_script->depth - 1];
+            char *                  line    = NULL;
+
+            if (p_frame->pc >= p_frame->end)
+            {
+                // Value overflowing the step is past the last value
+                bool done = add_overflows(p_frame->value, p_frame->step);
+
+                if (!done)
+                {
+                    p_frame->value += p_frame->step;
+                    done = loop_done(p_frame);
+                }
+                if (!done)
+                {
+                    p_frame->pc = p_frame->begin;
+                    set_loop_variable(p_script, p_frame);
+                }
+                else
+                {
+                    if (p_frame->owns_lines)
+                    {
+                        free_lines(p_frame->lines, p_frame->line_count);
+                    }
+                    p_script->depth--;
+                }
+                continue;
+            }
+
+            line = p_frame->lines[p_frame->pc];
+            if (get_line_type(line) == SCRIPT_LINE_BLOCK_OPEN)
+            {
+                const unsigned int header = p_frame->pc;
+                const unsigned int close  = find_block_close(p_frame->lines, header + 1, p_frame->end);
+
+                if (close == p_frame->end)
+                {
+                    fprintf(stderr, "ERROR: Unterminated script block [%s]!\n", line);
+                    p_frame->pc = p_frame->end;
+                    return -1;
+                }
+                p_frame->pc = close + 1;
+                if (push_block(p_script, p_frame->lines, header, close, false, 0))
+                {
+                    return -1;
+                }
+                continue;
+            }
+
+            p_frame->pc++;
+            ret = process_line(p_script, line, command, size);
+        }
+        else
+        {
+            char *             line = NULL;
+            script_line_type_t type;
+
+            if (line_callback(p_context, p_script->source_line, (int)sizeof(p_script->source_line)) == NULL)
+            {
+                if (p_script->collect_depth > 0)
+                {
+                    // The block can't be closed by lines of a following command source(e.g. the console)
+                    fprintf(
+                        stderr,
+                        "ERROR: Unterminated script block [%s]!\n",
+                        p_script->collect_count > 0 ? p_script->collect_lines[0] : "");
+                    discard_collected_lines(p_script);
+                    return -1;
+                }
+                return 0;
+            }
+            line = trim_line(p_script->source_line);
+            type = get_line_type(line);
+
+            if (p_script->collect_depth == 0 && type != SCRIPT_LINE_BLOCK_OPEN)
+            {
+                ret = process_line(p_script, line, command, size);
+            }
+            else
+            {
+                if (type == SCRIPT_LINE_BLOCK_OPEN)
+                {
+                    p_script->collect_depth++;
+                }
+                else if (type == SCRIPT_LINE_BLOCK_CLOSE)
+                {
+                    p_script->collect_depth--;
+                }
+
+                if (p_script->collect_depth > 0 || type != SCRIPT_LINE_BLOCK_CLOSE)
+                {
+                    if (collect_line(p_script, line))
+                    {
+                        fprintf(stderr, "ERROR: Out of memory for script block!\n");
+                        discard_collected_lines(p_script);
+                        return -1;
+                    }
+                }
+                else
+                {
+                    // Outermost block closed, the frame takes ownership of collected lines
+                    char **            lines = p_script->collect_lines;
+                    const unsigned int count = p_script->collect_count;
+
+                    p_script->collect_lines    = NULL;
+                    p_script->collect_count    = 0;
+                    p_script->collect_capacity = 0;
+                    if (push_block(p_script, lines, 0, count, true, count))
+                    {
+                        free_lines(lines, count);
+                        return -1;
+                    }
+                }
+                continue;
+            }
+        }
+
+        if (ret != 0)
+        {
+            return ret;
+        }
+    }
+}
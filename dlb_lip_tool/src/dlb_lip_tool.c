@@ -23,14 +23,26 @@
 /* General includes needed for binary */
 #include <assert.h>
 #include <ctype.h>
+#include <errno.h>
 #include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#include "dlb_lip_cache.h"
+#include "dlb_lip_compiled_config.h"
+#include "dlb_lip_config_fingerprint.h"
+#include "dlb_lip_config_watch.h"
+#include "dlb_lip_control_socket.h"
 #include "dlb_lip_libcec_bus.h"
+#include "dlb_lip_prefetch.h"
+#include "dlb_lip_query_cache.h"
+#include "dlb_lip_script.h"
 #include "dlb_lip_tool.h"
+#include "dlb_lip_tool_osa.h"
+#include "dlb_lip_validate.h"
+#include "dlb_lip_vocabulary.h"
 #include "dlb_lip_xml_parser.h"
 
 #if defined(_MSC_VER)
@@ -61,36 +73,71 @@ const char dolby_copyright[] = "\nUnpublished work.  Copyright 2019 Dolby Labora
 
 #define LIP_UUID_SIZE 2
 #define COMMAND_BUFFER_SIZE 128
-static long long     WAIT_TIME_MS = 1000; // Default wait time between commands
-static FILE *        log_file     = NULL;
-dlb_lip_xml_parser_t xml_parser;
-
-// For on_update_uuid
-static bool                   on_update_uuid_av_formats_valid = false;
-static dlb_lip_video_format_t on_update_uuid_v_format         = { 0 };
-static dlb_lip_audio_format_t on_update_uuid_a_format         = { 0 };
-static bool                   uuid_valid                      = false;
-static uint32_t               downstream_uuid;
-static dlb_lip_osa_timer_t    on_update_uuid_timer = { 0 };
+#define LIP_TOOL_MAX_DEVICES 8
+#define LIP_TOOL_MAX_VALIDATE_PATHS 64
+#define LIP_TOOL_QUERY_SKIPPED (-1)
+static FILE *log_file               = NULL;
+static bool  control_socket_enabled = false;
+
+// Output of the command executed for control socket client, set only on the thread executing the command.
+// Thread local, so messages of status_change(), timer and prefetch threads never end up in the client response.
+static DLB_LIP_TOOL_THREAD_LOCAL char * captured_output      = NULL;
+static DLB_LIP_TOOL_THREAD_LOCAL size_t captured_output_size = 0;
+static DLB_LIP_TOOL_THREAD_LOCAL size_t captured_output_len  = 0;
 
 /**
- *  Lite command line parser struct type
+ *  Command line options of single emulated device
  */
-struct cmdline_options_t
+typedef struct lip_tool_device_options_s
 {
     char commands_file_name[MAX_PATH];
     char config_file_name[MAX_PATH];
-    char log_file_name[MAX_PATH];
     char port_name[MAX_PATH];
     char state_file_name[MAX_PATH];
-    bool cache_enabled;
     bool sim_arc;
+
+    const dlb_lip_xml_parser_t *p_topology_config; // Config of the device parsed from --topology file, NULL for -x devices
+} lip_tool_device_options_t;
+
+/**
+ *  Lite command line parser struct type
+ */
+struct cmdline_options_t
+{
+    lip_tool_device_options_t devices[LIP_TOOL_MAX_DEVICES];
+    unsigned int              device_count;
+    char                      log_file_name[MAX_PATH];
+    char                      control_socket_name[MAX_PATH];
+    char                      cache_store_name[MAX_PATH];
+    char                      cache_dir_name[MAX_PATH];
+    char                      cache_shm_name[MAX_PATH];
+    char                      cache_import_archive_name[MAX_PATH];
+    char                      cache_export_archive_name[MAX_PATH];
+    char                      prefetch_file_name[MAX_PATH];
+    char                      prefetch_history_name[MAX_PATH];
+    char                      topology_file_name[MAX_PATH];
+    const char *              validate_paths[LIP_TOOL_MAX_VALIDATE_PATHS]; // Files and directories of --validate(argv)
+    unsigned int              validate_count;
+    unsigned int              validate_threads;
+    unsigned int              prefetch_learned;
+    uint64_t                  cache_max_size;
+    uint32_t                  cache_max_entries;
+    unsigned int              negative_ttl_ms;
+    bool                      cache_enabled;
+    bool                      cache_import;
+    bool                      cache_import_legacy; // Imports cache files without record header as well
+    bool                      compile_config; // Compiles XML configs of all devices and exits
+    bool                      use_compiled_config;
+    bool                      watch_config;
+    bool                      strict_config; // Latencies overwriting earlier different latencies are XML errors
 };
 
 typedef struct cmdline_options_t cmdline_options; ///< typedef for structure cmdline_options_t type
 
 #define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
 
+#define LIP_LIBRARY_VERSION ((DLB_LIP_LIB_V_API << 16) | DLB_LIP_LIB_V_FCT)
+
 typedef enum dlb_lip_tool_status_e
 {
     LIP_TOOL_INVALID,
@@ -100,6 +147,68 @@ typedef enum dlb_lip_tool_status_e
     LIP_TOOL_QUIT
 } dlb_lip_tool_status_t;
 
+/**
+ *  Emulated device - LIP instance with its own CEC bus connection and command stream
+ */
+typedef struct lip_tool_device_s
+{
+    unsigned int                     index;
+    const lip_tool_device_options_t *p_options;
+    dlb_lip_xml_parser_t             xml_parser;
+    uint32_t                         config_uuid; // UUID of the config file, live UUID changes with latency updates
+    dlb_lip_config_fingerprint_t     live_fingerprint; // Of xml_parser.config_params
+    dlb_lip_config_fingerprint_t     sent_fingerprint; // Of the config passed to dlb_lip last
+    dlb_lip_t *                      p_dlb_lip;
+    dlb_cec_bus_t *                  cec_bus;
+    unsigned char *                  p_mem;
+    FILE *                           commands_file;
+    long long                        wait_time_ms; // Wait time between commands
+    dlb_lip_tool_status_t            state;
+    bool                             in_barrier; // Command script of the device takes part in sync barriers
+
+    // For on_update_uuid
+    bool                   on_update_uuid_av_formats_valid;
+    dlb_lip_video_format_t on_update_uuid_v_format;
+    dlb_lip_audio_format_t on_update_uuid_a_format;
+    bool                   uuid_valid;
+    uint32_t               downstream_uuid;
+    dlb_lip_osa_timer_t    on_update_uuid_timer;
+
+    // Latency query results of the current downstream device
+    dlb_lip_query_cache_t query_cache;
+    dlb_lip_prefetch_t    prefetch;
+
+    // Serializes command execution between command stream and control socket clients
+    dlb_lip_tool_mutex_t  command_mutex;
+    dlb_lip_tool_thread_t thread;
+} lip_tool_device_t;
+
+static lip_tool_device_t devices[LIP_TOOL_MAX_DEVICES];
+static unsigned int      device_count = 0;
+static bool              strict_config = false; // Copy of the option for configs reloaded by the config watch
+
+// Parsed --topology file, configs of its devices are copied by open_device
+static dlb_lip_xml_topology_t topology;
+
+// Packed queries of the --prefetch file, prefetched by all devices
+static uint64_t     prefetch_formats[DLB_LIP_PREFETCH_MAX_FORMATS];
+static unsigned int prefetch_format_count = 0;
+
+/**
+ *  Barrier used by "sync <label>" command to line up command scripts of all devices
+ */
+typedef struct lip_tool_barrier_s
+{
+    dlb_lip_tool_mutex_t mutex;
+    dlb_lip_tool_cond_t  cond;
+    unsigned int         participants;
+    unsigned int         arrived;
+    unsigned long        generation;
+    char                 label[COMMAND_BUFFER_SIZE];
+} lip_tool_barrier_t;
+
+static lip_tool_barrier_t sync_barrier;
+
 static const char *lip_tool_state_description(dlb_lip_tool_status_t state)
 {
     const char *str = NULL;
@@ -128,15 +237,14 @@ static const char *lip_tool_state_description(dlb_lip_tool_status_t state)
     return str;
 }
 
-static dlb_lip_tool_status_t lip_tool_state = LIP_TOOL_INVALID;
-
-static void update_lip_tool_state(const char *filename, dlb_lip_tool_status_t new_state)
+static void update_lip_tool_state(lip_tool_device_t *p_device, dlb_lip_tool_status_t new_state)
 {
-    if (lip_tool_state != new_state)
+    if (p_device->state != new_state)
     {
-        FILE *file = NULL;
+        const char *filename = p_device->p_options->state_file_name;
+        FILE *      file     = NULL;
 
-        file = fopen(filename, lip_tool_state == LIP_TOOL_INVALID ? "wt+" : "at+");
+        file = fopen(filename, p_device->state == LIP_TOOL_INVALID ? "wt+" : "at+");
         if (file)
         {
             fprintf(file, "%s\n", lip_tool_state_description(new_state));
@@ -146,7 +254,7 @@ static void update_lip_tool_state(const char *filename, dlb_lip_tool_status_t ne
         {
             fprintf(stderr, "Failed to open state file(%s)\n", filename);
         }
-        lip_tool_state = new_state;
+        p_device->state = new_state;
     }
 }
 
@@ -213,6 +321,217 @@ void increase_count(int *count, const int argc, char **const argv)
     (*count)++;
 }
 
+/*!
+Returns options of the device the next device specific option belongs to.
+Every -x option starts new device, options given before the first -x belong to the first device.
+
+@param  opt         - pointer to the command line parser structure
+@param  new_config  - true if the option is XML config file
+
+@return pointer to the device options, exits if too many devices are given
+*/
+static lip_tool_device_options_t *get_device_options(cmdline_options *const opt, const bool new_config)
+{
+    if (opt->device_count == 0 || (new_config && opt->devices[opt->device_count - 1].config_file_name[0] != '\0'))
+    {
+        if (opt->device_count == LIP_TOOL_MAX_DEVICES)
+        {
+            fprintf(stderr, "ERROR: Too many devices, at most %u are supported.\n", LIP_TOOL_MAX_DEVICES);
+            exit(EXIT_FAILURE);
+        }
+        opt->device_count += 1;
+    }
+
+    return &opt->devices[opt->device_count - 1];
+}
+
+/*!
+Parses unsigned number value of a command line option.
+
+@return parsed number. On error prints out an error message and exits.
+*/
+static uint64_t parse_option_number(const char *option, const char *value, uint64_t max)
+{
+    char *             end    = NULL;
+    unsigned long long number = 0;
+
+    errno  = 0;
+    number = strtoull(value, &end, 10);
+    if (value[0] == '-' || end == value || *end != '\0' || errno != 0 || number > max)
+    {
+        fprintf(stderr, "ERROR: Invalid value of %s: %s\n", option, value);
+        exit(EXIT_FAILURE);
+    }
+
+    return (uint64_t)number;
+}
+
+/*!
+Parses single long(--name) option of the command line.
+
+@param count    - pointer to current argument count, moved past the option value
+@param argc     - number of arguments
+@param argv     - array of strings containing command line arguments
+@param opt      - pointer to the command line parser structure type to store parsed content
+
+@return void    On error prints out the help menu and exits.
+*/
+static void parse_long_option(int *count, const int argc, char **const argv, cmdline_options *const opt)
+{
+    const char *option = argv[*count];
+
+    if (strcmp(option, "--cache-store") == 0)
+    {
+        increase_count(count, argc, argv);
+
+        if (strlen(argv[*count]) >= MAX_PATH)
+        {
+            fprintf(stderr, "ERROR: Path to the cache store is too long.\n");
+            assert(strlen(argv[*count]) < MAX_PATH);
+            exit(EXIT_FAILURE);
+        }
+
+        snprintf(opt->cache_store_name, sizeof(opt->cache_store_name), "%s", argv[*count]);
+    }
+    else if (strcmp(option, "--cache-dir") == 0)
+    {
+        increase_count(count, argc, argv);
+
+        if (strlen(argv[*count]) >= MAX_PATH)
+        {
+            fprintf(stderr, "ERROR: Path to the cache directory is too long.\n");
+            assert(strlen(argv[*count]) < MAX_PATH);
+            exit(EXIT_FAILURE);
+        }
+
+        snprintf(opt->cache_dir_name, sizeof(opt->cache_dir_name), "%s", argv[*count]);
+    }
+    else if (strcmp(option, "--cache-shm") == 0)
+    {
+        increase_count(count, argc, argv);
+
+        if (strlen(argv[*count]) >= MAX_PATH)
+        {
+            fprintf(stderr, "ERROR: Name of the shared memory cache is too long.\n");
+            assert(strlen(argv[*count]) < MAX_PATH);
+            exit(EXIT_FAILURE);
+        }
+
+        snprintf(opt->cache_shm_name, sizeof(opt->cache_shm_name), "%s", argv[*count]);
+    }
+    else if (strcmp(option, "--cache-import-archive") == 0 || strcmp(option, "--cache-export-archive") == 0)
+    {
+        char *const file_name
+            = strcmp(option, "--cache-import-archive") == 0 ? opt->cache_import_archive_name : opt->cache_export_archive_name;
+
+        increase_count(count, argc, argv);
+
+        if (strlen(argv[*count]) >= MAX_PATH)
+        {
+            fprintf(stderr, "ERROR: Path to the cache archive is too long.\n");
+            assert(strlen(argv[*count]) < MAX_PATH);
+            exit(EXIT_FAILURE);
+        }
+
+        snprintf(file_name, MAX_PATH, "%s", argv[*count]);
+    }
+    else if (strcmp(option, "--topology") == 0)
+    {
+        increase_count(count, argc, argv);
+
+        if (strlen(argv[*count]) >= MAX_PATH)
+        {
+            fprintf(stderr, "ERROR: Path to the topology file is too long.\n");
+            assert(strlen(argv[*count]) < MAX_PATH);
+            exit(EXIT_FAILURE);
+        }
+
+        snprintf(opt->topology_file_name, sizeof(opt->topology_file_name), "%s", argv[*count]);
+    }
+    else if (strcmp(option, "--validate") == 0)
+    {
+        increase_count(count, argc, argv);
+
+        if (opt->validate_count == LIP_TOOL_MAX_VALIDATE_PATHS)
+        {
+            fprintf(stderr, "ERROR: Too many --validate paths, at most %u are supported.\n", LIP_TOOL_MAX_VALIDATE_PATHS);
+            exit(EXIT_FAILURE);
+        }
+
+        opt->validate_paths[opt->validate_count++] = argv[*count];
+    }
+    else if (strcmp(option, "--validate-threads") == 0)
+    {
+        increase_count(count, argc, argv);
+        opt->validate_threads = (unsigned int)parse_option_number(option, argv[*count], DLB_LIP_VALIDATE_MAX_THREADS);
+    }
+    else if (strcmp(option, "--cache-max-size") == 0)
+    {
+        increase_count(count, argc, argv);
+        opt->cache_max_size = parse_option_number(option, argv[*count], UINT64_MAX);
+    }
+    else if (strcmp(option, "--cache-max-entries") == 0)
+    {
+        increase_count(count, argc, argv);
+        opt->cache_max_entries = (uint32_t)parse_option_number(option, argv[*count], UINT32_MAX);
+    }
+    else if (strcmp(option, "--prefetch") == 0 || strcmp(option, "--prefetch-history") == 0)
+    {
+        char *const file_name = strcmp(option, "--prefetch") == 0 ? opt->prefetch_file_name : opt->prefetch_history_name;
+
+        increase_count(count, argc, argv);
+
+        if (strlen(argv[*count]) >= MAX_PATH)
+        {
+            fprintf(stderr, "ERROR: Path to the prefetch file is too long.\n");
+            assert(strlen(argv[*count]) < MAX_PATH);
+            exit(EXIT_FAILURE);
+        }
+
+        snprintf(file_name, MAX_PATH, "%s", argv[*count]);
+    }
+    else if (strcmp(option, "--prefetch-count") == 0)
+    {
+        increase_count(count, argc, argv);
+        opt->prefetch_learned = (unsigned int)parse_option_number(option, argv[*count], DLB_LIP_PREFETCH_MAX_FORMATS);
+    }
+    else if (strcmp(option, "--negative-cache-ttl") == 0)
+    {
+        increase_count(count, argc, argv);
+        opt->negative_ttl_ms = (unsigned int)parse_option_number(option, argv[*count], UINT32_MAX);
+    }
+    else if (strcmp(option, "--cache-import") == 0)
+    {
+        opt->cache_import = true;
+    }
+    else if (strcmp(option, "--cache-import-legacy") == 0)
+    {
+        opt->cache_import        = true;
+        opt->cache_import_legacy = true;
+    }
+    else if (strcmp(option, "--compile-config") == 0)
+    {
+        opt->compile_config = true;
+    }
+    else if (strcmp(option, "--no-compiled-config") == 0)
+    {
+        opt->use_compiled_config = false;
+    }
+    else if (strcmp(option, "--watch-config") == 0)
+    {
+        opt->watch_config = true;
+    }
+    else if (strcmp(option, "--strict-config") == 0)
+    {
+        opt->strict_config = true;
+    }
+    else
+    {
+        usage(argv);
+        exit(EXIT_FAILURE);
+    }
+}
+
 /*!
 Lite command line parser. Parses the command line of the binary call.
 
@@ -224,15 +543,34 @@ Lite command line parser. Parses the command line of the binary call.
 */
 void parse_cmdline(int argc, char **argv, cmdline_options *const opt)
 {
-    int  count = 1, len, flag = 0;
+    int  count = 1, len;
     char ch;
 
+    memset(opt->devices, 0, sizeof(opt->devices));
     memset(opt->log_file_name, '\0', sizeof(opt->log_file_name));
-    memset(opt->commands_file_name, '\0', sizeof(opt->commands_file_name));
-    memset(opt->port_name, '\0', sizeof(opt->port_name));
-    memset(opt->state_file_name, '\0', sizeof(opt->state_file_name));
-    opt->cache_enabled = true;
-    opt->sim_arc       = false;
+    memset(opt->control_socket_name, '\0', sizeof(opt->control_socket_name));
+    memset(opt->cache_store_name, '\0', sizeof(opt->cache_store_name));
+    memset(opt->cache_dir_name, '\0', sizeof(opt->cache_dir_name));
+    memset(opt->cache_shm_name, '\0', sizeof(opt->cache_shm_name));
+    memset(opt->cache_import_archive_name, '\0', sizeof(opt->cache_import_archive_name));
+    memset(opt->cache_export_archive_name, '\0', sizeof(opt->cache_export_archive_name));
+    memset(opt->prefetch_file_name, '\0', sizeof(opt->prefetch_file_name));
+    memset(opt->prefetch_history_name, '\0', sizeof(opt->prefetch_history_name));
+    memset(opt->topology_file_name, '\0', sizeof(opt->topology_file_name));
+    opt->device_count        = 0;
+    opt->validate_count      = 0;
+    opt->validate_threads    = 0;
+    opt->cache_max_size      = 0;
+    opt->cache_max_entries   = 0;
+    opt->negative_ttl_ms     = DLB_LIP_QUERY_CACHE_DEFAULT_NEGATIVE_TTL_MS;
+    opt->prefetch_learned    = DLB_LIP_PREFETCH_DEFAULT_LEARNED;
+    opt->cache_enabled       = true;
+    opt->cache_import        = false;
+    opt->cache_import_legacy = false;
+    opt->compile_config      = false;
+    opt->use_compiled_config = true;
+    opt->watch_config        = false;
+    opt->strict_config       = false;
 
     if (argc == 1)
     {
@@ -245,6 +583,13 @@ void parse_cmdline(int argc, char **argv, cmdline_options *const opt)
     /* parse command line arguments */
     while (count < argc)
     {
+        if (strncmp(argv[count], "--", 2) == 0)
+        {
+            parse_long_option(&count, argc, argv, opt);
+            count++;
+            continue;
+        }
+
         len = strlen(argv[count]);
         if (len != 2)
         {
@@ -269,7 +614,7 @@ void parse_cmdline(int argc, char **argv, cmdline_options *const opt)
         {
         case 'a':
         {
-            opt->sim_arc = true;
+            get_device_options(opt, false)->sim_arc = true;
             break;
         }
         case 'c':
@@ -283,7 +628,7 @@ void parse_cmdline(int argc, char **argv, cmdline_options *const opt)
                 exit(EXIT_FAILURE);
             }
 
-            snprintf(opt->commands_file_name, sizeof(opt->commands_file_name), "%s", argv[count]);
+            snprintf(get_device_options(opt, false)->commands_file_name, MAX_PATH, "%s", argv[count]);
             break;
         }
         case 'f':
@@ -316,7 +661,7 @@ void parse_cmdline(int argc, char **argv, cmdline_options *const opt)
                 exit(EXIT_FAILURE);
             }
 
-            snprintf(opt->port_name, sizeof(opt->port_name), "%s", argv[count]);
+            snprintf(get_device_options(opt, false)->port_name, MAX_PATH, "%s", argv[count]);
             break;
         }
         case 's':
@@ -330,7 +675,21 @@ void parse_cmdline(int argc, char **argv, cmdline_options *const opt)
                 exit(EXIT_FAILURE);
             }
 
-            snprintf(opt->state_file_name, sizeof(opt->state_file_name), "%s", argv[count]);
+            snprintf(get_device_options(opt, false)->state_file_name, MAX_PATH, "%s", argv[count]);
+            break;
+        }
+        case 'u':
+        {
+            increase_count(&count, argc, argv);
+
+            if (strlen(argv[count]) >= MAX_PATH)
+            {
+                fprintf(stderr, "ERROR: Path to the control socket is too long.\n");
+                assert(strlen(argv[count]) < MAX_PATH);
+                exit(EXIT_FAILURE);
+            }
+
+            snprintf(opt->control_socket_name, sizeof(opt->control_socket_name), "%s", argv[count]);
             break;
         }
         case 'x':
@@ -344,9 +703,7 @@ void parse_cmdline(int argc, char **argv, cmdline_options *const opt)
                 exit(EXIT_FAILURE);
             }
 
-            snprintf(opt->config_file_name, sizeof(opt->config_file_name), "%s", argv[count]);
-
-            flag = 1;
+            snprintf(get_device_options(opt, true)->config_file_name, MAX_PATH, "%s", argv[count]);
             break;
         }
         case 'v':
@@ -365,11 +722,34 @@ void parse_cmdline(int argc, char **argv, cmdline_options *const opt)
         }
         count++;
     }
-    if (flag == 0)
+    if (opt->validate_count > 0)
+    {
+        // Only the given files are parsed, devices are not needed
+        return;
+    }
+    if (opt->topology_file_name[0] != '\0')
+    {
+        // Devices and their options are given by the topology file, which is no device config to compile or reload
+        if (opt->device_count > 0 || opt->compile_config || opt->watch_config)
+        {
+            fprintf(stderr, "ERROR: --topology can't be combined with -x, -a, -c, -p, -s, --compile-config or --watch-config.\n");
+            exit(EXIT_FAILURE);
+        }
+        return;
+    }
+    if (opt->device_count == 0)
     {
         fprintf(stderr, "ERROR: No xml file given.\n");
         exit(EXIT_FAILURE);
     }
+    for (unsigned int i = 0; i < opt->device_count; ++i)
+    {
+        if (opt->devices[i].config_file_name[0] == '\0')
+        {
+            fprintf(stderr, "ERROR: No xml file given for device %u.\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
 }
 
 /*!
@@ -467,6 +847,23 @@ static void print_and_log_message(const char *format, ...)
 {
     va_list args;
     va_start(args, format);
+    if (captured_output && captured_output_len + 1 < captured_output_size)
+    {
+        va_list args_cpy;
+        int     len;
+        va_copy(args_cpy, args);
+        len = vsnprintf(
+            captured_output + captured_output_len, captured_output_size - captured_output_len, format, args_cpy);
+        if (len > 0)
+        {
+            captured_output_len += (size_t)len;
+            if (captured_output_len >= captured_output_size)
+            {
+                captured_output_len = captured_output_size - 1;
+            }
+        }
+        va_end(args_cpy);
+    }
     log_messages(NULL, format, args);
     va_end(args);
 }
@@ -516,7 +913,7 @@ static int transmit_data(dlb_cec_bus_t *cec_bus, const unsigned char data[CEC_BU
     return cec_bus->transmit_callback(cec_bus->handle, &command);
 }
 
-static int process_command_tx(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus, const char data[COMMAND_BUFFER_SIZE])
+static int process_command_tx(lip_tool_device_t *p_device, const char data[COMMAND_BUFFER_SIZE])
 {
     const char delim[2]         = ":";
     const char delim_command[2] = " ";
@@ -526,7 +923,6 @@ static int process_command_tx(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus, cons
     unsigned char parsed_size     = 0;
 
     char data_tmp[COMMAND_BUFFER_SIZE] = { 0 };
-    (void)p_dlb_lip;
 
     memcpy(data_tmp, data, COMMAND_BUFFER_SIZE);
 
@@ -551,30 +947,26 @@ static int process_command_tx(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus, cons
         token                      = strtok(NULL, delim);
     }
 
-    return transmit_data(cec_bus, parsed_data, parsed_size);
+    return transmit_data(p_device->cec_bus, parsed_data, parsed_size);
 }
 
-static int process_command_quit(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus, const char data[COMMAND_BUFFER_SIZE])
+static int process_command_quit(lip_tool_device_t *p_device, const char data[COMMAND_BUFFER_SIZE])
 {
-    (void)p_dlb_lip;
+    (void)p_device;
     (void)data;
-    (void)cec_bus;
 
     return 1;
 }
 
-static int process_command_wait_time(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus, const char data[COMMAND_BUFFER_SIZE])
+static int process_command_wait_time(lip_tool_device_t *p_device, const char data[COMMAND_BUFFER_SIZE])
 {
     unsigned int sleep_time_ms = 0;
     int          ret           = 0;
 
-    (void)p_dlb_lip;
-    (void)cec_bus;
-
     if (sscanf(data, "%*s %u\n", &sleep_time_ms) == 1)
     {
-        WAIT_TIME_MS = sleep_time_ms;
-        ret          = 0;
+        p_device->wait_time_ms = sleep_time_ms;
+        ret                    = 0;
     }
     else
     {
@@ -585,23 +977,20 @@ static int process_command_wait_time(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bu
     return ret;
 }
 
-static int process_command_wait(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus, const char data[COMMAND_BUFFER_SIZE])
+static int process_command_wait(lip_tool_device_t *p_device, const char data[COMMAND_BUFFER_SIZE])
 {
     char               wait_arg[32]  = { 0 };
     long long          sleep_time_ms = 0;
     int                ret           = 0;
     const unsigned int MAX_WAIT_MS   = 32000;
 
-    (void)p_dlb_lip;
-    (void)cec_bus;
-
     if (sscanf(data, "%*s %31s\n", wait_arg) == 1)
     {
         if (strcmp(wait_arg, "downstream") == 0)
         {
             const unsigned int MAX_RETRY_CNT = 10;
 
-            if (wait_for_downstream_device(p_dlb_lip, MAX_RETRY_CNT) == false)
+            if (wait_for_downstream_device(p_device->p_dlb_lip, MAX_RETRY_CNT) == false)
             {
                 print_and_log_message("Waiting for downstream device failed\n");
             }
@@ -613,7 +1002,7 @@ static int process_command_wait(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus, co
 
             while (waited < MAX_WAIT_MS)
             {
-                dlb_lip_status_t status = dlb_lip_get_status(p_dlb_lip, true);
+                dlb_lip_status_t status = dlb_lip_get_status(p_device->p_dlb_lip, true);
                 if ((status.status & LIP_UPSTREAM_CONNECTED) == LIP_UPSTREAM_CONNECTED)
                 {
                     ret = 0;
@@ -676,151 +1065,332 @@ get_audio_format_from_string(const char *codec, const char *subtype_str, const c
     return ret;
 }
 
-static int process_command_req_audio_latency(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus, const char data[COMMAND_BUFFER_SIZE])
+static unsigned int get_hdr_mode_count(dlb_lip_color_format_type_t color_format)
 {
-    char                   codec_str[16]   = { 0 };
-    char                   subtype_str[16] = { 0 };
-    char                   ext_str[16]     = { 0 };
-    int                    ret             = 0;
-    const dlb_lip_status_t status          = dlb_lip_get_status(p_dlb_lip, true);
-    (void)cec_bus;
+    unsigned int count = 0;
 
-    if (status.status == 0)
+    switch (color_format)
     {
-        print_and_log_message("LIP not supported ignoring cmd!\n");
+    case LIP_COLOR_FORMAT_HDR_STATIC:
+        count = LIP_HDR_STATIC_COUNT;
+        break;
+    case LIP_COLOR_FORMAT_HDR_DYNAMIC:
+        count = LIP_HDR_DYNAMIC_COUNT;
+        break;
+    case LIP_COLOR_FORMAT_DOLBY_VISION:
+        count = LIP_HDR_DOLBY_VISION_COUNT;
+        break;
+    default:
+        break;
     }
-    else if (sscanf(data, "%*s %*s %s %s %s\n", codec_str, subtype_str, ext_str) == 3)
+
+    return count;
+}
+
+static const char *get_hdr_mode_str(dlb_lip_color_format_type_t color_format, unsigned int hdr_mode)
+{
+    const char *str = dlb_lip_vocabulary_name(dlb_lip_vocabulary_hdr_kind(color_format), (int)hdr_mode);
+
+    return str ? str : "INVALID";
+}
+
+static void set_video_format(
+    dlb_lip_video_format_t *video_format, uint8_t vic, dlb_lip_color_format_type_t color_format, unsigned int hdr_mode)
+{
+    video_format->vic          = vic;
+    video_format->color_format = color_format;
+    switch (color_format)
     {
-        unsigned char          audio_latency = 0;
-        dlb_lip_audio_format_t format        = { 0 };
+    case LIP_COLOR_FORMAT_HDR_STATIC:
+        video_format->hdr_mode.hdr_static = (dlb_lip_hdr_static_t)hdr_mode;
+        break;
+    case LIP_COLOR_FORMAT_HDR_DYNAMIC:
+        video_format->hdr_mode.hdr_dynamic = (dlb_lip_hdr_dynamic_t)hdr_mode;
+        break;
+    case LIP_COLOR_FORMAT_DOLBY_VISION:
+        video_format->hdr_mode.dolby_vision = (dlb_lip_dolby_vision_t)hdr_mode;
+        break;
+    default:
+        break;
+    }
+}
 
-        ret = get_audio_format_from_string(codec_str, subtype_str, ext_str, &format);
+static int get_video_mode_from_string(const char *color_format, const char *hdr_mode, dlb_lip_video_format_t *video_format)
+{
+    const int color = dlb_lip_vocabulary_lookup(DLB_LIP_VOCABULARY_COLOR_FORMAT, color_format);
+    int       mode;
 
-        if (ret == 0)
-        {
-            ret = dlb_lip_get_audio_latency(p_dlb_lip, format, &audio_latency);
-            print_and_log_message("Audio_latency=%u\n", audio_latency);
-        }
+    if (color < 0)
+    {
+        return 1;
+    }
+
+    // The first hdr mode is set when hdr_mode is invalid
+    mode = dlb_lip_vocabulary_lookup(dlb_lip_vocabulary_hdr_kind((dlb_lip_color_format_type_t)color), hdr_mode);
+    set_video_format(video_format, video_format->vic, (dlb_lip_color_format_type_t)color, mode < 0 ? 0 : (unsigned int)mode);
+    if (mode < 0)
+    {
+        print_and_log_message("Invalid hdr_mode[%s] for %s\n", hdr_mode ? hdr_mode : "NULL", color_format);
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Kind of latency query issued to the downstream device
+ */
+typedef enum lip_query_type_e
+{
+    LIP_QUERY_AUDIO,
+    LIP_QUERY_VIDEO,
+    LIP_QUERY_AV
+} lip_query_type_t;
+
+typedef struct lip_query_s
+{
+    lip_query_type_t       type;
+    dlb_lip_audio_format_t audio_format;
+    dlb_lip_video_format_t video_format;
+} lip_query_t;
+
+/*!
+Gets query type from "req audio_latency|video_latency|av_latency ..." command.
+
+@return 0 on success, 1 if the command is not a latency query
+*/
+static int get_latency_query_type(const char *data, lip_query_type_t *type)
+{
+    int ret = 0;
+
+    if (strncmp(data, "req audio_latency", strlen("req audio_latency")) == 0)
+    {
+        *type = LIP_QUERY_AUDIO;
+    }
+    else if (strncmp(data, "req video_latency", strlen("req video_latency")) == 0)
+    {
+        *type = LIP_QUERY_VIDEO;
+    }
+    else if (strncmp(data, "req av_latency", strlen("req av_latency")) == 0)
+    {
+        *type = LIP_QUERY_AV;
     }
     else
     {
-        print_and_log_message("ERROR parsing cmd [ %s ]\n", data);
         ret = 1;
     }
 
     return ret;
 }
 
-static int get_video_mode_from_string(const char *color_format, const char *hdr_mode, dlb_lip_video_format_t *video_format)
+/*!
+Parses "req audio_latency|video_latency|av_latency ..." command into a query.
+
+@param data     - command string
+@param type     - expected query type
+@param query    - parsed query
+
+@return 0 on success, 1 when command couldn't be parsed
+*/
+static int parse_latency_query(const char *data, lip_query_type_t type, lip_query_t *query)
 {
-    int ret = 0;
+    char          codec_str[16]        = { 0 };
+    char          subtype_str[16]      = { 0 };
+    char          ext_str[16]          = { 0 };
+    char          color_format_str[16] = { 0 };
+    char          hdr_mode_str[32]     = { 0 };
+    unsigned char vic                  = 0; // VIC code
+    int           ret                  = 0;
 
-    if (strcmp(color_format, "HDR_STATIC") == 0)
-    {
-        video_format->color_format        = LIP_COLOR_FORMAT_HDR_STATIC;
-        video_format->hdr_mode.hdr_static = LIP_HDR_STATIC_SDR;
+    memset(query, 0, sizeof(*query));
+    query->type = type;
 
-        if (hdr_mode && (strcmp(hdr_mode, "SDR") == 0))
-        {
-            video_format->hdr_mode.hdr_static = LIP_HDR_STATIC_SDR;
-        }
-        else if (hdr_mode && (strcmp(hdr_mode, "HDR") == 0))
-        {
-            video_format->hdr_mode.hdr_static = LIP_HDR_STATIC_HDR;
-        }
-        else if (hdr_mode && (strcmp(hdr_mode, "SMPTE") == 0))
-        {
-            video_format->hdr_mode.hdr_static = LIP_HDR_STATIC_SMPTE_ST_2084;
-        }
-        else if (hdr_mode && (strcmp(hdr_mode, "HLG") == 0))
+    switch (type)
+    {
+    case LIP_QUERY_AUDIO:
+        if (sscanf(data, "%*s %*s %15s %15s %15s\n", codec_str, subtype_str, ext_str) == 3)
         {
-            video_format->hdr_mode.hdr_static = LIP_HDR_STATIC_HLG;
+            ret = get_audio_format_from_string(codec_str, subtype_str, ext_str, &query->audio_format);
         }
         else
         {
-            print_and_log_message("Invalid hdr_mode[%s] for HDR_STATIC\n", hdr_mode ? hdr_mode : "NULL");
             ret = 1;
         }
-    }
-    else if (strcmp(color_format, "HDR_DYNAMIC") == 0)
-    {
-        video_format->color_format         = LIP_COLOR_FORMAT_HDR_DYNAMIC;
-        video_format->hdr_mode.hdr_dynamic = LIP_HDR_DYNAMIC_SMPTE_ST_2094_10;
-
-        if (hdr_mode && (strcmp(hdr_mode, "SMPTE_ST_2094_10") == 0))
-        {
-            video_format->hdr_mode.hdr_dynamic = LIP_HDR_DYNAMIC_SMPTE_ST_2094_10;
-        }
-        else if (hdr_mode && (strcmp(hdr_mode, "ETSI") == 0))
+        break;
+    case LIP_QUERY_VIDEO:
+        if (sscanf(data, "%*s %*s VIC%hhu %15s %31s\n", &vic, color_format_str, hdr_mode_str) >= 2)
         {
-            video_format->hdr_mode.hdr_dynamic = LIP_HDR_DYNAMIC_ETSI_TS_103_433;
+            query->video_format.vic = vic;
+            ret                     = get_video_mode_from_string(color_format_str, hdr_mode_str, &query->video_format);
         }
-        else if (hdr_mode && (strcmp(hdr_mode, "ITU") == 0))
+        else
         {
-            video_format->hdr_mode.hdr_dynamic = LIP_HDR_DYNAMIC_ITU_T_H265;
+            ret = 1;
         }
-        else if (hdr_mode && (strcmp(hdr_mode, "SMPTE_ST_2094_40") == 0))
+        break;
+    case LIP_QUERY_AV:
+        if (sscanf(
+                data,
+                "%*s %*s %15s %15s %15s VIC%hhu %15s %31s\n",
+                codec_str,
+                subtype_str,
+                ext_str,
+                &vic,
+                color_format_str,
+                hdr_mode_str)
+            >= 5)
         {
-            video_format->hdr_mode.hdr_dynamic = LIP_HDR_DYNAMIC_SMPTE_ST_2094_40;
+            query->video_format.vic = vic;
+            ret                     = get_audio_format_from_string(codec_str, subtype_str, ext_str, &query->audio_format);
+            ret |= get_video_mode_from_string(color_format_str, hdr_mode_str, &query->video_format);
         }
         else
         {
-            print_and_log_message("Invalid hdr_mode[%s] for HDR_DYNAMIC\n", hdr_mode ? hdr_mode : "NULL");
             ret = 1;
         }
+        break;
+    default:
+        ret = 1;
+        break;
     }
-    else if (strcmp(color_format, "DV") == 0)
-    {
-        video_format->color_format          = LIP_COLOR_FORMAT_DOLBY_VISION;
-        video_format->hdr_mode.dolby_vision = LIP_HDR_DOLBY_VISION_SINK_LED;
 
-        if (hdr_mode && (strcmp(hdr_mode, "SINK") == 0))
-        {
-            video_format->hdr_mode.dolby_vision = LIP_HDR_DOLBY_VISION_SINK_LED;
-        }
-        else if (hdr_mode && (strcmp(hdr_mode, "SOURCE") == 0))
+    return ret;
+}
+
+/*!
+Packs the query into a key of the query cache, unused fields of the query are zero.
+
+@return packed query, never 0
+*/
+static uint64_t pack_latency_query(const lip_query_t *query)
+{
+    return ((uint64_t)query->type + 1U) << 56 | (uint64_t)query->audio_format.codec << 48
+           | (uint64_t)query->audio_format.subtype << 40 | (uint64_t)query->audio_format.ext << 32
+           | (uint64_t)query->video_format.vic << 16 | (uint64_t)query->video_format.color_format << 8
+           | (uint64_t)dlb_lip_get_hdr_mode_from_video_format(query->video_format);
+}
+
+static void unpack_latency_query(uint64_t key, lip_query_t *query)
+{
+    memset(query, 0, sizeof(*query));
+    query->type                 = (lip_query_type_t)((key >> 56) - 1U);
+    query->audio_format.codec   = (dlb_lip_audio_codec_t)((key >> 48) & 0xFF);
+    query->audio_format.subtype = (dlb_lip_audio_formats_subtypes_t)((key >> 40) & 0xFF);
+    query->audio_format.ext     = (uint8_t)((key >> 32) & 0xFF);
+    set_video_format(
+        &query->video_format,
+        (uint8_t)((key >> 16) & 0xFF),
+        (dlb_lip_color_format_type_t)((key >> 8) & 0xFF),
+        (unsigned int)(key & 0xFF));
+}
+
+/*!
+Issues latency query to the dlb_lip library. Answers of the current downstream device are memoized in the query cache,
+unsupported formats only until the negative TTL expires. Repeated queries don't call into dlb_lip at all, not even
+for the status.
+
+@param p_device         - emulated device
+@param query            - query to execute
+@param use_cache        - look up and store the result in the query cache of the device
+@param required_status  - status flags of which at least one must be set to query dlb_lip, 0 to query unconditionally
+@param audio_latency    - audio latency, untouched for video queries
+@param video_latency    - video latency, untouched for audio queries
+
+@return dlb_lip status of the query, LIP_TOOL_QUERY_SKIPPED if none of required_status flags was set
+*/
+static int execute_latency_query(
+    lip_tool_device_t *p_device,
+    const lip_query_t *query,
+    bool               use_cache,
+    uint32_t           required_status,
+    unsigned char *    audio_latency,
+    unsigned char *    video_latency)
+{
+    const uint64_t key        = pack_latency_query(query);
+    uint32_t       generation = 0;
+    unsigned char  audio      = audio_latency ? *audio_latency : LIP_INVALID_LATENCY;
+    unsigned char  video      = video_latency ? *video_latency : LIP_INVALID_LATENCY;
+    int            ret        = 1;
+
+    if (use_cache && dlb_lip_query_cache_lookup(&p_device->query_cache, key, &generation, &audio, &video))
+    {
+        ret = 0;
+    }
+    else if (required_status && !(dlb_lip_get_status(p_device->p_dlb_lip, true).status & required_status))
+    {
+        return LIP_TOOL_QUERY_SKIPPED;
+    }
+    else
+    {
+        switch (query->type)
         {
-            video_format->hdr_mode.dolby_vision = LIP_HDR_DOLBY_VISION_SOURCE_LED;
+        case LIP_QUERY_AUDIO:
+            ret = dlb_lip_get_audio_latency(p_device->p_dlb_lip, query->audio_format, &audio);
+            break;
+        case LIP_QUERY_VIDEO:
+            ret = dlb_lip_get_video_latency(p_device->p_dlb_lip, query->video_format, &video);
+            break;
+        case LIP_QUERY_AV:
+            ret = dlb_lip_get_av_latency(p_device->p_dlb_lip, query->video_format, query->audio_format, &video, &audio);
+            break;
+        default:
+            break;
         }
-        else
+
+        // Only answers of the downstream device are cached, failed queries are retried
+        if (use_cache && ret == 0)
         {
-            print_and_log_message("Invalid hdr_mode[%s] for Dolby Vision\n", hdr_mode ? hdr_mode : "NULL");
-            ret = 1;
+            const bool negative = (query->type != LIP_QUERY_VIDEO && audio == LIP_INVALID_LATENCY)
+                                  || (query->type != LIP_QUERY_AUDIO && video == LIP_INVALID_LATENCY);
+
+            dlb_lip_query_cache_insert(&p_device->query_cache, generation, key, audio, video, negative);
         }
     }
-    else
+
+    if (audio_latency && query->type != LIP_QUERY_VIDEO)
     {
-        ret = 1;
+        *audio_latency = audio;
+    }
+    if (video_latency && query->type != LIP_QUERY_AUDIO)
+    {
+        *video_latency = video;
     }
 
     return ret;
 }
 
-static int process_command_req_video_latency(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus, const char data[COMMAND_BUFFER_SIZE])
+static int
+process_command_req_latency(lip_tool_device_t *p_device, lip_query_type_t type, const char data[COMMAND_BUFFER_SIZE])
 {
-    char                   color_format_str[16] = { 0 };
-    char                   hdr_mode_str[32]     = { 0 };
-    unsigned char          vic                  = 0; // VIC code
-    int                    ret                  = 0;
-    const dlb_lip_status_t status               = dlb_lip_get_status(p_dlb_lip, true);
-    (void)cec_bus;
+    int         ret   = 0;
+    lip_query_t query = { 0 };
 
-    if (status.status == 0)
-    {
-        print_and_log_message("LIP not supported ignoring cmd!\n");
-    }
-    else if (sscanf(data, "%*s %*s VIC%hhu %s %s\n", &vic, color_format_str, hdr_mode_str) >= 2)
+    if (parse_latency_query(data, type, &query) == 0)
     {
-        dlb_lip_video_format_t video_format  = { 0 };
-        unsigned char          video_latency = 0;
-        video_format.vic                     = vic;
+        unsigned char audio_latency = 0;
+        unsigned char video_latency = 0;
 
-        ret |= get_video_mode_from_string(color_format_str, hdr_mode_str, &video_format);
+        dlb_lip_prefetch_learn(pack_latency_query(&query));
+
+        // Any status flag means LIP is supported
+        ret = execute_latency_query(p_device, &query, true, UINT32_MAX, &audio_latency, &video_latency);
+        if (ret == LIP_TOOL_QUERY_SKIPPED)
+        {
+            print_and_log_message("LIP not supported ignoring cmd!\n");
+            return 0;
+        }
 
-        if (ret == 0)
+        switch (type)
         {
-            ret = dlb_lip_get_video_latency(p_dlb_lip, video_format, &video_latency);
+        case LIP_QUERY_AUDIO:
+            print_and_log_message("Audio_latency=%u\n", audio_latency);
+            break;
+        case LIP_QUERY_VIDEO:
             print_and_log_message("Video_latency=%u\n", video_latency);
+            break;
+        default:
+            print_and_log_message("Video_latency=%u Audio_latency=%u\n", video_latency, audio_latency);
+            break;
         }
     }
     else
@@ -832,85 +1402,195 @@ static int process_command_req_video_latency(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t
     return ret;
 }
 
-static int process_command_req_av_latency(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus, const char data[COMMAND_BUFFER_SIZE])
+static int process_command_req_audio_latency(lip_tool_device_t *p_device, const char data[COMMAND_BUFFER_SIZE])
 {
-    char                   codec_str[16]        = { 0 };
-    char                   subtype_str[16]      = { 0 };
-    char                   ext_str[16]          = { 0 };
-    char                   color_format_str[16] = { 0 };
-    char                   hdr_mode_str[32]     = { 0 };
-    unsigned char          vic                  = 0; // VIC code
-    int                    ret                  = 0;
-    const dlb_lip_status_t status               = dlb_lip_get_status(p_dlb_lip, true);
-    (void)cec_bus;
+    return process_command_req_latency(p_device, LIP_QUERY_AUDIO, data);
+}
 
-    if (status.status == 0)
+static int process_command_req_video_latency(lip_tool_device_t *p_device, const char data[COMMAND_BUFFER_SIZE])
+{
+    return process_command_req_latency(p_device, LIP_QUERY_VIDEO, data);
+}
+
+static int process_command_req_av_latency(lip_tool_device_t *p_device, const char data[COMMAND_BUFFER_SIZE])
+{
+    return process_command_req_latency(p_device, LIP_QUERY_AV, data);
+}
+
+/*!
+Changes audio and/or video rendering mode nibble of the device UUID, so upstream devices learn the latencies changed.
+A device with downstream device(HUB) uses upper nibbles of the rendering mode bytes, a SINK the lower ones.
+
+@param p_config - live config of the device
+@param audio    - audio latencies changed
+@param video    - video latencies changed
+
+@return void
+*/
+static void bump_uuid_rendering_modes(dlb_lip_config_params_t *p_config, bool audio, bool video)
+{
+    const bool hub = p_config->downstream_device_addr != DLB_LOGICAL_ADDR_UNKNOWN;
+
+    if (video)
     {
-        print_and_log_message("LIP not supported ignoring cmd!\n");
+        const unsigned int shift                = hub ? 12U : 8U;
+        const uint8_t      video_rendering_mode = (((p_config->uuid >> shift) & 0xF) + 1U) % 0xF;
+        p_config->uuid                          = (p_config->uuid & ~(0xFU << shift)) | ((uint32_t)video_rendering_mode << shift);
     }
-    else if (
-        sscanf(data, "%*s %*s %s %s %s VIC%hhu %s %s\n", codec_str, subtype_str, ext_str, &vic, color_format_str, hdr_mode_str)
-        >= 5)
+    if (audio)
     {
-        unsigned char          audio_latency = 0;
-        unsigned char          video_latency = 0;
-        dlb_lip_video_format_t video_format  = { 0 };
-        dlb_lip_audio_format_t a_format      = { 0 };
-        video_format.vic                     = vic;
+        const unsigned int shift                = hub ? 4U : 0U;
+        const uint8_t      audio_rendering_mode = (((p_config->uuid >> shift) & 0xF) + 1U) % 0xF;
+        p_config->uuid                          = (p_config->uuid & ~(0xFU << shift)) | ((uint32_t)audio_rendering_mode << shift);
+    }
+}
 
-        ret = get_audio_format_from_string(codec_str, subtype_str, ext_str, &a_format);
-        ret |= get_video_mode_from_string(color_format_str, hdr_mode_str, &video_format);
+/*!
+Sets audio latency of one format in the latency table of the device config and in its dense array passed to dlb_lip.
+The format gets its own rule, which overrides all defaults of the table, so only its cell of the dense array changes.
 
-        if (ret == 0)
-        {
-            ret = dlb_lip_get_av_latency(p_dlb_lip, video_format, a_format, &video_latency, &audio_latency);
-            print_and_log_message("Video_latency=%u Audio_latency=%u\n", video_latency, audio_latency);
-        }
+@return 0 on success, 1 if the format is outside of the latency table
+*/
+static int set_config_audio_latency(lip_tool_device_t *p_device, const dlb_lip_audio_format_t *a_format, uint8_t latency)
+{
+    dlb_lip_xml_parser_t *const p_parser = &p_device->xml_parser;
+
+    if (dlb_lip_latency_table_set_cell(&p_parser->audio_latencies, a_format->codec, a_format->subtype, a_format->ext, latency))
+    {
+        print_and_log_message("Audio format is outside of the latency table!\n");
+        return 1;
     }
-    else
+    dlb_lip_config_fingerprint_set_audio_latency(&p_device->live_fingerprint, &p_parser->config_params, a_format, latency);
+
+    return 0;
+}
+
+/*!
+Sets video latency of one format in the latency table of the device config and in its dense array passed to dlb_lip.
+
+@return 0 on success, 1 if the format is outside of the latency table
+*/
+static int set_config_video_latency(lip_tool_device_t *p_device, const dlb_lip_video_format_t *v_format, uint8_t latency)
+{
+    dlb_lip_xml_parser_t *const p_parser = &p_device->xml_parser;
+    const uint8_t               hdr_mode = dlb_lip_get_hdr_mode_from_video_format(*v_format);
+
+    if (dlb_lip_latency_table_set_cell(&p_parser->video_latencies, v_format->vic, v_format->color_format, hdr_mode, latency))
     {
-        print_and_log_message("ERROR parsing cmd [ %s ] \n", data);
-        ret = 1;
+        print_and_log_message("Video format is outside of the latency table!\n");
+        return 1;
     }
+    dlb_lip_config_fingerprint_set_video_latency(
+        &p_device->live_fingerprint, &p_parser->config_params, v_format, hdr_mode, latency);
 
-    return ret;
+    return 0;
+}
+
+/*!
+Compares the live config of the device with the config passed to dlb_lip last.
+
+@return dlb_lip_config_changes_t flags of the changed parts, 0 if the live config was passed to dlb_lip
+*/
+static unsigned int get_device_config_changes(const lip_tool_device_t *p_device)
+{
+    return dlb_lip_config_fingerprint_compare(&p_device->live_fingerprint, &p_device->sent_fingerprint);
 }
 
-static int process_command_update_audio_latency(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus, const char data[COMMAND_BUFFER_SIZE])
+/*!
+Checks if the audio latency of the format is already in the live config, formats outside of the latency arrays never are.
+*/
+static bool device_config_has_audio_latency(
+    const lip_tool_device_t *p_device, const dlb_lip_audio_format_t *a_format, uint8_t latency)
 {
-    char                   codec_str[16]   = { 0 };
-    char                   subtype_str[16] = { 0 };
-    char                   ext_str[16]     = { 0 };
-    unsigned char          audio_latency   = 0;
-    int                    ret             = 0;
-    const dlb_lip_status_t status          = dlb_lip_get_status(p_dlb_lip, true);
-    (void)cec_bus;
+    const dlb_lip_config_params_t *const p_config = &p_device->xml_parser.config_params;
 
-    if (status.status == 0)
+    return (unsigned int)a_format->codec < IEC61937_AUDIO_CODECS && (unsigned int)a_format->subtype < IEC61937_SUBTYPES
+           && a_format->ext < MAX_AUDIO_FORMAT_EXTENSIONS
+           && p_config->audio_latencies[a_format->codec][a_format->subtype][a_format->ext] == latency;
+}
+
+/*!
+Checks if the video latency of the format is already in the live config, formats outside of the latency arrays never are.
+*/
+static bool device_config_has_video_latency(
+    const lip_tool_device_t *p_device, const dlb_lip_video_format_t *v_format, uint8_t latency)
+{
+    const dlb_lip_config_params_t *const p_config = &p_device->xml_parser.config_params;
+    const uint8_t                        hdr_mode = dlb_lip_get_hdr_mode_from_video_format(*v_format);
+
+    return v_format->vic < MAX_VICS && (unsigned int)v_format->color_format < LIP_COLOR_FORMAT_COUNT
+           && hdr_mode < HDR_MODES_COUNT && p_config->video_latencies[v_format->vic][v_format->color_format][hdr_mode] == latency;
+}
+
+/*!
+Passes the live config of the device to dlb_lip unless it equals the config passed last time, so unchanged configs
+neither call dlb_lip nor send UPDATE_UUID upstream. Rendering modes of the UUID are bumped for changed latency tables.
+
+@param bump_uuid - bump UUID rendering modes of changed latency tables, false if the UUID was set explicitly
+
+@return 0 on success or unchanged config, dlb_lip_set_config error otherwise
+*/
+static int push_device_config(lip_tool_device_t *p_device, bool bump_uuid)
+{
+    dlb_lip_config_params_t *const      p_config = &p_device->xml_parser.config_params;
+    dlb_lip_config_fingerprint_t *const p_live   = &p_device->live_fingerprint;
+    const unsigned int                  changes  = get_device_config_changes(p_device);
+    int                                 ret      = 0;
+
+    if (changes == 0)
     {
-        print_and_log_message("LIP not supported ignoring cmd!\n");
+        print_and_log_message("Device %u: config unchanged, update skipped\n", p_device->index);
+        return 0;
+    }
+
+    if (bump_uuid)
+    {
+        bump_uuid_rendering_modes(
+            p_config, (changes & DLB_LIP_CONFIG_AUDIO_CHANGED) != 0, (changes & DLB_LIP_CONFIG_VIDEO_CHANGED) != 0);
+        dlb_lip_config_fingerprint_update_params(p_live, p_config);
+    }
+    ret = dlb_lip_set_config(p_device->p_dlb_lip, p_config, false, DLB_LOGICAL_ADDR_UNKNOWN);
+    if (ret == 0)
+    {
+        p_device->sent_fingerprint = *p_live;
     }
-    else if (sscanf(data, "%*s %*s %s %s %s %hhu\n", codec_str, subtype_str, ext_str, &audio_latency) == 4)
+
+    return ret;
+}
+
+static int process_command_update_audio_latency(lip_tool_device_t *p_device, const char data[COMMAND_BUFFER_SIZE])
+{
+    char          codec_str[16]   = { 0 };
+    char          subtype_str[16] = { 0 };
+    char          ext_str[16]     = { 0 };
+    unsigned char audio_latency   = 0;
+    int           ret             = 0;
+
+    if (sscanf(data, "%*s %*s %s %s %s %hhu\n", codec_str, subtype_str, ext_str, &audio_latency) == 4)
     {
         dlb_lip_audio_format_t a_format = { 0 };
 
         ret = get_audio_format_from_string(codec_str, subtype_str, ext_str, &a_format);
-        if (ret == 0)
+        if (ret != 0)
         {
-            if (xml_parser.config_params.downstream_device_addr != DLB_LOGICAL_ADDR_UNKNOWN)
-            {
-                // HUB
-                const uint8_t audio_rendering_mode = (((xml_parser.config_params.uuid >> 4) & 0xF) + 1U) % 0xF;
-                xml_parser.config_params.uuid      = (xml_parser.config_params.uuid & 0xFFFFFF0F) | (audio_rendering_mode << 4U);
-            }
-            else
+            return ret;
+        }
+        // Update which changes nothing needs no status of dlb_lip
+        if (device_config_has_audio_latency(p_device, &a_format, audio_latency) && get_device_config_changes(p_device) == 0)
+        {
+            print_and_log_message("Device %u: config unchanged, update skipped\n", p_device->index);
+        }
+        else if (dlb_lip_get_status(p_device->p_dlb_lip, true).status == 0)
+        {
+            print_and_log_message("LIP not supported ignoring cmd!\n");
+        }
+        else
+        {
+            ret = set_config_audio_latency(p_device, &a_format, audio_latency);
+            if (ret == 0)
             {
-                // SINK
-                const uint8_t audio_rendering_mode = ((xml_parser.config_params.uuid & 0xF) + 1U) % 0xF;
-                xml_parser.config_params.uuid      = (xml_parser.config_params.uuid & 0xFFFFFFF0) | audio_rendering_mode;
+                ret = push_device_config(p_device, true);
             }
-            xml_parser.config_params.audio_latencies[a_format.codec][a_format.subtype][a_format.ext] = audio_latency;
-            ret = dlb_lip_set_config(p_dlb_lip, &xml_parser.config_params, false, DLB_LOGICAL_ADDR_UNKNOWN);
         }
     }
     else
@@ -922,45 +1602,40 @@ static int process_command_update_audio_latency(dlb_lip_t *p_dlb_lip, dlb_cec_bu
     return ret;
 }
 
-static int process_command_update_video_latency(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus, const char data[COMMAND_BUFFER_SIZE])
+static int process_command_update_video_latency(lip_tool_device_t *p_device, const char data[COMMAND_BUFFER_SIZE])
 {
-    char                   color_format_str[16] = { 0 };
-    char                   hdr_mode_str[32]     = { 0 };
-    unsigned char          vic                  = 0; // VIC code
-    unsigned char          video_latency        = 0;
-    int                    ret                  = 0;
-    const dlb_lip_status_t status               = dlb_lip_get_status(p_dlb_lip, true);
-    (void)cec_bus;
+    char          color_format_str[16] = { 0 };
+    char          hdr_mode_str[32]     = { 0 };
+    unsigned char vic                  = 0; // VIC code
+    unsigned char video_latency        = 0;
+    int           ret                  = 0;
 
-    if (status.status == 0)
-    {
-        print_and_log_message("LIP not supported ignoring cmd!\n");
-    }
-    else if (sscanf(data, "%*s %*s VIC%hhu %s %s %hhu\n", &vic, color_format_str, hdr_mode_str, &video_latency) == 4)
+    if (sscanf(data, "%*s %*s VIC%hhu %s %s %hhu\n", &vic, color_format_str, hdr_mode_str, &video_latency) == 4)
     {
         dlb_lip_video_format_t v_format = { 0 };
         v_format.vic                    = vic;
 
         ret = get_video_mode_from_string(color_format_str, hdr_mode_str, &v_format);
-        if (ret == 0)
+        if (ret != 0)
         {
-            if (xml_parser.config_params.downstream_device_addr != DLB_LOGICAL_ADDR_UNKNOWN)
-            {
-                // HUB
-                const uint8_t video_rendering_mode = (((xml_parser.config_params.uuid >> 12U) & 0xF) + 1U) % 0xF;
-                xml_parser.config_params.uuid      = (xml_parser.config_params.uuid & 0xFFFF0FFF) | (video_rendering_mode << 12U);
-            }
-            else
+            return ret;
+        }
+        // Update which changes nothing needs no status of dlb_lip
+        if (device_config_has_video_latency(p_device, &v_format, video_latency) && get_device_config_changes(p_device) == 0)
+        {
+            print_and_log_message("Device %u: config unchanged, update skipped\n", p_device->index);
+        }
+        else if (dlb_lip_get_status(p_device->p_dlb_lip, true).status == 0)
+        {
+            print_and_log_message("LIP not supported ignoring cmd!\n");
+        }
+        else
+        {
+            ret = set_config_video_latency(p_device, &v_format, video_latency);
+            if (ret == 0)
             {
-                // SINK
-                const uint8_t video_rendering_mode = (((xml_parser.config_params.uuid >> 8U) & 0xF) + 1U) % 0xF;
-                xml_parser.config_params.uuid      = (xml_parser.config_params.uuid & 0xFFFFF0FF) | (video_rendering_mode << 8U);
+                ret = push_device_config(p_device, true);
             }
-
-            xml_parser.config_params
-                .video_latencies[v_format.vic][v_format.color_format][dlb_lip_get_hdr_mode_from_video_format(v_format)]
-                = video_latency;
-            ret = dlb_lip_set_config(p_dlb_lip, &xml_parser.config_params, false, DLB_LOGICAL_ADDR_UNKNOWN);
         }
     }
     else
@@ -972,7 +1647,7 @@ static int process_command_update_video_latency(dlb_lip_t *p_dlb_lip, dlb_cec_bu
     return ret;
 }
 
-static int process_command_update_av_latency(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus, const char data[COMMAND_BUFFER_SIZE])
+static int process_command_update_av_latency(lip_tool_device_t *p_device, const char data[COMMAND_BUFFER_SIZE])
 {
     char                   codec_str[16]        = { 0 };
     char                   subtype_str[16]      = { 0 };
@@ -983,14 +1658,8 @@ static int process_command_update_av_latency(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t
     unsigned char          audio_latency        = 0;
     unsigned char          video_latency        = 0;
     int                    ret                  = 0;
-    const dlb_lip_status_t status               = dlb_lip_get_status(p_dlb_lip, true);
-    (void)cec_bus;
 
-    if (status.status == 0)
-    {
-        print_and_log_message("LIP not supported ignoring cmd!\n");
-    }
-    else if (
+    if (
         sscanf(
             data,
             "%*s %*s %s %s %s VIC%hhu %s %s %hhu %hhu\n",
@@ -1010,31 +1679,28 @@ static int process_command_update_av_latency(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t
 
         ret = get_audio_format_from_string(codec_str, subtype_str, ext_str, &a_format);
         ret |= get_video_mode_from_string(color_format_str, hdr_mode_str, &v_format);
-        if (ret == 0)
+        if (ret != 0)
         {
-            if (xml_parser.config_params.downstream_device_addr != DLB_LOGICAL_ADDR_UNKNOWN)
-            {
-                // HUB
-                const uint8_t video_rendering_mode = (((xml_parser.config_params.uuid >> 12U) & 0xF) + 1U) % 0xF;
-                const uint8_t audio_rendering_mode = (((xml_parser.config_params.uuid >> 4U) & 0xF) + 1U) % 0xF;
-                xml_parser.config_params.uuid      = (xml_parser.config_params.uuid & 0xFFFF0FFF) | (video_rendering_mode << 12U);
-                xml_parser.config_params.uuid      = (xml_parser.config_params.uuid & 0xFFFFFF0F) | (audio_rendering_mode << 4U);
-            }
-            else
+            return ret;
+        }
+        // Update which changes nothing needs no status of dlb_lip
+        if (device_config_has_video_latency(p_device, &v_format, video_latency)
+            && device_config_has_audio_latency(p_device, &a_format, audio_latency) && get_device_config_changes(p_device) == 0)
+        {
+            print_and_log_message("Device %u: config unchanged, update skipped\n", p_device->index);
+        }
+        else if (dlb_lip_get_status(p_device->p_dlb_lip, true).status == 0)
+        {
+            print_and_log_message("LIP not supported ignoring cmd!\n");
+        }
+        else
+        {
+            ret = set_config_video_latency(p_device, &v_format, video_latency);
+            ret |= set_config_audio_latency(p_device, &a_format, audio_latency);
+            if (ret == 0)
             {
-                // SINK
-                const uint8_t video_rendering_mode = (((xml_parser.config_params.uuid >> 8U) & 0xF) + 1U) % 0xF;
-                const uint8_t audio_rendering_mode = ((xml_parser.config_params.uuid & 0xF) + 1U) % 0xF;
-                xml_parser.config_params.uuid      = (xml_parser.config_params.uuid & 0xFFFFF0FF) | (video_rendering_mode << 8U);
-                xml_parser.config_params.uuid      = (xml_parser.config_params.uuid & 0xFFFFFFF0) | audio_rendering_mode;
+                ret = push_device_config(p_device, true);
             }
-
-            xml_parser.config_params
-                .video_latencies[v_format.vic][v_format.color_format][dlb_lip_get_hdr_mode_from_video_format(v_format)]
-                = video_latency;
-            xml_parser.config_params.audio_latencies[a_format.codec][a_format.subtype][a_format.ext] = audio_latency;
-
-            ret = dlb_lip_set_config(p_dlb_lip, &xml_parser.config_params, false, DLB_LOGICAL_ADDR_UNKNOWN);
         }
     }
     else
@@ -1046,32 +1712,36 @@ static int process_command_update_av_latency(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t
     return ret;
 }
 
-static int process_command_update_uuid(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus, const char data[COMMAND_BUFFER_SIZE])
+static int process_command_update_uuid(lip_tool_device_t *p_device, const char data[COMMAND_BUFFER_SIZE])
 {
-    uint32_t               uuid   = 0;
-    int                    ret    = 0;
-    const dlb_lip_status_t status = dlb_lip_get_status(p_dlb_lip, true);
-    (void)cec_bus;
+    uint32_t uuid = 0;
+    int      ret  = 0;
 
-    if (status.status == 0)
+    if (sscanf(data, "%*s %*s %u\n", &uuid) != 1)
     {
-        print_and_log_message("LIP not supported ignoring cmd!\n");
+        print_and_log_message("ERROR parsing cmd [ %s ] \n", data);
+        ret = 1;
+    }
+    // Update which changes nothing needs no status of dlb_lip
+    else if (uuid == p_device->xml_parser.config_params.uuid && get_device_config_changes(p_device) == 0)
+    {
+        print_and_log_message("Device %u: config unchanged, update skipped\n", p_device->index);
     }
-    else if (sscanf(data, "%*s %*s %u\n", &uuid) == 1)
+    else if (dlb_lip_get_status(p_device->p_dlb_lip, true).status == 0)
     {
-        xml_parser.config_params.uuid = uuid;
-        ret                           = dlb_lip_set_config(p_dlb_lip, &xml_parser.config_params, false, DLB_LOGICAL_ADDR_UNKNOWN);
+        print_and_log_message("LIP not supported ignoring cmd!\n");
     }
     else
     {
-        print_and_log_message("ERROR parsing cmd [ %s ] \n", data);
-        ret = 1;
+        p_device->xml_parser.config_params.uuid = uuid;
+        dlb_lip_config_fingerprint_update_params(&p_device->live_fingerprint, &p_device->xml_parser.config_params);
+        ret = push_device_config(p_device, false);
     }
 
     return ret;
 }
 
-static int process_command_on_update_uuid(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus, const char data[COMMAND_BUFFER_SIZE])
+static int process_command_on_update_uuid(lip_tool_device_t *p_device, const char data[COMMAND_BUFFER_SIZE])
 {
     char          codec_str[16]        = { 0 };
     char          subtype_str[16]      = { 0 };
@@ -1080,8 +1750,6 @@ static int process_command_on_update_uuid(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *c
     char          hdr_mode_str[32]     = { 0 };
     unsigned char vic                  = 0; // VIC code
     int           ret                  = 0;
-    (void)cec_bus;
-    (void)p_dlb_lip;
 
     if (sscanf(data, "%*s %*s %*s %s %s %s VIC%hhu %s %s\n", codec_str, subtype_str, ext_str, &vic, color_format_str, hdr_mode_str)
         >= 5)
@@ -1097,7 +1765,7 @@ static int process_command_on_update_uuid(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *c
         {
             print_and_log_message("ERROR parsing cmd [ %s ] \n", data);
         }
-        on_update_uuid_av_formats_valid = ret ? false : true;
+        p_device->on_update_uuid_av_formats_valid = ret ? false : true;
     }
     else
     {
@@ -1108,11 +1776,10 @@ static int process_command_on_update_uuid(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *c
     return ret;
 }
 
-static int process_command_random(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus, const char data[COMMAND_BUFFER_SIZE])
+static int process_command_random(lip_tool_device_t *p_device, const char data[COMMAND_BUFFER_SIZE])
 {
     int      ret       = 0;
     unsigned cmd_count = 0;
-    (void)p_dlb_lip;
 
     if (sscanf(data, "%*s %u\n", &cmd_count) == 1)
     {
@@ -1130,7 +1797,7 @@ static int process_command_random(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus,
 
             if (i % 2)
             {
-                const dlb_lip_status_t    status = dlb_lip_get_status(p_dlb_lip, true);
+                const dlb_lip_status_t    status = dlb_lip_get_status(p_device->p_dlb_lip, true);
                 dlb_cec_logical_address_t addresses[MAX_UPSTREAM_DEVICES_COUNT + 1];
                 unsigned int              valid_addresses = 0;
                 if (status.downstream_device_addr != DLB_LOGICAL_ADDR_UNKNOWN)
@@ -1147,7 +1814,7 @@ static int process_command_random(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus,
                 if (valid_addresses)
                 {
                     parsed_data[0]
-                        = (unsigned char)((p_dlb_lip->cec_bus.logical_address << 4) | addresses[rand() % valid_addresses]);
+                        = (unsigned char)((p_device->p_dlb_lip->cec_bus.logical_address << 4) | addresses[rand() % valid_addresses]);
                     parsed_data[1] = 0xa0;
                     parsed_data[2] = 0x00;
                     parsed_data[3] = 0xd0;
@@ -1156,7 +1823,7 @@ static int process_command_random(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus,
                     cmd_size       = cmd_size > 6 ? cmd_size : 6;
                 }
             }
-            transmit_data(cec_bus, parsed_data, cmd_size);
+            transmit_data(p_device->cec_bus, parsed_data, cmd_size);
         }
     }
     else
@@ -1168,158 +1835,1489 @@ static int process_command_random(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus,
     return ret;
 }
 
-struct commands_handlers
+static int compare_latency_samples(const void *a, const void *b)
 {
-    char *command;
-    int (*func)(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus, const char data[COMMAND_BUFFER_SIZE]);
-} commands_list[] = {
-    { "tx", process_command_tx },
-    { "q", process_command_quit },
-    { "wait_time", process_command_wait_time },
-    { "wait", process_command_wait },
-    { "req audio_latency", process_command_req_audio_latency },
-    { "req video_latency", process_command_req_video_latency },
-    { "req av_latency", process_command_req_av_latency },
-    { "update audio_latency", process_command_update_audio_latency },
-    { "update video_latency", process_command_update_video_latency },
-    { "update av_latency", process_command_update_av_latency },
-    { "update uuid", process_command_update_uuid },
-    { "on update uuid", process_command_on_update_uuid },
-    { "random", process_command_random },
-};
+    const unsigned long long sample_a = *(const unsigned long long *)a;
+    const unsigned long long sample_b = *(const unsigned long long *)b;
 
-static int process_console_command(dlb_lip_t *p_dlb_lip, dlb_cec_bus_t *cec_bus, const char buffer[COMMAND_BUFFER_SIZE])
+    return (sample_a > sample_b) - (sample_a < sample_b);
+}
+
+static unsigned long long get_percentile(const unsigned long long *sorted_samples, unsigned int count, unsigned int percentile)
 {
-    int ret = 1;
+    // nearest-rank method
+    unsigned int rank = (unsigned int)(((unsigned long long)percentile * count + 99U) / 100U);
+    return sorted_samples[rank ? rank - 1 : 0];
+}
 
-    for (unsigned int i = 0; i < ARRAY_SIZE(commands_list); ++i)
+static int process_command_bench(lip_tool_device_t *p_device, const char data[COMMAND_BUFFER_SIZE])
+{
+    const char          delim[]                        = " ";
+    char                data_tmp[COMMAND_BUFFER_SIZE]  = { 0 };
+    char                query_str[COMMAND_BUFFER_SIZE] = { 0 };
+    char                out_file_name[MAX_PATH]        = { 0 };
+    char *              query_end                      = query_str;
+    char *              token                          = NULL;
+    unsigned int        count                          = 100;
+    bool                cache                          = true;
+    unsigned int        errors                         = 0;
+    unsigned long       frames                         = 0;
+    unsigned long long  sum_us                         = 0;
+    unsigned long long *samples                        = NULL;
+    lip_query_t         query                          = { 0 };
+    lip_query_type_t    type;
+    dlb_lip_status_t    status;
+
+    memcpy(data_tmp, data, COMMAND_BUFFER_SIZE);
+    data_tmp[COMMAND_BUFFER_SIZE - 1] = 0;
+
+    /* drop the 'bench' part, split options from the benchmarked command */
+    strtok(data_tmp, delim);
+    while ((token = strtok(NULL, delim)) != NULL)
     {
-        if (strncmp(buffer, commands_list[i].command, strlen(commands_list[i].command)) == 0)
+        if (strncmp(token, "count=", strlen("count=")) == 0)
         {
-            ret = !commands_list[i].func(p_dlb_lip, cec_bus, buffer);
-            if (process_command_quit != commands_list[i].func && !ret)
+            count = (unsigned int)strtoul(token + strlen("count="), NULL, 10);
+        }
+        else if (strcmp(token, "cache=on") == 0)
+        {
+            cache = true;
+        }
+        else if (strcmp(token, "cache=off") == 0)
+        {
+            cache = false;
+        }
+        else if (strncmp(token, "out=", strlen("out=")) == 0)
+        {
+            snprintf(out_file_name, sizeof(out_file_name), "%s", token + strlen("out="));
+        }
+        else if (strchr(token, '='))
+        {
+            print_and_log_message("Unknown bench option [ %s ]\n", token);
+            return 1;
+        }
+        else
+        {
+            if (query_end != query_str)
             {
-                print_and_log_message("\n\nERROR: CMD(%s) PROCESSING FAILED\n\n\n", buffer);
+                query_end = concat_text(query_end, query_str + sizeof(query_str) - 1, delim);
             }
-            break;
+            query_end = concat_text(query_end, query_str + sizeof(query_str) - 1, token);
         }
     }
 
-    return ret;
-}
-
-static void store_cache_callback(void *arg, uint32_t uuid, const void *const cache_data, unsigned int size)
-{
-    FILE *file          = NULL;
-    char  filename[128] = { 0 };
-    snprintf(filename, sizeof(filename), "cache_%x.dat", uuid);
-    (void)arg;
-
-    file = fopen(filename, "wb");
-    if (file)
+    if (get_latency_query_type(query_str, &type))
     {
-        fwrite(cache_data, 1, size, file);
-        fclose(file);
+        print_and_log_message("ERROR parsing cmd [ %s ] - only req commands can be benchmarked\n", data);
+        return 1;
     }
+
+    if (count == 0 || parse_latency_query(query_str, type, &query))
+    {
+        print_and_log_message("ERROR parsing cmd [ %s ] \n", data);
+        return 1;
+    }
+
+    status = dlb_lip_get_status(p_device->p_dlb_lip, true);
+    if (status.status == 0)
+    {
+        print_and_log_message("LIP not supported ignoring cmd!\n");
+        return 0;
+    }
+
+    samples = (unsigned long long *)malloc(count * sizeof(*samples));
+    if (samples == NULL)
+    {
+        print_and_log_message("Couldn't allocate memory for %u samples\n", count);
+        return 1;
+    }
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        unsigned char       audio_latency = 0;
+        unsigned char       video_latency = 0;
+        dlb_cec_bus_stats_t stats_before;
+        dlb_cec_bus_stats_t stats_after;
+        unsigned long long  start_us;
+
+        if (!cache)
+        {
+            // Rediscover downstream device to invalidate latencies cached by dlb_lip
+            dlb_lip_set_config(p_device->p_dlb_lip, NULL, true, DLB_LOGICAL_ADDR_UNKNOWN);
+            wait_for_downstream_device(p_device->p_dlb_lip, 10);
+        }
+
+        dlb_cec_bus_get_stats(p_device->cec_bus, &stats_before);
+        start_us = dlb_lip_tool_time_us();
+        if (execute_latency_query(p_device, &query, cache, 0, &audio_latency, &video_latency))
+        {
+            errors += 1;
+        }
+        samples[i] = dlb_lip_tool_time_us() - start_us;
+        dlb_cec_bus_get_stats(p_device->cec_bus, &stats_after);
+
+        frames += (stats_after.tx_frames - stats_before.tx_frames) + (stats_after.rx_frames - stats_before.rx_frames);
+        sum_us += samples[i];
+    }
+
+    qsort(samples, count, sizeof(*samples), compare_latency_samples);
+
+    {
+        char         result[COMMAND_BUFFER_SIZE * 4];
+        const double ops_per_s        = count * 1000000.0 / (sum_us ? sum_us : 1);
+        const double frames_per_query = (double)frames / count;
+
+        print_and_log_message(
+            "bench [ %s ] count=%u cache=%s errors=%u\n"
+            "\tops/s: %.1f\n"
+            "\tlatency[us]: min=%llu mean=%llu p50=%llu p99=%llu max=%llu\n"
+            "\tbus frames/query: %.2f\n",
+            query_str,
+            count,
+            cache ? "on" : "off",
+            errors,
+            ops_per_s,
+            samples[0],
+            sum_us / count,
+            get_percentile(samples, count, 50),
+            get_percentile(samples, count, 99),
+            samples[count - 1],
+            frames_per_query);
+
+        // Machine readable summary for trend tracking
+        snprintf(
+            result,
+            sizeof(result),
+            "BENCH_RESULT cmd=\"%s\" count=%u cache=%s errors=%u ops_per_s=%.1f min_us=%llu mean_us=%llu p50_us=%llu "
+            "p99_us=%llu max_us=%llu frames_per_query=%.2f\n",
+            query_str,
+            count,
+            cache ? "on" : "off",
+            errors,
+            ops_per_s,
+            samples[0],
+            sum_us / count,
+            get_percentile(samples, count, 50),
+            get_percentile(samples, count, 99),
+            samples[count - 1],
+            frames_per_query);
+        print_and_log_message("%s", result);
+
+        if (out_file_name[0])
+        {
+            FILE *out_file = fopen(out_file_name, "at");
+            if (out_file)
+            {
+                fprintf(out_file, "%s", result);
+                fclose(out_file);
+            }
+            else
+            {
+                print_and_log_message("Failed to open bench output file(%s)\n", out_file_name);
+            }
+        }
+    }
+
+    free(samples);
+
+    return errors ? 1 : 0;
+}
+
+/*!
+Parses comma separated list of names, "*" selects all names.
+
+@return 0 if parsed correctly, 1 if unknown name was found
+*/
+static int parse_name_list(const char *list_str, const char *const *names, unsigned int count, bool *mask)
+{
+    const char *ptr = list_str;
+
+    memset(mask, 0, count * sizeof(bool));
+    if (strcmp(list_str, "*") == 0)
+    {
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            mask[i] = names[i] != NULL;
+        }
+        return 0;
+    }
+
+    while (*ptr)
+    {
+        size_t len   = strcspn(ptr, ",");
+        bool   found = false;
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (names[i] && strlen(names[i]) == len && strncmp(ptr, names[i], len) == 0)
+            {
+                mask[i] = true;
+                found   = true;
+                break;
+            }
+        }
+        if (!found)
+        {
+            return 1;
+        }
+        ptr += len;
+        if (*ptr == ',')
+        {
+            ptr++;
+        }
+    }
+
+    return 0;
+}
+
+static void write_sweep_line(FILE *out_file, const char *line)
+{
+    if (out_file)
+    {
+        fprintf(out_file, "%s\n", line);
+    }
+    else
+    {
+        print_and_log_message("%s\n", line);
+    }
+}
+
+static char *append_sweep_cell(char *dst, char *end, int ret, unsigned char latency)
+{
+    char cell[8];
+
+    if (ret)
+    {
+        snprintf(cell, sizeof(cell), ",E");
+    }
+    else if (latency == LIP_INVALID_LATENCY)
+    {
+        snprintf(cell, sizeof(cell), ",-");
+    }
+    else
+    {
+        snprintf(cell, sizeof(cell), ",%u", latency);
+    }
+    return concat_text(dst, end, cell);
+}
+
+static int process_command_sweep(lip_tool_device_t *p_device, const char data[COMMAND_BUFFER_SIZE])
+{
+    const char          delim[]                       = " ";
+    char                data_tmp[COMMAND_BUFFER_SIZE] = { 0 };
+    char                out_file_name[MAX_PATH]       = { 0 };
+    unsigned int        codec_count        = 0;
+    unsigned int        color_format_count = 0;
+    const char *const * codec_strs         = dlb_lip_vocabulary_names(DLB_LIP_VOCABULARY_CODEC, &codec_count);
+    const char *const * color_format_names = dlb_lip_vocabulary_names(DLB_LIP_VOCABULARY_COLOR_FORMAT, &color_format_count);
+    bool                vic_mask[MAX_VICS];
+    bool                color_mask[LIP_COLOR_FORMAT_COUNT];
+    bool                hdr_mask[HDR_MODES_COUNT];
+    bool                codec_mask[IEC61937_AUDIO_CODECS];
+    bool                subtype_mask[IEC61937_SUBTYPES];
+    bool                ext_mask[MAX_AUDIO_FORMAT_EXTENSIONS];
+    char *              token       = NULL;
+    char *              line        = NULL;
+    size_t              line_size   = 0;
+    FILE *              out_file    = NULL;
+    bool                video_sweep = false;
+    int                 ret         = 0;
+    unsigned int        queries     = 0;
+    unsigned int        errors      = 0;
+    unsigned long long  start_us    = 0;
+    dlb_cec_bus_stats_t stats_before;
+    dlb_cec_bus_stats_t stats_after;
+    dlb_lip_status_t    status;
+
+    parse_index_list("*", 1, MAX_VICS, vic_mask);
+    parse_index_list("*", 0, HDR_MODES_COUNT, hdr_mask);
+    parse_index_list("*", 0, IEC61937_SUBTYPES, subtype_mask);
+    parse_index_list("*", 0, MAX_AUDIO_FORMAT_EXTENSIONS, ext_mask);
+    parse_name_list("*", color_format_names, color_format_count, color_mask);
+    parse_name_list("*", codec_strs, codec_count, codec_mask);
+
+    memcpy(data_tmp, data, COMMAND_BUFFER_SIZE);
+    data_tmp[COMMAND_BUFFER_SIZE - 1] = 0;
+
+    /* drop the 'sweep' part */
+    strtok(data_tmp, delim);
+    token = strtok(NULL, delim);
+    if (token && strcmp(token, "video") == 0)
+    {
+        video_sweep = true;
+    }
+    else if (token == NULL || strcmp(token, "audio") != 0)
+    {
+        ret = 1;
+    }
+
+    while (ret == 0 && (token = strtok(NULL, delim)) != NULL)
+    {
+        if (video_sweep && strncmp(token, "vic=", strlen("vic=")) == 0)
+        {
+            ret = parse_index_list(token + strlen("vic="), 1, MAX_VICS, vic_mask);
+        }
+        else if (video_sweep && strncmp(token, "color=", strlen("color=")) == 0)
+        {
+            ret = parse_name_list(token + strlen("color="), color_format_names, color_format_count, color_mask);
+        }
+        else if (video_sweep && strncmp(token, "hdr=", strlen("hdr=")) == 0)
+        {
+            ret = parse_index_list(token + strlen("hdr="), 0, HDR_MODES_COUNT, hdr_mask);
+        }
+        else if (!video_sweep && strncmp(token, "codec=", strlen("codec=")) == 0)
+        {
+            ret = parse_name_list(token + strlen("codec="), codec_strs, codec_count, codec_mask);
+        }
+        else if (!video_sweep && strncmp(token, "subtype=", strlen("subtype=")) == 0)
+        {
+            ret = parse_index_list(token + strlen("subtype="), 0, IEC61937_SUBTYPES, subtype_mask);
+        }
+        else if (!video_sweep && strncmp(token, "ext=", strlen("ext=")) == 0)
+        {
+            ret = parse_index_list(token + strlen("ext="), 0, MAX_AUDIO_FORMAT_EXTENSIONS, ext_mask);
+        }
+        else if (strncmp(token, "out=", strlen("out=")) == 0)
+        {
+            snprintf(out_file_name, sizeof(out_file_name), "%s", token + strlen("out="));
+        }
+        else
+        {
+            ret = 1;
+        }
+    }
+
+    if (ret)
+    {
+        print_and_log_message("ERROR parsing cmd [ %s ] \n", data);
+        return 1;
+    }
+
+    status = dlb_lip_get_status(p_device->p_dlb_lip, true);
+    if (status.status == 0)
+    {
+        print_and_log_message("LIP not supported ignoring cmd!\n");
+        return 0;
+    }
+
+    if (out_file_name[0])
+    {
+        out_file = fopen(out_file_name, "wt");
+        if (out_file == NULL)
+        {
+            print_and_log_message("Failed to open sweep output file(%s)\n", out_file_name);
+            return 1;
+        }
+    }
+
+    // One column per color format/hdr mode or audio extension, each up to 32 characters wide
+    line_size = (LIP_COLOR_FORMAT_COUNT * HDR_MODES_COUNT + MAX_AUDIO_FORMAT_EXTENSIONS + 1) * 32;
+    line      = (char *)malloc(line_size);
+    if (line == NULL)
+    {
+        if (out_file)
+        {
+            fclose(out_file);
+        }
+        return 1;
+    }
+
+    dlb_cec_bus_get_stats(p_device->cec_bus, &stats_before);
+    start_us = dlb_lip_tool_time_us();
+
+    if (video_sweep)
+    {
+        char *line_end = line;
+
+        memset(line, 0, line_size);
+        line_end = concat_text(line_end, line + line_size - 1, "VIC");
+        for (unsigned int color = 0; color < LIP_COLOR_FORMAT_COUNT; ++color)
+        {
+            for (unsigned int hdr = 0; color_mask[color] && hdr < get_hdr_mode_count((dlb_lip_color_format_type_t)color); ++hdr)
+            {
+                if (hdr_mask[hdr])
+                {
+                    line_end = concat_text(line_end, line + line_size - 1, ",");
+                    line_end = concat_text(line_end, line + line_size - 1, color_format_names[color]);
+                    line_end = concat_text(line_end, line + line_size - 1, "/");
+                    line_end = concat_text(
+                        line_end, line + line_size - 1, get_hdr_mode_str((dlb_lip_color_format_type_t)color, hdr));
+                }
+            }
+        }
+        write_sweep_line(out_file, line);
+
+        for (unsigned int vic = 1; vic < MAX_VICS; ++vic)
+        {
+            char vic_str[16];
+
+            if (!vic_mask[vic])
+            {
+                continue;
+            }
+            memset(line, 0, line_size);
+            line_end = concat_text(line, line + line_size - 1, t_itoa(vic_str, (int)vic));
+
+            for (unsigned int color = 0; color < LIP_COLOR_FORMAT_COUNT; ++color)
+            {
+                for (unsigned int hdr = 0; color_mask[color] && hdr < get_hdr_mode_count((dlb_lip_color_format_type_t)color);
+                     ++hdr)
+                {
+                    if (hdr_mask[hdr])
+                    {
+                        lip_query_t   query         = { 0 };
+                        unsigned char video_latency = LIP_INVALID_LATENCY;
+                        int           query_ret     = 0;
+
+                        query.type = LIP_QUERY_VIDEO;
+                        set_video_format(&query.video_format, (uint8_t)vic, (dlb_lip_color_format_type_t)color, hdr);
+                        query_ret = execute_latency_query(p_device, &query, true, 0, NULL, &video_latency);
+                        errors += query_ret ? 1 : 0;
+                        queries += 1;
+                        line_end = append_sweep_cell(line_end, line + line_size - 1, query_ret, video_latency);
+                    }
+                }
+            }
+            write_sweep_line(out_file, line);
+        }
+    }
+    else
+    {
+        char *line_end = line;
+
+        memset(line, 0, line_size);
+        line_end = concat_text(line_end, line + line_size - 1, "FORMAT");
+        for (unsigned int ext = 0; ext < MAX_AUDIO_FORMAT_EXTENSIONS; ++ext)
+        {
+            char ext_str[16];
+
+            if (ext_mask[ext])
+            {
+                line_end = concat_text(line_end, line + line_size - 1, ",ext");
+                line_end = concat_text(line_end, line + line_size - 1, t_itoa(ext_str, (int)ext));
+            }
+        }
+        write_sweep_line(out_file, line);
+
+        for (unsigned int codec = 0; codec < IEC61937_AUDIO_CODECS; ++codec)
+        {
+            for (unsigned int subtype = 0; codec_mask[codec] && subtype < IEC61937_SUBTYPES; ++subtype)
+            {
+                char subtype_str[16];
+
+                if (!subtype_mask[subtype])
+                {
+                    continue;
+                }
+                memset(line, 0, line_size);
+                line_end = concat_text(line, line + line_size - 1, codec_strs[codec]);
+                line_end = concat_text(line_end, line + line_size - 1, "/");
+                line_end = concat_text(line_end, line + line_size - 1, t_itoa(subtype_str, (int)subtype));
+
+                for (unsigned int ext = 0; ext < MAX_AUDIO_FORMAT_EXTENSIONS; ++ext)
+                {
+                    if (ext_mask[ext])
+                    {
+                        lip_query_t   query         = { 0 };
+                        unsigned char audio_latency = LIP_INVALID_LATENCY;
+                        int           query_ret     = 0;
+
+                        query.type                 = LIP_QUERY_AUDIO;
+                        query.audio_format.codec   = (dlb_lip_audio_codec_t)codec;
+                        query.audio_format.subtype = (dlb_lip_audio_formats_subtypes_t)subtype;
+                        query.audio_format.ext     = (uint8_t)ext;
+                        query_ret                  = execute_latency_query(p_device, &query, true, 0, &audio_latency, NULL);
+                        errors += query_ret ? 1 : 0;
+                        queries += 1;
+                        line_end = append_sweep_cell(line_end, line + line_size - 1, query_ret, audio_latency);
+                    }
+                }
+                write_sweep_line(out_file, line);
+            }
+        }
+    }
+
+    dlb_cec_bus_get_stats(p_device->cec_bus, &stats_after);
+    print_and_log_message(
+        "sweep %s: %u queries, %u errors, %lu bus frames, %llu ms wall time\n",
+        video_sweep ? "video" : "audio",
+        queries,
+        errors,
+        (stats_after.tx_frames - stats_before.tx_frames) + (stats_after.rx_frames - stats_before.rx_frames),
+        (dlb_lip_tool_time_us() - start_us) / 1000ULL);
+
+    free(line);
+    if (out_file)
+    {
+        fclose(out_file);
+    }
+
+    return 0;
+}
+
+static void release_sync_barrier(void)
+{
+    sync_barrier.arrived = 0;
+    sync_barrier.generation += 1;
+    dlb_lip_tool_cond_broadcast(&sync_barrier.cond);
+}
+
+/*!
+Removes device from the sync barrier once its command script is finished,
+devices waiting in the barrier are released if the device was the last one missing.
+
+@param p_device - device leaving the barrier
+
+@return void
+*/
+static void leave_sync_barrier(lip_tool_device_t *p_device)
+{
+    dlb_lip_tool_mutex_lock(&sync_barrier.mutex);
+    if (p_device->in_barrier)
+    {
+        p_device->in_barrier = false;
+        sync_barrier.participants -= 1;
+        if (sync_barrier.arrived > 0 && sync_barrier.arrived >= sync_barrier.participants)
+        {
+            release_sync_barrier();
+        }
+    }
+    dlb_lip_tool_mutex_unlock(&sync_barrier.mutex);
+}
+
+static int process_command_cache(lip_tool_device_t *p_device, const char data[COMMAND_BUFFER_SIZE])
+{
+    char operation[16]                  = { 0 };
+    char file_name[COMMAND_BUFFER_SIZE] = { 0 };
+    int  count                          = -1;
+
+    (void)p_device;
+    if (sscanf(data, "%*s %15s %127s\n", operation, file_name) != 2)
+    {
+        print_and_log_message("ERROR parsing cmd [ %s ]\n", data);
+        return 1;
+    }
+
+    if (strcmp(operation, "export") == 0)
+    {
+        count = dlb_lip_cache_export(file_name);
+        if (count >= 0)
+        {
+            print_and_log_message("Exported %d UUIDs to cache archive %s\n", count, file_name);
+        }
+    }
+    else if (strcmp(operation, "import") == 0)
+    {
+        count = dlb_lip_cache_import(file_name);
+        if (count >= 0)
+        {
+            print_and_log_message("Imported %d UUIDs from cache archive %s\n", count, file_name);
+        }
+    }
+    else
+    {
+        print_and_log_message("ERROR parsing cmd [ %s ] - unknown cache operation %s\n", data, operation);
+    }
+
+    return count < 0;
+}
+
+static int process_command_sync(lip_tool_device_t *p_device, const char data[COMMAND_BUFFER_SIZE])
+{
+    char          label[COMMAND_BUFFER_SIZE] = { 0 };
+    unsigned long generation                 = 0;
+
+    if (sscanf(data, "%*s %127s\n", label) != 1)
+    {
+        print_and_log_message("ERROR parsing cmd [ %s ]\n", data);
+        return 1;
+    }
+
+    dlb_lip_tool_mutex_lock(&sync_barrier.mutex);
+    if (!p_device->in_barrier)
+    {
+        dlb_lip_tool_mutex_unlock(&sync_barrier.mutex);
+        print_and_log_message("Device %u is not running command script, sync %s ignored\n", p_device->index, label);
+        return 0;
+    }
+
+    if (sync_barrier.arrived > 0 && strcmp(sync_barrier.label, label) != 0)
+    {
+        dlb_lip_tool_mutex_unlock(&sync_barrier.mutex);
+        print_and_log_message(
+            "ERROR: device %u reached sync %s while other devices wait in sync %s\n", p_device->index, label, sync_barrier.label);
+        return 1;
+    }
+
+    if (sync_barrier.arrived == 0)
+    {
+        snprintf(sync_barrier.label, sizeof(sync_barrier.label), "%s", label);
+    }
+    sync_barrier.arrived += 1;
+
+    if (sync_barrier.arrived >= sync_barrier.participants)
+    {
+        release_sync_barrier();
+        dlb_lip_tool_mutex_unlock(&sync_barrier.mutex);
+    }
+    else
+    {
+        // Commands are executed with command_mutex locked, control socket clients, prefetch and config reload of
+        // the device must not wait for the other devices. It is locked again after the barrier mutex is released,
+        // as it is always locked first.
+        dlb_lip_tool_mutex_unlock(&p_device->command_mutex);
+        generation = sync_barrier.generation;
+        while (generation == sync_barrier.generation)
+        {
+            dlb_lip_tool_cond_wait(&sync_barrier.cond, &sync_barrier.mutex);
+        }
+        dlb_lip_tool_mutex_unlock(&sync_barrier.mutex);
+        dlb_lip_tool_mutex_lock(&p_device->command_mutex);
+    }
+
+    print_and_log_message("Device %u passed sync %s\n", p_device->index, label);
+
+    return 0;
+}
+
+struct commands_handlers
+{
+    char *command;
+    int (*func)(lip_tool_device_t *p_device, const char data[COMMAND_BUFFER_SIZE]);
+} commands_list[] = {
+    { "tx", process_command_tx },
+    { "q", process_command_quit },
+    { "wait_time", process_command_wait_time },
+    { "wait", process_command_wait },
+    { "req audio_latency", process_command_req_audio_latency },
+    { "req video_latency", process_command_req_video_latency },
+    { "req av_latency", process_command_req_av_latency },
+    { "update audio_latency", process_command_update_audio_latency },
+    { "update video_latency", process_command_update_video_latency },
+    { "update av_latency", process_command_update_av_latency },
+    { "update uuid", process_command_update_uuid },
+    { "on update uuid", process_command_on_update_uuid },
+    { "random", process_command_random },
+    { "bench", process_command_bench },
+    { "sweep", process_command_sweep },
+    { "sync", process_command_sync },
+    { "cache", process_command_cache },
+};
+
+static int process_console_command(lip_tool_device_t *p_device, const char buffer[COMMAND_BUFFER_SIZE])
+{
+    int ret = 1;
+
+    for (unsigned int i = 0; i < ARRAY_SIZE(commands_list); ++i)
+    {
+        if (strncmp(buffer, commands_list[i].command, strlen(commands_list[i].command)) == 0)
+        {
+            ret = !commands_list[i].func(p_device, buffer);
+            if (process_command_quit != commands_list[i].func && !ret)
+            {
+                print_and_log_message("\n\nERROR: CMD(%s) PROCESSING FAILED\n\n\n", buffer);
+            }
+            break;
+        }
+    }
+
+    return ret;
+}
+
+static dlb_lip_control_status_t execute_control_command(void *arg, const char *command, char *output, size_t output_size)
+{
+    lip_tool_device_t *      p_device                    = (lip_tool_device_t *)arg;
+    char                     buffer[COMMAND_BUFFER_SIZE] = { 0 };
+    dlb_lip_control_status_t status                      = DLB_LIP_CONTROL_UNKNOWN;
+
+    snprintf(buffer, sizeof(buffer), "%s", command);
+
+    dlb_lip_tool_mutex_lock(&p_device->command_mutex);
+    captured_output      = output;
+    captured_output_size = output_size;
+    captured_output_len  = 0;
+    output[0]            = '\0';
+
+    for (unsigned int i = 0; i < ARRAY_SIZE(commands_list); ++i)
+    {
+        if (strncmp(buffer, commands_list[i].command, strlen(commands_list[i].command)) == 0)
+        {
+            if (process_command_quit == commands_list[i].func)
+            {
+                status = DLB_LIP_CONTROL_QUIT;
+            }
+            else
+            {
+                status = commands_list[i].func(p_device, buffer) ? DLB_LIP_CONTROL_ERROR : DLB_LIP_CONTROL_OK;
+            }
+            break;
+        }
+    }
+
+    captured_output = NULL;
+    dlb_lip_tool_mutex_unlock(&p_device->command_mutex);
+
+    return status;
+}
+
+static void store_cache_callback(void *arg, uint32_t uuid, const void *const cache_data, unsigned int size)
+{
+    (void)arg;
+    dlb_lip_cache_store(uuid, cache_data, size);
+}
+
+static unsigned int read_cache_callback(void *arg, uint32_t uuid, void *const cache_data, unsigned int size)
+{
+    (void)arg;
+    return dlb_lip_cache_read(uuid, cache_data, size);
+}
+
+static uint32_t merge_uuid_callback(void *arg, uint32_t own_uuid, uint32_t ds_uuid)
+{
+    const uint8_t uuid_a[LIP_UUID_SIZE]          = { (own_uuid >> 24) & 0xFF, (own_uuid >> 16) & 0xFF };
+    const uint8_t uuid_b[LIP_UUID_SIZE]          = { (ds_uuid >> 24) & 0xFF, (ds_uuid >> 16) & 0xFF };
+    uint32_t      merged_uuid                    = 0;
+    uint8_t       merged_uuid_arr[LIP_UUID_SIZE] = { 0 };
+    // We are HUB - copy correct a/v rendering mode bits
+    uint16_t rendering_mode = (own_uuid & 0xF0F0) | (ds_uuid & 0x0F0F);
+    (void)arg;
+
+    for (uint32_t i = 0; i < LIP_UUID_SIZE; ++i)
+    {
+        merged_uuid_arr[i] = uuid_a[i] ^ uuid_b[(i + 1) % LIP_UUID_SIZE];
+    }
+
+    merged_uuid = (uint32_t)merged_uuid_arr[0] << 24 | merged_uuid_arr[1] << 16 | rendering_mode;
+
+    return merged_uuid;
+}
+
+static void status_change(void *arg, dlb_lip_status_t status)
+{
+    lip_tool_device_t *p_device = (lip_tool_device_t *)arg;
+    const bool         new_downstream
+        = (status.status & LIP_DOWNSTREAM_CONNECTED)
+          && (!p_device->uuid_valid || p_device->downstream_uuid != status.downstream_device_uuid);
+
+    if (status.status & LIP_DOWNSTREAM_CONNECTED)
+    {
+        if (p_device->uuid_valid && p_device->downstream_uuid != status.downstream_device_uuid)
+        {
+            print_and_log_message(
+                "Downstream device[%x] uuid change %x -> %x \n",
+                status.downstream_device_addr,
+                p_device->downstream_uuid,
+                status.downstream_device_uuid);
+            dlb_lip_osa_cancel_timer(&p_device->on_update_uuid_timer);
+            dlb_lip_osa_set_timer(&p_device->on_update_uuid_timer, 1U);
+        }
+        print_and_log_message("Downstream device with addr 0x%x connected\n", status.downstream_device_addr);
+        p_device->uuid_valid      = true;
+        p_device->downstream_uuid = status.downstream_device_uuid;
+    }
+    else
+    {
+        p_device->uuid_valid = false;
+    }
+    dlb_lip_query_cache_set_downstream(&p_device->query_cache, p_device->uuid_valid, status.downstream_device_uuid);
+    if (new_downstream)
+    {
+        // Queries are issued by the prefetch thread, never from the dlb_lip callback
+        dlb_lip_prefetch_trigger(&p_device->prefetch);
+    }
+    if (status.status & LIP_UPSTREAM_CONNECTED)
+    {
+        print_and_log_message("Upstream device connected\n");
+    }
+}
+
+static char *read_command_line(void *p_context, char *line, int size)
+{
+    FILE *commands_file = *(FILE **)p_context;
+    return fgets(line, size, commands_file ? commands_file : stdin);
+}
+
+static int uuid_timer_callback(void *arg, uint32_t callback_id)
+{
+    lip_tool_device_t *p_device = (lip_tool_device_t *)arg;
+    (void)callback_id;
+
+    if (p_device->on_update_uuid_av_formats_valid)
+    {
+        uint8_t video_latency = 0;
+        uint8_t audio_latency = 0;
+
+        print_and_log_message("Calling dlb_lip_get_av_latency triggered by UUID update\n");
+        dlb_lip_get_av_latency(
+            p_device->p_dlb_lip,
+            p_device->on_update_uuid_v_format,
+            p_device->on_update_uuid_a_format,
+            &video_latency,
+            &audio_latency);
+    }
+    return 0;
+}
+
+static unsigned long prefetch_bus_frames(void *arg)
+{
+    lip_tool_device_t * p_device = (lip_tool_device_t *)arg;
+    dlb_cec_bus_stats_t stats;
+
+    dlb_cec_bus_get_stats(p_device->cec_bus, &stats);
+    return stats.tx_frames + stats.rx_frames;
+}
+
+/*!
+Issues prefetched query like a req command would, results end up in dlb_lip cache and query cache of the device.
+
+@return 0 on success, 1 if the query failed or downstream device isn't connected
+*/
+static int prefetch_query(void *arg, uint64_t format)
+{
+    lip_tool_device_t *p_device      = (lip_tool_device_t *)arg;
+    lip_query_t        query         = { 0 };
+    unsigned char      audio_latency = 0;
+    unsigned char      video_latency = 0;
+    int                ret           = 1;
+
+    unpack_latency_query(format, &query);
+
+    // Commands and prefetch are serialized, so a command never waits for more than one prefetched query
+    dlb_lip_tool_mutex_lock(&p_device->command_mutex);
+    ret = execute_latency_query(p_device, &query, true, LIP_DOWNSTREAM_CONNECTED, &audio_latency, &video_latency);
+    dlb_lip_tool_mutex_unlock(&p_device->command_mutex);
+
+    return ret;
+}
+
+static void prefetch_done(void *arg, unsigned int succeeded, unsigned int count)
+{
+    lip_tool_device_t *p_device = (lip_tool_device_t *)arg;
+
+    print_and_log_message("Device %u prefetched %u of %u formats\n", p_device->index, succeeded, count);
+}
+
+/*!
+Reads req commands of the --prefetch file.
+
+@return 0 on success, 1 on error
+*/
+static int load_prefetch_formats(const char *file_name)
+{
+    FILE *       file = fopen(file_name, "r");
+    char         line[COMMAND_BUFFER_SIZE];
+    unsigned int line_no = 0;
+    int          ret     = 0;
+
+    if (file == NULL)
+    {
+        print_and_log_message("Couldn't open prefetch file[%s]!\n", file_name);
+        return 1;
+    }
+
+    while (ret == 0 && fgets(line, sizeof(line), file))
+    {
+        lip_query_type_t type  = LIP_QUERY_AUDIO;
+        lip_query_t      query = { 0 };
+
+        line_no += 1;
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#')
+        {
+            continue;
+        }
+
+        if (get_latency_query_type(line, &type) || parse_latency_query(line, type, &query))
+        {
+            print_and_log_message("ERROR parsing prefetch file[%s] line %u [ %s ]\n", file_name, line_no, line);
+            ret = 1;
+        }
+        else if (prefetch_format_count == DLB_LIP_PREFETCH_MAX_FORMATS)
+        {
+            print_and_log_message("Prefetch file[%s] has more than %u formats!\n", file_name, DLB_LIP_PREFETCH_MAX_FORMATS);
+            ret = 1;
+        }
+        else
+        {
+            prefetch_formats[prefetch_format_count++] = pack_latency_query(&query);
+        }
+    }
+    fclose(file);
+
+    return ret;
+}
+
+/*!
+Loads config of the device. Compiled config <file>.lipc is used if it is valid and not older than the XML file,
+otherwise the XML file is parsed.
+
+@param p_parser         - parser to load the config into
+@param config_file_name - XML config file of the device
+@param use_compiled     - false to always parse the XML file
+
+@return 0 on success, 1 on error
+*/
+static int load_device_config(dlb_lip_xml_parser_t *const p_parser, const char *config_file_name, const bool use_compiled)
+{
+    char compiled_file_name[MAX_PATH + sizeof(DLB_LIP_COMPILED_CONFIG_SUFFIX)];
+
+    snprintf(compiled_file_name, sizeof(compiled_file_name), "%s" DLB_LIP_COMPILED_CONFIG_SUFFIX, config_file_name);
+    // Overwrites are checked only when the XML file is parsed
+    if (use_compiled && !strict_config
+        && dlb_lip_compiled_config_load(compiled_file_name, config_file_name, p_parser, LIP_LIBRARY_VERSION) == 0)
+    {
+        print_and_log_message("Loaded compiled config[%s]\n", compiled_file_name);
+        return 0;
+    }
+
+    dlb_lip_xml_parser_init(p_parser);
+    p_parser->diagnostics.fail_on_overwrite = strict_config;
+    if (parse_xml_config_file(p_parser, config_file_name) != 0)
+    {
+        return 1;
+    }
+    dlb_lip_xml_parser_expand_latencies(p_parser);
+
+    return 0;
+}
+
+/*!
+Parses XML files and directories of --validate without opening any device and prints result of every file.
+
+@return 0 if all files are valid, 1 otherwise
+*/
+static int validate_configs(const cmdline_options *const opt)
+{
+    dlb_lip_validate_result_t *p_results      = NULL;
+    unsigned int               result_count   = 0;
+    unsigned int               invalid_count  = 0;
+    unsigned int               conflict_count = 0;
+    const unsigned long long   start_us       = dlb_lip_tool_time_us();
+
+    if (dlb_lip_validate_configs(
+            opt->validate_paths, opt->validate_count, opt->validate_threads, strict_config, &p_results, &result_count))
+    {
+        return 1;
+    }
+
+    for (unsigned int i = 0; i < result_count; ++i)
+    {
+        const dlb_lip_validate_result_t *const p_result = &p_results[i];
+
+        if (p_result->valid)
+        {
+            print_and_log_message(
+                "OK      %s devices %u fingerprint %016llx overwrites %u elements %u cells\n",
+                p_result->path,
+                p_result->devices,
+                (unsigned long long)p_result->fingerprint,
+                p_result->overwrite_elements,
+                p_result->overwritten_cells);
+        }
+        else
+        {
+            print_and_log_message("INVALID %s\n", p_result->path);
+            invalid_count += 1;
+        }
+        if (p_result->overwrite_elements > 0)
+        {
+            print_and_log_message("        %s\n", p_result->first_overwrite);
+            conflict_count += 1;
+        }
+    }
+    print_and_log_message(
+        "Validated %u files in %llu ms: %u invalid, %u with overwrites\n",
+        result_count,
+        (dlb_lip_tool_time_us() - start_us) / 1000ULL,
+        invalid_count,
+        conflict_count);
+    dlb_lip_validate_free(p_results, result_count);
+
+    return invalid_count > 0;
+}
+
+/*!
+Parses the topology file and adds its devices to the command line options, configs of the devices are kept
+in the parsed topology and copied by open_device.
+
+@return 0 on success, 1 on error
+*/
+static int load_topology(cmdline_options *const opt)
+{
+    topology.fail_on_overwrite = strict_config;
+    if (parse_xml_topology_file(&topology, opt->topology_file_name) != 0)
+    {
+        print_and_log_message("XML topology parsing ERROR[%s]!\n", opt->topology_file_name);
+        dlb_lip_xml_topology_destroy(&topology);
+        return 1;
+    }
+    if (topology.device_count > LIP_TOOL_MAX_DEVICES)
+    {
+        print_and_log_message("Too many devices in topology, at most %u are supported\n", LIP_TOOL_MAX_DEVICES);
+        dlb_lip_xml_topology_destroy(&topology);
+        return 1;
+    }
+
+    for (unsigned int i = 0; i < topology.device_count; ++i)
+    {
+        const dlb_lip_xml_topology_device_t *const p_device  = &topology.devices[i];
+        lip_tool_device_options_t *const           p_options = &opt->devices[i];
+
+        snprintf(p_options->config_file_name, sizeof(p_options->config_file_name), "%s", opt->topology_file_name);
+        snprintf(p_options->commands_file_name, sizeof(p_options->commands_file_name), "%s", p_device->commands_file_name);
+        snprintf(p_options->port_name, sizeof(p_options->port_name), "%s", p_device->port_name);
+        snprintf(p_options->state_file_name, sizeof(p_options->state_file_name), "%s", p_device->state_file_name);
+        p_options->sim_arc           = p_device->sim_arc;
+        p_options->p_topology_config = &p_device->parser;
+        print_and_log_message("Device %u: %s from topology[%s]\n", i, p_device->name, opt->topology_file_name);
+    }
+    opt->device_count = topology.device_count;
+
+    return 0;
+}
+
+/*!
+Parses XML configs of all devices and writes them to compiled configs <file>.lipc, loaded by following starts.
+
+@return 0 on success, 1 on error
+*/
+static int compile_device_configs(const cmdline_options *const opt)
+{
+    static dlb_lip_xml_parser_t parser;
+    int                         ret = 0;
+
+    for (unsigned int i = 0; i < opt->device_count; ++i)
+    {
+        const char *const config_file_name = opt->devices[i].config_file_name;
+        char              compiled_file_name[MAX_PATH + sizeof(DLB_LIP_COMPILED_CONFIG_SUFFIX)];
+
+        snprintf(compiled_file_name, sizeof(compiled_file_name), "%s" DLB_LIP_COMPILED_CONFIG_SUFFIX, config_file_name);
+        memset(&parser, 0, sizeof(parser));
+        if (load_device_config(&parser, config_file_name, false))
+        {
+            print_and_log_message("XML parsing ERROR[%s]!\n", config_file_name);
+            ret = 1;
+        }
+        else if (dlb_lip_compiled_config_write(compiled_file_name, &parser, LIP_LIBRARY_VERSION) == 0)
+        {
+            print_and_log_message("Compiled %s to %s\n", config_file_name, compiled_file_name);
+        }
+        else
+        {
+            ret = 1;
+        }
+        dlb_lip_xml_parser_destroy(&parser);
+    }
+
+    return ret;
+}
+
+/*!
+Copies cells of the src latency array which differ from dst.
+
+@return number of changed cells
+*/
+static unsigned int patch_latency_cells(uint8_t *dst, const uint8_t *src, size_t size)
+{
+    unsigned int changed = 0;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (dst[i] != src[i])
+        {
+            dst[i] = src[i];
+            changed += 1;
+        }
+    }
+
+    return changed;
+}
+
+/*!
+Exchanges the latency tables with their rules, nothing is allocated.
+*/
+static void swap_latency_tables(dlb_lip_latency_table_t *p_a, dlb_lip_latency_table_t *p_b)
+{
+    const dlb_lip_latency_table_t table = *p_a;
+
+    *p_a = *p_b;
+    *p_b = table;
 }
 
-static unsigned int read_cache_callback(void *arg, uint32_t uuid, void *const cache_data, unsigned int size)
-{
-    FILE *       file          = NULL;
-    char         filename[128] = { 0 };
-    unsigned int data_read     = 0;
-    (void)arg;
-    snprintf(filename, sizeof(filename), "cache_%x.dat", uuid);
+/*!
+Applies config parsed from the changed XML file to the running device. Only latency tables which differ(by fingerprint)
+are patched and only differing cells are changed, UUID rendering modes are bumped like by update commands unless
+the file changed the UUID itself. Nothing is passed to dlb_lip if the result equals the config passed last time.
+The device takes the latency tables of the new config, its old tables are left to the new config.
+Must be called with command_mutex of the device locked.
+
+@return 0 on success, 1 on error
+*/
+static int apply_device_config(lip_tool_device_t *p_device, dlb_lip_xml_parser_t *p_new)
+{
+    dlb_lip_config_params_t *const       p_config     = &p_device->xml_parser.config_params;
+    const dlb_lip_config_params_t *const p_new_config = &p_new->config_params;
+    dlb_lip_config_fingerprint_t *const  p_live       = &p_device->live_fingerprint;
+    const bool                           uuid_changed = p_new_config->uuid != p_device->config_uuid;
+    dlb_lip_config_fingerprint_t         new_fingerprint;
+    unsigned int                         table_changes = 0;
+    unsigned int                         audio_changes = 0;
+    unsigned int                         video_changes = 0;
+
+    if (p_new->physical_address != p_device->xml_parser.physical_address || p_new->device_type != p_device->xml_parser.device_type)
+    {
+        print_and_log_message("Device %u: PhysicalAddress and DeviceType changes need restart, ignored\n", p_device->index);
+    }
+
+    dlb_lip_config_fingerprint_init(&new_fingerprint, p_new_config);
+    table_changes = dlb_lip_config_fingerprint_compare(&new_fingerprint, p_live);
+    if (table_changes & DLB_LIP_CONFIG_AUDIO_CHANGED)
+    {
+        audio_changes = patch_latency_cells(
+            &p_config->audio_latencies[0][0][0], &p_new_config->audio_latencies[0][0][0], sizeof(p_config->audio_latencies));
+        p_live->audio = new_fingerprint.audio;
+    }
+    if (table_changes & DLB_LIP_CONFIG_VIDEO_CHANGED)
+    {
+        video_changes = patch_latency_cells(
+            &p_config->video_latencies[0][0][0], &p_new_config->video_latencies[0][0][0], sizeof(p_config->video_latencies));
+        p_live->video = new_fingerprint.video;
+    }
+    swap_latency_tables(&p_device->xml_parser.audio_latencies, &p_new->audio_latencies);
+    swap_latency_tables(&p_device->xml_parser.video_latencies, &p_new->video_latencies);
+
+    p_config->downstream_device_addr   = p_new_config->downstream_device_addr;
+    p_config->audio_transcoding        = p_new_config->audio_transcoding;
+    p_config->audio_transcoding_format = p_new_config->audio_transcoding_format;
+    p_config->render_mode              = p_new_config->render_mode;
+    if (uuid_changed)
+    {
+        p_config->uuid        = p_new_config->uuid;
+        p_device->config_uuid = p_new_config->uuid;
+    }
+    dlb_lip_config_fingerprint_update_params(p_live, p_config);
+
+    if (get_device_config_changes(p_device) == 0)
+    {
+        print_and_log_message("Device %u: config reloaded, no changes\n", p_device->index);
+        return 0;
+    }
 
-    file = fopen(filename, "rb");
-    if (file)
+    if (push_device_config(p_device, !uuid_changed) != 0)
     {
-        data_read = fread(cache_data, 1, size, file);
-        fclose(file);
+        return 1;
     }
+    print_and_log_message(
+        "Device %u: config reloaded, %u audio and %u video latencies changed, UUID 0x%08x\n",
+        p_device->index,
+        audio_changes,
+        video_changes,
+        p_config->uuid);
 
-    return data_read;
+    return 0;
 }
 
-static uint32_t merge_uuid_callback(void *arg, uint32_t own_uuid, uint32_t ds_uuid)
+/*!
+Adds base and included files of the device config to the config watch, so their changes reload the config.
+*/
+static void watch_config_dependencies(unsigned int index, const dlb_lip_xml_parser_t *p_parser)
 {
-    const uint8_t uuid_a[LIP_UUID_SIZE]          = { (own_uuid >> 24) & 0xFF, (own_uuid >> 16) & 0xFF };
-    const uint8_t uuid_b[LIP_UUID_SIZE]          = { (ds_uuid >> 24) & 0xFF, (ds_uuid >> 16) & 0xFF };
-    uint32_t      merged_uuid                    = 0;
-    uint8_t       merged_uuid_arr[LIP_UUID_SIZE] = { 0 };
-    // We are HUB - copy correct a/v rendering mode bits
-    uint16_t rendering_mode = (own_uuid & 0xF0F0) | (ds_uuid & 0x0F0F);
+    for (unsigned int i = 0; i < p_parser->dependency_count; ++i)
+    {
+        if (dlb_lip_config_watch_add(p_parser->dependencies[i].path, index))
+        {
+            print_and_log_message("Device %u: changes of %s are not watched\n", index, p_parser->dependencies[i].path);
+        }
+    }
+}
+
+/*!
+Called by the config watch when XML file of the device or any of its base and included files changed. The file is
+parsed without holding the device, the running config is kept if the file has errors. Files newly included by the
+file are added to the watch.
+
+@return void
+*/
+static void config_file_changed(void *arg, unsigned int index)
+{
+    lip_tool_device_t *const    p_device = &devices[index];
+    dlb_lip_xml_parser_t *const p_parser = (dlb_lip_xml_parser_t *)calloc(1, sizeof(dlb_lip_xml_parser_t));
+
     (void)arg;
+    if (p_parser == NULL)
+    {
+        return;
+    }
 
-    for (uint32_t i = 0; i < LIP_UUID_SIZE; ++i)
+    if (load_device_config(p_parser, p_device->p_options->config_file_name, false))
     {
-        merged_uuid_arr[i] = uuid_a[i] ^ uuid_b[(i + 1) % LIP_UUID_SIZE];
+        print_and_log_message(
+            "Device %u: XML parsing ERROR[%s], running config kept\n", p_device->index, p_device->p_options->config_file_name);
+    }
+    else
+    {
+        watch_config_dependencies(index, p_parser);
+        dlb_lip_tool_mutex_lock(&p_device->command_mutex);
+        if (apply_device_config(p_device, p_parser))
+        {
+            print_and_log_message("Device %u: dlb_lip_set_config failed on config reload\n", p_device->index);
+        }
+        dlb_lip_tool_mutex_unlock(&p_device->command_mutex);
     }
+    dlb_lip_xml_parser_destroy(p_parser);
+    free(p_parser);
+}
 
-    merged_uuid = (uint32_t)merged_uuid_arr[0] << 24 | merged_uuid_arr[1] << 16 | rendering_mode;
+/*!
+Parses XML config of the device, opens its command file, CEC bus connection and LIP instance.
 
-    return merged_uuid;
-}
+@param p_device         - device to open
+@param index            - index of the device on the command line
+@param opt              - command line options, options of the device are opt->devices[index]
 
-static void status_change(void *arg, dlb_lip_status_t status)
+@return 0 on success, 1 on error
+*/
+static int open_device(lip_tool_device_t *const p_device, const unsigned int index, const cmdline_options *const opt)
 {
-    (void)arg;
-    if (status.status & LIP_DOWNSTREAM_CONNECTED)
+    const lip_tool_device_options_t *const p_options          = &opt->devices[index];
+    const dlb_lip_prefetch_callbacks_t     prefetch_callbacks = { p_device, prefetch_bus_frames, prefetch_query, prefetch_done };
+    dlb_lip_callbacks_t                    dlb_lip_callbacks  = { 0 };
+
+    memset(p_device, 0, sizeof(lip_tool_device_t));
+    p_device->index        = index;
+    p_device->p_options    = p_options;
+    p_device->wait_time_ms = 1000; // Default wait time between commands
+
+    update_lip_tool_state(p_device, LIP_TOOL_INIT);
+
+    if (p_options->p_topology_config != NULL)
     {
-        if (uuid_valid && downstream_uuid != status.downstream_device_uuid)
+        if (dlb_lip_xml_parser_copy(&p_device->xml_parser, p_options->p_topology_config))
         {
-            print_and_log_message(
-                "Downstream device[%x] uuid change %x -> %x \n",
-                status.downstream_device_addr,
-                downstream_uuid,
-                status.downstream_device_uuid);
-            dlb_lip_osa_cancel_timer(&on_update_uuid_timer);
-            dlb_lip_osa_set_timer(&on_update_uuid_timer, 1U);
+            print_and_log_message("Out of memory for config of the device!\n");
+            return 1;
         }
-        print_and_log_message("Downstream device with addr 0x%x connected\n", status.downstream_device_addr);
-        uuid_valid      = true;
-        downstream_uuid = status.downstream_device_uuid;
     }
-    else
+    else if (0 != load_device_config(&p_device->xml_parser, p_options->config_file_name, opt->use_compiled_config))
     {
-        uuid_valid = false;
+        print_and_log_message("XML parsing ERROR!\n");
+        dlb_lip_xml_parser_destroy(&p_device->xml_parser);
+        return 1;
     }
-    if (status.status & LIP_UPSTREAM_CONNECTED)
+    p_device->config_uuid = p_device->xml_parser.config_params.uuid;
+    dlb_lip_config_fingerprint_init(&p_device->live_fingerprint, &p_device->xml_parser.config_params);
+
+    if (p_options->commands_file_name[0] != '\0')
     {
-        print_and_log_message("Upstream device connected\n");
+        p_device->commands_file = fopen(p_options->commands_file_name, "r");
+        if (p_device->commands_file == NULL)
+        {
+            print_and_log_message("Couldn't open commands file[%s]!\n", p_options->commands_file_name);
+            dlb_lip_xml_parser_destroy(&p_device->xml_parser);
+            return 1;
+        }
+    }
+
+    p_device->p_mem   = (unsigned char *)malloc(dlb_lip_query_memory());
+    p_device->cec_bus = dlb_cec_bus_init(
+        p_device->xml_parser.physical_address,
+        p_options->port_name,
+        p_device->xml_parser.device_type,
+        log_messages,
+        NULL,
+        p_options->sim_arc);
+    if (p_device->cec_bus == NULL)
+    {
+        free(p_device->p_mem);
+        if (p_device->commands_file)
+        {
+            fclose(p_device->commands_file);
+        }
+        dlb_lip_xml_parser_destroy(&p_device->xml_parser);
+        return 1;
+    }
+
+    dlb_lip_callbacks.arg                    = p_device;
+    dlb_lip_callbacks.printf_callback        = log_messages;
+    dlb_lip_callbacks.store_cache_callback   = opt->cache_enabled ? store_cache_callback : NULL;
+    dlb_lip_callbacks.read_cache_callback    = opt->cache_enabled ? read_cache_callback : NULL;
+    dlb_lip_callbacks.status_change_callback = status_change;
+    dlb_lip_callbacks.merge_uuid_callback    = merge_uuid_callback;
+
+    // status_change() may be called already from dlb_lip_open()
+    dlb_lip_query_cache_init(&p_device->query_cache, opt->negative_ttl_ms);
+    dlb_lip_prefetch_init(
+        &p_device->prefetch, prefetch_formats, prefetch_format_count, opt->prefetch_learned, &prefetch_callbacks);
+
+    p_device->p_dlb_lip = dlb_lip_open(p_device->p_mem, &p_device->xml_parser.config_params, dlb_lip_callbacks, p_device->cec_bus);
+    if (NULL == p_device->p_dlb_lip)
+    {
+        dlb_lip_prefetch_stop(&p_device->prefetch);
+        dlb_lip_query_cache_destroy(&p_device->query_cache);
+        dlb_cec_bus_destroy(p_device->cec_bus);
+        free(p_device->p_mem);
+        if (p_device->commands_file)
+        {
+            fclose(p_device->commands_file);
+        }
+        dlb_lip_xml_parser_destroy(&p_device->xml_parser);
+        return 1;
     }
+    p_device->sent_fingerprint = p_device->live_fingerprint; // dlb_lip_open took the config
+
+    dlb_lip_osa_init_timer(&p_device->on_update_uuid_timer, uuid_timer_callback, p_device);
+    dlb_lip_tool_mutex_init(&p_device->command_mutex);
+    dlb_lip_prefetch_start(&p_device->prefetch);
+
+    return 0;
 }
 
-static int uuid_timer_callback(void *arg, uint32_t callback_id)
+static void close_device(lip_tool_device_t *const p_device)
 {
-    dlb_lip_t *p_dlb_lip = (dlb_lip_t *)arg;
-    (void)callback_id;
+    dlb_lip_prefetch_stop(&p_device->prefetch);
+    dlb_lip_tool_mutex_destroy(&p_device->command_mutex);
+    dlb_lip_osa_delete_timer(&p_device->on_update_uuid_timer);
+    dlb_lip_close(p_device->p_dlb_lip);
+    dlb_lip_query_cache_destroy(&p_device->query_cache);
+    dlb_cec_bus_destroy(p_device->cec_bus);
+    free(p_device->p_mem);
+    dlb_lip_xml_parser_destroy(&p_device->xml_parser);
 
-    if (on_update_uuid_av_formats_valid)
+    if (p_device->commands_file)
     {
-        uint8_t video_latency = 0;
-        uint8_t audio_latency = 0;
-
-        print_and_log_message("Calling dlb_lip_get_av_latency triggered by UUID update\n");
-        dlb_lip_get_av_latency(p_dlb_lip, on_update_uuid_v_format, on_update_uuid_a_format, &video_latency, &audio_latency);
+        fclose(p_device->commands_file);
+        p_device->commands_file = NULL;
     }
-    return 0;
+
+    update_lip_tool_state(p_device, LIP_TOOL_QUIT);
 }
 
-int main(int argc, char **argv)
+/*!
+Executes commands of the device until quit command. Command stream of the first device
+continues with console input once its command file is finished, command streams of other
+devices end together with their command files.
+
+@param p_device - device executing the commands
+
+@return void
+*/
+static void run_command_stream(lip_tool_device_t *const p_device)
 {
-    cmdline_options     opt;
-    dlb_lip_t *         p_dlb_lip         = NULL;
-    dlb_cec_bus_t *     cec_bus           = NULL;
-    dlb_lip_callbacks_t dlb_lip_callbacks = { 0 };
+    const bool       console = p_device->index == 0;
+    dlb_lip_script_t script;
+    char             buffer[COMMAND_BUFFER_SIZE];
+    int              bExit = 0;
+
+    // Wait for downstream device
+    if (p_device->xml_parser.config_params.downstream_device_addr != DLB_LOGICAL_ADDR_UNKNOWN
+        && p_device->xml_parser.config_params.downstream_device_addr != DLB_LOGICAL_ADDR_UNREGISTERED)
+    {
+        const unsigned int MAX_RETRY_CNT = 10;
+
+        if (wait_for_downstream_device(p_device->p_dlb_lip, MAX_RETRY_CNT) == false)
+        {
+            print_and_log_message("Waiting for downstream device failed\n");
+        }
+    }
+
+    print_and_log_message("waiting for input\n");
+    dlb_lip_script_init(&script);
+
+    while (!bExit)
+    {
+        int script_status = 0;
+
+        update_lip_tool_state(p_device, p_device->commands_file ? LIP_TOOL_PROCESSSING : LIP_TOOL_WAITING_FOR_DATA);
+        memset(buffer, 0, sizeof(buffer));
+        script_status
+            = dlb_lip_script_next_command(&script, buffer, sizeof(buffer), read_command_line, &p_device->commands_file);
+        if (script_status < 0)
+        {
+            print_and_log_message("\n\nERROR: SCRIPT PROCESSING FAILED\n\n\n");
+        }
+        else if (script_status > 0)
+        {
+            if (p_device->commands_file)
+            {
+                if (device_count > 1)
+                {
+                    print_and_log_message("[%u] %s\n", p_device->index, buffer);
+                }
+                else
+                {
+                    print_and_log_message("%s\n", buffer);
+                }
+            }
+
+            // Strip new line characte
+            buffer[strcspn(buffer, "\r\n")] = 0;
+
+            if (buffer[0] == 0 || buffer[0] == '\n' || buffer[0] == '\r')
+            {
+                // Skip empty lines
+                continue;
+            }
+            update_lip_tool_state(p_device, LIP_TOOL_PROCESSSING);
+
+            dlb_lip_tool_mutex_lock(&p_device->command_mutex);
+            bExit = !process_console_command(p_device, buffer);
+            dlb_lip_tool_mutex_unlock(&p_device->command_mutex);
+
+            if (!bExit)
+            {
+                if (buffer[0] != 0 && buffer[0] != '\n' && buffer[0] != '\r')
+                {
+                    print_and_log_message("waiting for input\n");
+                }
+            }
+            else
+            {
+                print_and_log_message("Exiting ... cmd: %s\n", buffer);
+            }
 
-    unsigned char *p_mem;
-    size_t         mem_size;
+            if (!bExit)
+            {
+                usleep(p_device->wait_time_ms * 1000LL);
+            }
+        }
+        else
+        {
+            if (p_device->commands_file)
+            {
+                if (feof(p_device->commands_file))
+                {
+                    fclose(p_device->commands_file);
+                    p_device->commands_file = NULL;
+                    leave_sync_barrier(p_device);
+                    if (!console)
+                    {
+                        print_and_log_message("Command script of device %u finished\n", p_device->index);
+                        bExit = 1;
+                    }
+                }
+            }
+            else if (control_socket_enabled && feof(stdin))
+            {
+                // Console closed, keep serving control socket clients
+                usleep(100 * 1000LL);
+            }
+        }
+    }
+    leave_sync_barrier(p_device);
+    dlb_lip_script_destroy(&script);
+}
 
-    FILE *commands_file = NULL;
+static void command_stream_thread(void *arg)
+{
+    run_command_stream((lip_tool_device_t *)arg);
+}
 
-    char buffer[COMMAND_BUFFER_SIZE];
-    int  bExit = 0;
+int main(int argc, char **argv)
+{
+    cmdline_options opt;
+    unsigned int    opened_devices                       = 0;
+    bool            stream_started[LIP_TOOL_MAX_DEVICES] = { false };
+    int             ret                                  = 0;
 
 #if !defined(_MSC_VER)
     setvbuf(stdout, (char *)NULL, _IOLBF, 0);
@@ -1333,146 +3331,214 @@ int main(int argc, char **argv)
     fprintf(stdout, "************** Build time: %s **************\n", __TIME__);
     fprintf(stdout, "%s", dolby_copyright);
 
+    dlb_lip_vocabulary_init();
+
     /* parse command line */
     memset((void *)&opt, 0, sizeof(cmdline_options));
     parse_cmdline(argc, argv, &opt);
 
-    update_lip_tool_state(opt.state_file_name, LIP_TOOL_INIT);
-
-    memset((void *)&xml_parser, 0, sizeof(dlb_lip_xml_parser_t));
-
-    xml_parser.config_params.downstream_device_addr = DLB_LOGICAL_ADDR_UNKNOWN;
-    xml_parser.config_params.audio_transcoding      = false;
-    memset(xml_parser.config_params.audio_latencies, LIP_INVALID_LATENCY, sizeof(xml_parser.config_params.audio_latencies));
-    memset(xml_parser.config_params.video_latencies, LIP_INVALID_LATENCY, sizeof(xml_parser.config_params.video_latencies));
-    if (opt.config_file_name[0] != '\0')
+    if (opt.log_file_name[0] != '\0')
     {
-        int status = 0;
-        status     = parse_xml_config_file(&(xml_parser), opt.config_file_name);
-
-        if (0 != status)
+        log_file = fopen(opt.log_file_name, "w");
+        if (log_file == NULL)
         {
-            print_and_log_message("XML parsing ERROR!\n");
-            exit(EXIT_FAILURE);
+            print_and_log_message("can't open log file: %s \n", opt.log_file_name);
+            return -1;
         }
     }
 
-    if (opt.commands_file_name[0] != '\0')
+    strict_config = opt.strict_config;
+    if (opt.validate_count > 0)
     {
-        commands_file = fopen(opt.commands_file_name, "r");
-        if (commands_file == NULL)
+        // Only the XML files are needed, no adapter is opened
+        ret = validate_configs(&opt) ? -1 : 0;
+        if (log_file)
         {
-            print_and_log_message("Couldn't open commands file[%s]!\n", opt.commands_file_name);
-            return -1;
+            fclose(log_file);
+            log_file = NULL;
         }
+        return ret;
     }
-
-    if (opt.log_file_name[0] != '\0')
+    if (opt.topology_file_name[0] != '\0' && load_topology(&opt))
     {
-        log_file = fopen(opt.log_file_name, "w");
-        if (log_file == NULL)
+        if (log_file)
         {
-            print_and_log_message("can't open log file: %s \n", opt.log_file_name);
-            return -1;
+            fclose(log_file);
+            log_file = NULL;
         }
+        return -1;
     }
 
-    mem_size = dlb_lip_query_memory();
-    p_mem    = (unsigned char *)malloc(mem_size);
-    cec_bus = dlb_cec_bus_init(xml_parser.physical_address, opt.port_name, xml_parser.device_type, log_messages, NULL, opt.sim_arc);
-    if (cec_bus == NULL)
+    if (opt.compile_config)
     {
-        free(p_mem);
-        return -1;
+        // Only the XML files are needed, no adapter is opened
+        ret = compile_device_configs(&opt) ? -1 : 0;
+        if (log_file)
+        {
+            fclose(log_file);
+            log_file = NULL;
+        }
+        return ret;
     }
 
-    dlb_lip_callbacks.arg                    = NULL;
-    dlb_lip_callbacks.printf_callback        = log_messages;
-    dlb_lip_callbacks.store_cache_callback   = opt.cache_enabled ? store_cache_callback : NULL;
-    dlb_lip_callbacks.read_cache_callback    = opt.cache_enabled ? read_cache_callback : NULL;
-    dlb_lip_callbacks.status_change_callback = status_change;
-    dlb_lip_callbacks.merge_uuid_callback    = merge_uuid_callback;
+    if (opt.cache_enabled)
+    {
+        const dlb_lip_cache_config_t cache_config = { opt.cache_dir_name,
+                                                      opt.cache_store_name,
+                                                      opt.cache_shm_name,
+                                                      opt.cache_max_size,
+                                                      opt.cache_max_entries,
+                                                      LIP_LIBRARY_VERSION };
 
-    p_dlb_lip = dlb_lip_open(p_mem, &xml_parser.config_params, dlb_lip_callbacks, cec_bus);
+        dlb_lip_cache_open(&cache_config);
+        if (opt.cache_import)
+        {
+            const int imported = dlb_lip_cache_import_files(opt.cache_import_legacy);
+            if (imported >= 0)
+            {
+                print_and_log_message("Imported %d cache files into cache store\n", imported);
+            }
+        }
+        if (opt.cache_import_archive_name[0] != '\0')
+        {
+            // Before the devices are opened, so dlb_lip finds the imported UUIDs already on the first discovery
+            const int imported = dlb_lip_cache_import(opt.cache_import_archive_name);
+            if (imported >= 0)
+            {
+                print_and_log_message("Imported %d UUIDs from cache archive %s\n", imported, opt.cache_import_archive_name);
+            }
+        }
+    }
 
-    if (NULL == p_dlb_lip)
+    if (opt.prefetch_file_name[0] != '\0' && load_prefetch_formats(opt.prefetch_file_name))
     {
-        free(p_mem);
         return -1;
     }
+    if (dlb_lip_prefetch_history_open(opt.prefetch_history_name) > 0)
+    {
+        print_and_log_message("Prefetch history: loaded from %s\n", opt.prefetch_history_name);
+    }
 
-    dlb_lip_osa_init_timer(&on_update_uuid_timer, uuid_timer_callback, p_dlb_lip);
+    dlb_lip_tool_mutex_init(&sync_barrier.mutex);
+    dlb_lip_tool_cond_init(&sync_barrier.cond);
 
-    // Wait for downstream device
-    if (xml_parser.config_params.downstream_device_addr != DLB_LOGICAL_ADDR_UNKNOWN
-        && xml_parser.config_params.downstream_device_addr != DLB_LOGICAL_ADDR_UNREGISTERED)
+    device_count = opt.device_count;
+    for (opened_devices = 0; opened_devices < device_count; ++opened_devices)
     {
-        const unsigned int MAX_RETRY_CNT = 10;
+        if (open_device(&devices[opened_devices], opened_devices, &opt))
+        {
+            ret = -1;
+            break;
+        }
+    }
+    // Devices took copies of their configs
+    dlb_lip_xml_topology_destroy(&topology);
 
-        if (wait_for_downstream_device(p_dlb_lip, MAX_RETRY_CNT) == false)
+    if (ret == 0 && opt.cache_enabled)
+    {
+        // Warm start of the cache ran in parallel with XML parsing and adapter open
+        const int cache_records = dlb_lip_cache_wait_warm_start();
+        if (cache_records >= 0)
         {
-            print_and_log_message("Waiting for downstream device failed\n");
+            print_and_log_message("Cache warm start: %d valid records\n", cache_records);
         }
     }
-#if 1
-    print_and_log_message("waiting for input\n");
 
-    while (!bExit)
+    if (ret == 0)
     {
-        update_lip_tool_state(opt.state_file_name, commands_file ? LIP_TOOL_PROCESSSING : LIP_TOOL_WAITING_FOR_DATA);
-        memset(buffer, 0, sizeof(buffer));
-        if (fgets(buffer, sizeof(buffer), commands_file ? commands_file : stdin))
+        if (opt.control_socket_name[0] != '\0')
         {
-            if (commands_file)
+            if (dlb_lip_control_socket_open(opt.control_socket_name, execute_control_command, &devices[0]))
+            {
+                print_and_log_message("Couldn't open control socket[%s]!\n", opt.control_socket_name);
+            }
+            else
             {
-                print_and_log_message("%s", buffer);
+                print_and_log_message("Listening for commands on control socket[%s]\n", opt.control_socket_name);
+                control_socket_enabled = true;
             }
+        }
 
-            // Strip new line characte
-            buffer[strcspn(buffer, "\r\n")] = 0;
+        if (opt.watch_config)
+        {
+            const char *config_file_names[LIP_TOOL_MAX_DEVICES];
 
-            if (buffer[0] == 0 || buffer[0] == '\n' || buffer[0] == '\r')
+            for (unsigned int i = 0; i < device_count; ++i)
             {
-                // Skip empty lines
-                continue;
+                config_file_names[i] = opt.devices[i].config_file_name;
             }
-            update_lip_tool_state(opt.state_file_name, LIP_TOOL_PROCESSSING);
-
-            if (process_console_command(p_dlb_lip, cec_bus, buffer))
+            if (dlb_lip_config_watch_open(config_file_names, device_count, config_file_changed, NULL) == 0)
             {
-                if (buffer[0] != 0 && buffer[0] != '\n' && buffer[0] != '\r')
+                for (unsigned int i = 0; i < device_count; ++i)
                 {
-                    print_and_log_message("waiting for input\n");
+                    watch_config_dependencies(i, &devices[i].xml_parser);
                 }
+                print_and_log_message("Watching XML config files for changes\n");
             }
-            else
-            {
-                print_and_log_message("Exiting ... cmd: %s\n", buffer);
-                bExit = 1;
-            }
+        }
 
-            if (!bExit)
+        // Every command script takes part in sync barriers until it is finished
+        for (unsigned int i = 0; i < device_count; ++i)
+        {
+            if (devices[i].commands_file)
             {
-                usleep(WAIT_TIME_MS * 1000LL);
+                devices[i].in_barrier = true;
+                sync_barrier.participants += 1;
             }
         }
-        else
+
+        // First device executes commands on the main thread, scripts of other devices run on their own threads
+        for (unsigned int i = 1; i < device_count; ++i)
         {
-            if (commands_file)
+            if (devices[i].commands_file)
             {
-                if (feof(commands_file))
+                stream_started[i] = !dlb_lip_tool_thread_create(&devices[i].thread, command_stream_thread, &devices[i]);
+                if (!stream_started[i])
                 {
-                    fclose(commands_file);
-                    commands_file = NULL;
+                    print_and_log_message("Couldn't start command stream of device %u!\n", i);
+                    leave_sync_barrier(&devices[i]);
                 }
             }
         }
+
+        run_command_stream(&devices[0]);
+
+        for (unsigned int i = 1; i < device_count; ++i)
+        {
+            if (stream_started[i])
+            {
+                dlb_lip_tool_thread_join(&devices[i].thread);
+            }
+        }
+
+        dlb_lip_control_socket_close();
+        dlb_lip_config_watch_close();
+    }
+
+    while (opened_devices > 0)
+    {
+        opened_devices -= 1;
+        close_device(&devices[opened_devices]);
+    }
+
+    dlb_lip_tool_cond_destroy(&sync_barrier.cond);
+    dlb_lip_tool_mutex_destroy(&sync_barrier.mutex);
+    dlb_lip_prefetch_history_close();
+
+    if (opt.cache_enabled)
+    {
+        if (opt.cache_export_archive_name[0] != '\0')
+        {
+            const int exported = dlb_lip_cache_export(opt.cache_export_archive_name);
+            if (exported >= 0)
+            {
+                print_and_log_message("Exported %d UUIDs to cache archive %s\n", exported, opt.cache_export_archive_name);
+            }
+        }
+
+        // Devices are closed, write all stores queued by them
+        dlb_lip_cache_close();
     }
-#endif
-    dlb_lip_osa_delete_timer(&on_update_uuid_timer);
-    dlb_lip_close(p_dlb_lip);
-    dlb_cec_bus_destroy();
-    free(p_mem);
 
     if (log_file)
     {
@@ -1480,9 +3546,7 @@ int main(int argc, char **argv)
         log_file = NULL;
     }
 
-    update_lip_tool_state(opt.state_file_name, LIP_TOOL_QUIT);
-
-    return 0;
+    return ret;
 }
 
 /*!
@@ -1494,9 +3558,10 @@ void usage(char **const argv)
 {
     fprintf(stdout, "Build date: " __DATE__ "\n\n");
     fprintf(stdout, "Usage:");
-    fprintf(stdout, "\t%s -x <file> [-x <file>] [-v]]\n\n", argv[0]);
+    fprintf(stdout, "\t%s -x <file> [-c <file>] [-p <port>] [-x <file> [-c <file>] [-p <port>] ...] [-v]]\n\n", argv[0]);
     fprintf(stdout, "MANDATORY attributes:\n");
-    fprintf(stdout, "\t-x:     [file] Reads LIP parameters of the device from XML file.\n");
+    fprintf(stdout, "\t-x:     [file] Reads LIP parameters of the device from XML file. Every -x adds new device,\n");
+    fprintf(stdout, "\t        following -a, -c, -p and -s options belong to that device.\n");
     fprintf(stdout, "OPTIONAL attributes:\n");
     fprintf(stdout, "\t-a:     Act as ARC receiver - anwser to CEC ARC communication\n");
     fprintf(stdout, "\t-c:     [file] Reads real-time commands from file.\n");
@@ -1504,7 +3569,35 @@ void usage(char **const argv)
     fprintf(stdout, "\t-n:     No cache - disable caching\n");
     fprintf(stdout, "\t-p:     [port] Pulse8 cec adapter port name eg. COM4\n");
     fprintf(stdout, "\t-s:     [file] Writes current LIP tool state to a file.\n");
+    fprintf(stdout, "\t-u:     [path] Accepts commands from clients of a Unix-domain control socket.\n");
     fprintf(stdout, "\t-v:    verbosity flag\n");
+    fprintf(stdout, "\t--compile-config: Compiles XML files of all devices to <file>.lipc loaded by following starts and exits.\n");
+    fprintf(stdout, "\t--no-compiled-config: Always parses XML files, <file>.lipc is ignored.\n");
+    fprintf(stdout, "\t--validate: [path] Validates XML file or *.xml files of directory and exits, can be repeated.\n");
+    fprintf(stdout, "\t--validate-threads: [n] Number of threads parsing --validate files(default number of processors).\n");
+    fprintf(stdout, "\t--topology: [file] Emulates all devices of the topology file instead of -x devices.\n");
+    fprintf(stdout, "\t--strict-config: XML latencies overwriting different earlier latencies are errors.\n");
+    fprintf(stdout, "\t--watch-config: Reloads XML files changed while running, changed latencies are sent to dlb_lip.\n");
+    fprintf(stdout, "\t--cache-store: [file] Keeps LIP cache of all UUIDs in single memory mapped store file.\n");
+    fprintf(stdout, "\t--cache-import: Imports cache_<uuid>.dat files of the cache directory into the cache store.\n");
+    fprintf(stdout, "\t--cache-import-legacy: Like --cache-import, also trusts cache files without record header.\n");
+    fprintf(stdout, "\t--cache-dir: [dir] Directory of LIP cache files and relative cache store path.\n");
+    fprintf(stdout, "\t--cache-shm: [name] Shares LIP cache with other processes in POSIX shared memory segment eg. /dlb_lip.\n");
+    fprintf(stdout, "\t--cache-import-archive: [file] Imports UUIDs of a cache archive before the devices are opened.\n");
+    fprintf(stdout, "\t--cache-export-archive: [file] Exports all cached UUIDs to a cache archive at exit.\n");
+    fprintf(stdout, "\t--cache-max-size: [bytes] Maximum size of LIP cache, least recently used UUIDs are evicted.\n");
+    fprintf(stdout, "\t--cache-max-entries: [n] Maximum number of UUIDs in LIP cache, least recently used UUIDs are evicted.\n");
+    fprintf(
+        stdout,
+        "\t--negative-cache-ttl: [ms] Time unsupported formats of the downstream device are answered without bus traffic, "
+        "0 disables(default %u).\n",
+        DLB_LIP_QUERY_CACHE_DEFAULT_NEGATIVE_TTL_MS);
+    fprintf(stdout, "\t--prefetch: [file] req commands issued in background when downstream device connects or changes UUID.\n");
+    fprintf(stdout, "\t--prefetch-history: [file] Keeps formats requested by the user between runs for prefetch.\n");
+    fprintf(
+        stdout,
+        "\t--prefetch-count: [n] Number of most requested formats prefetched after the --prefetch file, 0 disables(default %u).\n",
+        DLB_LIP_PREFETCH_DEFAULT_LEARNED);
     fprintf(stdout, "Supported real-time commands:\n");
     for (unsigned int i = 0; i < ARRAY_SIZE(commands_list); ++i)
     {
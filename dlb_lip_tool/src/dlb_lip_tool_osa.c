@@ -0,0 +1,257 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_tool_osa.c
+ *  @brief      Threads and synchronization primitives used by the LIP tool
+ */
+
+#include <stdlib.h>
+
+#include "dlb_lip_tool_osa.h"
+
+#if !defined(_MSC_VER)
+#include <errno.h>
+#include <time.h>
+#endif
+
+typedef struct thread_start_s
+{
+    dlb_lip_tool_thread_func_t func;
+    void *                     arg;
+} thread_start_t;
+
+#if defined(_MSC_VER)
+
+static DWORD WINAPI thread_entry(LPVOID param)
+{
+    thread_start_t start = *(thread_start_t *)param;
+    free(param);
+    start.func(start.arg);
+    return 0;
+}
+
+int dlb_lip_tool_thread_create(dlb_lip_tool_thread_t *p_thread, dlb_lip_tool_thread_func_t func, void *arg)
+{
+    thread_start_t *p_start = (thread_start_t *)malloc(sizeof(thread_start_t));
+
+    if (p_start == NULL)
+    {
+        return 1;
+    }
+    p_start->func = func;
+    p_start->arg  = arg;
+
+    *p_thread = CreateThread(NULL, 0, thread_entry, p_start, 0, NULL);
+    if (*p_thread == NULL)
+    {
+        free(p_start);
+        return 1;
+    }
+
+    return 0;
+}
+
+void dlb_lip_tool_thread_join(dlb_lip_tool_thread_t *p_thread)
+{
+    WaitForSingleObject(*p_thread, INFINITE);
+    CloseHandle(*p_thread);
+}
+
+void dlb_lip_tool_mutex_init(dlb_lip_tool_mutex_t *p_mutex)
+{
+    InitializeCriticalSection(p_mutex);
+}
+
+void dlb_lip_tool_mutex_lock(dlb_lip_tool_mutex_t *p_mutex)
+{
+    EnterCriticalSection(p_mutex);
+}
+
+void dlb_lip_tool_mutex_unlock(dlb_lip_tool_mutex_t *p_mutex)
+{
+    LeaveCriticalSection(p_mutex);
+}
+
+void dlb_lip_tool_mutex_destroy(dlb_lip_tool_mutex_t *p_mutex)
+{
+    DeleteCriticalSection(p_mutex);
+}
+
+void dlb_lip_tool_cond_init(dlb_lip_tool_cond_t *p_cond)
+{
+    InitializeConditionVariable(p_cond);
+}
+
+void dlb_lip_tool_cond_wait(dlb_lip_tool_cond_t *p_cond, dlb_lip_tool_mutex_t *p_mutex)
+{
+    SleepConditionVariableCS(p_cond, p_mutex, INFINITE);
+}
+
+bool dlb_lip_tool_cond_timedwait(dlb_lip_tool_cond_t *p_cond, dlb_lip_tool_mutex_t *p_mutex, unsigned int timeout_ms)
+{
+    return SleepConditionVariableCS(p_cond, p_mutex, timeout_ms) ? true : false;
+}
+
+void dlb_lip_tool_cond_signal(dlb_lip_tool_cond_t *p_cond)
+{
+    WakeConditionVariable(p_cond);
+}
+
+void dlb_lip_tool_cond_broadcast(dlb_lip_tool_cond_t *p_cond)
+{
+    WakeAllConditionVariable(p_cond);
+}
+
+void dlb_lip_tool_cond_destroy(dlb_lip_tool_cond_t *p_cond)
+{
+    (void)p_cond;
+}
+
+typedef struct once_start_s
+{
+    void (*func)(void);
+} once_start_t;
+
+static BOOL CALLBACK once_entry(PINIT_ONCE p_once, PVOID param, PVOID *p_context)
+{
+    (void)p_once;
+    (void)p_context;
+    ((const once_start_t *)param)->func();
+    return TRUE;
+}
+
+void dlb_lip_tool_once(dlb_lip_tool_once_t *p_once, void (*func)(void))
+{
+    once_start_t start = { func };
+
+    InitOnceExecuteOnce(p_once, once_entry, &start, NULL);
+}
+
+unsigned long long dlb_lip_tool_time_us(void)
+{
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (unsigned long long)(counter.QuadPart / frequency.QuadPart) * 1000000ULL
+           + (unsigned long long)(counter.QuadPart % frequency.QuadPart) * 1000000ULL / frequency.QuadPart;
+}
+
+#else
+
+static void *thread_entry(void *param)
+{
+    thread_start_t start = *(thread_start_t *)param;
+    free(param);
+    start.func(start.arg);
+    return NULL;
+}
+
+int dlb_lip_tool_thread_create(dlb_lip_tool_thread_t *p_thread, dlb_lip_tool_thread_func_t func, void *arg)
+{
+    thread_start_t *p_start = (thread_start_t *)malloc(sizeof(thread_start_t));
+
+    if (p_start == NULL)
+    {
+        return 1;
+    }
+    p_start->func = func;
+    p_start->arg  = arg;
+
+    if (pthread_create(p_thread, NULL, thread_entry, p_start) != 0)
+    {
+        free(p_start);
+        return 1;
+    }
+
+    return 0;
+}
+
+void dlb_lip_tool_thread_join(dlb_lip_tool_thread_t *p_thread)
+{
+    pthread_join(*p_thread, NULL);
+}
+
+void dlb_lip_tool_mutex_init(dlb_lip_tool_mutex_t *p_mutex)
+{
+    pthread_mutex_init(p_mutex, NULL);
+}
+
+void dlb_lip_tool_mutex_lock(dlb_lip_tool_mutex_t *p_mutex)
+{
+    pthread_mutex_lock(p_mutex);
+}
+
+void dlb_lip_tool_mutex_unlock(dlb_lip_tool_mutex_t *p_mutex)
+{
+    pthread_mutex_unlock(p_mutex);
+}
+
+void dlb_lip_tool_mutex_destroy(dlb_lip_tool_mutex_t *p_mutex)
+{
+    pthread_mutex_destroy(p_mutex);
+}
+
+void dlb_lip_tool_cond_init(dlb_lip_tool_cond_t *p_cond)
+{
+    pthread_cond_init(p_cond, NULL);
+}
+
+void dlb_lip_tool_cond_wait(dlb_lip_tool_cond_t *p_cond, dlb_lip_tool_mutex_t *p_mutex)
+{
+    pthread_cond_wait(p_cond, p_mutex);
+}
+
+bool dlb_lip_tool_cond_timedwait(dlb_lip_tool_cond_t *p_cond, dlb_lip_tool_mutex_t *p_mutex, unsigned int timeout_ms)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += timeout_ms / 1000U;
+    ts.tv_nsec += (long)(timeout_ms % 1000U) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L)
+    {
+        ts.tv_sec += 1;
+        ts.tv_nsec -= 1000000000L;
+    }
+
+    return pthread_cond_timedwait(p_cond, p_mutex, &ts) != ETIMEDOUT;
+}
+
+void dlb_lip_tool_cond_signal(dlb_lip_tool_cond_t *p_cond)
+{
+    pthread_cond_signal(p_cond);
+}
+
+void dlb_lip_tool_cond_broadcast(dlb_lip_tool_cond_t *p_cond)
+{
+    pthread_cond_broadcast(p_cond);
+}
+
+void dlb_lip_tool_cond_destroy(dlb_lip_tool_cond_t *p_cond)
+{
+    pthread_cond_destroy(p_cond);
+}
+
+void dlb_lip_tool_once(dlb_lip_tool_once_t *p_once, void (*func)(void))
+{
+    pthread_once(p_once, func);
+}
+
+unsigned long long dlb_lip_tool_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000ULL + (unsigned long long)ts.tv_nsec / 1000ULL;
+}
+
+#endif
@@ -0,0 +1,414 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_validate.c
+ *  @brief      Validation of XML config files on a thread pool
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "dlb_lip_tool_osa.h"
+#include "dlb_lip_validate.h"
+#include "dlb_lip_vocabulary.h"
+
+#if defined(_MSC_VER)
+#include <Windows.h>
+#else
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+#define VALIDATE_PATH_SIZE 1024
+#define TOPOLOGY_PROBE_SIZE 512 // Topology files have LIP_Topology root element in the first bytes
+
+typedef struct validate_file_list_s
+{
+    char **      paths;
+    unsigned int count;
+    unsigned int capacity;
+} validate_file_list_t;
+
+typedef struct validate_pool_s
+{
+    dlb_lip_tool_mutex_t       mutex;
+    unsigned int               next; // Index of the next file to parse
+    dlb_lip_validate_result_t *p_results;
+    unsigned int               count;
+    bool                       fail_on_overwrite;
+} validate_pool_t;
+
+static int add_file(validate_file_list_t *p_list, const char *path)
+{
+    if (p_list->count == p_list->capacity)
+    {
+        const unsigned int capacity = p_list->capacity ? p_list->capacity * 2U : 64U;
+        char **const       paths    = (char **)realloc(p_list->paths, capacity * sizeof(char *));
+
+        if (paths == NULL)
+        {
+            return 1;
+        }
+        p_list->paths    = paths;
+        p_list->capacity = capacity;
+    }
+
+    p_list->paths[p_list->count] = (char *)malloc(strlen(path) + 1U);
+    if (p_list->paths[p_list->count] == NULL)
+    {
+        return 1;
+    }
+    strcpy(p_list->paths[p_list->count], path);
+    p_list->count += 1;
+
+    return 0;
+}
+
+static bool is_xml_file_name(const char *name)
+{
+    const size_t length = strlen(name);
+
+    return length > 4 && strcmp(name + length - 4, ".xml") == 0;
+}
+
+/*!
+Adds *.xml files of the directory and its subdirectories to the list.
+
+@return 0 on success, 1 on error
+*/
+static int add_directory(validate_file_list_t *p_list, const char *directory)
+{
+    char path[VALIDATE_PATH_SIZE];
+    int  ret = 0;
+#if defined(_MSC_VER)
+    WIN32_FIND_DATAA find_data;
+    HANDLE           find = INVALID_HANDLE_VALUE;
+
+    snprintf(path, sizeof(path), "%s\\*", directory);
+    find = FindFirstFileA(path, &find_data);
+    if (find == INVALID_HANDLE_VALUE)
+    {
+        return GetLastError() == ERROR_FILE_NOT_FOUND ? 0 : 1;
+    }
+    do
+    {
+        if (find_data.cFileName[0] == '.')
+        {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s\\%s", directory, find_data.cFileName);
+        if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+            ret = add_directory(p_list, path);
+        }
+        else if (is_xml_file_name(find_data.cFileName))
+        {
+            ret = add_file(p_list, path);
+        }
+    } while (ret == 0 && FindNextFileA(find, &find_data));
+    FindClose(find);
+#else
+    DIR *          dir      = opendir(directory);
+    struct dirent *p_dirent = NULL;
+
+    if (dir == NULL)
+    {
+        fprintf(stderr, "ERROR: Couldn't read directory %s.\n", directory);
+        return 1;
+    }
+    while (ret == 0 && (p_dirent = readdir(dir)) != NULL)
+    {
+        struct stat st;
+
+        if (p_dirent->d_name[0] == '.')
+        {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/%s", directory, p_dirent->d_name);
+        if (stat(path, &st) != 0)
+        {
+            continue;
+        }
+        if (S_ISDIR(st.st_mode))
+        {
+            ret = add_directory(p_list, path);
+        }
+        else if (is_xml_file_name(p_dirent->d_name))
+        {
+            ret = add_file(p_list, path);
+        }
+    }
+    closedir(dir);
+#endif
+
+    return ret;
+}
+
+static int compare_paths(const void *p_a, const void *p_b)
+{
+    return strcmp(*(char *const *)p_a, *(char *const *)p_b);
+}
+
+static uint64_t fingerprint_update(uint64_t hash, const void *data, size_t size)
+{
+    const unsigned char *p = (const unsigned char *)data;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash = (hash ^ p[i]) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/*!
+Adds the expanded config of the device to the fingerprint, field by field so padding of the structures is not hashed.
+*/
+static uint64_t fingerprint_device(uint64_t hash, const dlb_lip_xml_parser_t *p_parser)
+{
+    const dlb_lip_config_params_t *const p_config    = &p_parser->config_params;
+    const int32_t                        downstream  = (int32_t)p_config->downstream_device_addr;
+    const uint8_t                        transcoding = p_config->audio_transcoding ? 1U : 0U;
+    const uint8_t                        format[3]   = { (uint8_t)p_config->audio_transcoding_format.codec,
+                                          p_config->audio_transcoding_format.subtype,
+                                          p_config->audio_transcoding_format.ext };
+    const uint32_t                       device_type = (uint32_t)p_parser->device_type;
+
+    hash = fingerprint_update(hash, &p_config->uuid, sizeof(p_config->uuid));
+    hash = fingerprint_update(hash, &downstream, sizeof(downstream));
+    hash = fingerprint_update(hash, &transcoding, sizeof(transcoding));
+    hash = fingerprint_update(hash, format, sizeof(format));
+    hash = fingerprint_update(hash, &p_config->render_mode, sizeof(p_config->render_mode));
+    hash = fingerprint_update(hash, p_config->audio_latencies, sizeof(p_config->audio_latencies));
+    hash = fingerprint_update(hash, p_config->video_latencies, sizeof(p_config->video_latencies));
+    hash = fingerprint_update(hash, &p_parser->physical_address, sizeof(p_parser->physical_address));
+    hash = fingerprint_update(hash, &device_type, sizeof(device_type));
+
+    return hash;
+}
+
+static void add_diagnostics(dlb_lip_validate_result_t *p_result, const dlb_lip_xml_diagnostics_t *p_diag)
+{
+    p_result->overwrite_elements += p_diag->overwrite_elements;
+    p_result->overwritten_cells += p_diag->overwritten_cells;
+    if (p_result->first_overwrite[0] == '\0')
+    {
+        snprintf(p_result->first_overwrite, sizeof(p_result->first_overwrite), "%s", p_diag->first_overwrite);
+    }
+}
+
+static bool is_topology_file(const char *path)
+{
+    char   probe[TOPOLOGY_PROBE_SIZE + 1];
+    size_t size = 0;
+    FILE * file = fopen(path, "r");
+
+    if (file == NULL)
+    {
+        return false;
+    }
+    size        = fread(probe, 1, TOPOLOGY_PROBE_SIZE, file);
+    probe[size] = '\0';
+    fclose(file);
+
+    return strstr(probe, "<LIP_Topology") != NULL;
+}
+
+static void validate_config_file(dlb_lip_validate_result_t *p_result, dlb_lip_xml_parser_t *p_parser, bool fail_on_overwrite)
+{
+    dlb_lip_xml_parser_init(p_parser);
+    p_parser->diagnostics.fail_on_overwrite = fail_on_overwrite;
+    p_parser->diagnostics.quiet             = true;
+
+    p_result->valid   = parse_xml_config_file(p_parser, p_result->path) == 0;
+    p_result->devices = 1;
+    add_diagnostics(p_result, &p_parser->diagnostics);
+    if (p_result->valid)
+    {
+        dlb_lip_xml_parser_expand_latencies(p_parser);
+        p_result->fingerprint = fingerprint_device(14695981039346656037ULL, p_parser);
+    }
+    dlb_lip_xml_parser_destroy(p_parser);
+}
+
+static void validate_topology_file(dlb_lip_validate_result_t *p_result, bool fail_on_overwrite)
+{
+    dlb_lip_xml_topology_t *p_topology = (dlb_lip_xml_topology_t *)calloc(1, sizeof(dlb_lip_xml_topology_t));
+
+    if (p_topology == NULL)
+    {
+        return;
+    }
+    p_topology->fail_on_overwrite = fail_on_overwrite;
+    p_topology->quiet             = true;
+
+    p_result->valid       = parse_xml_topology_file(p_topology, p_result->path) == 0;
+    p_result->devices     = p_topology->device_count;
+    p_result->fingerprint = 14695981039346656037ULL;
+    for (unsigned int i = 0; i < p_topology->device_count; ++i)
+    {
+        add_diagnostics(p_result, &p_topology->devices[i].parser.diagnostics);
+        p_result->fingerprint = fingerprint_device(p_result->fingerprint, &p_topology->devices[i].parser);
+    }
+    if (!p_result->valid)
+    {
+        p_result->fingerprint = 0;
+    }
+    dlb_lip_xml_topology_destroy(p_topology);
+    free(p_topology);
+}
+
+static void validate_thread(void *arg)
+{
+    validate_pool_t *const      p_pool   = (validate_pool_t *)arg;
+    dlb_lip_xml_parser_t *const p_parser = (dlb_lip_xml_parser_t *)calloc(1, sizeof(dlb_lip_xml_parser_t));
+
+    while (p_parser != NULL)
+    {
+        dlb_lip_validate_result_t *p_result = NULL;
+
+        dlb_lip_tool_mutex_lock(&p_pool->mutex);
+        if (p_pool->next < p_pool->count)
+        {
+            p_result = &p_pool->p_results[p_pool->next++];
+        }
+        dlb_lip_tool_mutex_unlock(&p_pool->mutex);
+        if (p_result == NULL)
+        {
+            break;
+        }
+
+        if (is_topology_file(p_result->path))
+        {
+            validate_topology_file(p_result, p_pool->fail_on_overwrite);
+        }
+        else
+        {
+            validate_config_file(p_result, p_parser, p_pool->fail_on_overwrite);
+        }
+    }
+
+    free(p_parser);
+    dlb_lip_xml_fragments_clear();
+}
+
+static unsigned int get_processor_count(void)
+{
+#if defined(_MSC_VER)
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+    return (unsigned int)info.dwNumberOfProcessors;
+#else
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return count > 0 ? (unsigned int)count : 1U;
+#endif
+}
+
+int dlb_lip_validate_configs(
+    const char *const *         paths,
+    unsigned int                path_count,
+    unsigned int                threads,
+    bool                        fail_on_overwrite,
+    dlb_lip_validate_result_t **pp_results,
+    unsigned int *              p_result_count)
+{
+    validate_file_list_t  list = { NULL, 0, 0 };
+    validate_pool_t       pool;
+    dlb_lip_tool_thread_t thread_handles[DLB_LIP_VALIDATE_MAX_THREADS];
+    unsigned int          started = 0;
+    int                   ret     = 0;
+
+    *pp_results     = NULL;
+    *p_result_count = 0;
+
+    for (unsigned int i = 0; i < path_count && ret == 0; ++i)
+    {
+        struct stat st;
+
+        if (stat(paths[i], &st) != 0)
+        {
+            fprintf(stderr, "ERROR: Couldn't find %s.\n", paths[i]);
+            ret = 1;
+        }
+        else if ((st.st_mode & S_IFMT) == S_IFDIR)
+        {
+            ret = add_directory(&list, paths[i]);
+        }
+        else
+        {
+            ret = add_file(&list, paths[i]);
+        }
+    }
+
+    pool.p_results = ret == 0 && list.count > 0
+                         ? (dlb_lip_validate_result_t *)calloc(list.count, sizeof(dlb_lip_validate_result_t))
+                         : NULL;
+    if (pool.p_results == NULL)
+    {
+        for (unsigned int i = 0; i < list.count; ++i)
+        {
+            free(list.paths[i]);
+        }
+        free(list.paths);
+        return ret == 0 && list.count == 0 ? 0 : 1;
+    }
+
+    // Paths are owned by the results from here
+    qsort(list.paths, list.count, sizeof(char *), compare_paths);
+    for (unsigned int i = 0; i < list.count; ++i)
+    {
+        pool.p_results[i].path = list.paths[i];
+    }
+    free(list.paths);
+    pool.next              = 0;
+    pool.count             = list.count;
+    pool.fail_on_overwrite = fail_on_overwrite;
+    dlb_lip_tool_mutex_init(&pool.mutex);
+    dlb_lip_vocabulary_init(); // Before the threads parse names
+
+    threads = threads ? threads : get_processor_count();
+    threads = threads < DLB_LIP_VALIDATE_MAX_THREADS ? threads : DLB_LIP_VALIDATE_MAX_THREADS;
+    threads = threads < pool.count ? threads : pool.count;
+    while (started < threads && dlb_lip_tool_thread_create(&thread_handles[started], validate_thread, &pool) == 0)
+    {
+        started++;
+    }
+    if (started == 0)
+    {
+        // No thread could be started, files are parsed by the calling thread
+        validate_thread(&pool);
+    }
+    for (unsigned int i = 0; i < started; ++i)
+    {
+        dlb_lip_tool_thread_join(&thread_handles[i]);
+    }
+    dlb_lip_tool_mutex_destroy(&pool.mutex);
+
+    *pp_results     = pool.p_results;
+    *p_result_count = pool.count;
+
+    return 0;
+}
+
+void dlb_lip_validate_free(dlb_lip_validate_result_t *p_results, unsigned int result_count)
+{
+    for (unsigned int i = 0; p_results != NULL && i < result_count; ++i)
+    {
+        free(p_results[i].path);
+    }
+    free(p_results);
+}
@@ -0,0 +1,280 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_vocabulary.c
+ *  @brief      Names of LIP formats and device params used by XML configs and commands
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "dlb_lip_tool_osa.h"
+#include "dlb_lip_types.h"
+#include "dlb_lip_vocabulary.h"
+
+/**********************************************************************
+ *
+ *
+ *  Names, new formats are added here
+ *
+ *
+ **********************************************************************/
+
+#define CODEC_WORDS(X)                         \
+    X(PCM, "PCM")                              \
+    X(IEC61937_AC3, "DD")                      \
+    X(IEC61937_SMPTE_338M, "SMPTE_338M")       \
+    X(IEC61937_PAUSE_BURST, "PAUSE_BURST")     \
+    X(IEC61937_MPEG1_L1, "MPEG1_L1")           \
+    X(IEC61937_MEPG1_L2_L3, "MEPG1_L2_L3")     \
+    X(IEC61937_MPEG2, "MPEG2")                 \
+    X(IEC61937_MPEG2_AAC, "AAC")               \
+    X(IEC61937_MPEG2_L1, "MPEG2_L1")           \
+    X(IEC61937_MPEG2_L2, "MPEG2_L2")           \
+    X(IEC61937_MPEG2_L3, "MPEG2_L3")           \
+    X(IEC61937_DTS_TYPE_I, "DTS_TYPE_I")       \
+    X(IEC61937_DTS_TYPE_II, "DTS_TYPE_II")     \
+    X(IEC61937_DTS_TYPE_III, "DTS_TYPE_III")   \
+    X(IEC61937_ATRAC, "ATRAC")                 \
+    X(IEC61937_ATRAC_2_3, "ATRAC_2_3")         \
+    X(IEC61937_ATRAC_X, "ATRAC_X")             \
+    X(IEC61937_DTS_TYPE_IV, "DTS_TYPE_IV")     \
+    X(IEC61937_WMA_PRO, "WMA_PRO")             \
+    X(IEC61937_MPEG2_AAC_LSF, "MPEG2_AAC_LSF") \
+    X(IEC61937_MPEG4_AAC, "MPEG4_AAC")         \
+    X(IEC61937_EAC3, "DDP")                    \
+    X(IEC61937_MAT, "MAT")                     \
+    X(IEC61937_MPEG4, "MPEG4")
+
+// Names accepted in addition to the names above, never printed
+#define CODEC_ALIASES(X) X(IEC61937_DTS_TYPE_III, "DTS_TYPE_IIII")
+
+#define COLOR_FORMAT_WORDS(X)                      \
+    X(LIP_COLOR_FORMAT_HDR_STATIC, "HDR_STATIC")   \
+    X(LIP_COLOR_FORMAT_HDR_DYNAMIC, "HDR_DYNAMIC") \
+    X(LIP_COLOR_FORMAT_DOLBY_VISION, "DV")
+
+#define HDR_STATIC_WORDS(X)                  \
+    X(LIP_HDR_STATIC_SDR, "SDR")             \
+    X(LIP_HDR_STATIC_HDR, "HDR")             \
+    X(LIP_HDR_STATIC_SMPTE_ST_2084, "SMPTE") \
+    X(LIP_HDR_STATIC_HLG, "HLG")
+
+#define HDR_DYNAMIC_WORDS(X)                                \
+    X(LIP_HDR_DYNAMIC_SMPTE_ST_2094_10, "SMPTE_ST_2094_10") \
+    X(LIP_HDR_DYNAMIC_ETSI_TS_103_433, "ETSI")              \
+    X(LIP_HDR_DYNAMIC_ITU_T_H265, "ITU")                    \
+    X(LIP_HDR_DYNAMIC_SMPTE_ST_2094_40, "SMPTE_ST_2094_40")
+
+#define DOLBY_VISION_WORDS(X)                \
+    X(LIP_HDR_DOLBY_VISION_SINK_LED, "SINK") \
+    X(LIP_HDR_DOLBY_VISION_SOURCE_LED, "SOURCE")
+
+#define DEVICE_TYPE_WORDS(X)      \
+    X(LIP_DEVICE_STB, "playback") \
+    X(LIP_DEVICE_AVR, "audio")    \
+    X(LIP_DEVICE_TV, "tv")
+
+#define RENDERER_WORDS(X)          \
+    X(LIP_AUDIO_RENDERER, "audio") \
+    X(LIP_VIDEO_RENDERER, "video") \
+    X(LIP_AUDIO_RENDERER | LIP_VIDEO_RENDERER, "av")
+
+#define RENDERER_VALUES ((LIP_AUDIO_RENDERER | LIP_VIDEO_RENDERER) + 1)
+
+/**********************************************************************
+ *
+ *
+ *  Generated tables
+ *
+ *
+ **********************************************************************/
+
+typedef struct vocabulary_word_s
+{
+    dlb_lip_vocabulary_kind_t kind;
+    int                       value;
+    const char *              name;
+} vocabulary_word_t;
+
+#define VALUE_NAME(value, name) [value] = name,
+
+static const char *const codec_names[IEC61937_AUDIO_CODECS] = { CODEC_WORDS(VALUE_NAME) };
+static const char *const color_format_names[LIP_COLOR_FORMAT_COUNT] = { COLOR_FORMAT_WORDS(VALUE_NAME) };
+static const char *const hdr_static_names[LIP_HDR_STATIC_COUNT] = { HDR_STATIC_WORDS(VALUE_NAME) };
+static const char *const hdr_dynamic_names[LIP_HDR_DYNAMIC_COUNT] = { HDR_DYNAMIC_WORDS(VALUE_NAME) };
+static const char *const dolby_vision_names[LIP_HDR_DOLBY_VISION_COUNT] = { DOLBY_VISION_WORDS(VALUE_NAME) };
+static const char *const device_type_names[LIP_DEVICE_TYPES] = { DEVICE_TYPE_WORDS(VALUE_NAME) };
+static const char *const renderer_names[RENDERER_VALUES] = { RENDERER_WORDS(VALUE_NAME) };
+
+static const struct
+{
+    const char *const *names;
+    unsigned int       count;
+} vocabulary_names[DLB_LIP_VOCABULARY_KINDS] = {
+    [DLB_LIP_VOCABULARY_CODEC]        = { codec_names, IEC61937_AUDIO_CODECS },
+    [DLB_LIP_VOCABULARY_COLOR_FORMAT] = { color_format_names, LIP_COLOR_FORMAT_COUNT },
+    [DLB_LIP_VOCABULARY_HDR_STATIC]   = { hdr_static_names, LIP_HDR_STATIC_COUNT },
+    [DLB_LIP_VOCABULARY_HDR_DYNAMIC]  = { hdr_dynamic_names, LIP_HDR_DYNAMIC_COUNT },
+    [DLB_LIP_VOCABULARY_DOLBY_VISION] = { dolby_vision_names, LIP_HDR_DOLBY_VISION_COUNT },
+    [DLB_LIP_VOCABULARY_DEVICE_TYPE]  = { device_type_names, LIP_DEVICE_TYPES },
+    [DLB_LIP_VOCABULARY_RENDERER]     = { renderer_names, RENDERER_VALUES },
+};
+
+#define CODEC_WORD(value, name) { DLB_LIP_VOCABULARY_CODEC, (int)(value), name },
+#define COLOR_FORMAT_WORD(value, name) { DLB_LIP_VOCABULARY_COLOR_FORMAT, (int)(value), name },
+#define HDR_STATIC_WORD(value, name) { DLB_LIP_VOCABULARY_HDR_STATIC, (int)(value), name },
+#define HDR_DYNAMIC_WORD(value, name) { DLB_LIP_VOCABULARY_HDR_DYNAMIC, (int)(value), name },
+#define DOLBY_VISION_WORD(value, name) { DLB_LIP_VOCABULARY_DOLBY_VISION, (int)(value), name },
+#define DEVICE_TYPE_WORD(value, name) { DLB_LIP_VOCABULARY_DEVICE_TYPE, (int)(value), name },
+#define RENDERER_WORD(value, name) { DLB_LIP_VOCABULARY_RENDERER, (int)(value), name },
+
+static const vocabulary_word_t vocabulary_words[] = {
+    // clang-format off
+    CODEC_WORDS(CODEC_WORD)
+    CODEC_ALIASES(CODEC_WORD)
+    COLOR_FORMAT_WORDS(COLOR_FORMAT_WORD)
+    HDR_STATIC_WORDS(HDR_STATIC_WORD)
+    HDR_DYNAMIC_WORDS(HDR_DYNAMIC_WORD)
+    DOLBY_VISION_WORDS(DOLBY_VISION_WORD)
+    DEVICE_TYPE_WORDS(DEVICE_TYPE_WORD)
+    RENDERER_WORDS(RENDERER_WORD)
+    // clang-format on
+};
+
+#define VOCABULARY_WORD_COUNT (sizeof(vocabulary_words) / sizeof(vocabulary_words[0]))
+
+// Open addressing table of indexes into vocabulary_words, at most half full so probes stay short
+#define VOCABULARY_SLOTS 128
+#define VOCABULARY_SLOT_EMPTY 0xFF
+
+typedef char vocabulary_slots_check_t[VOCABULARY_WORD_COUNT * 2 <= VOCABULARY_SLOTS ? 1 : -1];
+
+static uint8_t              vocabulary_slots[VOCABULARY_SLOTS];
+static dlb_lip_tool_once_t vocabulary_once = DLB_LIP_TOOL_ONCE_INIT;
+
+/**********************************************************************
+ *
+ *
+ *  Hash table
+ *
+ *
+ **********************************************************************/
+
+/*!
+FNV-1a hash of the kind and the name.
+
+@return hash
+*/
+static uint32_t hash_word(dlb_lip_vocabulary_kind_t kind, const char *name)
+{
+    uint32_t hash = 2166136261U;
+
+    hash = (hash ^ (uint32_t)kind) * 16777619U;
+    for (const unsigned char *p = (const unsigned char *)name; *p; ++p)
+    {
+        hash = (hash ^ *p) * 16777619U;
+    }
+
+    return hash;
+}
+
+static void build_vocabulary_slots(void)
+{
+    memset(vocabulary_slots, VOCABULARY_SLOT_EMPTY, sizeof(vocabulary_slots));
+    for (unsigned int i = 0; i < VOCABULARY_WORD_COUNT; ++i)
+    {
+        uint32_t slot = hash_word(vocabulary_words[i].kind, vocabulary_words[i].name) % VOCABULARY_SLOTS;
+
+        while (vocabulary_slots[slot] != VOCABULARY_SLOT_EMPTY)
+        {
+            slot = (slot + 1) % VOCABULARY_SLOTS;
+        }
+        vocabulary_slots[slot] = (uint8_t)i;
+    }
+}
+
+void dlb_lip_vocabulary_init(void)
+{
+    dlb_lip_tool_once(&vocabulary_once, build_vocabulary_slots);
+}
+
+int dlb_lip_vocabulary_lookup(dlb_lip_vocabulary_kind_t kind, const char *name)
+{
+    uint32_t slot;
+
+    if (name == NULL || kind >= DLB_LIP_VOCABULARY_KINDS)
+    {
+        return -1;
+    }
+
+    // Built on the first lookup if dlb_lip_vocabulary_init wasn't called
+    dlb_lip_vocabulary_init();
+
+    for (slot = hash_word(kind, name) % VOCABULARY_SLOTS; vocabulary_slots[slot] != VOCABULARY_SLOT_EMPTY;
+         slot = (slot + 1) % VOCABULARY_SLOTS)
+    {
+        const vocabulary_word_t *const p_word = &vocabulary_words[vocabulary_slots[slot]];
+
+        if (p_word->kind == kind && strcmp(p_word->name, name) == 0)
+        {
+            return p_word->value;
+        }
+    }
+
+    return -1;
+}
+
+const char *dlb_lip_vocabulary_name(dlb_lip_vocabulary_kind_t kind, int value)
+{
+    if (kind >= DLB_LIP_VOCABULARY_KINDS || value < 0 || (unsigned int)value >= vocabulary_names[kind].count)
+    {
+        return NULL;
+    }
+
+    return vocabulary_names[kind].names[value];
+}
+
+const char *const *dlb_lip_vocabulary_names(dlb_lip_vocabulary_kind_t kind, unsigned int *p_count)
+{
+    if (kind >= DLB_LIP_VOCABULARY_KINDS)
+    {
+        *p_count = 0;
+        return NULL;
+    }
+
+    *p_count = vocabulary_names[kind].count;
+    return vocabulary_names[kind].names;
+}
+
+dlb_lip_vocabulary_kind_t dlb_lip_vocabulary_hdr_kind(dlb_lip_color_format_type_t color_format)
+{
+    dlb_lip_vocabulary_kind_t kind = DLB_LIP_VOCABULARY_KINDS;
+
+    switch (color_format)
+    {
+    case LIP_COLOR_FORMAT_HDR_STATIC:
+        kind = DLB_LIP_VOCABULARY_HDR_STATIC;
+        break;
+    case LIP_COLOR_FORMAT_HDR_DYNAMIC:
+        kind = DLB_LIP_VOCABULARY_HDR_DYNAMIC;
+        break;
+    case LIP_COLOR_FORMAT_DOLBY_VISION:
+        kind = DLB_LIP_VOCABULARY_DOLBY_VISION;
+        break;
+    default:
+        break;
+    }
+
+    return kind;
+}
@@ -22,8 +22,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
 
+#include "dlb_lip_tool_osa.h"
 #include "dlb_lip_types.h"
+#include "dlb_lip_vocabulary.h"
 #include "dlb_lip_xml_parser.h"
 #include "dlb_xml.h"
 
@@ -43,36 +47,26 @@
  *
  **********************************************************************/
 
-static const struct
-{
-    const dlb_lip_audio_codec_t codec;
-    const char *const           name;
-} codec_names[IEC61937_AUDIO_CODECS] = {
-    { PCM, "PCM" },
-    { IEC61937_AC3, "DD" },
-    { IEC61937_SMPTE_338M, "SMPTE_338M" },
-    { IEC61937_PAUSE_BURST, "PAUSE_BURST" },
-    { IEC61937_MPEG1_L1, "MPEG1_L1" },
-    { IEC61937_MEPG1_L2_L3, "MEPG1_L2_L3" },
-    { IEC61937_MPEG2, "MPEG2" },
-    { IEC61937_MPEG2_AAC, "AAC" },
-    { IEC61937_MPEG2_L1, "MPEG2_L1" },
-    { IEC61937_MPEG2_L2, "MPEG2_L2" },
-    { IEC61937_MPEG2_L3, "MPEG2_L3" },
-    { IEC61937_DTS_TYPE_I, "DTS_TYPE_I" },
-    { IEC61937_DTS_TYPE_II, "DTS_TYPE_II" },
-    { IEC61937_DTS_TYPE_III, "DTS_TYPE_IIII" },
-    { IEC61937_ATRAC, "ATRAC" },
-    { IEC61937_ATRAC_2_3, "ATRAC_2_3" },
-    { IEC61937_ATRAC_X, "ATRAC_X" },
-    { IEC61937_DTS_TYPE_IV, "DTS_TYPE_IV" },
-    { IEC61937_WMA_PRO, "WMA_PRO" },
-    { IEC61937_MPEG2_AAC_LSF, "MPEG2_AAC_LSF" },
-    { IEC61937_MPEG4_AAC, "MPEG4_AAC" },
-    { IEC61937_EAC3, "DDP" },
-    { IEC61937_MAT, "MAT" },
-    { IEC61937_MPEG4, "MPEG4" },
-};
+// Logical addresses CEC allocates to the first device of a type, the values LogicalAddressMap takes
+#define TOPOLOGY_LOGICAL_ADDR_TV 0
+#define TOPOLOGY_LOGICAL_ADDR_PLAYBACK 4
+#define TOPOLOGY_LOGICAL_ADDR_AUDIO 5
+
+/**
+ *  Base or included file parsed with its own base and included files, kept until any of its dependencies changes.
+ *  Every thread keeps its own files, so parsers of different threads don't share state.
+ */
+typedef struct xml_fragment_s
+{
+    char                  path[MAX_XML_PATH];
+    dlb_lip_xml_parser_t *p_parser;
+} xml_fragment_t;
+
+static DLB_LIP_TOOL_THREAD_LOCAL xml_fragment_t xml_fragments[MAX_XML_FRAGMENTS];
+static DLB_LIP_TOOL_THREAD_LOCAL unsigned int   xml_fragment_next = 0; // Entry replaced when all entries are used
+
+static const char *const video_dimension_names[DLB_LIP_LATENCY_TABLE_DIMENSIONS] = { "VIC", "color", "hdr" };
+static const char *const audio_dimension_names[DLB_LIP_LATENCY_TABLE_DIMENSIONS] = { "codec", "subtype", "ext" };
 
 /**********************************************************************
  *
@@ -88,6 +82,12 @@ static int attribute_callback(void *p_context, char *tag, char *attribute, char
 
 static void error_callback(void *p_context, char *msg);
 
+static char *topology_line_callback(void *p_context);
+
+static int topology_element_callback(void *p_context, char *tag, char *text);
+
+static int topology_attribute_callback(void *p_context, char *tag, char *attribute, char *value);
+
 /**********************************************************************
  *
  *  Utils
@@ -96,6 +96,28 @@ static void error_callback(void *p_context, char *msg);
 
 static void clear_xml_cache(dlb_lip_xml_cache_t *p_xml_cache);
 
+static int parse_index_ranges(const char *value, unsigned int min, unsigned int max, dlb_lip_xml_index_ranges_t *p_ranges);
+
+static unsigned int get_index_range_count(const dlb_lip_xml_index_ranges_t *p_ranges);
+
+static void get_index_range(
+    const dlb_lip_xml_index_ranges_t *p_ranges, unsigned int index, uint8_t size, uint8_t *p_first, uint8_t *p_last);
+
+static int collect_overwrites(
+    dlb_lip_xml_diagnostics_t *    p_diag,
+    const dlb_lip_latency_table_t *p_table,
+    const uint8_t                  first[DLB_LIP_LATENCY_TABLE_DIMENSIONS],
+    const uint8_t                  last[DLB_LIP_LATENCY_TABLE_DIMENSIONS],
+    uint8_t                        latency);
+
+static int report_overwrites(dlb_lip_xml_diagnostics_t *p_diag, const char *element, const char *const *dimension_names);
+
+static const dlb_lip_xml_parser_t *get_xml_fragment(dlb_lip_xml_parser_t *p_ctx, const char *file_name);
+
+static int apply_xml_base(dlb_lip_xml_parser_t *p_ctx, const char *file_name);
+
+static int include_xml_fragment(dlb_lip_xml_parser_t *p_ctx, const char *file_name);
+
 static int save_video_latency(dlb_lip_xml_parser_t *p_ctx, char *text);
 
 static int save_audio_latency(dlb_lip_xml_parser_t *p_ctx, char *text);
@@ -112,107 +134,863 @@ static int cache_audio_latency_params(dlb_lip_xml_parser_t *p_ctx, char *attribu
  *
  ***********************************************************************/
 
+void dlb_lip_xml_parser_init(dlb_lip_xml_parser_t *p_parser)
+{
+    p_parser->config_params.downstream_device_addr = DLB_LOGICAL_ADDR_UNKNOWN;
+    p_parser->config_params.audio_transcoding      = false;
+    dlb_lip_latency_table_init(&p_parser->video_latencies, MAX_VICS, LIP_COLOR_FORMAT_COUNT, HDR_MODES_COUNT);
+    dlb_lip_latency_table_init(
+        &p_parser->audio_latencies, IEC61937_AUDIO_CODECS, IEC61937_SUBTYPES, MAX_AUDIO_FORMAT_EXTENSIONS);
+    memset(&p_parser->diagnostics, 0, sizeof(p_parser->diagnostics));
+    p_parser->dependency_count = 0;
+}
+
+void dlb_lip_xml_parser_destroy(dlb_lip_xml_parser_t *p_parser)
+{
+    dlb_lip_latency_table_destroy(&p_parser->video_latencies);
+    dlb_lip_latency_table_destroy(&p_parser->audio_latencies);
+}
+
+int dlb_lip_xml_parser_copy(dlb_lip_xml_parser_t *p_dst, const dlb_lip_xml_parser_t *p_src)
+{
+    *p_dst = *p_src;
+    // Tables of the copy don't share rules with the source
+    dlb_lip_latency_table_init(&p_dst->video_latencies, 0, 0, 0);
+    dlb_lip_latency_table_init(&p_dst->audio_latencies, 0, 0, 0);
+    if (dlb_lip_latency_table_copy(&p_dst->video_latencies, &p_src->video_latencies)
+        || dlb_lip_latency_table_copy(&p_dst->audio_latencies, &p_src->audio_latencies))
+    {
+        dlb_lip_xml_parser_destroy(p_dst);
+        return 1;
+    }
+
+    return 0;
+}
+
+void dlb_lip_xml_parser_expand_latencies(dlb_lip_xml_parser_t *p_parser)
+{
+    dlb_lip_latency_table_expand(&p_parser->video_latencies, &p_parser->config_params.video_latencies[0][0][0]);
+    dlb_lip_latency_table_expand(&p_parser->audio_latencies, &p_parser->config_params.audio_latencies[0][0][0]);
+}
+
+int dlb_lip_xml_dependency_stat(dlb_lip_xml_dependency_t *p_dependency, const char *path)
+{
+    struct stat st;
+
+    if (stat(path, &st) != 0)
+    {
+        return 1;
+    }
+    snprintf(p_dependency->path, sizeof(p_dependency->path), "%s", path);
+#if defined(_MSC_VER)
+    p_dependency->mtime = (int64_t)st.st_mtime * 1000000000;
+#else
+    // Edits within the second of the previous one change only the nanoseconds
+    p_dependency->mtime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    p_dependency->size = (int64_t)st.st_size;
+
+    return 0;
+}
+
 int parse_xml_config_file(dlb_lip_xml_parser_t *p_parser, const char *p_config_file_name)
 {
-    int status            = 0;
-    p_parser->config_file = fopen(p_config_file_name, "r");
+    int status = 0;
+
+    // Taken before the file is read, so a write during parsing makes the recorded file look changed
+    p_parser->dependency_count = dlb_lip_xml_dependency_stat(&p_parser->dependencies[0], p_config_file_name) == 0 ? 1 : 0;
+    p_parser->config_file      = fopen(p_config_file_name, "r");
     if (p_parser->config_file == NULL)
     {
         printf("Couldn't open XML config file[%s]!\n", p_config_file_name);
         return -1;
     }
 
+    snprintf(p_parser->file_name, sizeof(p_parser->file_name), "%s", p_config_file_name);
+    p_parser->diagnostics.line = 0;
     status = dlb_xml_parse2(p_parser, &line_callback, &element_callback, &attribute_callback, &error_callback);
     fclose(p_parser->config_file);
 
     return status;
 }
 
-static void clear_xml_cache(dlb_lip_xml_cache_t *p_xml_cache)
-{
-    p_xml_cache->aud_latency_opened        = false;
-    p_xml_cache->vid_latency_opened        = false;
-    p_xml_cache->video_format.vic          = 0;
-    p_xml_cache->video_format.color_format = LIP_COLOR_FORMAT_COUNT;
-    p_xml_cache->audio_format.codec        = IEC61937_AUDIO_CODECS;
-    p_xml_cache->audio_format.subtype      = IEC61937_SUBTYPES;
-    p_xml_cache->audio_format.ext          = MAX_AUDIO_FORMAT_EXTENSIONS;
+/*!
+Returns index of the topology device with the name, device_count if there is no such device.
+*/
+static unsigned int find_topology_device(const dlb_lip_xml_topology_t *p_topology, const char *name)
+{
+    unsigned int i = 0;
+
+    while (i < p_topology->device_count && strcmp(p_topology->devices[i].name, name) != 0)
+    {
+        i++;
+    }
+    return i;
+}
+
+/*!
+Sets LogicalAddressMap of every linked upstream device to the logical address of its downstream device.
+
+@return 0 on success, 1 if a link names an unknown device or a device has more downstream devices
+*/
+static int resolve_topology_links(dlb_lip_xml_topology_t *p_topology)
+{
+    bool linked[MAX_XML_TOPOLOGY_DEVICES] = { false };
+
+    for (unsigned int i = 0; i < p_topology->link_count; ++i)
+    {
+        const dlb_lip_xml_topology_link_t *const p_link = &p_topology->links[i];
+        const unsigned int                       from   = find_topology_device(p_topology, p_link->from);
+        const unsigned int                       to     = find_topology_device(p_topology, p_link->to);
+        dlb_lip_config_params_t *                p_config;
+
+        if (from == p_topology->device_count || to == p_topology->device_count || from == to)
+        {
+            fprintf(stderr, "ERROR: Invalid Link from \"%s\" to \"%s\" in the topology file!\n", p_link->from, p_link->to);
+            return 1;
+        }
+        if (linked[from])
+        {
+            fprintf(stderr, "ERROR: Device \"%s\" has more than one downstream Link in the topology file!\n", p_link->from);
+            return 1;
+        }
+        linked[from] = true;
+
+        p_config = &p_topology->devices[from].parser.config_params;
+        switch (p_topology->devices[to].parser.device_type)
+        {
+        case LIP_DEVICE_TV:
+            p_config->downstream_device_addr = (dlb_cec_logical_address_t)TOPOLOGY_LOGICAL_ADDR_TV;
+            break;
+        case LIP_DEVICE_STB:
+            p_config->downstream_device_addr = (dlb_cec_logical_address_t)TOPOLOGY_LOGICAL_ADDR_PLAYBACK;
+            break;
+        case LIP_DEVICE_AVR:
+            p_config->downstream_device_addr = (dlb_cec_logical_address_t)TOPOLOGY_LOGICAL_ADDR_AUDIO;
+            break;
+        default:
+            fprintf(stderr, "ERROR: Device \"%s\" of a Link has no DeviceType in the topology file!\n", p_link->to);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int parse_xml_topology_file(dlb_lip_xml_topology_t *p_topology, const char *p_topology_file_name)
+{
+    int status = 0;
+
+    p_topology->config_file = fopen(p_topology_file_name, "r");
+    if (p_topology->config_file == NULL)
+    {
+        printf("Couldn't open XML topology file[%s]!\n", p_topology_file_name);
+        return 1;
+    }
+
+    snprintf(p_topology->file_name, sizeof(p_topology->file_name), "%s", p_topology_file_name);
+    p_topology->line          = 0;
+    p_topology->device_count  = 0;
+    p_topology->device_opened = false;
+    p_topology->link_count    = 0;
+    status                    = dlb_xml_parse2(
+        p_topology, &topology_line_callback, &topology_element_callback, &topology_attribute_callback, &error_callback);
+    fclose(p_topology->config_file);
+    if (status != 0)
+    {
+        return 1;
+    }
+
+    if (p_topology->device_count == 0)
+    {
+        fprintf(stderr, "ERROR: No Device in the topology file!\n");
+        return 1;
+    }
+    if (resolve_topology_links(p_topology))
+    {
+        return 1;
+    }
+    for (unsigned int i = 0; i < p_topology->device_count; ++i)
+    {
+        dlb_lip_xml_parser_expand_latencies(&p_topology->devices[i].parser);
+    }
+
+    return 0;
+}
+
+void dlb_lip_xml_topology_destroy(dlb_lip_xml_topology_t *p_topology)
+{
+    for (unsigned int i = 0; i < p_topology->device_count; ++i)
+    {
+        dlb_lip_xml_parser_destroy(&p_topology->devices[i].parser);
+    }
+    p_topology->device_count = 0;
+}
+
+static void clear_xml_cache(dlb_lip_xml_cache_t *p_xml_cache)
+{
+    p_xml_cache->aud_latency_opened        = false;
+    p_xml_cache->vid_latency_opened        = false;
+    p_xml_cache->video_format.vic          = 0;
+    p_xml_cache->video_format.color_format = LIP_COLOR_FORMAT_COUNT;
+    p_xml_cache->audio_format.codec        = IEC61937_AUDIO_CODECS;
+    p_xml_cache->audio_format.subtype      = IEC61937_SUBTYPES;
+    p_xml_cache->audio_format.ext          = MAX_AUDIO_FORMAT_EXTENSIONS;
+    p_xml_cache->vic_ranges.count          = 0;
+    p_xml_cache->subtype_ranges.count      = 0;
+    p_xml_cache->ext_ranges.count          = 0;
+}
+
+/*!
+Parses list of indexes and index ranges of an attribute into sorted, non-overlapping ranges.
+
+@return 0 on success, 1 if the list is invalid, empty or has more than MAX_XML_INDEX_RANGES ranges
+*/
+static int parse_index_ranges(const char *value, unsigned int min, unsigned int max, dlb_lip_xml_index_ranges_t *p_ranges)
+{
+    bool mask[UINT8_MAX + 1];
+
+    p_ranges->count = 0;
+    if (max > UINT8_MAX + 1U || parse_index_list(value, min, max, mask))
+    {
+        return 1;
+    }
+
+    // Runs of the mask, so overlapping and adjacent ranges of the list become one range
+    for (unsigned int i = min; i < max;)
+    {
+        if (!mask[i])
+        {
+            i++;
+            continue;
+        }
+        if (p_ranges->count == MAX_XML_INDEX_RANGES)
+        {
+            return 1;
+        }
+        p_ranges->first[p_ranges->count] = (uint8_t)i;
+        while (i < max && mask[i])
+        {
+            i++;
+        }
+        p_ranges->last[p_ranges->count] = (uint8_t)(i - 1U);
+        p_ranges->count += 1;
+    }
+
+    return p_ranges->count == 0;
+}
+
+/*!
+Returns number of ranges of the attribute, 1(the whole dimension) if the attribute is not given.
+*/
+static unsigned int get_index_range_count(const dlb_lip_xml_index_ranges_t *p_ranges)
+{
+    return p_ranges->count ? p_ranges->count : 1U;
+}
+
+/*!
+Returns index range of the attribute, the whole dimension of given size if the attribute is not given.
+*/
+static void get_index_range(
+    const dlb_lip_xml_index_ranges_t *p_ranges, unsigned int index, uint8_t size, uint8_t *p_first, uint8_t *p_last)
+{
+    if (p_ranges->count == 0)
+    {
+        *p_first = 0;
+        *p_last  = (uint8_t)(size - 1U);
+    }
+    else
+    {
+        *p_first = p_ranges->first[index];
+        *p_last  = p_ranges->last[index];
+    }
+}
+
+/*!
+Records the overwritten block of cells in the entry of its old value, values not fitting in the entries are only counted.
+*/
+static void record_overwrite(
+    dlb_lip_xml_diagnostics_t *p_diag,
+    uint8_t                    old_latency,
+    const uint8_t              first[DLB_LIP_LATENCY_TABLE_DIMENSIONS],
+    const uint8_t              last[DLB_LIP_LATENCY_TABLE_DIMENSIONS])
+{
+    dlb_lip_xml_overwrite_t *p_overwrite = NULL;
+    unsigned int             cells       = 1;
+
+    for (unsigned int d = 0; d < DLB_LIP_LATENCY_TABLE_DIMENSIONS; ++d)
+    {
+        cells *= last[d] - first[d] + 1U;
+    }
+
+    for (unsigned int i = 0; i < p_diag->overwrite_count && p_overwrite == NULL; ++i)
+    {
+        if (p_diag->overwrites[i].latency == old_latency)
+        {
+            p_overwrite = &p_diag->overwrites[i];
+        }
+    }
+    if (p_overwrite == NULL)
+    {
+        if (p_diag->overwrite_count == MAX_XML_OVERWRITES)
+        {
+            p_diag->other_cells += cells;
+            return;
+        }
+        p_overwrite          = &p_diag->overwrites[p_diag->overwrite_count++];
+        p_overwrite->latency = old_latency;
+        p_overwrite->cells   = 0;
+        memcpy(p_overwrite->first, first, sizeof(p_overwrite->first));
+        memcpy(p_overwrite->last, last, sizeof(p_overwrite->last));
+    }
+
+    for (unsigned int d = 0; d < DLB_LIP_LATENCY_TABLE_DIMENSIONS; ++d)
+    {
+        p_overwrite->first[d] = first[d] < p_overwrite->first[d] ? first[d] : p_overwrite->first[d];
+        p_overwrite->last[d]  = last[d] > p_overwrite->last[d] ? last[d] : p_overwrite->last[d];
+    }
+    p_overwrite->cells += cells;
+}
+
+/**
+ *  Part of the block of a latency element not covered yet by the rules looked at
+ */
+typedef struct xml_box_s
+{
+    uint8_t first[DLB_LIP_LATENCY_TABLE_DIMENSIONS];
+    uint8_t last[DLB_LIP_LATENCY_TABLE_DIMENSIONS];
+} xml_box_t;
+
+typedef struct xml_boxes_s
+{
+    xml_box_t *  boxes;
+    unsigned int count;
+    unsigned int capacity;
+} xml_boxes_t;
+
+static int push_xml_box(xml_boxes_t *p_boxes, const xml_box_t *p_box)
+{
+    if (p_boxes->count == p_boxes->capacity)
+    {
+        const unsigned int capacity = p_boxes->capacity ? p_boxes->capacity * 2U : 16U;
+        xml_box_t *const   boxes    = (xml_box_t *)realloc(p_boxes->boxes, capacity * sizeof(xml_box_t));
+
+        if (boxes == NULL)
+        {
+            return 1;
+        }
+        p_boxes->boxes    = boxes;
+        p_boxes->capacity = capacity;
+    }
+    p_boxes->boxes[p_boxes->count++] = *p_box;
+
+    return 0;
+}
+
+static bool xml_box_intersects(const xml_box_t *p_box, const dlb_lip_latency_rule_t *p_rule)
+{
+    for (unsigned int d = 0; d < DLB_LIP_LATENCY_TABLE_DIMENSIONS; ++d)
+    {
+        if (p_box->last[d] < p_rule->first[d] || p_box->first[d] > p_rule->last[d])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+Splits the parts of the box outside the rule off to the uncovered boxes, the box is clipped to the rule.
+
+@return 0 on success, 1 if memory couldn't be allocated
+*/
+static int split_xml_box(xml_box_t *p_box, const dlb_lip_latency_rule_t *p_rule, xml_boxes_t *p_uncovered)
+{
+    for (unsigned int d = 0; d < DLB_LIP_LATENCY_TABLE_DIMENSIONS; ++d)
+    {
+        xml_box_t part = *p_box;
+
+        if (p_box->first[d] < p_rule->first[d])
+        {
+            part.last[d] = (uint8_t)(p_rule->first[d] - 1U);
+            if (push_xml_box(p_uncovered, &part))
+            {
+                return 1;
+            }
+            p_box->first[d] = p_rule->first[d];
+        }
+        part = *p_box;
+        if (p_box->last[d] > p_rule->last[d])
+        {
+            part.first[d] = (uint8_t)(p_rule->last[d] + 1U);
+            if (push_xml_box(p_uncovered, &part))
+            {
+                return 1;
+            }
+            p_box->last[d] = p_rule->last[d];
+        }
+    }
+
+    return 0;
+}
+
+typedef struct xml_dense_overwrites_s
+{
+    dlb_lip_xml_diagnostics_t *p_diag;
+    xml_box_t                  block;
+    uint8_t                    latency;
+} xml_dense_overwrites_t;
+
+static int collect_dense_overwrite(void *arg, const dlb_lip_latency_rule_t *p_rule)
+{
+    xml_dense_overwrites_t *const p_dense = (xml_dense_overwrites_t *)arg;
+    xml_box_t                     box     = p_dense->block;
+
+    if (p_rule->latency != p_dense->latency && p_rule->latency != LIP_INVALID_LATENCY && xml_box_intersects(&box, p_rule))
+    {
+        for (unsigned int d = 0; d < DLB_LIP_LATENCY_TABLE_DIMENSIONS; ++d)
+        {
+            box.first[d] = box.first[d] > p_rule->first[d] ? box.first[d] : p_rule->first[d];
+            box.last[d]  = box.last[d] < p_rule->last[d] ? box.last[d] : p_rule->last[d];
+        }
+        record_overwrite(p_dense->p_diag, p_rule->latency, box.first, box.last);
+    }
+    return 0;
+}
+
+/*!
+Collects cells of the block which hold a different latency set by earlier rules of the table. Rules are looked at
+from the last one, every rule takes the part of the block not covered by later rules, so the work depends on
+the rules intersecting the block, not on its cells. Rules of a dense table are runs of its cells, which don't overlap.
+
+@return 0 on success, 1 if memory couldn't be allocated
+*/
+static int collect_overwrites(
+    dlb_lip_xml_diagnostics_t *    p_diag,
+    const dlb_lip_latency_table_t *p_table,
+    const uint8_t                  first[DLB_LIP_LATENCY_TABLE_DIMENSIONS],
+    const uint8_t                  last[DLB_LIP_LATENCY_TABLE_DIMENSIONS],
+    uint8_t                        latency)
+{
+    xml_boxes_t uncovered = { NULL, 0, 0 };
+    xml_boxes_t next      = { NULL, 0, 0 };
+    xml_box_t   block;
+    int         ret = 0;
+
+    if (!dlb_lip_latency_table_intersects(p_table, first, last))
+    {
+        return 0;
+    }
+    memcpy(block.first, first, sizeof(block.first));
+    memcpy(block.last, last, sizeof(block.last));
+
+    if (p_table->dense)
+    {
+        xml_dense_overwrites_t dense = { p_diag, block, latency };
+
+        return dlb_lip_latency_table_for_each_rule(p_table, collect_dense_overwrite, &dense);
+    }
+
+    ret = push_xml_box(&uncovered, &block);
+    for (unsigned int i = p_table->rule_count; i > 0 && uncovered.count > 0 && ret == 0; --i)
+    {
+        const dlb_lip_latency_rule_t *const p_rule = &p_table->rules[i - 1];
+        xml_boxes_t                         swap;
+
+        next.count = 0;
+        for (unsigned int b = 0; b < uncovered.count && ret == 0; ++b)
+        {
+            xml_box_t box = uncovered.boxes[b];
+
+            if (!xml_box_intersects(&box, p_rule))
+            {
+                ret = push_xml_box(&next, &box);
+            }
+            else if ((ret = split_xml_box(&box, p_rule, &next)) == 0 && p_rule->latency != latency
+                     && p_rule->latency != LIP_INVALID_LATENCY)
+            {
+                record_overwrite(p_diag, p_rule->latency, box.first, box.last);
+            }
+        }
+        swap      = uncovered;
+        uncovered = next;
+        next      = swap;
+    }
+    free(uncovered.boxes);
+    free(next.boxes);
+
+    return ret;
+}
+
+/*!
+Prints one line for all overwrites collected for the closed latency or Include element and clears them.
+
+@return 1 if the element overwrote earlier latencies and overwrites are errors, 0 otherwise
+*/
+static int report_overwrites(dlb_lip_xml_diagnostics_t *p_diag, const char *element, const char *const *dimension_names)
+{
+    char         summary[MAX_XML_LINE];
+    int          length = 0;
+    unsigned int cells  = p_diag->other_cells;
+
+    if (p_diag->overwrite_count == 0 && p_diag->other_cells == 0)
+    {
+        return 0;
+    }
+
+    for (unsigned int i = 0; i < p_diag->overwrite_count; ++i)
+    {
+        cells += p_diag->overwrites[i].cells;
+    }
+    length = snprintf(
+        summary,
+        sizeof(summary),
+        "%s: line %u: %s overwrites %u cells:",
+        p_diag->fail_on_overwrite ? "ERROR" : "WARNING",
+        p_diag->line,
+        element,
+        cells);
+
+    for (unsigned int i = 0; i < p_diag->overwrite_count && length < (int)sizeof(summary); ++i)
+    {
+        const dlb_lip_xml_overwrite_t *const p_overwrite = &p_diag->overwrites[i];
+
+        length += snprintf(summary + length, sizeof(summary) - length, " %d(", p_overwrite->latency);
+        for (unsigned int d = 0; d < DLB_LIP_LATENCY_TABLE_DIMENSIONS && length < (int)sizeof(summary); ++d)
+        {
+            if (p_overwrite->first[d] == p_overwrite->last[d])
+            {
+                length += snprintf(
+                    summary + length, sizeof(summary) - length, "%s %d ", dimension_names[d], p_overwrite->first[d]);
+            }
+            else
+            {
+                length += snprintf(
+                    summary + length,
+                    sizeof(summary) - length,
+                    "%s %d-%d ",
+                    dimension_names[d],
+                    p_overwrite->first[d],
+                    p_overwrite->last[d]);
+            }
+        }
+        if (length < (int)sizeof(summary))
+        {
+            length += snprintf(summary + length, sizeof(summary) - length, "in %u cells)", p_overwrite->cells);
+        }
+    }
+    if (p_diag->other_cells > 0 && length < (int)sizeof(summary))
+    {
+        snprintf(summary + length, sizeof(summary) - length, " other values(in %u cells)", p_diag->other_cells);
+    }
+    if (p_diag->first_overwrite[0] == '\0')
+    {
+        snprintf(
+            p_diag->first_overwrite, sizeof(p_diag->first_overwrite), "%.*s", (int)sizeof(p_diag->first_overwrite) - 1, summary);
+    }
+    if (!p_diag->quiet)
+    {
+        fprintf(stderr, "%s\n", summary);
+    }
+
+    p_diag->overwrite_elements += 1;
+    p_diag->overwritten_cells += cells;
+    p_diag->overwrite_count = 0;
+    p_diag->other_cells     = 0;
+
+    return p_diag->fail_on_overwrite ? 1 : 0;
+}
+
+/*!
+Checks if any file the parsed file depends on was modified or removed since it was parsed.
+*/
+static bool xml_dependencies_changed(const dlb_lip_xml_parser_t *p_parser)
+{
+    for (unsigned int i = 0; i < p_parser->dependency_count; ++i)
+    {
+        const dlb_lip_xml_dependency_t *const p_dependency = &p_parser->dependencies[i];
+        dlb_lip_xml_dependency_t              current;
+
+        if (dlb_lip_xml_dependency_stat(&current, p_dependency->path) != 0 || current.mtime != p_dependency->mtime
+            || current.size != p_dependency->size)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*!
+Adds dependencies of the base or included file to the dependencies of the file being parsed.
+
+@return 0 on success, 1 if there are too many dependencies
+*/
+static int add_xml_dependencies(dlb_lip_xml_parser_t *p_ctx, const dlb_lip_xml_parser_t *p_fragment)
+{
+    for (unsigned int i = 0; i < p_fragment->dependency_count; ++i)
+    {
+        const dlb_lip_xml_dependency_t *const p_dependency = &p_fragment->dependencies[i];
+        bool                                  known        = false;
+
+        for (unsigned int j = 0; j < p_ctx->dependency_count && !known; ++j)
+        {
+            known = strcmp(p_ctx->dependencies[j].path, p_dependency->path) == 0;
+        }
+        if (known)
+        {
+            continue;
+        }
+        if (p_ctx->dependency_count == MAX_XML_DEPENDENCIES)
+        {
+            fprintf(stderr, "ERROR: Too many base and included XML files[%s]!\n", p_dependency->path);
+            return 1;
+        }
+        p_ctx->dependencies[p_ctx->dependency_count++] = *p_dependency;
+    }
+
+    return 0;
+}
+
+/*!
+Returns parsed base or included file, the file is parsed if it isn't kept yet or it or any of its own base and
+included files changed since it was parsed. Dependencies of the file are added to the file being parsed.
+Relative file name is relative to the directory of the file being parsed.
+
+@return parsed file, valid until the next call, NULL on error
+*/
+static const dlb_lip_xml_parser_t *get_xml_fragment(dlb_lip_xml_parser_t *p_ctx, const char *file_name)
+{
+    const char *const     separator = strrchr(p_ctx->file_name, '/');
+    char                  path[MAX_XML_PATH];
+    struct stat           st;
+    xml_fragment_t *      p_fragment = NULL;
+    dlb_lip_xml_parser_t *p_parser   = NULL;
+
+    if (file_name[0] == '/' || separator == NULL)
+    {
+        snprintf(path, sizeof(path), "%s", file_name);
+    }
+    else
+    {
+        snprintf(path, sizeof(path), "%.*s/%s", (int)(separator - p_ctx->file_name), p_ctx->file_name, file_name);
+    }
+
+    for (unsigned int i = 0; i < MAX_XML_FRAGMENTS && p_fragment == NULL; ++i)
+    {
+        if (xml_fragments[i].p_parser != NULL && strcmp(xml_fragments[i].path, path) == 0)
+        {
+            p_fragment = &xml_fragments[i];
+        }
+    }
+    if (p_fragment != NULL && !xml_dependencies_changed(p_fragment->p_parser))
+    {
+        return add_xml_dependencies(p_ctx, p_fragment->p_parser) == 0 ? p_fragment->p_parser : NULL;
+    }
+
+    if (stat(path, &st) != 0)
+    {
+        fprintf(stderr, "ERROR: Couldn't open included XML file[%s]!\n", path);
+        return NULL;
+    }
+
+    if (p_ctx->include_depth == MAX_XML_INCLUDE_DEPTH)
+    {
+        fprintf(stderr, "ERROR: Included XML files nested too deep[%s]!\n", path);
+        return NULL;
+    }
+    p_parser = (dlb_lip_xml_parser_t *)calloc(1, sizeof(dlb_lip_xml_parser_t));
+    if (p_parser == NULL)
+    {
+        return NULL;
+    }
+    dlb_lip_xml_parser_init(p_parser);
+    p_parser->include_depth                 = p_ctx->include_depth + 1;
+    p_parser->diagnostics.fail_on_overwrite = p_ctx->diagnostics.fail_on_overwrite;
+    p_parser->diagnostics.quiet             = p_ctx->diagnostics.quiet;
+    if (parse_xml_config_file(p_parser, path) != 0)
+    {
+        dlb_lip_xml_parser_destroy(p_parser);
+        free(p_parser);
+        return NULL;
+    }
+
+    // Files included by the file may have used the entry found above
+    p_fragment = NULL;
+    for (unsigned int i = 0; i < MAX_XML_FRAGMENTS && p_fragment == NULL; ++i)
+    {
+        if (xml_fragments[i].p_parser == NULL || strcmp(xml_fragments[i].path, path) == 0)
+        {
+            p_fragment = &xml_fragments[i];
+        }
+    }
+    if (p_fragment == NULL)
+    {
+        p_fragment        = &xml_fragments[xml_fragment_next];
+        xml_fragment_next = (xml_fragment_next + 1U) % MAX_XML_FRAGMENTS;
+    }
+    if (p_fragment->p_parser != NULL)
+    {
+        dlb_lip_xml_parser_destroy(p_fragment->p_parser);
+        free(p_fragment->p_parser);
+    }
+    snprintf(p_fragment->path, sizeof(p_fragment->path), "%s", path);
+    p_fragment->p_parser = p_parser;
+
+    return add_xml_dependencies(p_ctx, p_parser) == 0 ? p_parser : NULL;
+}
+
+void dlb_lip_xml_fragments_clear(void)
+{
+    for (unsigned int i = 0; i < MAX_XML_FRAGMENTS; ++i)
+    {
+        if (xml_fragments[i].p_parser != NULL)
+        {
+            dlb_lip_xml_parser_destroy(xml_fragments[i].p_parser);
+            free(xml_fragments[i].p_parser);
+            xml_fragments[i].p_parser = NULL;
+        }
+    }
+    xml_fragment_next = 0;
+}
+
+/*!
+Starts the config from DeviceParams and latencies of the base file.
+
+@return 0 on success, 1 on error
+*/
+static int apply_xml_base(dlb_lip_xml_parser_t *p_ctx, const char *file_name)
+{
+    const dlb_lip_xml_parser_t *const p_base = get_xml_fragment(p_ctx, file_name);
+
+    if (p_base == NULL)
+    {
+        return 1;
+    }
+
+    if (dlb_lip_latency_table_copy(&p_ctx->video_latencies, &p_base->video_latencies)
+        || dlb_lip_latency_table_copy(&p_ctx->audio_latencies, &p_base->audio_latencies))
+    {
+        fprintf(stderr, "ERROR: Out of memory for latencies of the base XML file!\n");
+        return 1;
+    }
+    p_ctx->config_params    = p_base->config_params;
+    p_ctx->physical_address = p_base->physical_address;
+    p_ctx->device_type      = p_base->device_type;
+
+    return 0;
+}
+
+typedef struct latency_rules_append_s
+{
+    dlb_lip_xml_diagnostics_t *p_diag;
+    dlb_lip_latency_table_t *  p_table;
+} latency_rules_append_t;
+
+static int append_latency_rule(void *arg, const dlb_lip_latency_rule_t *p_rule)
+{
+    latency_rules_append_t *const p_append = (latency_rules_append_t *)arg;
+
+    if (collect_overwrites(p_append->p_diag, p_append->p_table, p_rule->first, p_rule->last, p_rule->latency))
+    {
+        return 1;
+    }
+    return dlb_lip_latency_table_set(p_append->p_table, p_rule->first, p_rule->last, p_rule->latency);
+}
+
+/*!
+Adds latency rules of the table to the end of the destination table, the table is copied if the destination is empty.
+
+@return 0 on success, 1 if the tables have different dimensions or memory couldn't be allocated
+*/
+static int append_latency_rules(
+    dlb_lip_xml_diagnostics_t *p_diag, dlb_lip_latency_table_t *p_table, const dlb_lip_latency_table_t *p_rules)
+{
+    latency_rules_append_t append = { p_diag, p_table };
+
+    if (p_table->rule_count == 0 && !p_table->dense)
+    {
+        return dlb_lip_latency_table_copy(p_table, p_rules);
+    }
+
+    return dlb_lip_latency_table_for_each_rule(p_rules, append_latency_rule, &append);
+}
+
+/*!
+Adds latencies of the included file at the position of the Include element.
+
+@return 0 on success, 1 on error
+*/
+static int include_xml_fragment(dlb_lip_xml_parser_t *p_ctx, const char *file_name)
+{
+    const dlb_lip_xml_parser_t *const p_fragment = get_xml_fragment(p_ctx, file_name);
+    char                              element[MAX_XML_PATH + 32];
+
+    if (p_fragment == NULL)
+    {
+        return 1;
+    }
+
+    if (append_latency_rules(&p_ctx->diagnostics, &p_ctx->video_latencies, &p_fragment->video_latencies))
+    {
+        fprintf(stderr, "ERROR: Invalid video latencies in the included XML file!\n");
+        return 1;
+    }
+    snprintf(element, sizeof(element), "Include %s video latencies", file_name);
+    if (report_overwrites(&p_ctx->diagnostics, element, video_dimension_names))
+    {
+        return 1;
+    }
+
+    if (append_latency_rules(&p_ctx->diagnostics, &p_ctx->audio_latencies, &p_fragment->audio_latencies))
+    {
+        fprintf(stderr, "ERROR: Invalid audio latencies in the included XML file!\n");
+        return 1;
+    }
+    snprintf(element, sizeof(element), "Include %s audio latencies", file_name);
+    return report_overwrites(&p_ctx->diagnostics, element, audio_dimension_names);
 }
 
 static int save_video_latency(dlb_lip_xml_parser_t *p_ctx, char *text)
 {
     if (p_ctx->xml_cache.vid_latency_opened)
     {
-        uint8_t                     VIC          = p_ctx->xml_cache.video_format.vic;
         dlb_lip_color_format_type_t color_format = p_ctx->xml_cache.video_format.color_format;
         uint8_t                     hdr_mode     = color_format != LIP_COLOR_FORMAT_COUNT
                                ? dlb_lip_get_hdr_mode_from_video_format(p_ctx->xml_cache.video_format)
                                : HDR_MODES_COUNT;
 
-        uint8_t vid_latency     = (uint8_t)strtoul(text, NULL, 10);
-        uint8_t old_vid_latency = 0;
+        uint8_t vid_latency = (uint8_t)strtoul(text, NULL, 10);
+        char    element[32];
 
         if (vid_latency > 0 && vid_latency < LIP_INVALID_LATENCY)
         {
-            // all parameters provided, save given latency
-            if ((VIC != 0) && (color_format != LIP_COLOR_FORMAT_COUNT) && (hdr_mode != HDR_MODES_COUNT))
-            {
-                old_vid_latency = p_ctx->config_params.video_latencies[VIC][color_format][hdr_mode];
-                if (LIP_INVALID_LATENCY != old_vid_latency)
-                {
-                    fprintf(stderr, "WARNING: Overwriting video latency value: %d with: %d!\n", old_vid_latency, vid_latency);
-                }
+            // Parameters which are not provided select all their values, every VIC range is one block
+            uint8_t first[DLB_LIP_LATENCY_TABLE_DIMENSIONS] = {
+                0,
+                color_format != LIP_COLOR_FORMAT_COUNT ? (uint8_t)color_format : 0,
+                hdr_mode != HDR_MODES_COUNT ? hdr_mode : 0,
+            };
+            uint8_t last[DLB_LIP_LATENCY_TABLE_DIMENSIONS] = {
+                MAX_VICS - 1,
+                color_format != LIP_COLOR_FORMAT_COUNT ? (uint8_t)color_format : LIP_COLOR_FORMAT_COUNT - 1,
+                hdr_mode != HDR_MODES_COUNT ? hdr_mode : HDR_MODES_COUNT - 1,
+            };
 
-                p_ctx->config_params.video_latencies[VIC][color_format][hdr_mode] = vid_latency;
-            }
-            // only VIC provided, save given latency for all color_formats and hdr_modes
-            else if ((VIC != 0) && (color_format == LIP_COLOR_FORMAT_COUNT) && (hdr_mode == HDR_MODES_COUNT))
-            {
-                for (uint8_t proc_idx = 0; proc_idx < LIP_COLOR_FORMAT_COUNT; proc_idx++)
-                {
-                    for (uint8_t hdr_idx = 0; hdr_idx < HDR_MODES_COUNT; hdr_idx++)
-                    {
-                        old_vid_latency = p_ctx->config_params.video_latencies[VIC][proc_idx][hdr_idx];
-                        if (LIP_INVALID_LATENCY != old_vid_latency)
-                        {
-                            fprintf(
-                                stderr, "WARNING: Overwriting video latency value: %d with: %d!\n", old_vid_latency, vid_latency);
-                        }
-                        p_ctx->config_params.video_latencies[VIC][proc_idx][hdr_idx] = vid_latency;
-                    }
-                }
-            }
-            // VIC and color_format mode provided, save given latency for all hdr_modes
-            else if ((VIC != 0) && (color_format != LIP_COLOR_FORMAT_COUNT) && (hdr_mode == HDR_MODES_COUNT))
+            for (unsigned int v = 0; v < get_index_range_count(&p_ctx->xml_cache.vic_ranges); ++v)
             {
-                for (uint8_t hdr_idx = 0; hdr_idx < HDR_MODES_COUNT; hdr_idx++)
+                get_index_range(&p_ctx->xml_cache.vic_ranges, v, MAX_VICS, &first[0], &last[0]);
+                if (collect_overwrites(&p_ctx->diagnostics, &p_ctx->video_latencies, first, last, vid_latency)
+                    || dlb_lip_latency_table_set(&p_ctx->video_latencies, first, last, vid_latency))
                 {
-                    old_vid_latency = p_ctx->config_params.video_latencies[VIC][color_format][hdr_idx];
-                    if (LIP_INVALID_LATENCY != old_vid_latency)
-                    {
-                        fprintf(stderr, "WARNING: Overwriting video latency value: %d with: %d!\n", old_vid_latency, vid_latency);
-                    }
-
-                    p_ctx->config_params.video_latencies[VIC][color_format][hdr_idx] = vid_latency;
+                    fprintf(stderr, "ERROR: Invalid video latency range in the input XML file!\n");
+                    return 1;
                 }
             }
-            // no VIC provided (or couple other permutations), save given latency for all VICs, processing and latency modes
-            else
+            snprintf(element, sizeof(element), "VidLatency %d", vid_latency);
+            if (report_overwrites(&p_ctx->diagnostics, element, video_dimension_names))
             {
-                for (uint8_t vic_idx = 0; vic_idx < MAX_VICS; vic_idx++)
-                {
-                    for (uint8_t color_idx = 0; color_idx < LIP_COLOR_FORMAT_COUNT; color_idx++)
-                    {
-                        old_vid_latency = p_ctx->config_params.video_latencies[vic_idx][color_idx][hdr_mode];
-                        if (LIP_INVALID_LATENCY != old_vid_latency)
-                        {
-                            fprintf(
-                                stderr, "WARNING: Overwriting video latency value: %d with: %d!\n", old_vid_latency, vid_latency);
-                        }
-
-                        p_ctx->config_params.video_latencies[vic_idx][color_idx][hdr_mode] = vid_latency;
-                    }
-                }
+                return 1;
             }
         }
         else
@@ -233,88 +1011,45 @@ static int save_video_latency(dlb_lip_xml_parser_t *p_ctx, char *text)
 
 static int save_audio_latency(dlb_lip_xml_parser_t *p_ctx, char *text)
 {
-    // TODO handle extension
     if (p_ctx->xml_cache.aud_latency_opened)
     {
         dlb_lip_audio_format_t audio_format = p_ctx->xml_cache.audio_format;
 
-        uint8_t aud_latency     = (uint8_t)strtoul(text, NULL, 10);
-        uint8_t old_aud_latency = 0;
+        uint8_t aud_latency = (uint8_t)strtoul(text, NULL, 10);
+        char    element[32];
 
         if (aud_latency > 0 && aud_latency < LIP_INVALID_LATENCY)
         {
-            // all parameters provided, save given latency
-            if ((audio_format.codec != IEC61937_AUDIO_CODECS) && (audio_format.subtype != IEC61937_SUBTYPES)
-                && (audio_format.ext != MAX_AUDIO_FORMAT_EXTENSIONS))
-            {
-                old_aud_latency = p_ctx->config_params.audio_latencies[audio_format.codec][audio_format.subtype][audio_format.ext];
-                if (LIP_INVALID_LATENCY != old_aud_latency)
-                {
-                    fprintf(stderr, "WARNING: Overwriting audio latency value: %d with: %d!\n", old_aud_latency, aud_latency);
-                }
+            // Parameters which are not provided select all their values, every subtype and ext range pair is one block
+            uint8_t first[DLB_LIP_LATENCY_TABLE_DIMENSIONS] = {
+                audio_format.codec != IEC61937_AUDIO_CODECS ? (uint8_t)audio_format.codec : 0,
+                0,
+                0,
+            };
+            uint8_t last[DLB_LIP_LATENCY_TABLE_DIMENSIONS] = {
+                audio_format.codec != IEC61937_AUDIO_CODECS ? (uint8_t)audio_format.codec : IEC61937_AUDIO_CODECS - 1,
+                IEC61937_SUBTYPES - 1,
+                MAX_AUDIO_FORMAT_EXTENSIONS - 1,
+            };
 
-                p_ctx->config_params.audio_latencies[audio_format.codec][audio_format.subtype][audio_format.ext] = aud_latency;
-            }
-            // only audio format provided, save given latency for all latency modes
-            else if (
-                (audio_format.codec != IEC61937_AUDIO_CODECS)
-                && (audio_format.subtype == IEC61937_SUBTYPES && audio_format.ext == MAX_AUDIO_FORMAT_EXTENSIONS))
-            {
-                for (unsigned int subtype_idx = 0; subtype_idx < IEC61937_SUBTYPES; subtype_idx++)
-                {
-                    for (unsigned int extension_idx = 0; extension_idx < MAX_AUDIO_FORMAT_EXTENSIONS; extension_idx++)
-                    {
-                        old_aud_latency = p_ctx->config_params.audio_latencies[audio_format.codec][subtype_idx][extension_idx];
-                        if (LIP_INVALID_LATENCY != old_aud_latency)
-                        {
-                            fprintf(
-                                stderr, "WARNING: Overwriting audio latency value: %d with: %d!\n", old_aud_latency, aud_latency);
-                        }
-
-                        p_ctx->config_params.audio_latencies[audio_format.codec][subtype_idx][extension_idx] = aud_latency;
-                    }
-                }
-            }
-            // audio format provided and subtype provided, save given latency for ext
-            else if (
-                (audio_format.codec != IEC61937_AUDIO_CODECS) && (audio_format.subtype != IEC61937_SUBTYPES)
-                && (audio_format.ext == MAX_AUDIO_FORMAT_EXTENSIONS))
+            for (unsigned int st = 0; st < get_index_range_count(&p_ctx->xml_cache.subtype_ranges); ++st)
             {
-                for (unsigned int extension_idx = 0; extension_idx < MAX_AUDIO_FORMAT_EXTENSIONS; extension_idx++)
+                get_index_range(&p_ctx->xml_cache.subtype_ranges, st, IEC61937_SUBTYPES, &first[1], &last[1]);
+                for (unsigned int e = 0; e < get_index_range_count(&p_ctx->xml_cache.ext_ranges); ++e)
                 {
-                    old_aud_latency = p_ctx->config_params.audio_latencies[audio_format.codec][audio_format.subtype][extension_idx];
-                    if (LIP_INVALID_LATENCY != old_aud_latency)
+                    get_index_range(&p_ctx->xml_cache.ext_ranges, e, MAX_AUDIO_FORMAT_EXTENSIONS, &first[2], &last[2]);
+                    if (collect_overwrites(&p_ctx->diagnostics, &p_ctx->audio_latencies, first, last, aud_latency)
+                        || dlb_lip_latency_table_set(&p_ctx->audio_latencies, first, last, aud_latency))
                     {
-                        fprintf(stderr, "WARNING: Overwriting audio latency value: %d with: %d!\n", old_aud_latency, aud_latency);
+                        fprintf(stderr, "ERROR: Invalid audio latency range in the input XML file!\n");
+                        return 1;
                     }
-
-                    p_ctx->config_params.audio_latencies[audio_format.codec][audio_format.subtype][extension_idx] = aud_latency;
                 }
             }
-            // only latency mode provided, save given latency for all audio formats
-            else if (
-                (audio_format.codec == IEC61937_AUDIO_CODECS) && (audio_format.subtype == IEC61937_SUBTYPES)
-                && (audio_format.ext == MAX_AUDIO_FORMAT_EXTENSIONS))
+            snprintf(element, sizeof(element), "AudLatency %d", aud_latency);
+            if (report_overwrites(&p_ctx->diagnostics, element, audio_dimension_names))
             {
-                for (uint8_t aud_frmt_idx = 0; aud_frmt_idx < IEC61937_AUDIO_CODECS; aud_frmt_idx++)
-                {
-                    for (unsigned int subtype_idx = 0; subtype_idx < IEC61937_SUBTYPES; subtype_idx++)
-                    {
-                        for (unsigned int extension_idx = 0; extension_idx < MAX_AUDIO_FORMAT_EXTENSIONS; extension_idx++)
-                        {
-                            old_aud_latency = p_ctx->config_params.audio_latencies[aud_frmt_idx][subtype_idx][extension_idx];
-                            if (LIP_INVALID_LATENCY != old_aud_latency)
-                            {
-                                fprintf(
-                                    stderr,
-                                    "WARNING: Overwriting audio latency value: %d with: %d!\n",
-                                    old_aud_latency,
-                                    aud_latency);
-                            }
-                            p_ctx->config_params.audio_latencies[aud_frmt_idx][subtype_idx][extension_idx] = aud_latency;
-                        }
-                    }
-                }
+                return 1;
             }
         }
         else
@@ -333,105 +1068,62 @@ static int save_audio_latency(dlb_lip_xml_parser_t *p_ctx, char *text)
     return 0;
 }
 
-static int cache_video_latency_params(dlb_lip_xml_parser_t *p_ctx, char *attribute, char *value)
+/*!
+Sets hdr mode of the cached color format, -1 sets the count of hdr modes of the color format.
+*/
+static void set_cached_hdr_mode(dlb_lip_video_format_t *p_format, int hdr_mode)
 {
-    if (!strncmp(attribute, "VIC", strlen("VIC")))
+    switch (p_format->color_format)
     {
-        p_ctx->xml_cache.video_format.vic = (uint8_t)strtoul(value, NULL, 10);
+    case LIP_COLOR_FORMAT_HDR_STATIC:
+        p_format->hdr_mode.hdr_static = hdr_mode < 0 ? LIP_HDR_STATIC_COUNT : (dlb_lip_hdr_static_t)hdr_mode;
+        break;
+    case LIP_COLOR_FORMAT_HDR_DYNAMIC:
+        p_format->hdr_mode.hdr_dynamic = hdr_mode < 0 ? LIP_HDR_DYNAMIC_COUNT : (dlb_lip_hdr_dynamic_t)hdr_mode;
+        break;
+    case LIP_COLOR_FORMAT_DOLBY_VISION:
+        p_format->hdr_mode.dolby_vision = hdr_mode < 0 ? LIP_HDR_DOLBY_VISION_COUNT : (dlb_lip_dolby_vision_t)hdr_mode;
+        break;
+    default:
+        break;
     }
-    else if (!strncmp(attribute, "color_format", strlen("color_format")))
+}
+
+static int cache_video_latency_params(dlb_lip_xml_parser_t *p_ctx, char *attribute, char *value)
+{
+    if (!strncmp(attribute, "VIC", strlen("VIC")))
     {
-        if (!strncmp(value, "HDR_STATIC", strlen("HDR_STATIC")))
-        {
-            p_ctx->xml_cache.video_format.color_format        = LIP_COLOR_FORMAT_HDR_STATIC;
-            p_ctx->xml_cache.video_format.hdr_mode.hdr_static = LIP_HDR_STATIC_COUNT;
-        }
-        else if (!strncmp(value, "HDR_DYNAMIC", strlen("HDR_DYNAMIC")))
+        // VIC="0" selects all VICs, as the attribute was a single VIC before lists were supported
+        if (strcmp(value, "0") == 0)
         {
-            p_ctx->xml_cache.video_format.color_format         = LIP_COLOR_FORMAT_HDR_DYNAMIC;
-            p_ctx->xml_cache.video_format.hdr_mode.hdr_dynamic = LIP_HDR_DYNAMIC_COUNT;
+            p_ctx->xml_cache.vic_ranges.count = 0;
         }
-        else if (!strncmp(value, "DV", strlen("DV")))
+        else if (parse_index_ranges(value, 0, MAX_VICS, &p_ctx->xml_cache.vic_ranges))
         {
-            p_ctx->xml_cache.video_format.color_format          = LIP_COLOR_FORMAT_DOLBY_VISION;
-            p_ctx->xml_cache.video_format.hdr_mode.dolby_vision = LIP_HDR_DOLBY_VISION_COUNT;
-        }
-        else
-        {
-            p_ctx->xml_cache.video_format.color_format = LIP_COLOR_FORMAT_COUNT;
+            fprintf(stderr, "ERROR: %s: invalid VIC list in the input XML file!\n", value);
+            return 1;
         }
     }
+    else if (!strncmp(attribute, "color_format", strlen("color_format")))
+    {
+        const int color_format = dlb_lip_vocabulary_lookup(DLB_LIP_VOCABULARY_COLOR_FORMAT, value);
+
+        // hdr_mode must follow, the counts mark values not set yet
+        p_ctx->xml_cache.video_format.color_format =
+            color_format < 0 ? LIP_COLOR_FORMAT_COUNT : (dlb_lip_color_format_type_t)color_format;
+        set_cached_hdr_mode(&p_ctx->xml_cache.video_format, -1);
+    }
     else if (!strncmp(attribute, "hdr_mode", strlen("hdr_mode")))
     {
-        if (p_ctx->xml_cache.video_format.color_format == LIP_COLOR_FORMAT_HDR_STATIC)
-        {
-            if (strcmp(value, "SDR") == 0)
-            {
-                p_ctx->xml_cache.video_format.hdr_mode.hdr_static = LIP_HDR_STATIC_SDR;
-            }
-            else if (strcmp(value, "HDR") == 0)
-            {
-                p_ctx->xml_cache.video_format.hdr_mode.hdr_static = LIP_HDR_STATIC_HDR;
-            }
-            else if (strcmp(value, "SMPTE") == 0)
-            {
-                p_ctx->xml_cache.video_format.hdr_mode.hdr_static = LIP_HDR_STATIC_SMPTE_ST_2084;
-            }
-            else if (strcmp(value, "HLG") == 0)
-            {
-                p_ctx->xml_cache.video_format.hdr_mode.hdr_static = LIP_HDR_STATIC_HLG;
-            }
-            else
-            {
-                fprintf(stderr, "ERROR: invalid or unsupported video format!\n");
-                return 1;
-            }
-        }
-        else if (p_ctx->xml_cache.video_format.color_format == LIP_COLOR_FORMAT_HDR_DYNAMIC)
-        {
-            if (strcmp(value, "SMPTE_ST_2094_10") == 0)
-            {
-                p_ctx->xml_cache.video_format.hdr_mode.hdr_dynamic = LIP_HDR_DYNAMIC_SMPTE_ST_2094_10;
-            }
-            else if (strcmp(value, "ETSI") == 0)
-            {
-                p_ctx->xml_cache.video_format.hdr_mode.hdr_dynamic = LIP_HDR_DYNAMIC_ETSI_TS_103_433;
-            }
-            else if (strcmp(value, "ITU") == 0)
-            {
-                p_ctx->xml_cache.video_format.hdr_mode.hdr_dynamic = LIP_HDR_DYNAMIC_ITU_T_H265;
-            }
-            else if (strcmp(value, "SMPTE_ST_2094_40") == 0)
-            {
-                p_ctx->xml_cache.video_format.hdr_mode.hdr_dynamic = LIP_HDR_DYNAMIC_SMPTE_ST_2094_40;
-            }
-            else
-            {
-                fprintf(stderr, "ERROR: invalid or unsupported video format!\n");
-                return 1;
-            }
-        }
-        else if (p_ctx->xml_cache.video_format.color_format == LIP_COLOR_FORMAT_DOLBY_VISION)
-        {
-            if (strcmp(value, "SINK") == 0)
-            {
-                p_ctx->xml_cache.video_format.hdr_mode.dolby_vision = LIP_HDR_DOLBY_VISION_SINK_LED;
-            }
-            else if (strcmp(value, "SOURCE") == 0)
-            {
-                p_ctx->xml_cache.video_format.hdr_mode.dolby_vision = LIP_HDR_DOLBY_VISION_SOURCE_LED;
-            }
-            else
-            {
-                fprintf(stderr, "ERROR: invalid or unsupported video format!\n");
-                return 1;
-            }
-        }
-        else
+        const dlb_lip_vocabulary_kind_t kind     = dlb_lip_vocabulary_hdr_kind(p_ctx->xml_cache.video_format.color_format);
+        const int                       hdr_mode = dlb_lip_vocabulary_lookup(kind, value);
+
+        if (hdr_mode < 0)
         {
             fprintf(stderr, "ERROR: invalid or unsupported video format!\n");
             return 1;
         }
+        set_cached_hdr_mode(&p_ctx->xml_cache.video_format, hdr_mode);
     }
     else
     {
@@ -448,18 +1140,76 @@ static int cache_video_latency_params(dlb_lip_xml_parser_t *p_ctx, char *attribu
 
 dlb_lip_audio_codec_t get_codec_type_from_str(const char *const codec_str)
 {
-    dlb_lip_audio_codec_t codec = IEC61937_AUDIO_CODECS;
+    const int codec = dlb_lip_vocabulary_lookup(DLB_LIP_VOCABULARY_CODEC, codec_str);
+
+    return codec < 0 ? IEC61937_AUDIO_CODECS : (dlb_lip_audio_codec_t)codec;
+}
+
+const char *get_codec_str_from_type(const dlb_lip_audio_codec_t codec)
+{
+    return dlb_lip_vocabulary_name(DLB_LIP_VOCABULARY_CODEC, (int)codec);
+}
+
+int parse_index_list(const char *const list_str, const unsigned int min, const unsigned int max, bool *const mask)
+{
+    const char *ptr = list_str;
+
+    memset(mask, 0, max * sizeof(bool));
+
+    if (list_str == NULL)
+    {
+        return 1;
+    }
 
-    for (unsigned int i = 0; i < IEC61937_AUDIO_CODECS && codec_str; i++)
+    if (strcmp(list_str, "*") == 0)
     {
-        if (codec_names[i].name && (strcmp(codec_str, codec_names[i].name) == 0))
+        for (unsigned int i = min; i < max; i++)
         {
-            codec = codec_names[i].codec;
-            break;
+            mask[i] = true;
+        }
+        return 0;
+    }
+
+    while (*ptr)
+    {
+        char *        end   = NULL;
+        unsigned long first = strtoul(ptr, &end, 10);
+        unsigned long last  = first;
+
+        if (end == ptr)
+        {
+            return 1;
+        }
+        ptr = end;
+        if (*ptr == '-')
+        {
+            ptr++;
+            last = strtoul(ptr, &end, 10);
+            if (end == ptr)
+            {
+                return 1;
+            }
+            ptr = end;
+        }
+        if (first < min || last >= max || first > last)
+        {
+            return 1;
+        }
+        for (unsigned long i = first; i <= last; i++)
+        {
+            mask[i] = true;
+        }
+        if (*ptr == ',')
+        {
+            ptr++;
+        }
+        else if (*ptr != '\0')
+        {
+            return 1;
         }
     }
 
-    return codec;
+    return 0;
 }
 
 static int cache_audio_latency_params(dlb_lip_xml_parser_t *p_ctx, char *attribute, char *value)
@@ -477,25 +1227,19 @@ static int cache_audio_latency_params(dlb_lip_xml_parser_t *p_ctx, char *attribu
     }
     else if (!strncmp(attribute, "subtype", strlen("subtype")))
     {
-        unsigned long subtype = strtoul(value, NULL, 10);
-
-        if (subtype > IEC61937_SUBTYPES)
+        if (parse_index_ranges(value, 0, IEC61937_SUBTYPES, &p_ctx->xml_cache.subtype_ranges))
         {
             fprintf(stderr, "WARNING: %s: invalid or unsupported audio subtype !\n", value);
             return 1;
         }
-        p_ctx->xml_cache.audio_format.subtype = (dlb_lip_audio_formats_subtypes_t)(subtype);
     }
     else if (!strncmp(attribute, "ext", strlen("ext")))
     {
-        unsigned long ext = strtoul(value, NULL, 10);
-
-        if (ext > MAX_AUDIO_FORMAT_EXTENSIONS)
+        if (parse_index_ranges(value, 0, MAX_AUDIO_FORMAT_EXTENSIONS, &p_ctx->xml_cache.ext_ranges))
         {
             fprintf(stderr, "WARNING: %s: invalid or unsupported audio extension !\n", value);
             return 1;
         }
-        p_ctx->xml_cache.audio_format.ext = (uint8_t)(ext);
     }
     else
     {
@@ -578,51 +1322,33 @@ static int element_callback(void *p_context, char *tag, char *text)
         }
         else if (!strncmp(tag, "DeviceType", strlen("DeviceType")))
         {
-            if (!strncmp(text, "playback", strlen("playback")))
-            {
-                p_ctx->device_type = LIP_DEVICE_STB;
-            }
-            else if (!strncmp(text, "audio", strlen("audio")))
-            {
-                p_ctx->device_type = LIP_DEVICE_AVR;
-            }
-            else if (!strncmp(text, "tv", strlen("tv")))
-            {
-                p_ctx->device_type = LIP_DEVICE_TV;
-            }
-            else
+            const int device_type = dlb_lip_vocabulary_lookup(DLB_LIP_VOCABULARY_DEVICE_TYPE, text);
+
+            if (device_type < 0)
             {
                 fprintf(stderr, "ERROR: Invalid device type in the input XML file!\n");
                 return 1;
             }
+            p_ctx->device_type = (dlb_lip_device_type_t)device_type;
         }
         else if (!strncmp(tag, "Renderer", strlen("Renderer")))
         {
-            if (!strncmp(text, "audio", strlen("audio")))
-            {
-                p_ctx->config_params.render_mode = LIP_AUDIO_RENDERER;
-            }
-            else if (!strncmp(text, "video", strlen("video")))
-            {
-                p_ctx->config_params.render_mode = LIP_VIDEO_RENDERER;
-            }
-            else if (!strncmp(text, "av", strlen("av")))
-            {
-                p_ctx->config_params.render_mode = LIP_AUDIO_RENDERER | LIP_VIDEO_RENDERER;
-            }
-            else
+            const int render_mode = dlb_lip_vocabulary_lookup(DLB_LIP_VOCABULARY_RENDERER, text);
+
+            if (render_mode < 0)
             {
                 fprintf(stderr, "ERROR: Invalid Renderer type(%s) in the input XML file!\n", text ? text : "NULL");
                 return 1;
             }
+            p_ctx->config_params.render_mode = (uint8_t)render_mode;
         }
         else if (!strncmp(tag, "VidLatency", strlen("VidLatency")))
         {
-            save_video_latency(p_ctx, text);
+            return save_video_latency(p_ctx, text);
         }
         else if (!strncmp(tag, "AudLatency", strlen("AudLatency")))
         {
-            save_audio_latency(p_ctx, text);
+            return save_audio_latency(p_ctx, text);
         }
     }
 
@@ -650,6 +1376,14 @@ static int attribute_callback(void *p_context, char *tag, char *attribute, char
     {
         ret = cache_audio_latency_params(p_ctx, attribute, value);
     }
+    else if (!strcmp(tag, "Include") && !strcmp(attribute, "file"))
+    {
+        ret = include_xml_fragment(p_ctx, value);
+    }
+    else if (!strcmp(tag, "LIP_Config") && !strcmp(attribute, "base"))
+    {
+        ret = apply_xml_base(p_ctx, value);
+    }
     else
     {
         fprintf(stderr, "ERROR: Invalid tag [%s] in the input XML file!\n", tag);
@@ -670,9 +1404,172 @@ static char *line_callback(void *p_context)
     {
         return NULL;
     }
+    ((dlb_lip_xml_parser_t *)p_context)->diagnostics.line += 1;
     return fgets(((dlb_lip_xml_parser_t *)p_context)->xml_line, MAX_XML_LINE, ((dlb_lip_xml_parser_t *)p_context)->config_file);
 }
 
+/**
+ * @brief Loads next line from a topology file
+ *
+ * @param p_context: Passed through context pointer, to load a line
+ */
+static char *topology_line_callback(void *p_context)
+{
+    dlb_lip_xml_topology_t *p_topology = (dlb_lip_xml_topology_t *)p_context;
+
+    if (feof(p_topology->config_file))
+    {
+        return NULL;
+    }
+    p_topology->line += 1;
+    if (p_topology->device_opened)
+    {
+        p_topology->devices[p_topology->device_count - 1].parser.diagnostics.line = p_topology->line;
+    }
+    return fgets(p_topology->xml_line, MAX_XML_LINE, p_topology->config_file);
+}
+
+/**
+ * @brief "Element" callback for topology XML parser, elements inside Device are passed to element_callback of the device
+ *
+ * @param p_context: Passed through context pointer
+ * @param tag: Tag string (name of the element)
+ * @param text: Text enclosed inside the element's open and close tags, or NULL on open tag
+ */
+static int topology_element_callback(void *p_context, char *tag, char *text)
+{
+    dlb_lip_xml_topology_t *p_topology = (dlb_lip_xml_topology_t *)p_context;
+
+    if (strcmp(tag, "Device") == 0)
+    {
+        if (text == NULL)
+        {
+            dlb_lip_xml_topology_device_t *p_device = &p_topology->devices[p_topology->device_count];
+
+            if (p_topology->device_opened || p_topology->device_count == MAX_XML_TOPOLOGY_DEVICES)
+            {
+                fprintf(stderr, "ERROR: Nested Device or too many devices in the topology file!\n");
+                return 1;
+            }
+            memset(p_device, 0, sizeof(*p_device));
+            dlb_lip_xml_parser_init(&p_device->parser);
+            p_device->parser.diagnostics.fail_on_overwrite = p_topology->fail_on_overwrite;
+            p_device->parser.diagnostics.quiet             = p_topology->quiet;
+            p_device->parser.diagnostics.line              = p_topology->line;
+            snprintf(p_device->parser.file_name, sizeof(p_device->parser.file_name), "%s", p_topology->file_name);
+            p_topology->device_count += 1;
+            p_topology->device_opened = true;
+        }
+        else
+        {
+            const dlb_lip_xml_topology_device_t *p_device = &p_topology->devices[p_topology->device_count - 1];
+
+            p_topology->device_opened = false;
+            if (p_device->name[0] == '\0' || find_topology_device(p_topology, p_device->name) != p_topology->device_count - 1)
+            {
+                fprintf(stderr, "ERROR: Device without name or with duplicate name in the topology file!\n");
+                return 1;
+            }
+        }
+    }
+    else if (strcmp(tag, "Link") == 0)
+    {
+        if (text == NULL)
+        {
+            if (p_topology->device_opened || p_topology->link_count == MAX_XML_TOPOLOGY_DEVICES)
+            {
+                fprintf(stderr, "ERROR: Link inside Device or too many links in the topology file!\n");
+                return 1;
+            }
+            memset(&p_topology->links[p_topology->link_count], 0, sizeof(p_topology->links[0]));
+            p_topology->link_count += 1;
+        }
+    }
+    else if (p_topology->device_opened)
+    {
+        return element_callback(&p_topology->devices[p_topology->device_count - 1].parser, tag, text);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief "Attribute" callback for topology XML parser
+ *
+ * @param p_context: Passed through context pointer
+ * @param tag: Tag string (name of the element)
+ * @param attribute: Attribute string (name of the attribute)
+ * @param value: Text enclosed inside the attribute's quotes
+ */
+static int topology_attribute_callback(void *p_context, char *tag, char *attribute, char *value)
+{
+    dlb_lip_xml_topology_t *p_topology = (dlb_lip_xml_topology_t *)p_context;
+    char *                  p_string   = NULL;
+    size_t                  size       = 0;
+
+    if (strcmp(tag, "Device") == 0)
+    {
+        dlb_lip_xml_topology_device_t *p_device = &p_topology->devices[p_topology->device_count - 1];
+
+        if (strcmp(attribute, "arc") == 0)
+        {
+            p_device->sim_arc = strcmp(value, "true") == 0;
+            return 0;
+        }
+        else if (strcmp(attribute, "base") == 0)
+        {
+            return apply_xml_base(&p_device->parser, value);
+        }
+        else if (strcmp(attribute, "name") == 0)
+        {
+            p_string = p_device->name;
+            size     = sizeof(p_device->name);
+        }
+        else if (strcmp(attribute, "port") == 0)
+        {
+            p_string = p_device->port_name;
+            size     = sizeof(p_device->port_name);
+        }
+        else if (strcmp(attribute, "commands") == 0)
+        {
+            p_string = p_device->commands_file_name;
+            size     = sizeof(p_device->commands_file_name);
+        }
+        else if (strcmp(attribute, "state") == 0)
+        {
+            p_string = p_device->state_file_name;
+            size     = sizeof(p_device->state_file_name);
+        }
+    }
+    else if (strcmp(tag, "Link") == 0)
+    {
+        dlb_lip_xml_topology_link_t *p_link = &p_topology->links[p_topology->link_count - 1];
+
+        if (strcmp(attribute, "from") == 0)
+        {
+            p_string = p_link->from;
+            size     = sizeof(p_link->from);
+        }
+        else if (strcmp(attribute, "to") == 0)
+        {
+            p_string = p_link->to;
+            size     = sizeof(p_link->to);
+        }
+    }
+    else if (p_topology->device_opened)
+    {
+        return attribute_callback(&p_topology->devices[p_topology->device_count - 1].parser, tag, attribute, value);
+    }
+
+    if (p_string == NULL || (size_t)snprintf(p_string, size, "%s", value) >= size)
+    {
+        fprintf(stderr, "ERROR: Invalid or too long attribute %s of %s in the topology file!\n", attribute, tag);
+        return 1;
+    }
+
+    return 0;
+}
+
 /**
  * @brief "Error" callback for XML parser
  *
@@ -0,0 +1,199 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_cache_archive_test.c
+ *  @brief      Unit test of the cache archive export and import between cache backends
+ */
+
+// nftw() is an XSI extension
+#define _XOPEN_SOURCE 700
+
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dlb_lip_cache.h"
+#include "dlb_lip_test.h"
+
+#define TEST_LIBRARY_VERSION 0x010200U
+#define TEST_BLOBS 3U
+#define TEST_MAX_BLOB_SIZE 4096U
+#define TEST_PATH_SIZE 1024U
+
+static const uint32_t     test_uuids[TEST_BLOBS]      = { 0x11111111U, 0x2222U, 0xABCDEF01U };
+static const unsigned int test_blob_sizes[TEST_BLOBS] = { 1U, 700U, TEST_MAX_BLOB_SIZE };
+
+static char test_directory[] = "/tmp/dlb_lip_cache_archive_test_XXXXXX";
+
+static void make_path(char *path, const char *name)
+{
+    snprintf(path, TEST_PATH_SIZE, "%s/%s", test_directory, name);
+}
+
+static void fill_blob(unsigned char *blob, unsigned int index)
+{
+    for (unsigned int i = 0; i < test_blob_sizes[index]; ++i)
+    {
+        blob[i] = (unsigned char)(i * 7U + index * 31U + 1U);
+    }
+}
+
+static void open_cache(const char *directory_name, const char *store_path, uint32_t library_version)
+{
+    char                   directory[TEST_PATH_SIZE];
+    dlb_lip_cache_config_t config = { 0 };
+
+    make_path(directory, directory_name);
+    config.directory       = directory;
+    config.store_path      = store_path;
+    config.library_version = library_version;
+    TEST_CHECK(dlb_lip_cache_open(&config) == 0);
+    dlb_lip_cache_wait_warm_start();
+}
+
+/*!
+Checks blobs of the cache, the blob of skipped_uuid must not be cached.
+
+@return number of blobs read back unchanged
+*/
+static unsigned int count_blobs(uint32_t skipped_uuid)
+{
+    unsigned char expected[TEST_MAX_BLOB_SIZE];
+    unsigned char blob[TEST_MAX_BLOB_SIZE];
+    unsigned int  count = 0;
+
+    for (unsigned int i = 0; i < TEST_BLOBS; ++i)
+    {
+        const unsigned int size = dlb_lip_cache_read(test_uuids[i], blob, sizeof(blob));
+
+        fill_blob(expected, i);
+        if (test_uuids[i] == skipped_uuid)
+        {
+            TEST_CHECK(size == 0);
+        }
+        else if (size == test_blob_sizes[i] && memcmp(blob, expected, size) == 0)
+        {
+            count += 1;
+        }
+    }
+
+    return count;
+}
+
+static void test_round_trip(void)
+{
+    unsigned char blob[TEST_MAX_BLOB_SIZE];
+    char          files_archive[TEST_PATH_SIZE];
+    char          store_archive[TEST_PATH_SIZE];
+
+    make_path(files_archive, "files.lica");
+    make_path(store_archive, "store.lica");
+
+    // Cache files to the store file and back to cache files of another directory
+    open_cache("files", NULL, TEST_LIBRARY_VERSION);
+    for (unsigned int i = 0; i < TEST_BLOBS; ++i)
+    {
+        fill_blob(blob, i);
+        dlb_lip_cache_store(test_uuids[i], blob, test_blob_sizes[i]);
+    }
+    TEST_CHECK(dlb_lip_cache_export(files_archive) == (int)TEST_BLOBS);
+    dlb_lip_cache_close();
+
+    open_cache("store", "cache.store", TEST_LIBRARY_VERSION);
+    TEST_CHECK(count_blobs(0) == 0);
+    TEST_CHECK(dlb_lip_cache_import(files_archive) == (int)TEST_BLOBS);
+    TEST_CHECK(count_blobs(0) == TEST_BLOBS);
+    TEST_CHECK(dlb_lip_cache_export(store_archive) == (int)TEST_BLOBS);
+    dlb_lip_cache_close();
+
+    open_cache("files_copy", NULL, TEST_LIBRARY_VERSION);
+    TEST_CHECK(dlb_lip_cache_import(store_archive) == (int)TEST_BLOBS);
+    TEST_CHECK(count_blobs(0) == TEST_BLOBS);
+    dlb_lip_cache_close();
+
+    // Blobs imported into cache files are persisted
+    open_cache("files_copy", NULL, TEST_LIBRARY_VERSION);
+    TEST_CHECK(count_blobs(0) == TEST_BLOBS);
+    dlb_lip_cache_close();
+}
+
+static void test_other_library_version_is_rejected(void)
+{
+    char archive[TEST_PATH_SIZE];
+
+    make_path(archive, "files.lica");
+    open_cache("other_version", NULL, TEST_LIBRARY_VERSION + 1U);
+    TEST_CHECK(dlb_lip_cache_import(archive) == -1);
+    TEST_CHECK(count_blobs(0) == 0);
+    dlb_lip_cache_close();
+}
+
+static void test_corrupted_entry_is_skipped(void)
+{
+    unsigned char header[12];
+    char          archive[TEST_PATH_SIZE];
+    uint32_t      last_uuid = 0;
+    long          offset    = 16;
+    FILE *        file      = NULL;
+
+    // Flip the last byte of the last entry
+    make_path(archive, "files.lica");
+    file = fopen(archive, "r+b");
+    TEST_CHECK(file != NULL);
+    if (file == NULL)
+    {
+        return;
+    }
+    for (unsigned int i = 0; i < TEST_BLOBS; ++i)
+    {
+        TEST_CHECK(fseek(file, offset, SEEK_SET) == 0 && fread(header, 1, sizeof(header), file) == sizeof(header));
+        last_uuid = (uint32_t)header[0] | (uint32_t)header[1] << 8 | (uint32_t)header[2] << 16 | (uint32_t)header[3] << 24;
+        offset += (long)sizeof(header)
+                  + (long)((uint32_t)header[4] | (uint32_t)header[5] << 8 | (uint32_t)header[6] << 16
+                           | (uint32_t)header[7] << 24);
+    }
+    TEST_CHECK(fseek(file, offset - 1, SEEK_SET) == 0);
+    header[0] = (unsigned char)(fgetc(file) ^ 0xFF);
+    TEST_CHECK(fseek(file, offset - 1, SEEK_SET) == 0 && fputc(header[0], file) != EOF);
+    fclose(file);
+
+    open_cache("corrupted", NULL, TEST_LIBRARY_VERSION);
+    TEST_CHECK(dlb_lip_cache_import(archive) == (int)TEST_BLOBS - 1);
+    TEST_CHECK(count_blobs(last_uuid) == TEST_BLOBS - 1U);
+    dlb_lip_cache_close();
+}
+
+static int remove_path(const char *path, const struct stat *p_stat, int type, struct FTW *p_ftw)
+{
+    (void)p_stat;
+    (void)type;
+    (void)p_ftw;
+    return remove(path);
+}
+
+int main(void)
+{
+    if (mkdtemp(test_directory) == NULL)
+    {
+        fprintf(stderr, "ERROR: Couldn't create %s\n", test_directory);
+        return 1;
+    }
+
+    test_round_trip();
+    test_other_library_version_is_rejected();
+    test_corrupted_entry_is_skipped();
+
+    nftw(test_directory, remove_path, 16, FTW_DEPTH | FTW_PHYS);
+
+    return TEST_RESULT();
+}
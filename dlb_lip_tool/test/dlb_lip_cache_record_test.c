@@ -0,0 +1,196 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_cache_record_test.c
+ *  @brief      Unit test of the validation of cache records and the import of cache files into the store
+ */
+
+// nftw() is an XSI extension
+#define _XOPEN_SOURCE 700
+
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "dlb_lip_cache.h"
+#include "dlb_lip_test.h"
+
+#define TEST_LIBRARY_VERSION 0x010200U
+#define TEST_UUID 0x1234ABCDU
+#define TEST_BLOB_SIZE 300U
+#define TEST_PATH_SIZE 1024U
+#define TEST_RECORD_HEADER_SIZE 16 // magic, library version, blob size and CRC32C
+
+static char test_directory[] = "/tmp/dlb_lip_cache_record_test_XXXXXX";
+
+static void make_path(char *path, const char *name)
+{
+    snprintf(path, TEST_PATH_SIZE, "%s/%s", test_directory, name);
+}
+
+static void make_cache_file_path(char *path, const char *directory_name)
+{
+    snprintf(path, TEST_PATH_SIZE, "%s/%s/cache_%x.dat", test_directory, directory_name, TEST_UUID);
+}
+
+static void fill_blob(unsigned char *blob)
+{
+    for (unsigned int i = 0; i < TEST_BLOB_SIZE; ++i)
+    {
+        blob[i] = (unsigned char)(i * 13U + 5U);
+    }
+}
+
+static void open_cache(const char *directory_name, const char *store_path, uint32_t library_version)
+{
+    char                   directory[TEST_PATH_SIZE];
+    dlb_lip_cache_config_t config = { 0 };
+
+    make_path(directory, directory_name);
+    config.directory       = directory;
+    config.store_path      = store_path;
+    config.library_version = library_version;
+    TEST_CHECK(dlb_lip_cache_open(&config) == 0);
+    dlb_lip_cache_wait_warm_start();
+}
+
+/*!
+Reopens the cache files of the directory.
+
+@return true if the blob is read back unchanged
+*/
+static bool blob_valid(const char *directory_name, uint32_t library_version)
+{
+    unsigned char expected[TEST_BLOB_SIZE];
+    unsigned char blob[TEST_BLOB_SIZE * 2];
+    unsigned int  size = 0;
+
+    fill_blob(expected);
+    open_cache(directory_name, NULL, library_version);
+    size = dlb_lip_cache_read(TEST_UUID, blob, sizeof(blob));
+    dlb_lip_cache_close();
+
+    return size == TEST_BLOB_SIZE && memcmp(blob, expected, size) == 0;
+}
+
+static void write_blob(const char *directory_name)
+{
+    unsigned char blob[TEST_BLOB_SIZE];
+
+    fill_blob(blob);
+    open_cache(directory_name, NULL, TEST_LIBRARY_VERSION);
+    dlb_lip_cache_store(TEST_UUID, blob, sizeof(blob));
+    dlb_lip_cache_close();
+}
+
+static void test_valid_record(void)
+{
+    write_blob("valid");
+    TEST_CHECK(blob_valid("valid", TEST_LIBRARY_VERSION));
+}
+
+static void test_other_library_version_is_rejected(void)
+{
+    write_blob("version");
+    TEST_CHECK(!blob_valid("version", TEST_LIBRARY_VERSION + 1U));
+}
+
+static void test_checksum_mismatch_is_rejected(void)
+{
+    char  path[TEST_PATH_SIZE];
+    FILE *file = NULL;
+    int   ch   = 0;
+
+    write_blob("checksum");
+    make_cache_file_path(path, "checksum");
+    file = fopen(path, "r+b");
+    TEST_CHECK(file != NULL);
+    if (file == NULL)
+    {
+        return;
+    }
+    TEST_CHECK(fseek(file, -1, SEEK_END) == 0 && (ch = fgetc(file)) != EOF);
+    TEST_CHECK(fseek(file, -1, SEEK_END) == 0 && fputc(ch ^ 0x01, file) != EOF);
+    fclose(file);
+
+    TEST_CHECK(!blob_valid("checksum", TEST_LIBRARY_VERSION));
+}
+
+static void test_truncated_record_is_rejected(void)
+{
+    char path[TEST_PATH_SIZE];
+
+    write_blob("truncated");
+    make_cache_file_path(path, "truncated");
+    TEST_CHECK(truncate(path, TEST_RECORD_HEADER_SIZE + TEST_BLOB_SIZE - 1) == 0);
+
+    TEST_CHECK(!blob_valid("truncated", TEST_LIBRARY_VERSION));
+}
+
+static void test_headerless_file_import(void)
+{
+    unsigned char blob[TEST_BLOB_SIZE];
+    unsigned char read[TEST_BLOB_SIZE];
+    char          path[TEST_PATH_SIZE];
+    FILE *        file = NULL;
+
+    // Bare blob of a cache file written before records had a header
+    fill_blob(blob);
+    open_cache("legacy", "cache.store", TEST_LIBRARY_VERSION);
+    dlb_lip_cache_close();
+    make_cache_file_path(path, "legacy");
+    file = fopen(path, "wb");
+    TEST_CHECK(file != NULL && fwrite(blob, 1, sizeof(blob), file) == sizeof(blob));
+    if (file)
+    {
+        fclose(file);
+    }
+
+    open_cache("legacy", "cache.store", TEST_LIBRARY_VERSION);
+    TEST_CHECK(dlb_lip_cache_import_files(false) == 0);
+    TEST_CHECK(dlb_lip_cache_read(TEST_UUID, read, sizeof(read)) == 0);
+    dlb_lip_cache_close();
+
+    open_cache("legacy", "cache.store", TEST_LIBRARY_VERSION);
+    TEST_CHECK(dlb_lip_cache_import_files(true) == 1);
+    TEST_CHECK(dlb_lip_cache_read(TEST_UUID, read, sizeof(read)) == TEST_BLOB_SIZE && memcmp(read, blob, sizeof(blob)) == 0);
+    dlb_lip_cache_close();
+}
+
+static int remove_path(const char *path, const struct stat *p_stat, int type, struct FTW *p_ftw)
+{
+    (void)p_stat;
+    (void)type;
+    (void)p_ftw;
+    return remove(path);
+}
+
+int main(void)
+{
+    if (mkdtemp(test_directory) == NULL)
+    {
+        fprintf(stderr, "ERROR: Couldn't create %s\n", test_directory);
+        return 1;
+    }
+
+    test_valid_record();
+    test_other_library_version_is_rejected();
+    test_checksum_mismatch_is_rejected();
+    test_truncated_record_is_rejected();
+    test_headerless_file_import();
+
+    nftw(test_directory, remove_path, 16, FTW_DEPTH | FTW_PHYS);
+
+    return TEST_RESULT();
+}
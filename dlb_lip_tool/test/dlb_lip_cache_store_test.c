@@ -0,0 +1,302 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_cache_store_test.c
+ *  @brief      Unit test of the compaction and the index rebuild of the memory mapped cache store
+ */
+
+// nftw() is an XSI extension
+#define _XOPEN_SOURCE 700
+
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "dlb_lip_cache.h"
+#include "dlb_lip_test.h"
+
+#define TEST_LIBRARY_VERSION 0x010200U
+#define TEST_UUID_BASE 0x5000U
+#define TEST_BLOB_SIZE 100U
+#define TEST_BIG_BLOB_SIZE 1000U
+#define TEST_PATH_SIZE 1024U
+
+// Store file layout: 64 byte header starting with magic, version, slot size and slot count, then the slots.
+// Every slot is a header of UUID, record size, state and last use followed by the record.
+#define TEST_STORE_HEADER_SIZE 64U
+#define TEST_SLOT_HEADER_SIZE 16U
+#define TEST_SLOT_STATE_WRITING 1U
+
+static char test_directory[] = "/tmp/dlb_lip_cache_store_test_XXXXXX";
+
+static void make_path(char *path, const char *name)
+{
+    snprintf(path, TEST_PATH_SIZE, "%s/%s", test_directory, name);
+}
+
+static void fill_blob(unsigned char *blob, unsigned int size, uint32_t uuid)
+{
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        blob[i] = (unsigned char)(i + uuid * 3U);
+    }
+}
+
+static void open_store(const char *directory_name, uint32_t max_entries)
+{
+    char                   directory[TEST_PATH_SIZE];
+    dlb_lip_cache_config_t config = { 0 };
+
+    make_path(directory, directory_name);
+    config.directory       = directory;
+    config.store_path      = "cache.store";
+    config.max_entries     = max_entries;
+    config.library_version = TEST_LIBRARY_VERSION;
+    TEST_CHECK(dlb_lip_cache_open(&config) == 0);
+    dlb_lip_cache_wait_warm_start();
+}
+
+static void store_blob(uint32_t uuid, unsigned int size)
+{
+    unsigned char blob[TEST_BIG_BLOB_SIZE];
+
+    fill_blob(blob, size, uuid);
+    dlb_lip_cache_store(uuid, blob, size);
+}
+
+static bool blob_valid(uint32_t uuid, unsigned int size)
+{
+    unsigned char expected[TEST_BIG_BLOB_SIZE];
+    unsigned char blob[TEST_BIG_BLOB_SIZE];
+
+    fill_blob(expected, size, uuid);
+    return dlb_lip_cache_read(uuid, blob, sizeof(blob)) == size && memcmp(blob, expected, size) == 0;
+}
+
+static uint32_t get_u32(const unsigned char *p)
+{
+    uint32_t value = 0;
+
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static void put_u32(unsigned char *p, uint32_t value)
+{
+    memcpy(p, &value, sizeof(value));
+}
+
+/*!
+Reads the store file of the directory.
+
+@return allocated file content, NULL on error
+*/
+static unsigned char *read_store(const char *directory_name, long *p_size)
+{
+    char           path[TEST_PATH_SIZE];
+    unsigned char *p_data = NULL;
+    FILE *         file   = NULL;
+
+    snprintf(path, sizeof(path), "%s/%s/cache.store", test_directory, directory_name);
+    file = fopen(path, "rb");
+    if (file && fseek(file, 0, SEEK_END) == 0 && (*p_size = ftell(file)) > 0 && fseek(file, 0, SEEK_SET) == 0)
+    {
+        p_data = (unsigned char *)malloc((size_t)*p_size);
+        if (p_data && fread(p_data, 1, (size_t)*p_size, file) != (size_t)*p_size)
+        {
+            free(p_data);
+            p_data = NULL;
+        }
+    }
+    if (file)
+    {
+        fclose(file);
+    }
+
+    return p_data;
+}
+
+static void write_store(const char *directory_name, const unsigned char *p_data, long size)
+{
+    char  path[TEST_PATH_SIZE];
+    FILE *file = NULL;
+
+    snprintf(path, sizeof(path), "%s/%s/cache.store", test_directory, directory_name);
+    file = fopen(path, "wb");
+    TEST_CHECK(file != NULL && fwrite(p_data, 1, (size_t)size, file) == (size_t)size);
+    if (file)
+    {
+        fclose(file);
+    }
+}
+
+static unsigned char *find_slot(unsigned char *p_data, uint32_t uuid)
+{
+    const uint32_t slot_size  = get_u32(p_data + 8);
+    const uint32_t slot_count = get_u32(p_data + 12);
+
+    for (uint32_t i = 0; i < slot_count; ++i)
+    {
+        unsigned char *const p_slot = p_data + TEST_STORE_HEADER_SIZE + (size_t)i * (TEST_SLOT_HEADER_SIZE + slot_size);
+
+        if (get_u32(p_slot) == uuid && get_u32(p_slot + 8) != 0)
+        {
+            return p_slot;
+        }
+    }
+
+    return NULL;
+}
+
+static void test_compaction_to_entry_limit(void)
+{
+    const unsigned int count        = 40;
+    const unsigned int max_entries  = 8;
+    unsigned char *    p_data       = NULL;
+    long               size         = 0;
+    unsigned int       valid        = 0;
+    bool               recent_valid = true;
+
+    open_store("limit", 0);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        store_blob(TEST_UUID_BASE + i, TEST_BLOB_SIZE);
+    }
+    dlb_lip_cache_close();
+
+    // Least recently used UUIDs are evicted and the store is rewritten with as many slots as the limit allows
+    open_store("limit", max_entries);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        const bool blob_read = blob_valid(TEST_UUID_BASE + i, TEST_BLOB_SIZE);
+
+        valid += blob_read ? 1U : 0U;
+        recent_valid &= i < count - max_entries || blob_read;
+    }
+    TEST_CHECK(valid == max_entries);
+    TEST_CHECK(recent_valid);
+    dlb_lip_cache_close();
+
+    p_data = read_store("limit", &size);
+    TEST_CHECK(p_data != NULL);
+    if (p_data)
+    {
+        TEST_CHECK(get_u32(p_data + 12) == max_entries);
+        TEST_CHECK(size == (long)(TEST_STORE_HEADER_SIZE + max_entries * (TEST_SLOT_HEADER_SIZE + get_u32(p_data + 8))));
+    }
+    free(p_data);
+}
+
+static void test_slot_growth(void)
+{
+    open_store("growth", 0);
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        store_blob(TEST_UUID_BASE + i, TEST_BLOB_SIZE);
+    }
+    // Bigger blob rewrites the store with bigger slots
+    store_blob(TEST_UUID_BASE + 3, TEST_BIG_BLOB_SIZE);
+    TEST_CHECK(blob_valid(TEST_UUID_BASE + 3, TEST_BIG_BLOB_SIZE));
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        TEST_CHECK(blob_valid(TEST_UUID_BASE + i, TEST_BLOB_SIZE));
+    }
+    dlb_lip_cache_close();
+
+    open_store("growth", 0);
+    TEST_CHECK(blob_valid(TEST_UUID_BASE + 3, TEST_BIG_BLOB_SIZE));
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        TEST_CHECK(blob_valid(TEST_UUID_BASE + i, TEST_BLOB_SIZE));
+    }
+    dlb_lip_cache_close();
+}
+
+static void test_index_rebuild_drops_corrupt_slots(void)
+{
+    unsigned char *p_data = NULL;
+    unsigned char *p_slot = NULL;
+    long           size   = 0;
+
+    open_store("corrupt", 0);
+    for (unsigned int i = 0; i < 5; ++i)
+    {
+        store_blob(TEST_UUID_BASE + i, TEST_BLOB_SIZE);
+    }
+    dlb_lip_cache_close();
+
+    p_data = read_store("corrupt", &size);
+    TEST_CHECK(p_data != NULL);
+    if (p_data == NULL)
+    {
+        return;
+    }
+    // Record size not fitting the slot, interrupted write and duplicate UUID
+    p_slot = find_slot(p_data, TEST_UUID_BASE);
+    TEST_CHECK(p_slot != NULL);
+    if (p_slot)
+    {
+        put_u32(p_slot + 4, get_u32(p_data + 8) + 1U);
+    }
+    p_slot = find_slot(p_data, TEST_UUID_BASE + 1);
+    TEST_CHECK(p_slot != NULL);
+    if (p_slot)
+    {
+        put_u32(p_slot + 8, TEST_SLOT_STATE_WRITING);
+    }
+    p_slot = find_slot(p_data, TEST_UUID_BASE + 2);
+    TEST_CHECK(p_slot != NULL);
+    if (p_slot)
+    {
+        put_u32(p_slot, TEST_UUID_BASE + 3);
+    }
+    write_store("corrupt", p_data, size);
+    free(p_data);
+
+    open_store("corrupt", 0);
+    TEST_CHECK(!blob_valid(TEST_UUID_BASE, TEST_BLOB_SIZE));
+    TEST_CHECK(!blob_valid(TEST_UUID_BASE + 1, TEST_BLOB_SIZE));
+    TEST_CHECK(!blob_valid(TEST_UUID_BASE + 2, TEST_BLOB_SIZE));
+    TEST_CHECK(blob_valid(TEST_UUID_BASE + 4, TEST_BLOB_SIZE));
+
+    // Freed slots are reused
+    store_blob(TEST_UUID_BASE, TEST_BLOB_SIZE);
+    TEST_CHECK(blob_valid(TEST_UUID_BASE, TEST_BLOB_SIZE));
+    dlb_lip_cache_close();
+}
+
+static int remove_path(const char *path, const struct stat *p_stat, int type, struct FTW *p_ftw)
+{
+    (void)p_stat;
+    (void)type;
+    (void)p_ftw;
+    return remove(path);
+}
+
+int main(void)
+{
+    if (mkdtemp(test_directory) == NULL)
+    {
+        fprintf(stderr, "ERROR: Couldn't create %s\n", test_directory);
+        return 1;
+    }
+
+    test_compaction_to_entry_limit();
+    test_slot_growth();
+    test_index_rebuild_drops_corrupt_slots();
+
+    nftw(test_directory, remove_path, 16, FTW_DEPTH | FTW_PHYS);
+
+    return TEST_RESULT();
+}
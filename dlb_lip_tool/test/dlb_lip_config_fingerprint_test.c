@@ -0,0 +1,113 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_config_fingerprint_test.c
+ *  @brief      Unit test of the incremental fingerprint of a LIP config
+ */
+
+#include <string.h>
+
+#include "dlb_lip_config_fingerprint.h"
+#include "dlb_lip_test.h"
+
+static dlb_lip_config_params_t config;
+
+static void init_config(void)
+{
+    memset(&config, 0, sizeof(config));
+    config.uuid = 0x1000;
+    memset(config.audio_latencies, 20, sizeof(config.audio_latencies));
+    memset(config.video_latencies, 40, sizeof(config.video_latencies));
+}
+
+static void test_no_op_updates(void)
+{
+    dlb_lip_config_fingerprint_t live;
+    dlb_lip_config_fingerprint_t sent;
+    dlb_lip_audio_format_t       a_format = { 0 };
+    dlb_lip_video_format_t       v_format = { 0 };
+
+    init_config();
+    dlb_lip_config_fingerprint_init(&live, &config);
+    sent = live;
+    TEST_CHECK(dlb_lip_config_fingerprint_compare(&live, &sent) == 0);
+
+    // Latency the cell already has
+    a_format.codec = IEC61937_EAC3;
+    a_format.ext   = 1;
+    dlb_lip_config_fingerprint_set_audio_latency(&live, &config, &a_format, 20);
+    v_format.vic          = 16;
+    v_format.color_format = LIP_COLOR_FORMAT_HDR_STATIC;
+    dlb_lip_config_fingerprint_set_video_latency(&live, &config, &v_format, 1, 40);
+    dlb_lip_config_fingerprint_update_params(&live, &config);
+    TEST_CHECK(dlb_lip_config_fingerprint_compare(&live, &sent) == 0);
+
+    // Changed and restored
+    dlb_lip_config_fingerprint_set_audio_latency(&live, &config, &a_format, 25);
+    TEST_CHECK(dlb_lip_config_fingerprint_compare(&live, &sent) == DLB_LIP_CONFIG_AUDIO_CHANGED);
+    dlb_lip_config_fingerprint_set_audio_latency(&live, &config, &a_format, 20);
+    TEST_CHECK(dlb_lip_config_fingerprint_compare(&live, &sent) == 0);
+}
+
+static void test_changed_parts(void)
+{
+    dlb_lip_config_fingerprint_t live;
+    dlb_lip_config_fingerprint_t sent;
+    dlb_lip_config_fingerprint_t full;
+    dlb_lip_audio_format_t       a_format = { 0 };
+    dlb_lip_video_format_t       v_format = { 0 };
+
+    init_config();
+    dlb_lip_config_fingerprint_init(&live, &config);
+    sent = live;
+
+    v_format.vic          = 97;
+    v_format.color_format = LIP_COLOR_FORMAT_DOLBY_VISION;
+    dlb_lip_config_fingerprint_set_video_latency(&live, &config, &v_format, 2, 41);
+    TEST_CHECK(dlb_lip_config_fingerprint_compare(&live, &sent) == DLB_LIP_CONFIG_VIDEO_CHANGED);
+    TEST_CHECK(config.video_latencies[97][LIP_COLOR_FORMAT_DOLBY_VISION][2] == 41);
+
+    config.render_mode = 1;
+    dlb_lip_config_fingerprint_update_params(&live, &config);
+    TEST_CHECK(dlb_lip_config_fingerprint_compare(&live, &sent) == (DLB_LIP_CONFIG_VIDEO_CHANGED | DLB_LIP_CONFIG_PARAMS_CHANGED));
+
+    a_format.codec = PCM;
+    dlb_lip_config_fingerprint_set_audio_latency(&live, &config, &a_format, 0);
+    TEST_CHECK(dlb_lip_config_fingerprint_compare(&live, &sent)
+               == (DLB_LIP_CONFIG_AUDIO_CHANGED | DLB_LIP_CONFIG_VIDEO_CHANGED | DLB_LIP_CONFIG_PARAMS_CHANGED));
+
+    // Latencies moved to other cells change the hash as well
+    init_config();
+    dlb_lip_config_fingerprint_init(&live, &config);
+    sent         = live;
+    a_format.ext = 0;
+    dlb_lip_config_fingerprint_set_audio_latency(&live, &config, &a_format, 30);
+    a_format.ext = 1;
+    dlb_lip_config_fingerprint_set_audio_latency(&live, &config, &a_format, 10);
+    TEST_CHECK(dlb_lip_config_fingerprint_compare(&live, &sent) == DLB_LIP_CONFIG_AUDIO_CHANGED);
+
+    // Incremental updates end at the fingerprint of the whole config
+    dlb_lip_config_fingerprint_init(&full, &config);
+    TEST_CHECK(dlb_lip_config_fingerprint_compare(&live, &full) == 0);
+
+    config.uuid = 0x1001;
+    dlb_lip_config_fingerprint_update_params(&live, &config);
+    TEST_CHECK(dlb_lip_config_fingerprint_compare(&live, &full) == DLB_LIP_CONFIG_PARAMS_CHANGED);
+}
+
+int main(void)
+{
+    test_no_op_updates();
+    test_changed_parts();
+
+    return TEST_RESULT();
+}
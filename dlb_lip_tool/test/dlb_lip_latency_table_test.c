@@ -0,0 +1,218 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_latency_table_test.c
+ *  @brief      Unit test of the sparse latency table
+ */
+
+#include <string.h>
+
+#include "dlb_lip_latency_table.h"
+#include "dlb_lip_test.h"
+
+static uint8_t expected[DLB_LIP_LATENCY_TABLE_VIDEO_CELLS];
+static uint8_t actual[DLB_LIP_LATENCY_TABLE_VIDEO_CELLS];
+
+static void init_video_table(dlb_lip_latency_table_t *p_table)
+{
+    dlb_lip_latency_table_init(p_table, MAX_VICS, LIP_COLOR_FORMAT_COUNT, HDR_MODES_COUNT);
+}
+
+static size_t video_offset(unsigned int vic, unsigned int color_format, unsigned int hdr_mode)
+{
+    return ((size_t)vic * LIP_COLOR_FORMAT_COUNT + color_format) * HDR_MODES_COUNT + hdr_mode;
+}
+
+static int set_rule(void *arg, const dlb_lip_latency_rule_t *p_rule)
+{
+    return dlb_lip_latency_table_set((dlb_lip_latency_table_t *)arg, p_rule->first, p_rule->last, p_rule->latency);
+}
+
+/*!
+Checks that the table gives the expected latency of every cell by get, expand and by its rules set to another table.
+*/
+static void check_video_table(const dlb_lip_latency_table_t *p_table)
+{
+    static dlb_lip_latency_table_t copy;
+    unsigned int                   mismatches = 0;
+
+    for (unsigned int vic = 0; vic < MAX_VICS; ++vic)
+    {
+        for (unsigned int color = 0; color < LIP_COLOR_FORMAT_COUNT; ++color)
+        {
+            for (unsigned int hdr = 0; hdr < HDR_MODES_COUNT; ++hdr)
+            {
+                mismatches += dlb_lip_latency_table_get(p_table, vic, color, hdr) != expected[video_offset(vic, color, hdr)];
+            }
+        }
+    }
+    TEST_CHECK(mismatches == 0);
+
+    dlb_lip_latency_table_expand(p_table, actual);
+    TEST_CHECK(memcmp(actual, expected, sizeof(expected)) == 0);
+
+    init_video_table(&copy);
+    TEST_CHECK(dlb_lip_latency_table_for_each_rule(p_table, set_rule, &copy) == 0);
+    dlb_lip_latency_table_expand(&copy, actual);
+    TEST_CHECK(memcmp(actual, expected, sizeof(expected)) == 0);
+
+    TEST_CHECK(dlb_lip_latency_table_copy(&copy, p_table) == 0);
+    TEST_CHECK(copy.dense == p_table->dense && copy.rule_count == p_table->rule_count);
+    dlb_lip_latency_table_expand(&copy, actual);
+    TEST_CHECK(memcmp(actual, expected, sizeof(expected)) == 0);
+    dlb_lip_latency_table_destroy(&copy);
+}
+
+static void test_rule_coverage(void)
+{
+    static dlb_lip_latency_table_t table;
+    const uint8_t vic_first[DLB_LIP_LATENCY_TABLE_DIMENSIONS]    = { 96, 0, 0 };
+    const uint8_t vic_last[DLB_LIP_LATENCY_TABLE_DIMENSIONS]     = { 96, LIP_COLOR_FORMAT_COUNT - 1, HDR_MODES_COUNT - 1 };
+    const uint8_t unset[DLB_LIP_LATENCY_TABLE_DIMENSIONS]        = { 97, 0, 0 };
+    const uint8_t out_of_range[DLB_LIP_LATENCY_TABLE_DIMENSIONS] = { MAX_VICS, 0, 0 };
+
+    init_video_table(&table);
+    memset(expected, LIP_INVALID_LATENCY, sizeof(expected));
+    check_video_table(&table);
+
+    // Default of the VIC, overridden by one cell
+    TEST_CHECK(dlb_lip_latency_table_set(&table, vic_first, vic_last, 40) == 0);
+    memset(&expected[video_offset(96, 0, 0)], 40, LIP_COLOR_FORMAT_COUNT * HDR_MODES_COUNT);
+    TEST_CHECK(dlb_lip_latency_table_set_cell(&table, 96, LIP_COLOR_FORMAT_HDR_STATIC, 1, 60) == 0);
+    expected[video_offset(96, LIP_COLOR_FORMAT_HDR_STATIC, 1)] = 60;
+    TEST_CHECK(table.rule_count == 2);
+    check_video_table(&table);
+
+    // Repeated updates of one cell keep one rule, a rule covering the VIC replaces both
+    TEST_CHECK(dlb_lip_latency_table_set_cell(&table, 96, LIP_COLOR_FORMAT_HDR_STATIC, 1, 70) == 0);
+    expected[video_offset(96, LIP_COLOR_FORMAT_HDR_STATIC, 1)] = 70;
+    TEST_CHECK(table.rule_count == 2);
+    check_video_table(&table);
+    TEST_CHECK(dlb_lip_latency_table_set(&table, vic_first, vic_last, 50) == 0);
+    memset(&expected[video_offset(96, 0, 0)], 50, LIP_COLOR_FORMAT_COUNT * HDR_MODES_COUNT);
+    TEST_CHECK(table.rule_count == 1);
+    check_video_table(&table);
+
+    TEST_CHECK(dlb_lip_latency_table_intersects(&table, vic_first, vic_last));
+    TEST_CHECK(!dlb_lip_latency_table_intersects(&table, unset, unset));
+    TEST_CHECK(dlb_lip_latency_table_set(&table, out_of_range, out_of_range, 10) == 1);
+    TEST_CHECK(dlb_lip_latency_table_set(&table, vic_last, vic_first, 10) == 1);
+    dlb_lip_latency_table_destroy(&table);
+}
+
+static void test_merge(void)
+{
+    static dlb_lip_latency_table_t base;
+    static dlb_lip_latency_table_t fragment;
+    const uint8_t                  all_first[DLB_LIP_LATENCY_TABLE_DIMENSIONS] = { 0, 0, 0 };
+    const uint8_t                  all_last[DLB_LIP_LATENCY_TABLE_DIMENSIONS]  = { MAX_VICS - 1,
+                                                                       LIP_COLOR_FORMAT_COUNT - 1,
+                                                                       HDR_MODES_COUNT - 1 };
+
+    init_video_table(&base);
+    init_video_table(&fragment);
+    TEST_CHECK(dlb_lip_latency_table_set(&base, all_first, all_last, 20) == 0);
+    TEST_CHECK(dlb_lip_latency_table_set_cell(&base, 16, 0, 0, 30) == 0);
+    TEST_CHECK(dlb_lip_latency_table_set_cell(&fragment, 16, 0, 0, 35) == 0);
+    TEST_CHECK(dlb_lip_latency_table_set_cell(&fragment, 4, 1, 2, 45) == 0);
+
+    // Rules of the fragment follow the rules of the base and override them
+    TEST_CHECK(dlb_lip_latency_table_for_each_rule(&fragment, set_rule, &base) == 0);
+    memset(expected, 20, sizeof(expected));
+    expected[video_offset(16, 0, 0)] = 35;
+    expected[video_offset(4, 1, 2)]  = 45;
+    TEST_CHECK(base.rule_count == 3);
+    check_video_table(&base);
+
+    // Copy is independent of the table
+    TEST_CHECK(dlb_lip_latency_table_copy(&fragment, &base) == 0);
+    TEST_CHECK(dlb_lip_latency_table_set_cell(&fragment, 16, 0, 0, 55) == 0);
+    TEST_CHECK(dlb_lip_latency_table_get(&base, 16, 0, 0) == 35);
+    TEST_CHECK(dlb_lip_latency_table_get(&fragment, 16, 0, 0) == 55);
+
+    dlb_lip_latency_table_destroy(&base);
+    dlb_lip_latency_table_destroy(&fragment);
+}
+
+static void test_rule_storage_growth(void)
+{
+    static dlb_lip_latency_table_t table;
+
+    init_video_table(&table);
+    memset(expected, LIP_INVALID_LATENCY, sizeof(expected));
+    TEST_CHECK(table.rules == NULL && table.rule_capacity == 0);
+
+    // Storage of the rules grows with their count
+    for (unsigned int vic = 0; vic < 100; ++vic)
+    {
+        TEST_CHECK(dlb_lip_latency_table_set_cell(&table, vic, 0, 0, (uint8_t)(vic + 1)) == 0);
+        expected[video_offset(vic, 0, 0)] = (uint8_t)(vic + 1);
+    }
+    TEST_CHECK(table.rule_count == 100);
+    TEST_CHECK(table.rule_capacity >= 100 && table.rule_capacity < 2 * 100);
+    check_video_table(&table);
+
+    dlb_lip_latency_table_destroy(&table);
+    TEST_CHECK(table.rules == NULL && table.rule_count == 0);
+}
+
+static void test_dense_fallback(void)
+{
+    static dlb_lip_latency_table_t table;
+    const uint8_t vic_first[DLB_LIP_LATENCY_TABLE_DIMENSIONS] = { 200, 0, 0 };
+    const uint8_t vic_last[DLB_LIP_LATENCY_TABLE_DIMENSIONS]  = { 201, LIP_COLOR_FORMAT_COUNT - 1, HDR_MODES_COUNT - 1 };
+    const uint8_t unset[DLB_LIP_LATENCY_TABLE_DIMENSIONS]     = { 5, 1, 3 };
+    unsigned int  cells                                       = 0;
+
+    init_video_table(&table);
+    memset(expected, LIP_INVALID_LATENCY, sizeof(expected));
+
+    // Every other cell gets its own latency, no rule covers another one
+    for (unsigned int vic = 0; vic < MAX_VICS; ++vic)
+    {
+        for (unsigned int color = 0; color < LIP_COLOR_FORMAT_COUNT; ++color)
+        {
+            for (unsigned int hdr = 0; hdr < HDR_MODES_COUNT; hdr += 2)
+            {
+                const uint8_t latency = (uint8_t)(1 + cells % 200);
+
+                TEST_CHECK(dlb_lip_latency_table_set_cell(&table, vic, color, hdr, latency) == 0);
+                expected[video_offset(vic, color, hdr)] = latency;
+                cells += 1;
+            }
+        }
+    }
+    TEST_CHECK(cells > DLB_LIP_LATENCY_TABLE_MAX_RULES);
+    TEST_CHECK(table.dense);
+    check_video_table(&table);
+
+    // Blocks and cells set to the dense table
+    TEST_CHECK(dlb_lip_latency_table_set(&table, vic_first, vic_last, 90) == 0);
+    memset(&expected[video_offset(200, 0, 0)], 90, 2 * LIP_COLOR_FORMAT_COUNT * HDR_MODES_COUNT);
+    TEST_CHECK(dlb_lip_latency_table_set_cell(&table, 0, 0, 1, 91) == 0);
+    expected[video_offset(0, 0, 1)] = 91;
+    check_video_table(&table);
+
+    TEST_CHECK(dlb_lip_latency_table_intersects(&table, vic_first, vic_last));
+    TEST_CHECK(!dlb_lip_latency_table_intersects(&table, unset, unset));
+    dlb_lip_latency_table_destroy(&table);
+}
+
+int main(void)
+{
+    test_rule_coverage();
+    test_merge();
+    test_rule_storage_growth();
+    test_dense_fallback();
+
+    return TEST_RESULT();
+}
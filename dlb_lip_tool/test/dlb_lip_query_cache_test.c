@@ -0,0 +1,134 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_query_cache_test.c
+ *  @brief      Unit test of the latency query results cached by the tool
+ */
+
+// nanosleep() is POSIX
+#define _POSIX_C_SOURCE 200809L
+
+#include <time.h>
+
+#include "dlb_lip_query_cache.h"
+#include "dlb_lip_test.h"
+
+#define TEST_NEGATIVE_TTL_MS 50U
+#define TEST_UUID 0x12345678U
+#define TEST_INVALID_LATENCY 0xFFU
+
+static dlb_lip_query_cache_t cache;
+
+static void wait_ms(unsigned int ms)
+{
+    struct timespec ts = { (time_t)(ms / 1000U), (long)(ms % 1000U) * 1000000L };
+
+    // Sleep again for the rest when interrupted by a signal
+    while (nanosleep(&ts, &ts) != 0)
+    {
+    }
+}
+
+static bool lookup(uint64_t key, uint32_t *p_generation, uint8_t *p_audio_latency)
+{
+    uint8_t video_latency = 0;
+
+    return dlb_lip_query_cache_lookup(&cache, key, p_generation, p_audio_latency, &video_latency);
+}
+
+static void test_negative_result_expires(void)
+{
+    uint32_t generation    = 0;
+    uint8_t  audio_latency = 0;
+
+    dlb_lip_query_cache_init(&cache, TEST_NEGATIVE_TTL_MS);
+    dlb_lip_query_cache_set_downstream(&cache, true, TEST_UUID);
+
+    TEST_CHECK(!lookup(1, &generation, &audio_latency));
+    dlb_lip_query_cache_insert(&cache, generation, 1, 20, 0, false);
+    dlb_lip_query_cache_insert(&cache, generation, 2, TEST_INVALID_LATENCY, 0, true);
+
+    TEST_CHECK(lookup(2, &generation, &audio_latency) && audio_latency == TEST_INVALID_LATENCY);
+    wait_ms(TEST_NEGATIVE_TTL_MS + 10U);
+    TEST_CHECK(!lookup(2, &generation, &audio_latency));
+    // Latencies never expire
+    TEST_CHECK(lookup(1, &generation, &audio_latency) && audio_latency == 20);
+
+    // Expired slot is reused by the same key and expires again
+    dlb_lip_query_cache_insert(&cache, generation, 2, TEST_INVALID_LATENCY, 0, true);
+    TEST_CHECK(lookup(2, &generation, &audio_latency));
+    wait_ms(TEST_NEGATIVE_TTL_MS + 10U);
+    TEST_CHECK(!lookup(2, &generation, &audio_latency));
+
+    dlb_lip_query_cache_destroy(&cache);
+}
+
+static void test_zero_ttl_disables_negative_results(void)
+{
+    uint32_t generation    = 0;
+    uint8_t  audio_latency = 0;
+
+    dlb_lip_query_cache_init(&cache, 0);
+    dlb_lip_query_cache_set_downstream(&cache, true, TEST_UUID);
+
+    TEST_CHECK(!lookup(2, &generation, &audio_latency));
+    dlb_lip_query_cache_insert(&cache, generation, 2, TEST_INVALID_LATENCY, 0, true);
+    TEST_CHECK(!lookup(2, &generation, &audio_latency));
+
+    dlb_lip_query_cache_destroy(&cache);
+}
+
+static void test_downstream_change_drops_results(void)
+{
+    uint32_t generation    = 0;
+    uint32_t stale         = 0;
+    uint8_t  audio_latency = 0;
+
+    dlb_lip_query_cache_init(&cache, TEST_NEGATIVE_TTL_MS);
+
+    // Nothing is cached without downstream device
+    TEST_CHECK(!lookup(1, &generation, &audio_latency));
+    dlb_lip_query_cache_insert(&cache, generation, 1, 20, 0, false);
+    TEST_CHECK(!lookup(1, &generation, &audio_latency));
+
+    dlb_lip_query_cache_set_downstream(&cache, true, TEST_UUID);
+    TEST_CHECK(!lookup(1, &generation, &audio_latency));
+    dlb_lip_query_cache_insert(&cache, generation, 1, 20, 0, false);
+    TEST_CHECK(lookup(1, &generation, &audio_latency));
+
+    // Same UUID keeps the results
+    dlb_lip_query_cache_set_downstream(&cache, true, TEST_UUID);
+    TEST_CHECK(lookup(1, &generation, &audio_latency));
+
+    // Result of a query sent before the UUID changed is not stored
+    TEST_CHECK(!lookup(3, &stale, &audio_latency));
+    dlb_lip_query_cache_set_downstream(&cache, true, TEST_UUID + 1U);
+    dlb_lip_query_cache_insert(&cache, stale, 3, 30, 0, false);
+    TEST_CHECK(!lookup(3, &generation, &audio_latency));
+    TEST_CHECK(!lookup(1, &generation, &audio_latency));
+
+    dlb_lip_query_cache_insert(&cache, generation, 1, 40, 0, false);
+    dlb_lip_query_cache_set_downstream(&cache, false, 0);
+    dlb_lip_query_cache_set_downstream(&cache, true, TEST_UUID + 1U);
+    TEST_CHECK(!lookup(1, &generation, &audio_latency));
+
+    dlb_lip_query_cache_destroy(&cache);
+}
+
+int main(void)
+{
+    test_negative_result_expires();
+    test_zero_ttl_disables_negative_results();
+    test_downstream_change_drops_results();
+
+    return TEST_RESULT();
+}
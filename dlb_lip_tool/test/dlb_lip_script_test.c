@@ -0,0 +1,134 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_script_test.c
+ *  @brief      Unit test of the command script preprocessor
+ */
+
+#include <string.h>
+
+#include "dlb_lip_script.h"
+#include "dlb_lip_test.h"
+
+#define MAX_COMMANDS 16
+
+typedef struct script_source_s
+{
+    const char *const *lines;
+    unsigned int       next;
+} script_source_t;
+
+static char *read_script_line(void *p_context, char *line, int size)
+{
+    script_source_t *const p_source = (script_source_t *)p_context;
+
+    if (p_source->lines[p_source->next] == NULL)
+    {
+        return NULL;
+    }
+    snprintf(line, (size_t)size, "%s\n", p_source->lines[p_source->next++]);
+    return line;
+}
+
+/*!
+Expands the script until it ends or fails and checks the produced commands.
+
+@return result of the last dlb_lip_script_next_command call
+*/
+static int run_script(const char *const *lines, const char *const *expected)
+{
+    script_source_t  source = { lines, 0 };
+    dlb_lip_script_t script;
+    char             command[DLB_LIP_SCRIPT_MAX_LINE];
+    unsigned int     count = 0;
+    int              ret   = 0;
+
+    dlb_lip_script_init(&script);
+    while ((ret = dlb_lip_script_next_command(&script, command, sizeof(command), read_script_line, &source)) == 1)
+    {
+        TEST_CHECK(expected[count] != NULL);
+        if (expected[count] == NULL)
+        {
+            break;
+        }
+        TEST_CHECK(strcmp(command, expected[count]) == 0);
+        count += 1;
+    }
+    TEST_CHECK(expected[count] == NULL);
+    dlb_lip_script_destroy(&script);
+
+    return ret;
+}
+
+static void test_loops_and_expressions(void)
+{
+    const char *const lines[]    = { "set n = 2",
+                                  "# comment",
+                                  "repeat 2 i {",
+                                  "tx ${i * 10 + n}",
+                                  "}",
+                                  "for v in 1..5 step 2 {",
+                                  "for w in 0..1 {",
+                                  "req ${v}:${w}",
+                                  "}",
+                                  "}",
+                                  "wait ${(7 % 4) - -1}",
+                                  NULL };
+    const char *const expected[] = { "tx 2",    "tx 12",   "req 1:0", "req 1:1", "req 3:0",
+                                     "req 3:1", "req 5:0", "req 5:1", "wait 4",  NULL };
+
+    TEST_CHECK(run_script(lines, expected) == 0);
+}
+
+static void test_remainder_of_minimum(void)
+{
+    const char *const lines[]    = { "set m = -9223372036854775807 - 1", "tx ${m % -1}", NULL };
+    const char *const expected[] = { "tx 0", NULL };
+
+    TEST_CHECK(run_script(lines, expected) == 0);
+}
+
+static void test_loop_ending_at_maximum(void)
+{
+    const char *const lines[]    = { "for v in 9223372036854775806..9223372036854775807 step 4 {", "tx ${v}", "}", "tx end", NULL };
+    const char *const expected[] = { "tx 9223372036854775806", "tx end", NULL };
+
+    TEST_CHECK(run_script(lines, expected) == 0);
+}
+
+static void test_errors(void)
+{
+    const char *const overflow[]     = { "set m = -9223372036854775807 - 1", "tx ${m / -1}", NULL };
+    const char *const product[]      = { "tx ${4611686018427387904 * 2}", NULL };
+    const char *const sum[]          = { "tx ${9223372036854775807 + 1}", NULL };
+    const char *const difference[]   = { "tx ${-9223372036854775807 - 2}", NULL };
+    const char *const division[]     = { "tx ${1 / 0}", NULL };
+    const char *const unterminated[] = { "repeat 2 {", "tx 1", NULL };
+    const char *const none[]         = { NULL };
+
+    TEST_CHECK(run_script(overflow, none) == -1);
+    TEST_CHECK(run_script(product, none) == -1);
+    TEST_CHECK(run_script(sum, none) == -1);
+    TEST_CHECK(run_script(difference, none) == -1);
+    TEST_CHECK(run_script(division, none) == -1);
+    TEST_CHECK(run_script(unterminated, none) == -1);
+}
+
+int main(void)
+{
+    test_loops_and_expressions();
+    test_remainder_of_minimum();
+    test_loop_ending_at_maximum();
+    test_errors();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,36 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_test.h
+ *  @brief      Checks shared by the unit tests, a test returns the number of failed checks from main
+ */
+
+#ifndef DLB_LIP_TEST_H
+#define DLB_LIP_TEST_H
+
+#include <stdio.h>
+
+static unsigned int test_failures = 0;
+
+#define TEST_CHECK(condition)                                                                  \
+    do                                                                                         \
+    {                                                                                          \
+        if (!(condition))                                                                      \
+        {                                                                                      \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);      \
+            test_failures += 1;                                                                \
+        }                                                                                      \
+    } while (0)
+
+#define TEST_RESULT() (test_failures == 0 ? 0 : 1)
+
+#endif
@@ -0,0 +1,124 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_vocabulary_test.c
+ *  @brief      Unit test of the names of LIP formats and device params
+ */
+
+#include <string.h>
+
+#include "dlb_lip_test.h"
+#include "dlb_lip_tool_osa.h"
+#include "dlb_lip_vocabulary.h"
+
+#define TEST_THREADS 4
+#define TEST_LOOKUPS 1000
+
+typedef struct lookup_thread_s
+{
+    dlb_lip_tool_thread_t thread;
+    unsigned int          failures;
+} lookup_thread_t;
+
+static void lookup_names(void *arg)
+{
+    lookup_thread_t *const p_lookup = (lookup_thread_t *)arg;
+
+    for (unsigned int i = 0; i < TEST_LOOKUPS; ++i)
+    {
+        if (dlb_lip_vocabulary_lookup(DLB_LIP_VOCABULARY_CODEC, "DDP") != IEC61937_EAC3)
+        {
+            p_lookup->failures += 1;
+        }
+    }
+}
+
+static void test_first_lookups_in_threads(void)
+{
+    lookup_thread_t threads[TEST_THREADS] = { 0 };
+
+    // The table is built by whichever thread looks up first, the others wait for it
+    for (unsigned int i = 0; i < TEST_THREADS; ++i)
+    {
+        TEST_CHECK(dlb_lip_tool_thread_create(&threads[i].thread, lookup_names, &threads[i]) == 0);
+    }
+    for (unsigned int i = 0; i < TEST_THREADS; ++i)
+    {
+        dlb_lip_tool_thread_join(&threads[i].thread);
+        TEST_CHECK(threads[i].failures == 0);
+    }
+}
+
+static void test_every_name_round_trips(void)
+{
+    for (int kind = 0; kind < DLB_LIP_VOCABULARY_KINDS; ++kind)
+    {
+        unsigned int             count = 0;
+        const char *const *const names = dlb_lip_vocabulary_names((dlb_lip_vocabulary_kind_t)kind, &count);
+        unsigned int             named = 0;
+
+        for (unsigned int value = 0; value < count; ++value)
+        {
+            if (names[value] != NULL)
+            {
+                TEST_CHECK(dlb_lip_vocabulary_lookup((dlb_lip_vocabulary_kind_t)kind, names[value]) == (int)value);
+                TEST_CHECK(dlb_lip_vocabulary_name((dlb_lip_vocabulary_kind_t)kind, (int)value) == names[value]);
+                named += 1;
+            }
+        }
+        TEST_CHECK(named > 0);
+    }
+}
+
+static void test_exact_lookup(void)
+{
+    TEST_CHECK(dlb_lip_vocabulary_lookup(DLB_LIP_VOCABULARY_CODEC, "DDP") == IEC61937_EAC3);
+    TEST_CHECK(dlb_lip_vocabulary_lookup(DLB_LIP_VOCABULARY_CODEC, "ddp") == -1);
+    TEST_CHECK(dlb_lip_vocabulary_lookup(DLB_LIP_VOCABULARY_CODEC, "DDP ") == -1);
+    TEST_CHECK(dlb_lip_vocabulary_lookup(DLB_LIP_VOCABULARY_CODEC, "DD") == IEC61937_AC3);
+    TEST_CHECK(dlb_lip_vocabulary_lookup(DLB_LIP_VOCABULARY_CODEC, NULL) == -1);
+    TEST_CHECK(dlb_lip_vocabulary_lookup(DLB_LIP_VOCABULARY_HDR_STATIC, "SDR") == LIP_HDR_STATIC_SDR);
+
+    // The same name in different kinds
+    TEST_CHECK(dlb_lip_vocabulary_lookup(DLB_LIP_VOCABULARY_DEVICE_TYPE, "audio") == LIP_DEVICE_AVR);
+    TEST_CHECK(dlb_lip_vocabulary_lookup(DLB_LIP_VOCABULARY_RENDERER, "audio") == LIP_AUDIO_RENDERER);
+    TEST_CHECK(dlb_lip_vocabulary_lookup(DLB_LIP_VOCABULARY_CODEC, "audio") == -1);
+}
+
+static void test_alias_lookup(void)
+{
+    TEST_CHECK(dlb_lip_vocabulary_lookup(DLB_LIP_VOCABULARY_CODEC, "DTS_TYPE_IIII") == IEC61937_DTS_TYPE_III);
+    TEST_CHECK(dlb_lip_vocabulary_lookup(DLB_LIP_VOCABULARY_CODEC, "DTS_TYPE_III") == IEC61937_DTS_TYPE_III);
+
+    // Aliases are accepted, never printed
+    TEST_CHECK(strcmp(dlb_lip_vocabulary_name(DLB_LIP_VOCABULARY_CODEC, IEC61937_DTS_TYPE_III), "DTS_TYPE_III") == 0);
+}
+
+static void test_hdr_kinds(void)
+{
+    TEST_CHECK(dlb_lip_vocabulary_hdr_kind(LIP_COLOR_FORMAT_HDR_STATIC) == DLB_LIP_VOCABULARY_HDR_STATIC);
+    TEST_CHECK(dlb_lip_vocabulary_hdr_kind(LIP_COLOR_FORMAT_HDR_DYNAMIC) == DLB_LIP_VOCABULARY_HDR_DYNAMIC);
+    TEST_CHECK(dlb_lip_vocabulary_hdr_kind(LIP_COLOR_FORMAT_DOLBY_VISION) == DLB_LIP_VOCABULARY_DOLBY_VISION);
+    TEST_CHECK(dlb_lip_vocabulary_hdr_kind(LIP_COLOR_FORMAT_COUNT) == DLB_LIP_VOCABULARY_KINDS);
+    TEST_CHECK(dlb_lip_vocabulary_name(DLB_LIP_VOCABULARY_HDR_STATIC, LIP_HDR_STATIC_COUNT) == NULL);
+}
+
+int main(void)
+{
+    test_first_lookups_in_threads();
+    test_every_name_round_trips();
+    test_exact_lookup();
+    test_alias_lookup();
+    test_hdr_kinds();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,205 @@
+/******************************************************************************
+ * This program is protected under international and U.S. copyright laws as
+ * an unpublished work. This program is confidential and proprietary to the
+ * copyright owners. Reproduction or disclosure, in whole or in part, or the
+ * production of derivative works therefrom without the express permission of
+ * the copyright owners is prohibited.
+ *
+ *                Copyright (C) 2020 by Dolby International AB.
+ *                            All rights reserved.
+ ******************************************************************************/
+
+/**
+ *  @file       dlb_lip_xml_parser_test.c
+ *  @brief      Unit test of XML configs inheriting from base files and including other files
+ */
+
+// nftw() is an XSI extension
+#define _XOPEN_SOURCE 700
+
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dlb_lip_test.h"
+#include "dlb_lip_xml_parser.h"
+
+#define TEST_PATH_SIZE 1024U
+#define TEST_VIC_BASE 96
+#define TEST_VIC_INCLUDED 97
+
+static char test_directory[] = "/tmp/dlb_lip_xml_parser_test_XXXXXX";
+
+static void make_path(char *path, const char *name)
+{
+    snprintf(path, TEST_PATH_SIZE, "%s/%s", test_directory, name);
+}
+
+static void write_file(const char *name, const char *text)
+{
+    char  path[TEST_PATH_SIZE];
+    FILE *file = NULL;
+
+    make_path(path, name);
+    file = fopen(path, "w");
+    TEST_CHECK(file != NULL && fputs(text, file) >= 0);
+    if (file)
+    {
+        fclose(file);
+    }
+}
+
+/*!
+Parses the config file of the test directory with overwrites counted but not printed.
+
+@return status of the parser
+*/
+static int parse_config(dlb_lip_xml_parser_t *p_parser, const char *name)
+{
+    char path[TEST_PATH_SIZE];
+
+    make_path(path, name);
+    dlb_lip_xml_parser_init(p_parser);
+    p_parser->diagnostics.quiet = true;
+    return parse_xml_config_file(p_parser, path);
+}
+
+static uint8_t video_latency(const dlb_lip_xml_parser_t *p_parser, uint8_t vic)
+{
+    return dlb_lip_latency_table_get(&p_parser->video_latencies, vic, 0, 0);
+}
+
+static uint8_t audio_latency(const dlb_lip_xml_parser_t *p_parser, dlb_lip_audio_codec_t codec)
+{
+    return dlb_lip_latency_table_get(&p_parser->audio_latencies, (uint8_t)codec, 0, 0);
+}
+
+static void write_base_files(void)
+{
+    write_file("base.xml",
+               "<LIP_Config>\n"
+               "    <DeviceParams>\n"
+               "        <UUID>0xAABB0000</UUID>\n"
+               "        <PhysicalAddress>1.0.0.0</PhysicalAddress>\n"
+               "        <DeviceType>playback</DeviceType>\n"
+               "    </DeviceParams>\n"
+               "    <VideoLatencies>\n"
+               "        <VidLatency VIC=\"96\">100</VidLatency>\n"
+               "    </VideoLatencies>\n"
+               "    <AudioLatencies>\n"
+               "        <AudLatency format=\"PCM\">50</AudLatency>\n"
+               "        <AudLatency format=\"DD\">110</AudLatency>\n"
+               "    </AudioLatencies>\n"
+               "</LIP_Config>\n");
+    write_file("included.xml",
+               "<LIP_Config>\n"
+               "    <DeviceParams>\n"
+               "        <UUID>0xCCDD0000</UUID>\n"
+               "    </DeviceParams>\n"
+               "    <VideoLatencies>\n"
+               "        <VidLatency VIC=\"97\">150</VidLatency>\n"
+               "    </VideoLatencies>\n"
+               "    <AudioLatencies>\n"
+               "        <AudLatency format=\"DD\">120</AudLatency>\n"
+               "    </AudioLatencies>\n"
+               "</LIP_Config>\n");
+    write_file("config.xml",
+               "<LIP_Config base=\"base.xml\">\n"
+               "    <DeviceParams>\n"
+               "        <UUID>0xAABB0001</UUID>\n"
+               "    </DeviceParams>\n"
+               "    <Include file=\"included.xml\"/>\n"
+               "    <AudioLatencies>\n"
+               "        <AudLatency format=\"PCM\">60</AudLatency>\n"
+               "    </AudioLatencies>\n"
+               "</LIP_Config>\n");
+}
+
+static void test_base_and_included_latencies(void)
+{
+    dlb_lip_xml_parser_t parser;
+
+    write_base_files();
+    TEST_CHECK(parse_config(&parser, "config.xml") == 0);
+
+    // DeviceParams of the base file changed by the config, DeviceParams of the included file are ignored
+    TEST_CHECK(parser.config_params.uuid == 0xAABB0001U);
+    TEST_CHECK(parser.physical_address == 0x1000);
+    TEST_CHECK(parser.device_type == LIP_DEVICE_STB);
+
+    TEST_CHECK(video_latency(&parser, TEST_VIC_BASE) == 100);
+    TEST_CHECK(video_latency(&parser, TEST_VIC_INCLUDED) == 150);
+    TEST_CHECK(audio_latency(&parser, IEC61937_AC3) == 120);
+    TEST_CHECK(audio_latency(&parser, PCM) == 60);
+    TEST_CHECK(parser.diagnostics.overwrite_elements == 2);
+
+    // Config file, its base file and the included file
+    TEST_CHECK(parser.dependency_count == 3);
+    dlb_lip_xml_parser_destroy(&parser);
+}
+
+static void test_changed_included_file_is_parsed_again(void)
+{
+    dlb_lip_xml_parser_t parser;
+
+    write_base_files();
+    TEST_CHECK(parse_config(&parser, "config.xml") == 0);
+    TEST_CHECK(video_latency(&parser, TEST_VIC_INCLUDED) == 150);
+    dlb_lip_xml_parser_destroy(&parser);
+
+    // Size changes as well, so the change is seen within the timestamp resolution
+    write_file("included.xml",
+               "<LIP_Config>\n"
+               "    <VideoLatencies>\n"
+               "        <VidLatency VIC=\"97\">160</VidLatency>\n"
+               "        <VidLatency VIC=\"98\">170</VidLatency>\n"
+               "    </VideoLatencies>\n"
+               "</LIP_Config>\n");
+    TEST_CHECK(parse_config(&parser, "config.xml") == 0);
+    TEST_CHECK(video_latency(&parser, TEST_VIC_BASE) == 100);
+    TEST_CHECK(video_latency(&parser, TEST_VIC_INCLUDED) == 160);
+    TEST_CHECK(video_latency(&parser, TEST_VIC_INCLUDED + 1) == 170);
+    TEST_CHECK(audio_latency(&parser, IEC61937_AC3) == 110);
+    dlb_lip_xml_parser_destroy(&parser);
+}
+
+static void test_missing_base_file_is_rejected(void)
+{
+    dlb_lip_xml_parser_t parser;
+
+    write_file("orphan.xml",
+               "<LIP_Config base=\"missing.xml\">\n"
+               "    <DeviceParams>\n"
+               "        <UUID>0xAABB0002</UUID>\n"
+               "    </DeviceParams>\n"
+               "</LIP_Config>\n");
+    TEST_CHECK(parse_config(&parser, "orphan.xml") != 0);
+    dlb_lip_xml_parser_destroy(&parser);
+}
+
+static int remove_path(const char *path, const struct stat *p_stat, int type, struct FTW *p_ftw)
+{
+    (void)p_stat;
+    (void)type;
+    (void)p_ftw;
+    return remove(path);
+}
+
+int main(void)
+{
+    if (mkdtemp(test_directory) == NULL)
+    {
+        fprintf(stderr, "ERROR: Couldn't create %s\n", test_directory);
+        return 1;
+    }
+
+    test_base_and_included_latencies();
+    test_changed_included_file_is_parsed_again();
+    test_missing_base_file_is_rejected();
+
+    dlb_lip_xml_fragments_clear();
+    nftw(test_directory, remove_path, 16, FTW_DEPTH | FTW_PHYS);
+
+    return TEST_RESULT();
+}